@@ -0,0 +1,83 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#include <cstdlib>
+#include <cstring>
+#include <cppipc/client/call_batch.hpp>
+#include <logger/logger.hpp>
+
+namespace cppipc {
+
+call_batch::~call_batch() {
+  // flush reports the failures of the calls through their futures, but
+  // must not throw out of a destructor if the batch itself cannot be sent
+  try {
+    flush();
+  } catch (std::exception& e) {
+    logstream(LOG_ERROR) << "Unable to flush a call batch: " << e.what() << std::endl;
+  } catch (...) {
+    logstream(LOG_ERROR) << "Unable to flush a call batch" << std::endl;
+  }
+}
+
+void call_batch::flush() {
+  if (m_calls.empty()) return;
+  std::vector<pending_call> calls;
+  calls.swap(m_calls);
+
+  call_message msg;
+  msg.objectid = 0;
+  msg.function_name = CALL_BATCH_FUNCTION_NAME;
+  turi::oarchive oarc;
+  oarc << calls.size();
+  for (const auto& c : calls) {
+    oarc << c.objectid << c.function_name << c.body;
+  }
+  // Pad the buffer to even; see comm_client::build_call_message
+  if (oarc.off & 1) oarc.write(" ", 1);
+  msg.body = oarc.buf;
+  msg.bodylen = oarc.off;
+
+  // The batch is the running command, so that CTRL-C cancels it.
+  reply_message reply;
+  int retcode = m_client.call_as_running_command(msg, reply);
+
+  if (retcode == 0 && reply.status == reply_status::NO_FUNCTION &&
+      reply.properties.count(CALL_BATCH_PROPERTY) == 0) {
+    // The server does not know batches; issue the calls one at a time.
+    for (auto& c : calls) {
+      call_message single;
+      single.objectid = c.objectid;
+      single.function_name = c.function_name;
+      char* body = (char*)malloc(c.body.size());
+      memcpy(body, c.body.data(), c.body.size());
+      single.body = body;
+      single.bodylen = c.body.size();
+      reply_message single_reply;
+      int single_retcode = m_client.call_as_running_command(single, single_reply);
+      c.on_reply(single_retcode, single_reply);
+    }
+    return;
+  }
+
+  if (retcode != 0 || reply.status != reply_status::OK) {
+    // The batch failed as a whole
+    for (auto& c : calls) c.on_reply(retcode, reply);
+    return;
+  }
+
+  turi::iarchive iarc(reply.body, reply.bodylen);
+  for (auto& c : calls) {
+    size_t status;
+    std::string body;
+    reply_message call_reply;
+    iarc >> status >> call_reply.properties >> body;
+    call_reply.status = static_cast<reply_status>(status);
+    call_reply.copy_body_from(body);
+    c.on_reply(0, call_reply);
+  }
+}
+
+} // cppipc
@@ -0,0 +1,135 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#ifndef CPPIPC_CLIENT_CALL_BATCH_HPP
+#define CPPIPC_CLIENT_CALL_BATCH_HPP
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+#include <functional>
+#include <cppipc/client/comm_client.hpp>
+
+namespace cppipc {
+
+namespace detail {
+/**
+ * \ingroup cppipc
+ * \internal
+ * Sets the value of a promise to the result of fn().
+ * Works correctly for void types.
+ */
+template <typename RetType>
+struct set_promise_value {
+  template <typename Fn>
+  static void exec(std::promise<RetType>& promise, Fn&& fn) {
+    promise.set_value(fn());
+  }
+};
+
+template <>
+struct set_promise_value<void> {
+  template <typename Fn>
+  static void exec(std::promise<void>& promise, Fn&& fn) {
+    fn();
+    promise.set_value();
+  }
+};
+} // namespace detail
+
+/**
+ * \ingroup cppipc
+ * Collects calls to remote objects and issues them to the server in a
+ * single message, so that a sequence of calls (for instance, setting many
+ * options) costs one round trip instead of one per call.
+ *
+ * \code
+ * cppipc::call_batch batch(client);
+ * std::future<int> opened = proxy.call_async(batch, &file_write_base::open, "log.txt");
+ * std::future<void> written = proxy.call_async(batch, &file_write_base::write, "hello");
+ * batch.flush(); // one round trip
+ * int ret = opened.get();
+ * \endcode
+ *
+ * The server executes the calls in the order they were issued. The future
+ * of a call holds its return value, or the exception the call raised (the
+ * same exception \ref comm_client::call would have thrown). Since the
+ * arguments of a call are serialized when it is issued, a call cannot take
+ * the result of an earlier call of the same batch as argument.
+ *
+ * Pending calls are flushed on destruction; an error sending them is then
+ * logged rather than thrown. As for \ref comm_client::call,
+ * only the main thread may flush a batch, and the batch (or each call, against
+ * a server without batches) is the running command while it is in flight,
+ * so CTRL-C cancels it.
+ */
+class EXPORT call_batch {
+ public:
+  explicit call_batch(comm_client& client): m_client(client) { }
+
+  call_batch(const call_batch&) = delete;
+  call_batch& operator=(const call_batch&) = delete;
+
+  ~call_batch();
+
+  /**
+   * Adds a call of function f of the object objectid to the batch,
+   * returning the future of its result. Throws immediately if the client
+   * is not started or the function is not registered.
+   */
+  template <typename MemFn, typename... Args>
+  std::future<typename detail::member_function_return_type<MemFn>::type>
+  call(size_t objectid, MemFn f, const Args&... args) {
+    if (!m_client.started) {
+      throw ipcexception(reply_status::COMM_FAILURE, 0, "Client not started");
+    }
+    typedef typename detail::member_function_return_type<MemFn>::type return_type;
+    call_message msg;
+    m_client.build_call_message(objectid, f, msg, args...);
+
+    auto promise = std::make_shared<std::promise<return_type>>();
+    comm_client* client = &m_client;
+    pending_call pending;
+    pending.objectid = msg.objectid;
+    pending.function_name = msg.function_name;
+    pending.body.assign(msg.body, msg.bodylen);
+    pending.on_reply = [promise, client](int retcode, reply_message& reply) {
+      try {
+        detail::set_promise_value<return_type>::exec(*promise, [&]() {
+          return client->decode_reply<return_type>(retcode, reply);
+        });
+      } catch (...) {
+        promise->set_exception(std::current_exception());
+      }
+    };
+    m_calls.push_back(std::move(pending));
+    return promise->get_future();
+  }
+
+  /**
+   * Issues the pending calls, and sets the results of their futures. A
+   * communication failure is reported through the futures of the calls.
+   * Against a server which does not support batches, the calls are issued
+   * one at a time.
+   */
+  void flush();
+
+  /// The number of pending calls.
+  size_t size() const { return m_calls.size(); }
+
+ private:
+  struct pending_call {
+    size_t objectid = 0;
+    std::string function_name;
+    std::string body;
+    std::function<void(int, reply_message&)> on_reply;
+  };
+
+  comm_client& m_client;
+  std::vector<pending_call> m_calls;
+};
+
+} // cppipc
+#endif
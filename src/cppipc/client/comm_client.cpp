@@ -375,6 +375,64 @@ int comm_client::internal_call(call_message& call, reply_message& reply, bool co
 }
 
 
+int comm_client::call_as_running_command(call_message& msg,
+                                         reply_message& reply) {
+  // Set the command id
+  // 0 and uint64_t(-1) have special meaning, so don't send those
+  size_t command_id = m_command_id.inc();
+  auto ret = msg.properties.insert(std::make_pair<std::string, std::string>(
+        "command_id", std::to_string(command_id)));
+  ASSERT_TRUE(ret.second);
+
+  auto &r = get_running_command();
+  r.store(command_id);
+
+  // Read and save the current signal handler (e.g. Python's SIGINT handler)
+  // Set signal handler to catch CTRL-C during this call
+  if(cancel_handling_enabled &&
+      !console_cancel_handler::get_instance().set_handler()) {
+    logstream(LOG_WARNING) << "Could not read previous signal handler, "
+      "thus will not respond to CTRL-C.\n";
+    cancel_handling_enabled = false;
+  }
+
+  // call
+  int retcode = internal_call(msg, reply);
+
+  // Replace the SIGINT signal handler with the original one
+  if(cancel_handling_enabled) {
+    if(!console_cancel_handler::get_instance().unset_handler()) {
+      logstream(LOG_WARNING) <<
+        "Could not reset signal handler after server operation. Disabling CTRL-C support.\n";
+      cancel_handling_enabled = false;
+    }
+  }
+
+  // Check if we need to re-raise a SIGINT in Python
+  if(cancel_handling_enabled) {
+    // Check if CTRL-C was pressed for this command.
+    size_t running_command = get_running_command().load();
+    if(running_command && running_command == get_cancelled_command().load()) {
+      // Check if there was a cancel message, whether it was heeded.
+      auto ret = reply.properties.find(std::string("cancel"));
+
+      // If there is no 'cancel' property, then must_cancel was never checked
+      // on the server side, showing that this command does not support it.
+      if(ret == reply.properties.end()) {
+        // Raise this again for Python to make sure you can break out of a for
+        // loop with a turicreate call inside that does not throw on ctrl-c
+        // NOTE: I don't think I care if raise fails.
+        console_cancel_handler::get_instance().raise_cancel();
+      }
+    }
+  }
+
+  // Reset running command
+  get_running_command().store(0);
+  return retcode;
+}
+
+
 size_t comm_client::make_object(std::string object_type_name) {
   if (!started) {
     throw ipcexception(reply_status::COMM_FAILURE, 0, "Client not started");
@@ -66,6 +66,7 @@ struct deserialize_return_and_clear<void, false> {
 } // namespace detail
 
 class object_factory_proxy;
+class call_batch;
 
 /**
  * \ingroup cppipc
@@ -197,6 +198,8 @@ class object_factory_proxy;
  */
 class EXPORT comm_client {
  private:
+  friend class call_batch;
+
   nanosockets::async_request_socket object_socket;
   // This is a pointer because the endpoint address must be received from the
   // server, so it cannot be constructed in the constructor
@@ -229,6 +232,15 @@ class EXPORT comm_client {
    */
   int internal_call(call_message& call, reply_message& reply, bool control=false);
 
+  /**
+   * Issues a call as the running command: gives it a new command id, and
+   * installs the console cancel handler for the duration of the call, so
+   * that CTRL-C cancels it on the server. Used by \ref call and
+   * \ref call_batch. Only the main thread may call this.
+   * Returns as \ref internal_call.
+   */
+  int call_as_running_command(call_message& msg, reply_message& reply);
+
   int internal_call_impl(call_message& call, 
                          nanosockets::zmq_msg_vector& ret, 
                          bool control,
@@ -573,22 +585,13 @@ class EXPORT comm_client {
   }
 
   /**
-   * Calls a remote function returning the result.
-   * The return type is the actual return value.
-   * May throw an exception of type reply_status on failure.
-   *
-   * NOTE: ONLY the main thread can call this.  If this becomes untrue, some
-   * invariants will be violated (only one thread is allowed to change the
-   * currently running command).
+   * \internal
+   * Fills msg with a call to function f of the object objectid, with the
+   * given arguments.
    */
   template <typename MemFn, typename... Args>
-  typename detail::member_function_return_type<MemFn>::type 
-  call(size_t objectid, MemFn f, const Args&... args) {
-    if (!started) {
-      throw ipcexception(reply_status::COMM_FAILURE, 0, "Client not started");
-    }
-    typedef typename detail::member_function_return_type<MemFn>::type return_type;
-    call_message msg;
+  void build_call_message(size_t objectid, MemFn f, call_message& msg,
+                          const Args&... args) {
     prepare_call_message_structure(objectid, f, msg);
     // generate the arguments
     turi::oarchive oarc;
@@ -606,61 +609,16 @@ class EXPORT comm_client {
     if (oarc.off & 1) oarc.write(" ", 1);
     msg.body = oarc.buf;
     msg.bodylen = oarc.off;
+  }
 
-    // Set the command id
-    // 0 and uint64_t(-1) have special meaning, so don't send those
-    size_t command_id = m_command_id.inc();
-    auto ret = msg.properties.insert(std::make_pair<std::string, std::string>(
-          "command_id", std::to_string(command_id)));
-    ASSERT_TRUE(ret.second);
-
-    auto &r = get_running_command();
-    r.store(command_id);
-
-    // Read and save the current signal handler (e.g. Python's SIGINT handler)
-    // Set signal handler to catch CTRL-C during this call
-    if(cancel_handling_enabled &&
-        !console_cancel_handler::get_instance().set_handler()) {
-      logstream(LOG_WARNING) << "Could not read previous signal handler, "
-        "thus will not respond to CTRL-C.\n";
-      cancel_handling_enabled = false;
-    }
-
-    // call
-    reply_message reply;
-    int retcode = internal_call(msg, reply);
-
-    // Replace the SIGINT signal handler with the original one
-    if(cancel_handling_enabled) {
-      if(!console_cancel_handler::get_instance().unset_handler()) {
-        logstream(LOG_WARNING) <<
-          "Could not reset signal handler after server operation. Disabling CTRL-C support.\n";
-        cancel_handling_enabled = false;
-      }
-    }
-
-    // Check if we need to re-raise a SIGINT in Python
-    if(cancel_handling_enabled) {
-      // Check if CTRL-C was pressed for this command.
-      size_t running_command = get_running_command().load();
-      if(running_command && running_command == get_cancelled_command().load()) {
-        // Check if there was a cancel message, whether it was heeded.
-        auto ret = reply.properties.find(std::string("cancel"));
-
-        // If there is no 'cancel' property, then must_cancel was never checked
-        // on the server side, showing that this command does not support it.
-        if(ret == reply.properties.end()) {
-          // Raise this again for Python to make sure you can break out of a for
-          // loop with a turicreate call inside that does not throw on ctrl-c
-          // NOTE: I don't think I care if raise fails.
-          console_cancel_handler::get_instance().raise_cancel();
-        }
-      }
-    }
-
-    // Reset running command
-    get_running_command().store(0);
-
+  /**
+   * \internal
+   * Returns the result of a call from its reply, where retcode is the
+   * communication status of the call. Throws the exception matching the
+   * reply status on failure.
+   */
+  template <typename RetType>
+  RetType decode_reply(int retcode, reply_message& reply) {
     bool success = (retcode == 0);
     std::string custommsg;
     if (reply.body != NULL && reply.bodylen > 0) {
@@ -687,10 +645,36 @@ class EXPORT comm_client {
       }
     } else {
       detail::set_deserializer_to_client(this);
-      return detail::deserialize_return_and_clear<return_type, 
-             std::is_convertible<return_type, ipc_object_base*>::value>::exec(*this, reply);
+      return detail::deserialize_return_and_clear<RetType, 
+             std::is_convertible<RetType, ipc_object_base*>::value>::exec(*this, reply);
     }
   }
+
+  /**
+   * Calls a remote function returning the result.
+   * The return type is the actual return value.
+   * May throw an exception of type reply_status on failure.
+   *
+   * NOTE: ONLY the main thread can call this.  If this becomes untrue, some
+   * invariants will be violated (only one thread is allowed to change the
+   * currently running command).
+   *
+   * To issue many calls in a single round trip, see \ref call_batch.
+   */
+  template <typename MemFn, typename... Args>
+  typename detail::member_function_return_type<MemFn>::type 
+  call(size_t objectid, MemFn f, const Args&... args) {
+    if (!started) {
+      throw ipcexception(reply_status::COMM_FAILURE, 0, "Client not started");
+    }
+    typedef typename detail::member_function_return_type<MemFn>::type return_type;
+    call_message msg;
+    build_call_message(objectid, f, msg, args...);
+
+    reply_message reply;
+    int retcode = call_as_running_command(msg, reply);
+    return decode_reply<return_type>(retcode, reply);
+  }
 };
 
 } // cppipc
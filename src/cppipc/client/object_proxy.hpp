@@ -8,6 +8,7 @@
 #include <string>
 #include <map>
 #include <cppipc/client/comm_client.hpp>
+#include <cppipc/client/call_batch.hpp>
 namespace cppipc {
 
 
@@ -150,6 +151,16 @@ class object_proxy {
     return comm.call(remote_object_id, f, args...);
   }
 
+  /**
+   * Adds a call of a remote function to a batch, returning the future of
+   * its result. The call is issued when the batch is flushed.
+   */
+  template <typename MemFn, typename... Args>
+  std::future<typename detail::member_function_return_type<MemFn>::type>
+  call_async(call_batch& batch, MemFn f, const Args&... args) {
+    return batch.call(remote_object_id, f, args...);
+  }
+
  private:
   comm_client& comm;
   size_t remote_object_id;
@@ -166,6 +166,17 @@ struct EXPORT reply_message {
  */
 std::string reply_status_to_string(reply_status);
 
+/**
+ * \ingroup cppipc
+ * The function name of a call_message holding a batch of calls (see
+ * call_batch). The body holds the number of calls, then the object id,
+ * function name and body of every call. The reply has the
+ * CALL_BATCH_PROPERTY property, and its body holds the status, properties
+ * and body of the reply of every call.
+ */
+constexpr const char* CALL_BATCH_FUNCTION_NAME = "__call_batch__";
+constexpr const char* CALL_BATCH_PROPERTY = "call_batch";
+
 class ipcexception : public std::exception {
   public:
     ipcexception(reply_status s, 
@@ -185,6 +185,52 @@ bool comm_server::callback(nanosockets::zmq_msg_vector& recv,
     return true;
   }
 
+  if (call.function_name == CALL_BATCH_FUNCTION_NAME) {
+    execute_call_batch(call, rep);
+  } else {
+    execute_call(call, rep);
+  }
+  rep.emit(reply);
+  return true;
+}
+
+void comm_server::execute_call_batch(call_message& batch, reply_message& rep) {
+  turi::iarchive iarc(batch.body, batch.bodylen);
+  turi::oarchive oarc;
+  size_t num_calls = 0;
+  iarc >> num_calls;
+  for (size_t i = 0; i < num_calls; ++i) {
+    std::string body;
+    call_message call;
+    iarc >> call.objectid >> call.function_name >> body;
+    // the command id of the batch, so that every call can be cancelled
+    call.properties = batch.properties;
+    call.body = body.data();
+    call.bodylen = body.size();
+    // the body is owned by the string; do not let the message free it
+    call.zmqbodyused = true;
+
+    reply_message call_rep;
+    execute_call(call, call_rep);
+    // Report whether cancellation was checked (and heeded) by any call, as
+    // the client does for a single call.
+    auto cancel = call_rep.properties.find("cancel");
+    if (cancel != call_rep.properties.end() &&
+        (rep.properties.count("cancel") == 0 || cancel->second == "true")) {
+      rep.properties["cancel"] = cancel->second;
+    }
+    oarc << (size_t)call_rep.status << call_rep.properties
+         << std::string(call_rep.body != NULL ? call_rep.body : "", call_rep.bodylen);
+  }
+  // Pad the buffer to even; see execute_call
+  if (oarc.off & 1) oarc.write(" ", 1);
+  rep.status = reply_status::OK;
+  rep.properties.insert({CALL_BATCH_PROPERTY, "1"});
+  rep.body = oarc.buf;
+  rep.bodylen = oarc.off;
+}
+
+void comm_server::execute_call(call_message& call, reply_message& rep) {
   // find the object ID
   {
     boost::lock_guard<boost::mutex> guard(registered_object_lock);
@@ -193,8 +239,7 @@ bool comm_server::callback(nanosockets::zmq_msg_vector& recv,
       logstream(LOG_ERROR) << ret << std::endl;
       rep.copy_body_from(ret);
       rep.status = reply_status::NO_OBJECT;
-      rep.emit(reply);
-      return true;
+      return;
     }
   }
   //
@@ -204,8 +249,7 @@ bool comm_server::callback(nanosockets::zmq_msg_vector& recv,
     logstream(LOG_ERROR) << ret << std::endl;
     rep.copy_body_from(ret);
     rep.status = reply_status::NO_FUNCTION;
-    rep.emit(reply);
-    return true;
+    return;
   }
 
   std::string trimmed_function_name;
@@ -324,9 +368,6 @@ bool comm_server::callback(nanosockets::zmq_msg_vector& recv,
     get_srv_running_command().store(0);
     cancel_checked.store(false);
   }
-
-  rep.emit(reply);
-  return true;
 }
 
 /**
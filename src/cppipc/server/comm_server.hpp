@@ -155,6 +155,12 @@ class EXPORT comm_server {
   /// Internal callback for messages received from zeromq
   bool callback(nanosockets::zmq_msg_vector& recv, nanosockets::zmq_msg_vector& reply);
 
+  /// Executes a call, filling in its reply
+  void execute_call(call_message& call, reply_message& rep);
+
+  /// Executes the calls of a batch (see call_batch) in order
+  void execute_call_batch(call_message& batch, reply_message& rep);
+
   std::map<std::string, dispatch*> dispatch_map;
   boost::mutex registered_object_lock;
   std::map<size_t, std::shared_ptr<void>> registered_objects; 
@@ -8,6 +8,8 @@
 #include <string>
 #include <iostream>
 #include <boost/algorithm/string.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include <globals/globals.hpp>
 #include <zookeeper_util/key_value.hpp>
 #include <fault/sockets/async_reply_socket.hpp>
 #include <fault/sockets/publish_socket.hpp>
@@ -20,16 +22,36 @@
 #include <fault/message_flags.hpp>
 namespace libfault {
 
+size_t QO_SERVER_GROUP_COMMIT_MAX_LATENCY_US = 0;
+
+REGISTER_GLOBAL(int64_t, QO_SERVER_GROUP_COMMIT_MAX_LATENCY_US, true);
+
+size_t QO_SERVER_GROUP_COMMIT_MAX_BATCH = 256;
+
+REGISTER_GLOBAL_WITH_CHECKS(int64_t,
+                            QO_SERVER_GROUP_COMMIT_MAX_BATCH,
+                            true,
+                            +[](int64_t val){ return val >= 1; });
+
+size_t QO_SERVER_NUM_REPLY_THREADS = 4;
+
+REGISTER_GLOBAL_WITH_CHECKS(int64_t,
+                            QO_SERVER_NUM_REPLY_THREADS,
+                            true,
+                            +[](int64_t val){ return val >= 1; });
+
 query_object_server_master::query_object_server_master(void* zmq_ctx,
                                                        turi::zookeeper_util::key_value* zk_keyval,
                                                        std::string _objectkey,
                                                        query_object* _qobj) {
   objectkey = _objectkey;
   qobj = _qobj;
+  commit_in_progress = false;
   repsock = new async_reply_socket(zmq_ctx, zk_keyval,
                                    boost::bind(&query_object_server_master::master_reply_callback,
                                                this,
-                                               _1, _2));
+                                               _1, _2),
+                                   QO_SERVER_NUM_REPLY_THREADS);
 
   pubsock = new publish_socket(zmq_ctx, zk_keyval);
   repsock->register_key(objectkey);
@@ -49,11 +71,21 @@ bool query_object_server_master::master_reply_callback(zmq_msg_vector& recv,
                                                        zmq_msg_vector& reply) {
   bool hasreply = false;
   reply.clear();
-  uint64_t version = qobj->get_version();
 
   query_object_message qrecv;
   qobj->parse_message(recv, qrecv);
 
+  if (qrecv.header.flags & QO_MESSAGE_FLAG_UPDATE) {
+    pending_update update;
+    update.recv = &recv;
+    update.msg = &qrecv;
+    update.reply = &reply;
+    update.hasreply = false;
+    update.done = false;
+    group_commit(update);
+    return update.hasreply;
+  }
+
   bool is_shared_lock = false;
   if (qrecv.header.flags & QO_MESSAGE_FLAG_QUERY) {
     query_obj_rwlock.lock_shared();
@@ -62,19 +94,7 @@ bool query_object_server_master::master_reply_callback(zmq_msg_vector& recv,
     query_obj_rwlock.lock();
     is_shared_lock = false;
   }
-  bool changed = qobj->process_message(qrecv, reply, &hasreply);
-  // if this is the master object
-  if (changed) {
-    // push out of publish socket. Attach a version number to the head
-    // this is the version BEFORE the message
-    zmq_msg_t* msg = recv.insert_front();
-    zmq_msg_init_size(msg, sizeof(version));
-    (*(size_t*)zmq_msg_data(msg)) = version;
-    pubsock->send(recv);
-    recv.pop_front();
-  }
-
-  // we must release the lock only after we send out the pub socket
+  qobj->process_message(qrecv, reply, &hasreply);
   if (is_shared_lock) {
     query_obj_rwlock.unlock_shared();
   } else {
@@ -85,6 +105,83 @@ bool query_object_server_master::master_reply_callback(zmq_msg_vector& recv,
 }
 
 
+void query_object_server_master::group_commit(pending_update& update) {
+  boost::unique_lock<boost::mutex> guard(commit_lock);
+  commit_queue.push_back(&update);
+  // wakes up a leader waiting for its batch to fill
+  commit_cond.notify_all();
+
+  while (!update.done) {
+    if (commit_in_progress) {
+      commit_cond.wait(guard);
+      continue;
+    }
+    // become the leader of the next batch
+    commit_in_progress = true;
+    // no more updates than reply threads can be queued at once
+    size_t max_batch = std::min(QO_SERVER_GROUP_COMMIT_MAX_BATCH,
+                                QO_SERVER_NUM_REPLY_THREADS);
+    if (QO_SERVER_GROUP_COMMIT_MAX_LATENCY_US > 0) {
+      boost::system_time deadline =
+          boost::get_system_time() +
+          boost::posix_time::microseconds(QO_SERVER_GROUP_COMMIT_MAX_LATENCY_US);
+      while (commit_queue.size() < max_batch) {
+        if (!commit_cond.timed_wait(guard, deadline)) break;
+      }
+    }
+    std::vector<pending_update*> batch;
+    if (commit_queue.size() <= QO_SERVER_GROUP_COMMIT_MAX_BATCH) {
+      batch.swap(commit_queue);
+    } else {
+      batch.assign(commit_queue.begin(),
+                   commit_queue.begin() + QO_SERVER_GROUP_COMMIT_MAX_BATCH);
+      commit_queue.erase(commit_queue.begin(),
+                         commit_queue.begin() + QO_SERVER_GROUP_COMMIT_MAX_BATCH);
+    }
+    guard.unlock();
+    apply_batch(batch);
+    guard.lock();
+
+    for (pending_update* u : batch) u->done = true;
+    commit_in_progress = false;
+    // wakes up the threads of the batch, and the next leader
+    commit_cond.notify_all();
+  }
+}
+
+
+void query_object_server_master::apply_batch(std::vector<pending_update*>& batch) {
+  query_obj_rwlock.lock();
+  uint64_t version = qobj->get_version();
+
+  // the message parts of the updates which changed the object
+  zmq_msg_vector changes;
+  uint64_t num_changes = 0;
+  for (pending_update* u : batch) {
+    bool changed = qobj->process_message(*(u->msg), *(u->reply), &(u->hasreply));
+    if (changed) {
+      for (size_t i = 0; i < u->recv->size(); ++i) {
+        changes.insert_back(*((*(u->recv))[i]));
+      }
+      ++num_changes;
+    }
+  }
+
+  if (num_changes > 0) {
+    // push out of publish socket. Attach the version BEFORE the batch and
+    // the number of updates to the head
+    zmq_msg_t* msg = changes.insert_front();
+    zmq_msg_init_size(msg, 2 * sizeof(uint64_t));
+    ((uint64_t*)zmq_msg_data(msg))[0] = version;
+    ((uint64_t*)zmq_msg_data(msg))[1] = num_changes;
+    pubsock->send(changes);
+  }
+
+  // we must release the lock only after we send out the pub socket
+  query_obj_rwlock.unlock();
+}
+
+
 
 int query_object_server_master::start() {
   pollset.start_poll_thread();
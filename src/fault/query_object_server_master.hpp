@@ -11,6 +11,8 @@
 #include <iostream>
 #include <boost/algorithm/string.hpp>
 #include <boost/thread/shared_mutex.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
 #include <zookeeper_util/key_value.hpp>
 #include <fault/sockets/async_reply_socket.hpp>
 #include <fault/sockets/publish_socket.hpp>
@@ -19,8 +21,39 @@
 #include <fault/zmq/zmq_msg_vector.hpp>
 namespace libfault {
 
+/**
+ * The longest time (in microseconds) an update waits for other updates to
+ * join its batch before the batch is applied. 0 (the default) adds no
+ * latency: a batch then holds the updates which arrived while the previous
+ * batch was being applied.
+ */
+extern size_t QO_SERVER_GROUP_COMMIT_MAX_LATENCY_US;
+
+/**
+ * The maximum number of updates applied and replicated as one batch.
+ */
+extern size_t QO_SERVER_GROUP_COMMIT_MAX_BATCH;
+
+/**
+ * The number of threads of a master which process messages, and so the
+ * maximum number of concurrent updates which can join a batch.
+ */
+extern size_t QO_SERVER_NUM_REPLY_THREADS;
+
 /**
  * \ingroup fault
+ *
+ * Updates are group committed: concurrent updates are queued, and one of
+ * the threads processing them (the leader) applies the whole queue under a
+ * single acquisition of the write lock, then publishes the updates which
+ * changed the object to the replicas as a single batch message. The
+ * threads reply to their clients once the batch containing their update
+ * has been applied.
+ *
+ * A batch is published as a header of two uint64_t, the version of the
+ * object before the batch and the number of updates, followed by the
+ * message parts of every update. Each update in a batch increments the
+ * version by exactly 1.
  */
 struct query_object_server_master {
 
@@ -35,6 +68,20 @@ struct query_object_server_master {
 
   socket_receive_pollset pollset;
 
+  /// An update waiting in the group commit queue
+  struct pending_update {
+    zmq_msg_vector* recv;
+    query_object_message* msg;
+    zmq_msg_vector* reply;
+    bool hasreply;
+    bool done;
+  };
+
+  boost::mutex commit_lock;
+  boost::condition_variable commit_cond;
+  std::vector<pending_update*> commit_queue;
+  bool commit_in_progress;
+
   query_object_server_master(void* zmq_ctx,
                              turi::zookeeper_util::key_value* zk_keyval,
                              std::string objectkey,
@@ -46,6 +93,13 @@ struct query_object_server_master {
                              zmq_msg_vector& reply);
 
   int start();
+
+ private:
+  /// Queues the update and returns once its batch has been applied.
+  void group_commit(pending_update& update);
+
+  /// Applies a batch of updates, and publishes the ones which changed the object.
+  void apply_batch(std::vector<pending_update*>& batch);
 };
 
 
@@ -124,19 +124,39 @@ int query_object_server_replica::start() {
 
 void query_object_server_replica::playback_recorded_messages(){
   for (size_t i = 0;i < buffered_messages.size(); ++i) {
-    uint64_t version = (*(size_t*)zmq_msg_data(buffered_messages[i].front()));
-    if (version >= qobj->version) {
-      buffered_messages[i].pop_front();
-      zmq_msg_vector ignored_reply;
-      bool hasreply = false;
-      qobj->message_wrapper(buffered_messages[i], ignored_reply,
-                            &hasreply, QO_MESSAGE_FLAG_NOREPLY);
-    }
+    apply_batch(buffered_messages[i]);
   }
   buffered_messages.clear();
 }
 
 
+void query_object_server_replica::apply_batch(zmq_msg_vector& recv) {
+  // the head of a batch is the version of the object before the batch and
+  // the number of updates in the batch. See query_object_server_master.
+  assert(zmq_msg_size(recv.front()) == 2 * sizeof(uint64_t));
+  uint64_t version = ((uint64_t*)zmq_msg_data(recv.front()))[0];
+  uint64_t num_updates = ((uint64_t*)zmq_msg_data(recv.front()))[1];
+  recv.pop_front();
+
+  query_obj_rwlock.lock();
+  if (version > qobj->version) {
+    std::cout << "Slave master version divergence\n";
+  }
+  for (uint64_t i = 0; i < num_updates; ++i) {
+    query_object_message qrecv;
+    qobj->parse_message(recv, qrecv);
+    // updates already contained in the snapshot are skipped
+    if (version + i < qobj->version) continue;
+    // set the no reply flag
+    qrecv.header.flags |= QO_MESSAGE_FLAG_NOREPLY;
+    bool hasreply = false;
+    zmq_msg_vector ignored_reply;
+    qobj->process_message(qrecv, ignored_reply, &hasreply);
+  }
+  query_obj_rwlock.unlock();
+}
+
+
 bool query_object_server_replica::replica_reply_callback(zmq_msg_vector& recv,
                                                          zmq_msg_vector& reply) {
   bool hasreply = false;
@@ -170,42 +190,10 @@ bool query_object_server_replica::replica_reply_callback(zmq_msg_vector& recv,
 bool query_object_server_replica::subscribe_callback(zmq_msg_vector& recv) {
   if (waiting_for_snapshot) {
     buffered_messages.push_back(recv);
-    return false;
   } else {
-    assert(zmq_msg_size(recv.front()) == sizeof(uint64_t));
-    uint64_t version = (*(size_t*)zmq_msg_data(recv.front()));
-    if (version != qobj->version) {
-      std::cout << "Slave master version divergence\n";
-    }
-    recv.pop_front();
-    bool hasreply = false;
-    zmq_msg_vector ignored_reply;
-
-    // parse the message to determine if it a query or an update
-    // (thus read lock, or write lock)
-    query_object_message qrecv;
-    qobj->parse_message(recv, qrecv);
-
-    bool is_shared_lock = false;
-    if (qrecv.header.flags & QO_MESSAGE_FLAG_QUERY) {
-      query_obj_rwlock.lock_shared();
-      is_shared_lock = true;
-    } else {
-      query_obj_rwlock.lock();
-      is_shared_lock = false;
-    }
-    // set the no reply flag
-    qrecv.header.flags |= QO_MESSAGE_FLAG_NOREPLY;
-    qobj->process_message(qrecv, ignored_reply, &hasreply);
-
-    // release the lcok
-    if (is_shared_lock) {
-      query_obj_rwlock.unlock_shared();
-    } else {
-      query_obj_rwlock.unlock();
-    }
-    return false;
+    apply_batch(recv);
   }
+  return false;
 }
 
 
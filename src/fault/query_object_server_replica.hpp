@@ -59,6 +59,9 @@ struct query_object_server_replica {
 
   void playback_recorded_messages();
 
+  /// Applies a batch of updates published by the master
+  void apply_batch(zmq_msg_vector& recv);
+
 
   void keyval_change(turi::zookeeper_util::key_value* unused,
                      const std::vector<std::string>& newkeys,
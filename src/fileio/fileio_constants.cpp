@@ -119,6 +119,9 @@ static bool check_cache_file_hdfs_location(std::string val) {
 EXPORT const size_t FILEIO_INITIAL_CAPACITY_PER_FILE = 1024;
 EXPORT size_t FILEIO_MAXIMUM_CACHE_CAPACITY_PER_FILE = 128 * 1024 * 1024;
 EXPORT size_t FILEIO_MAXIMUM_CACHE_CAPACITY = 2LL * 1024 * 1024 * 1024;
+EXPORT size_t FILEIO_MEMORY_BUDGET = 0;
+EXPORT size_t FILEIO_CACHE_SPILL_HIGH_WATERMARK = 90;
+EXPORT size_t FILEIO_CACHE_SPILL_LOW_WATERMARK = 75;
 EXPORT size_t FILEIO_READER_BUFFER_SIZE = 16 * 1024;
 EXPORT size_t FILEIO_WRITER_BUFFER_SIZE = 96 * 1024;
 EXPORT std::string S3_ENDPOINT;
@@ -127,6 +130,15 @@ EXPORT int64_t NUM_GPUS = -1;
 
 REGISTER_GLOBAL(int64_t, FILEIO_MAXIMUM_CACHE_CAPACITY, true);
 REGISTER_GLOBAL(int64_t, FILEIO_MAXIMUM_CACHE_CAPACITY_PER_FILE, true)
+REGISTER_GLOBAL(int64_t, FILEIO_MEMORY_BUDGET, true);
+REGISTER_GLOBAL_WITH_CHECKS(int64_t,
+                            FILEIO_CACHE_SPILL_HIGH_WATERMARK,
+                            true,
+                            +[](int64_t val){ return val > 0 && val <= 100; });
+REGISTER_GLOBAL_WITH_CHECKS(int64_t,
+                            FILEIO_CACHE_SPILL_LOW_WATERMARK,
+                            true,
+                            +[](int64_t val){ return val >= 0 && val <= 100; });
 REGISTER_GLOBAL(int64_t, FILEIO_READER_BUFFER_SIZE, false);
 REGISTER_GLOBAL(int64_t, FILEIO_WRITER_BUFFER_SIZE, false);
 REGISTER_GLOBAL(std::string, S3_ENDPOINT, true);
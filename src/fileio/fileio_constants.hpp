@@ -67,6 +67,28 @@ extern size_t FILEIO_MAXIMUM_CACHE_CAPACITY_PER_FILE;
  */
 extern size_t FILEIO_MAXIMUM_CACHE_CAPACITY;
 
+/**
+ * \ingroup fileio
+ * The memory shared by sort, groupby, join and the caches, in bytes (see
+ * \ref memory_budget). 0 means unlimited.
+ */
+extern size_t FILEIO_MEMORY_BUDGET;
+
+/**
+ * \ingroup fileio
+ * When the memory used by all cached files exceeds this percentage of
+ * FILEIO_MAXIMUM_CACHE_CAPACITY, idle cached files are flushed to disk in the
+ * background, least recently used first.
+ */
+extern size_t FILEIO_CACHE_SPILL_HIGH_WATERMARK;
+
+/**
+ * \ingroup fileio
+ * Background flushing of cached files stops once the memory used by all
+ * cached files is below this percentage of FILEIO_MAXIMUM_CACHE_CAPACITY.
+ */
+extern size_t FILEIO_CACHE_SPILL_LOW_WATERMARK;
+
 /**
  * \ingroup fileio
  * The default fileio reader buffer size
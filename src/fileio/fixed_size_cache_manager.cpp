@@ -5,7 +5,9 @@
  */
 #include <fileio/fileio_constants.hpp>
 #include <fileio/fixed_size_cache_manager.hpp>
+#include <fileio/memory_budget.hpp>
 #include <logger/assertions.hpp>
+#include <parallel/atomic_ops.hpp>
 #include <iostream>
 #include <iomanip>
 
@@ -13,6 +15,9 @@
 namespace turi {
 
 namespace fileio {
+
+  /// The name of the cache in the memory budget.
+  static const char BUDGET_CONSUMER[] = "fileio_cache";
 /*************************************************************************/
 /*                                                                       */
 /*                         Cache Block implementation                    */
@@ -35,16 +40,12 @@ namespace fileio {
       // try to double up to maximum capacity
       new_capacity = std::max(new_capacity, capacity * 2);
       new_capacity = std::min(new_capacity, maximum_capacity);
-      size_t current_cache_utilization = owning_cache_manager->get_cache_utilization();
-      // will we exceed capacity?
-      if (current_cache_utilization + (new_capacity - capacity) > 
-          FILEIO_MAXIMUM_CACHE_CAPACITY) {
-
+      // reserve the additional memory. will we exceed capacity?
+      if (!owning_cache_manager->try_reserve_utilization(new_capacity - capacity)) {
         // resizing will cause us to go over the maximum cache limit
         // try again with the minimal queried size.
         new_capacity = queried_capacity;
-        if (current_cache_utilization + (new_capacity - capacity) > 
-            FILEIO_MAXIMUM_CACHE_CAPACITY) {
+        if (!owning_cache_manager->try_reserve_utilization(new_capacity - capacity)) {
           // yup. we will still exceed capacity. FAIL.
           return false;
         }
@@ -52,11 +53,11 @@ namespace fileio {
       // realloc
       char* newdata = (char*)realloc(data, new_capacity);
       if (newdata == nullptr) {
-        // failed failed to realloc
+        // failed failed to realloc. Give back the reservation.
+        owning_cache_manager->decrement_utilization((ssize_t)new_capacity - (ssize_t)capacity);
         return false;
       }
       data = newdata;
-      owning_cache_manager->increment_utilization((ssize_t)new_capacity - (ssize_t)capacity);
       capacity = new_capacity;
       return true;
     } else {
@@ -132,13 +133,19 @@ namespace fileio {
    return *instance;
  }
 
-  fixed_size_cache_manager::fixed_size_cache_manager() { }
+  fixed_size_cache_manager::fixed_size_cache_manager() {
+    reclaimer_id = memory_budget::get_instance().register_reclaimer(
+        BUDGET_CONSUMER, [this](size_t bytes) { request_spill(bytes); });
+  }
 
   fixed_size_cache_manager::~fixed_size_cache_manager() {
+    memory_budget::get_instance().unregister_reclaimer(reclaimer_id);
+    stop_spill_thread();
     clear();
   }
 
  EXPORT void fixed_size_cache_manager::clear() {
+    std::lock_guard<turi::mutex> lck(mutex);
     cache_blocks.clear();
   }
 
@@ -173,6 +180,7 @@ namespace fileio {
                            << " Capacity = " << new_entry_max_capacity << std::endl;
 
       std::shared_ptr<cache_block> block(new cache_block(cache_id, new_entry_max_capacity, this));
+      block->last_access = ++access_clock;
       cache_blocks[cache_id] = block;
       return block;
     } else {
@@ -181,12 +189,18 @@ namespace fileio {
       // we need to clear the content of the block.
       auto iter = cache_blocks.find(cache_id);
       std::shared_ptr<cache_block> block = iter->second;
-      // if its a pointer. we just reuse it. 
-      if (block->is_pointer()) {
+      if (block->spilling) {
+        // the spill thread is reading the old contents. Leave them to it;
+        // it will discard them since the block is no longer registered.
+        block.reset(new cache_block(cache_id, new_entry_max_capacity, this));
+        iter->second = block;
+      } else if (block->is_pointer()) {
+        // if its a pointer. we just reuse it.
         block->initialize_memory(block->maximum_capacity);
       } else {
         block->initialize_memory(new_entry_max_capacity);
       }
+      block->last_access = ++access_clock;
       return block;
     }
   }
@@ -203,45 +217,194 @@ namespace fileio {
   std::shared_ptr<cache_block> fixed_size_cache_manager::get_cache(cache_id_type cache_id) {
     logstream(LOG_DEBUG) << "Get cache block " << cache_id << std::endl;
     std::lock_guard<turi::mutex> lck(mutex);
-    if (cache_blocks.find(cache_id) != cache_blocks.end()) {
-      return cache_blocks[cache_id];
+    auto iter = cache_blocks.find(cache_id);
+    if (iter != cache_blocks.end()) {
+      iter->second->last_access = ++access_clock;
+      return iter->second;
+    }
+    throw std::out_of_range("Cannot find cache block with id " + cache_id);
+  }
+
+  bool fixed_size_cache_manager::is_in_memory(cache_id_type cache_id) {
+    std::lock_guard<turi::mutex> lck(mutex);
+    auto iter = cache_blocks.find(cache_id);
+    if (iter != cache_blocks.end()) {
+      return iter->second->is_pointer();
     }
     throw std::out_of_range("Cannot find cache block with id " + cache_id);
   }
 
   void fixed_size_cache_manager::increment_utilization(ssize_t increment) {
+    memory_budget::get_instance().acquire(BUDGET_CONSUMER, increment);
     current_cache_utilization.inc(increment);
+    request_spill_if_needed();
+  }
+
+  bool fixed_size_cache_manager::try_reserve_utilization(size_t increment) {
+    auto& budget = memory_budget::get_instance();
+    if (!budget.try_acquire(BUDGET_CONSUMER, increment)) return false;
+    size_t current = current_cache_utilization.value;
+    while (current + increment <= FILEIO_MAXIMUM_CACHE_CAPACITY) {
+      size_t previous = atomic_compare_and_swap_val(current_cache_utilization.value,
+                                                    current, current + increment);
+      if (previous == current) {
+        request_spill_if_needed();
+        return true;
+      }
+      current = previous;
+    }
+    budget.release(BUDGET_CONSUMER, increment);
+    return false;
   }
 
   void fixed_size_cache_manager::decrement_utilization(ssize_t increment) {
     current_cache_utilization.dec(increment);
+    memory_budget::get_instance().release(BUDGET_CONSUMER, increment);
   }
 
-  void fixed_size_cache_manager::try_cache_evict() {
+  std::shared_ptr<cache_block> fixed_size_cache_manager::find_eviction_candidate() {
     // lock must be acquired outside of this call
     ASSERT_FALSE(mutex.try_lock());
-    // we will try to evict the largest
-    std::string largest_entry_name;
-    std::shared_ptr<cache_block> largest_block;
-    size_t current_largest_block_size = 0;
+    std::shared_ptr<cache_block> ret;
     for (auto& iter: cache_blocks) {
+      const auto& block = iter.second;
       // we can only evict if we are the only pointers to the cache block
-      if (iter.second.unique() && iter.second->is_pointer()) {
-        if (iter.second->get_pointer_size() > current_largest_block_size) {
-          largest_entry_name = iter.first;
-          largest_block = iter.second;
-          current_largest_block_size = largest_block->get_pointer_size();
-        }
+      if (block.unique() && block->is_pointer() && !block->spilling &&
+          block->get_pointer_size() > 0) {
+        if (!ret || block->last_access < ret->last_access) ret = block;
       }
     }
-    if (largest_block) {
-      logstream_ontick(5, LOG_INFO) << "Evicting " << largest_entry_name 
-                          << " with size " << current_largest_block_size << std::endl;
-      largest_block->write_to_file();
+    return ret;
+  }
+
+  void fixed_size_cache_manager::try_cache_evict() {
+    // lock must be acquired outside of this call
+    ASSERT_FALSE(mutex.try_lock());
+    // we will try to evict the least recently used
+    std::shared_ptr<cache_block> block = find_eviction_candidate();
+    if (block) {
+      logstream_ontick(5, LOG_INFO) << "Evicting " << block->cache_id
+                          << " with size " << block->get_pointer_size() << std::endl;
+      block->write_to_file();
       logstream_ontick(5, LOG_INFO) << "Cache Utilization:" << get_cache_utilization()
                                     << std::endl;
     }
   }
+
+  void fixed_size_cache_manager::request_spill_if_needed() {
+    size_t high_watermark =
+        FILEIO_MAXIMUM_CACHE_CAPACITY / 100 * FILEIO_CACHE_SPILL_HIGH_WATERMARK;
+    if (current_cache_utilization.value <= high_watermark) return;
+    request_spill(0);
+  }
+
+  void fixed_size_cache_manager::request_spill(size_t reclaim_bytes) {
+    std::lock_guard<turi::mutex> lck(spill_mutex);
+    spill_reclaim_bytes = std::max(spill_reclaim_bytes, reclaim_bytes);
+    if (spill_thread_stop || spill_requested) return;
+    if (!spill_thread_started) {
+      spill_thread.launch([this]() { spill_thread_loop(); });
+      spill_thread_started = true;
+    }
+    spill_requested = true;
+    spill_cond.broadcast();
+  }
+
+  bool fixed_size_cache_manager::spill_one_block() {
+    std::shared_ptr<cache_block> block;
+    {
+      std::lock_guard<turi::mutex> lck(mutex);
+      block = find_eviction_candidate();
+      if (!block) return false;
+      block->spilling = true;
+    }
+
+    // Nobody else references the block, and new_cache() replaces it rather
+    // than reusing its memory while spilling is set, so its contents cannot
+    // change while we write them out.
+    size_t size = block->size;
+    std::string filename = get_temp_name_prefer_hdfs();
+    bool written = false;
+    try {
+      fileio_impl::general_fstream_sink fout(filename);
+      fout.write(block->data, size);
+      written = fout.good();
+      fout.close();
+    } catch (...) {
+      logstream(LOG_WARNING) << "Failed to spill cache block " << block->cache_id
+                             << " to " << filename << std::endl;
+    }
+
+    bool committed = false;
+    {
+      std::lock_guard<turi::mutex> lck(mutex);
+      block->spilling = false;
+      auto iter = cache_blocks.find(block->cache_id);
+      // only switch to the file if the block is still registered, still idle
+      // (referenced by the map and by us), and unchanged.
+      if (written && iter != cache_blocks.end() && iter->second == block &&
+          block.use_count() == 2 && block->is_pointer() && block->size == size) {
+        logstream(LOG_DEBUG) << "Spilled " << block->cache_id << " to "
+                             << filename << std::endl;
+        block->release_memory();
+        block->filename = filename;
+        committed = true;
+      }
+    }
+    if (!committed) {
+      try {
+        delete_temp_file(filename);
+      } catch (...) { }
+    }
+    return true;
+  }
+
+  void fixed_size_cache_manager::spill_thread_loop() {
+    size_t reclaim_bytes = 0;
+    while (true) {
+      {
+        std::unique_lock<turi::mutex> lck(spill_mutex);
+        spill_in_progress = false;
+        spill_cond.broadcast();
+        while (!spill_requested && !spill_thread_stop) spill_cond.wait(lck);
+        if (spill_thread_stop) return;
+        spill_requested = false;
+        spill_in_progress = true;
+        reclaim_bytes = spill_reclaim_bytes;
+        spill_reclaim_bytes = 0;
+      }
+      size_t low_watermark =
+          FILEIO_MAXIMUM_CACHE_CAPACITY / 100 * FILEIO_CACHE_SPILL_LOW_WATERMARK;
+      size_t utilization = get_cache_utilization();
+      // release what the memory budget asked for, if that goes further
+      if (reclaim_bytes > 0) {
+        low_watermark = std::min(low_watermark,
+                                 utilization > reclaim_bytes ? utilization - reclaim_bytes : 0);
+      }
+      logstream(LOG_DEBUG) << "Spilling cache blocks. Cache Utilization: "
+                           << utilization << std::endl;
+      while (get_cache_utilization() > low_watermark) {
+        if (!spill_one_block()) break;
+      }
+    }
+  }
+
+  void fixed_size_cache_manager::stop_spill_thread() {
+    {
+      std::lock_guard<turi::mutex> lck(spill_mutex);
+      spill_thread_stop = true;
+      spill_cond.broadcast();
+      if (!spill_thread_started) return;
+    }
+    spill_thread.join();
+  }
+
+ EXPORT void fixed_size_cache_manager::wait_for_spill() {
+    std::unique_lock<turi::mutex> lck(spill_mutex);
+    while ((spill_requested || spill_in_progress) && !spill_thread_stop) {
+      spill_cond.wait(lck);
+    }
+  }
 } // end of fileio
 
 } // end of turicreate
@@ -142,6 +142,12 @@ struct cache_block {
   std::string filename;
   // the cache manager which created this block
   fixed_size_cache_manager* owning_cache_manager = NULL;
+  // value of the cache manager access clock when the block was last
+  // created or fetched. Protected by the cache manager lock.
+  size_t last_access = 0;
+  // true while the background spill thread is writing the block to disk.
+  // Protected by the cache manager lock.
+  bool spilling = false;
 
   /**
    * Clears, and reinitializes the cache block with a new maximum capacity.
@@ -176,20 +182,42 @@ struct cache_block {
  *      FILEIO_INITIAL_CACHE_CAPACITY_PER_FILE. Then as more memory is allocated for the
  *      cache, then utilization is incremented again.
  *    - If there is < FILEIO_MAXIMUM_CACHE_CAPACITY_PER_FILE free bytes available:
- *      The largest cache block is evicted. If there is 
- *      FILEIO_MAXIMUM_CACHE_CAPACITY_PER_FILE free bytes, Goto the first case.
- *      Otherwise, create a new cache block with all the remaining free bytes.
+ *      create a new cache block with all the remaining free bytes. If the
+ *      cache is entirely full, the least recently used idle cache block is
+ *      first evicted synchronously.
+ *
+ *  Background Spilling
+ *  -------------------
+ *  Synchronous eviction is a last resort. Whenever utilization exceeds
+ *  FILEIO_CACHE_SPILL_HIGH_WATERMARK percent of the maximum capacity, a
+ *  background spill thread is woken up. It flushes idle in-memory cache
+ *  blocks (blocks nobody holds a reference to) to disk, least recently used
+ *  first, until utilization drops below FILEIO_CACHE_SPILL_LOW_WATERMARK
+ *  percent of the maximum. The block is written to disk without holding the
+ *  manager lock, and only switched to the file if nobody touched the block
+ *  in the meantime; otherwise the file is discarded.
  *
  *  The relevant constants are thus:
  *   FILEIO_MAXIMUM_CACHE_CAPACITY : the maximum total size of all cache blocks
  *   FILEIO_MAXIMUM_CACHE_CAPACITY_PER_FILE : the maximum size of each cache blocks
  *   FILEIO_INITIAL_CAPACITY_PER_FILE : the initial size of each cache blocks
+ *   FILEIO_CACHE_SPILL_HIGH_WATERMARK / FILEIO_CACHE_SPILL_LOW_WATERMARK :
+ *     the utilization percentages starting and stopping background spilling
+ *
+ *  Memory Budget
+ *  -------------
+ *  The utilization is charged to the "fileio_cache" consumer of the
+ *  \ref memory_budget. Cache blocks do not grow past what the budget
+ *  grants, and stay on disk instead. When another consumer is short of
+ *  memory, the spill thread is woken up to release what it asked for.
  *
  *  Overcommit Behavior
  *  -------------------
- *  We try our best to maintain cache utilization below the maximum. However,
- *  it is possible to exceed maximum cache utilization under certain race
- *  conditions since we avoid locking on the cache utilization counter.
+ *  Growing a cache block reserves the additional memory with a compare and
+ *  swap on the utilization counter, so growth never exceeds the maximum.
+ *  Only the FILEIO_INITIAL_CAPACITY_PER_FILE bytes given to every new
+ *  block are charged unconditionally, and may overcommit slightly when many
+ *  blocks are created concurrently.
  */
 class fixed_size_cache_manager {
 
@@ -220,6 +248,16 @@ class fixed_size_cache_manager {
    */
   std::shared_ptr<cache_block> get_cache(cache_id_type cache_id);
 
+  /**
+   * Returns true if the cache block associated with the cache_id is held
+   * in memory, false if it was spilled to disk. Unlike \ref get_cache, this
+   * does not count as a use of the block for the eviction order.
+   * Throws std::out_of_range if the cache_id does not exist.
+   *
+   * Thread safe.
+   */
+  bool is_in_memory(cache_id_type cache_id);
+
   /**
    * Free the data in the cache block. Delete the allocated memory or temp file
    * associated with the cache. 
@@ -233,6 +271,12 @@ class fixed_size_cache_manager {
    */
   void clear();
 
+  /**
+   * Blocks until the background spill thread has no pending work.
+   * Mainly for testing.
+   */
+  void wait_for_spill();
+
   /**
    * Returns the amount of memory being used by the caches.
    */
@@ -258,6 +302,24 @@ class fixed_size_cache_manager {
 
   turi::mutex mutex;
   std::unordered_map<std::string, std::shared_ptr<cache_block> > cache_blocks;
+  // Incremented on every cache block creation or lookup, to order the
+  // blocks by recency. Protected by mutex.
+  size_t access_clock = 0;
+
+  // State of the background spill thread. Protected by spill_mutex, which
+  // may be acquired while holding mutex, but not the other way around.
+  turi::mutex spill_mutex;
+  turi::conditional spill_cond;
+  thread spill_thread;
+  bool spill_thread_started = false;
+  bool spill_requested = false;
+  bool spill_in_progress = false;
+  bool spill_thread_stop = false;
+  // Bytes other consumers of the memory budget asked us to release.
+  size_t spill_reclaim_bytes = 0;
+
+  // ID of our reclaim function in the memory budget.
+  size_t reclaimer_id = 0;
 
   /**
    * Increments cache utilization counter
@@ -268,12 +330,55 @@ class fixed_size_cache_manager {
    */
   void decrement_utilization(ssize_t decrement);
 
+  /**
+   * Atomically adds increment to the utilization if the result does not
+   * exceed FILEIO_MAXIMUM_CACHE_CAPACITY, and the memory budget grants it.
+   * Returns true on success.
+   */
+  bool try_reserve_utilization(size_t increment);
+
   /**
    * Tries to evict some stuff out of cache.
    * Lock must be acquired when this function is called.
    */
   void try_cache_evict();
 
+  /**
+   * Returns the least recently used in-memory cache block which nobody else
+   * references and is not being spilled, or an empty pointer.
+   * Lock must be acquired when this function is called.
+   */
+  std::shared_ptr<cache_block> find_eviction_candidate();
+
+  /**
+   * Wakes up the background spill thread if utilization is above the high
+   * watermark. Must not be called with spill_mutex held.
+   */
+  void request_spill_if_needed();
+
+  /**
+   * Wakes up the background spill thread to release reclaim_bytes on top of
+   * the usual spilling down to the low watermark. Must not be called with
+   * spill_mutex held.
+   */
+  void request_spill(size_t reclaim_bytes);
+
+  /**
+   * Flushes one eviction candidate to disk without holding the lock.
+   * Returns false if there was no candidate.
+   */
+  bool spill_one_block();
+
+  /**
+   * The main loop of the background spill thread.
+   */
+  void spill_thread_loop();
+
+  /**
+   * Stops and joins the spill thread.
+   */
+  void stop_spill_thread();
+
   friend struct cache_block;
 };
 
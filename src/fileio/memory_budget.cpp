@@ -0,0 +1,184 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#include <algorithm>
+#include <fileio/memory_budget.hpp>
+#include <fileio/fileio_constants.hpp>
+#include <logger/logger.hpp>
+
+namespace turi {
+namespace fileio {
+
+/**************************************************************************/
+/*                                                                        */
+/*                              reservation                               */
+/*                                                                        */
+/**************************************************************************/
+
+memory_budget::reservation::reservation(reservation&& other)
+    : m_budget(other.m_budget), m_consumer(std::move(other.m_consumer)),
+      m_size(other.m_size) {
+  other.m_budget = nullptr;
+  other.m_size = 0;
+}
+
+memory_budget::reservation&
+memory_budget::reservation::operator=(reservation&& other) {
+  if (this != &other) {
+    release();
+    m_budget = other.m_budget;
+    m_consumer = std::move(other.m_consumer);
+    m_size = other.m_size;
+    other.m_budget = nullptr;
+    other.m_size = 0;
+  }
+  return *this;
+}
+
+bool memory_budget::reservation::try_grow(size_t new_size) {
+  if (new_size <= m_size) return true;
+  if (m_budget == nullptr) return false;
+  if (!m_budget->try_acquire(m_consumer, new_size - m_size)) return false;
+  m_size = new_size;
+  return true;
+}
+
+void memory_budget::reservation::shrink(size_t new_size) {
+  if (m_budget == nullptr || new_size >= m_size) return;
+  m_budget->release(m_consumer, m_size - new_size);
+  m_size = new_size;
+}
+
+void memory_budget::reservation::release() {
+  if (m_budget != nullptr && m_size > 0) m_budget->release(m_consumer, m_size);
+  m_size = 0;
+}
+
+/**************************************************************************/
+/*                                                                        */
+/*                             memory_budget                              */
+/*                                                                        */
+/**************************************************************************/
+
+memory_budget& memory_budget::get_instance() {
+  static memory_budget* budget = new memory_budget();
+  return *budget;
+}
+
+size_t memory_budget::capacity() const {
+  return FILEIO_MEMORY_BUDGET == 0 ? (size_t)(-1) : FILEIO_MEMORY_BUDGET;
+}
+
+size_t memory_budget::used() const {
+  std::lock_guard<turi::mutex> guard(m_lock);
+  return m_used;
+}
+
+memory_budget::reservation
+memory_budget::reserve(const std::string& consumer, size_t desired,
+                       size_t minimum) {
+  size_t granted = grant(consumer, desired, std::min(minimum, desired), true);
+  if (granted < desired) {
+    logstream(LOG_INFO) << "Memory budget: " << consumer << " requested "
+                        << desired << " bytes, granted " << granted << std::endl;
+  }
+  return reservation(this, consumer, granted);
+}
+
+bool memory_budget::try_acquire(const std::string& consumer, size_t bytes) {
+  return grant(consumer, bytes, 0, false) == bytes;
+}
+
+void memory_budget::acquire(const std::string& consumer, size_t bytes) {
+  std::lock_guard<turi::mutex> guard(m_lock);
+  grant_locked(consumer, bytes);
+}
+
+void memory_budget::release(const std::string& consumer, size_t bytes) {
+  std::lock_guard<turi::mutex> guard(m_lock);
+  auto& stats = m_consumers[consumer];
+  bytes = std::min(bytes, stats.bytes);
+  stats.bytes -= bytes;
+  m_used -= bytes;
+}
+
+size_t memory_budget::available_locked() const {
+  size_t cap = capacity();
+  return m_used < cap ? cap - m_used : 0;
+}
+
+size_t memory_budget::grant(const std::string& consumer, size_t bytes,
+                            size_t minimum, bool partial) {
+  if (bytes == 0) return 0;
+  {
+    std::lock_guard<turi::mutex> guard(m_lock);
+    if (available_locked() >= bytes) return grant_locked(consumer, bytes);
+  }
+  reclaim_for(consumer, bytes);
+  std::lock_guard<turi::mutex> guard(m_lock);
+  size_t available = available_locked();
+  if (available >= bytes) return grant_locked(consumer, bytes);
+  ++m_consumers[consumer].num_denials;
+  logstream_ontick(5, LOG_INFO) << "Memory budget exhausted: " << m_used
+                                << " of " << capacity() << " bytes used"
+                                << std::endl;
+  if (!partial) return 0;
+  return grant_locked(consumer, std::max(available, minimum));
+}
+
+size_t memory_budget::grant_locked(const std::string& consumer, size_t bytes) {
+  auto& stats = m_consumers[consumer];
+  if (stats.consumer.empty()) stats.consumer = consumer;
+  stats.bytes += bytes;
+  stats.peak_bytes = std::max(stats.peak_bytes, stats.bytes);
+  m_used += bytes;
+  return bytes;
+}
+
+void memory_budget::reclaim_for(const std::string& consumer, size_t bytes) {
+  std::vector<std::function<void(size_t)>> reclaimers;
+  {
+    std::lock_guard<turi::mutex> guard(m_lock);
+    for (const auto& r : m_reclaimers) {
+      if (r.second.consumer != consumer) reclaimers.push_back(r.second.reclaim);
+    }
+  }
+  for (const auto& reclaim : reclaimers) reclaim(bytes);
+}
+
+size_t memory_budget::register_reclaimer(const std::string& consumer,
+                                         std::function<void(size_t)> reclaim) {
+  std::lock_guard<turi::mutex> guard(m_lock);
+  size_t id = m_next_reclaimer_id++;
+  m_reclaimers[id] = reclaimer{consumer, std::move(reclaim)};
+  return id;
+}
+
+void memory_budget::unregister_reclaimer(size_t reclaimer_id) {
+  std::lock_guard<turi::mutex> guard(m_lock);
+  m_reclaimers.erase(reclaimer_id);
+}
+
+std::vector<memory_budget::consumer_report> memory_budget::report() const {
+  std::lock_guard<turi::mutex> guard(m_lock);
+  std::vector<consumer_report> ret;
+  for (const auto& c : m_consumers) ret.push_back(c.second);
+  return ret;
+}
+
+void memory_budget::print_report(std::ostream& out) const {
+  size_t cap = capacity();
+  out << "Memory budget: " << used() << " bytes used of ";
+  if (cap == (size_t)(-1)) out << "unlimited";
+  else out << cap;
+  out << "\n";
+  for (const auto& c : report()) {
+    out << "  " << c.consumer << ": " << c.bytes << " bytes (peak "
+        << c.peak_bytes << "), " << c.num_denials << " requests cut short\n";
+  }
+}
+
+} // namespace fileio
+} // namespace turi
@@ -0,0 +1,175 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#ifndef FILEIO_MEMORY_BUDGET_HPP
+#define FILEIO_MEMORY_BUDGET_HPP
+#include <functional>
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+#include <parallel/mutex.hpp>
+
+namespace turi {
+namespace fileio {
+
+/**
+ * \ingroup fileio
+ *
+ * A process wide memory budget shared by the memory hungry subsystems: sort,
+ * groupby, join, the file cache (\ref fixed_size_cache_manager), the
+ * decoded block cache and the ml_data block manager.
+ *
+ * The budget holds FILEIO_MEMORY_BUDGET bytes (0 means unlimited). Each
+ * subsystem is a named consumer which requests memory before using it, and
+ * adapts to what it is granted:
+ *  - Operators (sort, groupby, join) take a \ref reservation for the
+ *    duration of the operation with \ref reserve. They get between the
+ *    minimum they need to make progress and the amount they would like, and
+ *    size their buffers (and hence how often they spill) accordingly.
+ *  - Caches charge their memory as it grows with \ref try_acquire, and keep
+ *    the data on disk or drop it when denied. They also register a reclaim
+ *    function, called when a request of another consumer falls short, which
+ *    should release (possibly asynchronously) about the given number of
+ *    bytes.
+ *  - Memory which has to be allocated anyway is charged with \ref acquire,
+ *    so that the other consumers see it.
+ *
+ * The minimum of a reservation is granted even if it overcommits the
+ * budget; \ref report lists the memory held by each consumer, its peak,
+ * and the number of requests which were cut short.
+ */
+class memory_budget {
+ public:
+  /**
+   * Memory granted to a consumer, returned to the budget on destruction.
+   * Movable, not copyable. Not thread safe.
+   */
+  class reservation {
+   public:
+    reservation() = default;
+    reservation(const reservation&) = delete;
+    reservation& operator=(const reservation&) = delete;
+    reservation(reservation&& other);
+    reservation& operator=(reservation&& other);
+    ~reservation() { release(); }
+
+    /// The number of bytes granted.
+    size_t size() const { return m_size; }
+
+    /**
+     * Grows the reservation to new_size bytes if the budget allows it.
+     * Returns false, leaving the reservation unchanged, otherwise.
+     */
+    bool try_grow(size_t new_size);
+
+    /// Shrinks the reservation to new_size bytes.
+    void shrink(size_t new_size);
+
+    /// Returns all the memory to the budget.
+    void release();
+
+   private:
+    friend class memory_budget;
+    reservation(memory_budget* budget, std::string consumer, size_t size)
+        : m_budget(budget), m_consumer(std::move(consumer)), m_size(size) { }
+    memory_budget* m_budget = nullptr;
+    std::string m_consumer;
+    size_t m_size = 0;
+  };
+
+  /// The memory held by a consumer.
+  struct consumer_report {
+    std::string consumer;
+    /// Bytes currently held
+    size_t bytes = 0;
+    /// Most bytes held at once
+    size_t peak_bytes = 0;
+    /// Number of requests which were granted less than asked for
+    size_t num_denials = 0;
+  };
+
+  /// Get singleton instance
+  static memory_budget& get_instance();
+
+  /// The size of the budget in bytes. (size_t)(-1) if unlimited.
+  size_t capacity() const;
+
+  /// The number of bytes held by all the consumers.
+  size_t used() const;
+
+  /**
+   * Reserves up to desired bytes for consumer, and at least
+   * min(minimum, desired) bytes even if that overcommits the budget.
+   */
+  reservation reserve(const std::string& consumer, size_t desired,
+                      size_t minimum = 0);
+
+  /**
+   * Charges bytes to consumer if they fit in the budget. Returns false,
+   * charging nothing, otherwise.
+   */
+  bool try_acquire(const std::string& consumer, size_t bytes);
+
+  /// Charges bytes to consumer unconditionally.
+  void acquire(const std::string& consumer, size_t bytes);
+
+  /// Returns bytes previously charged to consumer.
+  void release(const std::string& consumer, size_t bytes);
+
+  /**
+   * Registers a function which releases about the given number of bytes
+   * held by consumer. It is called without any lock of the budget held, and
+   * never for a request of the consumer itself. Returns an ID for
+   * \ref unregister_reclaimer.
+   */
+  size_t register_reclaimer(const std::string& consumer,
+                            std::function<void(size_t)> reclaim);
+
+  /// Unregisters a reclaim function.
+  void unregister_reclaimer(size_t reclaimer_id);
+
+  /// Returns the memory held by each consumer which ever requested memory.
+  std::vector<consumer_report> report() const;
+
+  /// Prints \ref report in a human readable form.
+  void print_report(std::ostream& out) const;
+
+ private:
+  memory_budget() = default;
+
+  struct reclaimer {
+    std::string consumer;
+    std::function<void(size_t)> reclaim;
+  };
+
+  mutable turi::mutex m_lock;
+  size_t m_used = 0;
+  std::map<std::string, consumer_report> m_consumers;
+  std::map<size_t, reclaimer> m_reclaimers;
+  size_t m_next_reclaimer_id = 0;
+
+  /**
+   * Grants bytes to consumer if they fit. Otherwise asks the other consumers
+   * to reclaim memory and tries again; if they still do not fit, grants what
+   * is left but at least minimum if partial is set, and nothing if not.
+   * Returns the number of bytes granted.
+   */
+  size_t grant(const std::string& consumer, size_t bytes, size_t minimum,
+               bool partial);
+
+  /// Charges bytes to consumer. m_lock must be held.
+  size_t grant_locked(const std::string& consumer, size_t bytes);
+
+  /// The bytes left in the budget. m_lock must be held.
+  size_t available_locked() const;
+
+  /// Calls the reclaim functions of the consumers other than consumer.
+  void reclaim_for(const std::string& consumer, size_t bytes);
+};
+
+} // namespace fileio
+} // namespace turi
+#endif
@@ -5,6 +5,7 @@
  */
 #include <ml_data/data_storage/ml_data_block_manager.hpp>
 #include <ml_data/ml_data.hpp>
+#include <fileio/memory_budget.hpp>
 
 namespace turi { namespace ml_data_internal {
 
@@ -96,11 +97,26 @@ std::shared_ptr<ml_data_block> ml_data_block_manager::get_block(size_t block_ind
       }
     }
 
+    // The block is needed regardless, so it is only charged to the memory
+    // budget, so that the other consumers account for it, and returned to
+    // the budget when the last reference to the block goes away.
+    size_t block_bytes =
+        row_block_buffer[0].entry_data.size() * sizeof(entry_value)
+        + row_block_buffer[0].additional_data.size() * sizeof(flexible_type);
+    for(const auto& column : untranslated_column_buffers) {
+      block_bytes += column.size() * sizeof(flexible_type);
+    }
+    fileio::memory_budget::get_instance().acquire("ml_data", block_bytes);
+
     ret.reset(new ml_data_block
               {metadata,
                     rm,
                     std::move(row_block_buffer[0]),
-                    std::move(untranslated_column_buffers)});
+                    std::move(untranslated_column_buffers)},
+              [block_bytes](ml_data_block* block) {
+                delete block;
+                fileio::memory_budget::get_instance().release("ml_data", block_bytes);
+              });
 
     // Reaquire the lock on the cache.
     guard.lock();
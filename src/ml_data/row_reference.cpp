@@ -3,6 +3,7 @@
  * Use of this source code is governed by a BSD-3-clause license that can
  * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
  */
+#include <algorithm>
 #include <ml_data/ml_data.hpp>
 #include <ml_data/row_reference.hpp>
 
@@ -65,76 +66,120 @@ ml_data_row_reference ml_data_row_reference::from_row(
   }
   
   ////////////////////////////////////////////////////////////////////////////////
-  // Next, build the data_block we're going to dump it in to. 
-  
-  std::shared_ptr<ml_data_internal::ml_data_block> data_block(new ml_data_internal::ml_data_block);
+  // Copy the data over
 
-  data_block->metadata = metadata;
-  data_block->rm = (has_target
-                    ? metadata->cached_rm_with_target
-                    : metadata->cached_rm_without_target);
+  const ml_data_internal::row_metadata& rm = (has_target
+                                              ? metadata->cached_rm_with_target
+                                              : metadata->cached_rm_without_target);
 
-  ////////////////////////////////////////////////////////////////////////////////
-  // Copy the data over
   std::vector<std::vector<flexible_type> > data(
-      data_block->rm.total_num_columns, {FLEX_UNDEFINED});
+      rm.total_num_columns, {FLEX_UNDEFINED});
 
   for(size_t i = 0; i < row.size(); ++i) {
     size_t col_idx = col_indices[i];
     if(col_idx == size_t(-1))
       continue;
-    
-    const auto& v = row[i].second;
-    data[col_idx][0] = v;
-
-    if(v.get_type() != flex_type_enum::UNDEFINED) {
-      ml_data_internal::check_type_consistent_with_mode(
-          data_block->rm.metadata_vect[col_idx]->name,
-          v.get_type(),
-          data_block->rm.metadata_vect[col_idx]->mode);
+
+    data[col_idx][0] = row[i].second;
+  }
+
+  std::shared_ptr<ml_data_internal::ml_data_block> data_block(new ml_data_internal::ml_data_block);
+  std::vector<ml_data_row_reference> row_refs;
+
+  from_column_buffer(metadata, data, has_target, data_block, row_refs, none_action);
+
+  return row_refs[0];
+}
+
+void ml_data_row_reference::from_column_buffer(
+    const std::shared_ptr<ml_metadata>& metadata,
+    std::vector<std::vector<flexible_type> >& column_buffer,
+    bool has_target,
+    const std::shared_ptr<ml_data_internal::ml_data_block>& data_block,
+    std::vector<ml_data_row_reference>& row_refs,
+    ml_missing_value_action none_action) {
+
+  data_block->metadata = metadata;
+  data_block->rm = (has_target
+                    ? metadata->cached_rm_with_target
+                    : metadata->cached_rm_without_target);
+
+  const ml_data_internal::row_metadata& rm = data_block->rm;
+  DASSERT_EQ(column_buffer.size(), rm.total_num_columns);
+
+  size_t num_rows = 0;
+  for(const auto& column : column_buffer) {
+    num_rows = std::max(num_rows, column.size());
+  }
+
+  ////////////////////////////////////////////////////////////////////////////////
+  // Check the types of the values.
+
+  for(size_t col_idx = 0; col_idx < column_buffer.size(); ++col_idx) {
+    const auto& column_metadata = rm.metadata_vect[col_idx];
+    for(const flexible_type& v : column_buffer[col_idx]) {
+      if(v.get_type() != flex_type_enum::UNDEFINED) {
+        ml_data_internal::check_type_consistent_with_mode(
+            column_metadata->name, v.get_type(), column_metadata->mode);
+      }
     }
   }
-  
+
   ////////////////////////////////////////////////////////////////////////////////
   // Handle any untranslated columns properly.
 
   bool has_untranslated_columns = metadata->has_untranslated_columns();
 
+  data_block->untranslated_columns.clear();
+
   if(has_untranslated_columns) {
     size_t num_utc = metadata->num_untranslated_columns();
 
     data_block->untranslated_columns.reserve(num_utc);
 
-    for(size_t i = 0; i < data.size(); ++i) {
+    for(size_t i = 0; i < column_buffer.size(); ++i) {
       if(metadata->is_untranslated_column(i)) {
-        data_block->untranslated_columns.push_back(std::move(data[i]));
+        data_block->untranslated_columns.push_back(std::move(column_buffer[i]));
+        column_buffer[i].clear();
       }
     }
   }
-    
-  // Single use for the mapping of one item.
-  static std::vector<size_t> row2data_idx_map = {0};
 
-  // Do the unpacking. 
+  // Do the unpacking.
+  std::vector<size_t> row2data_idx_map;
+
   ml_data_internal::fill_row_buffer_from_column_buffer(
       row2data_idx_map,
       data_block->translated_rows,
       data_block->rm,
-      data,
+      column_buffer,
       /* thread_idx = */ 0,
       /* track_statistics = */ false,
       /* immutable_metadata = */ true,
       none_action);
 
-  // Build the reference. 
-  ml_data_row_reference row_ref;
-  row_ref.data_block = data_block;
-  row_ref.current_in_block_index = 0;
-  row_ref.current_in_block_row_index = 0;
-  row_ref.has_translated_columns = metadata->has_translated_columns();
-  row_ref.has_untranslated_columns = has_untranslated_columns;
+  ////////////////////////////////////////////////////////////////////////////////
+  // Build the references.
+
+  bool has_translated_columns = metadata->has_translated_columns();
 
-  return row_ref;
+  row_refs.resize(num_rows);
+
+  size_t in_block_index = 0;
+
+  for(size_t i = 0; i < num_rows; ++i) {
+    ml_data_row_reference& row_ref = row_refs[i];
+    row_ref.data_block = data_block;
+    row_ref.current_in_block_index = in_block_index;
+    row_ref.current_in_block_row_index = i;
+    row_ref.has_translated_columns = has_translated_columns;
+    row_ref.has_untranslated_columns = has_untranslated_columns;
+
+    if(has_translated_columns) {
+      in_block_index += ml_data_internal::get_row_data_size(
+          rm, data_block->translated_rows.entry_data.data() + in_block_index);
+    }
+  }
 }
 
 }
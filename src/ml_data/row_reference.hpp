@@ -98,6 +98,27 @@ class ml_data_row_reference {
   static GL_HOT ml_data_row_reference from_row(
       const std::shared_ptr<ml_metadata>& metadata, const flex_dict& row,
       ml_missing_value_action none_action = ml_missing_value_action::USE_NAN);
+
+  /** Create references to a batch of rows given as columns.
+   *
+   *  column_buffer holds one vector of values per column of metadata
+   *  (followed by the target column if has_target), all with one value
+   *  per row, as ml_data_internal::fill_row_buffer_from_column_buffer
+   *  expects. The values of the untranslated columns are moved out of
+   *  column_buffer.
+   *
+   *  The rows are translated into data_block, reusing its buffers, and a
+   *  reference to every row, all sharing data_block, is written to
+   *  row_refs. data_block must not be shared with other references while
+   *  this runs.
+   */
+  static GL_HOT void from_column_buffer(
+      const std::shared_ptr<ml_metadata>& metadata,
+      std::vector<std::vector<flexible_type> >& column_buffer,
+      bool has_target,
+      const std::shared_ptr<ml_data_internal::ml_data_block>& data_block,
+      std::vector<ml_data_row_reference>& row_refs,
+      ml_missing_value_action none_action = ml_missing_value_action::USE_NAN);
   
   /**
    * Fill an observation vector, represented as an ml_data_entry
@@ -0,0 +1,151 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <set>
+#include <sstream>
+#include <parallel/numa_topology.hpp>
+#include <logger/logger.hpp>
+#ifdef __linux__
+#include <dirent.h>
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace turi {
+
+numa_topology::numa_topology(std::vector<std::vector<size_t>> cpus_of_node) {
+  for (auto& cpus : cpus_of_node) {
+    if (cpus.empty()) continue;
+    std::sort(cpus.begin(), cpus.end());
+    cpus.erase(std::unique(cpus.begin(), cpus.end()), cpus.end());
+    m_cpus_of_node.push_back(std::move(cpus));
+  }
+  if (m_cpus_of_node.empty()) m_cpus_of_node.resize(1);
+
+  for (size_t node = 0; node < m_cpus_of_node.size(); ++node) {
+    for (size_t cpu : m_cpus_of_node[node]) {
+      if (cpu >= m_node_of_cpu.size()) m_node_of_cpu.resize(cpu + 1, 0);
+      m_node_of_cpu[cpu] = node;
+    }
+  }
+}
+
+std::vector<size_t> numa_topology::parse_cpu_list(const std::string& cpu_list) {
+  std::set<size_t> cpus;
+  std::stringstream strm(cpu_list);
+  std::string range;
+  while (std::getline(strm, range, ',')) {
+    size_t dash = range.find('-');
+    char* end = nullptr;
+    unsigned long first = std::strtoul(range.c_str(), &end, 10);
+    if (end == range.c_str()) continue;
+    unsigned long last = first;
+    if (dash != std::string::npos) {
+      const char* last_str = range.c_str() + dash + 1;
+      last = std::strtoul(last_str, &end, 10);
+      if (end == last_str || last < first) continue;
+    }
+    for (unsigned long cpu = first; cpu <= last; ++cpu) cpus.insert(cpu);
+  }
+  return std::vector<size_t>(cpus.begin(), cpus.end());
+}
+
+#ifdef __linux__
+/**
+ * Reads the CPUs of each node from /sys/devices/system/node, restricted to
+ * the CPUs the process may run on. Returns nothing if the topology is not
+ * available.
+ */
+static std::vector<std::vector<size_t>> read_linux_topology() {
+  std::vector<std::vector<size_t>> ret;
+  const std::string node_root = "/sys/devices/system/node";
+  DIR* dir = opendir(node_root.c_str());
+  if (dir == nullptr) return ret;
+  std::map<size_t, std::string> node_dirs;
+  while (struct dirent* entry = readdir(dir)) {
+    std::string name = entry->d_name;
+    if (name.size() > 4 && name.compare(0, 4, "node") == 0 &&
+        std::all_of(name.begin() + 4, name.end(), ::isdigit)) {
+      node_dirs[std::stoul(name.substr(4))] = node_root + "/" + name;
+    }
+  }
+  closedir(dir);
+
+  cpu_set_t allowed;
+  CPU_ZERO(&allowed);
+  bool has_allowed = sched_getaffinity(0, sizeof(allowed), &allowed) == 0;
+
+  for (const auto& node_dir : node_dirs) {
+    std::ifstream fin(node_dir.second + "/cpulist");
+    std::string cpu_list;
+    if (!fin.good() || !std::getline(fin, cpu_list)) continue;
+    std::vector<size_t> cpus;
+    for (size_t cpu : numa_topology::parse_cpu_list(cpu_list)) {
+      if (!has_allowed || (cpu < CPU_SETSIZE && CPU_ISSET(cpu, &allowed))) {
+        cpus.push_back(cpu);
+      }
+    }
+    ret.push_back(std::move(cpus));
+  }
+  return ret;
+}
+#endif
+
+const numa_topology& numa_topology::get_instance() {
+  static const numa_topology* topology = []() {
+    std::vector<std::vector<size_t>> cpus_of_node;
+#ifdef __linux__
+    cpus_of_node = read_linux_topology();
+#endif
+    auto ret = new numa_topology(std::move(cpus_of_node));
+    logstream(LOG_INFO) << "Found " << ret->num_nodes() << " NUMA node(s)"
+                        << std::endl;
+    return ret;
+  }();
+  return *topology;
+}
+
+size_t numa_topology::node_of_cpu(size_t cpu) const {
+  return cpu < m_node_of_cpu.size() ? m_node_of_cpu[cpu] : 0;
+}
+
+size_t numa_topology::num_worker_groups(size_t num_workers) const {
+  return std::max<size_t>(1, std::min(num_nodes(), num_workers));
+}
+
+size_t numa_topology::node_of_worker(size_t worker, size_t num_workers) const {
+  if (num_workers == 0) return 0;
+  worker = std::min(worker, num_workers - 1);
+  return worker * num_worker_groups(num_workers) / num_workers;
+}
+
+bool numa_topology::bind_current_thread(size_t node) const {
+#ifdef __linux__
+  if (node >= num_nodes() || cpus_of_node(node).empty()) return false;
+  cpu_set_t cpus;
+  CPU_ZERO(&cpus);
+  for (size_t cpu : cpus_of_node(node)) {
+    if (cpu < CPU_SETSIZE) CPU_SET(cpu, &cpus);
+  }
+  return pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus) == 0;
+#else
+  return false;
+#endif
+}
+
+size_t numa_topology::current_node() const {
+#ifdef __linux__
+  int cpu = sched_getcpu();
+  if (cpu >= 0) return node_of_cpu(cpu);
+#endif
+  return 0;
+}
+
+} // namespace turi
@@ -0,0 +1,92 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#ifndef TURI_PARALLEL_NUMA_TOPOLOGY_HPP
+#define TURI_PARALLEL_NUMA_TOPOLOGY_HPP
+#include <string>
+#include <vector>
+
+namespace turi {
+
+/**
+ * \ingroup threading
+ * Describes the NUMA nodes of the machine, and the CPUs of each node.
+ *
+ * On Linux the topology is read from /sys/devices/system/node, keeping only
+ * the nodes which have CPUs the process is allowed to run on. Everywhere
+ * else, or if the topology cannot be read, the machine is described as a
+ * single node holding all the CPUs.
+ *
+ * The thread pool uses the topology to split its workers in one group per
+ * node (see \ref thread_pool). Worker i of n belongs to the group
+ * \ref node_of_worker(i, n), and the workers of a group are contiguous.
+ * There is no explicit placement of data: \ref parallel_for gives worker i
+ * the i-th contiguous range of the work, and the pool runs it in the group of
+ * worker i, so contiguous ranges of segments land on the same node, and the
+ * buffers a worker first touches are allocated there.
+ */
+class numa_topology {
+ public:
+  /**
+   * Describes a machine with the given nodes. Each element lists the CPUs
+   * of a node. Nodes without CPUs are dropped. If there are no nodes left,
+   * the machine is a single node with no known CPUs.
+   */
+  explicit numa_topology(std::vector<std::vector<size_t>> cpus_of_node);
+
+  /// Returns the topology of this machine, discovered on first use.
+  static const numa_topology& get_instance();
+
+  /// Number of nodes. Always at least 1.
+  size_t num_nodes() const { return m_cpus_of_node.size(); }
+
+  /// The CPUs of a node. May be empty on a single node machine.
+  const std::vector<size_t>& cpus_of_node(size_t node) const {
+    return m_cpus_of_node[node];
+  }
+
+  /// The node of a CPU. Unknown CPUs belong to node 0.
+  size_t node_of_cpu(size_t cpu) const;
+
+  /**
+   * The number of worker groups a pool of num_workers threads is split in:
+   * one per node, but no more than there are workers.
+   */
+  size_t num_worker_groups(size_t num_workers) const;
+
+  /**
+   * The node of worker i in a pool of num_workers threads. The workers of
+   * each node are contiguous, and the nodes get the same number of workers,
+   * give or take one.
+   */
+  size_t node_of_worker(size_t worker, size_t num_workers) const;
+
+  /**
+   * Restricts the calling thread to the CPUs of a node, so that the memory
+   * it first touches is allocated on the node. Returns false if the thread
+   * could not be bound (unsupported platform, or the node has no known
+   * CPUs), in which case the affinity of the thread is left unchanged.
+   */
+  bool bind_current_thread(size_t node) const;
+
+  /**
+   * The node the calling thread is currently running on, or 0 if it cannot
+   * be determined.
+   */
+  size_t current_node() const;
+
+  /**
+   * Parses a Linux CPU list, such as "0-3,8,10-11". Returns the CPUs in
+   * increasing order. Malformed entries are skipped.
+   */
+  static std::vector<size_t> parse_cpu_list(const std::string& cpu_list);
+
+ private:
+  std::vector<std::vector<size_t>> m_cpus_of_node;
+  std::vector<size_t> m_node_of_cpu;
+};
+
+} // namespace turi
+#endif
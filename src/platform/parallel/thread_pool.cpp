@@ -78,30 +78,40 @@ void thread_pool::resize(size_t nthreads) {
   // additional threads rather than destroying the pool
   if(nthreads != pool_size) {
     pool_size = nthreads;
-
-    // stop the queue from blocking
-    spawn_queue.stop_blocking();
-
-    // join the threads in the thread group
-    while(true) {
-      try {
-        threads.join(); break;
-      } catch (const char* error_str) {
-        // this should not be possible!
-        logstream(LOG_FATAL) 
-            << "Unexpected exception caught in thread pool destructor: " 
-            << error_str << std::endl;
-      }
-    }
-    spawn_queue.start_blocking();
+    join_all_threads();
     spawn_thread_group();
   }
 } // end of set_nthreads
 
 
+void thread_pool::join_all_threads() {
+  // stop the queues from blocking
+  for (auto& queue : spawn_queues) queue->stop_blocking();
+
+  // join the threads in the thread group
+  while(true) {
+    try {
+      threads.join(); break;
+    } catch (const char* error_str) {
+      // this should not be possible!
+      logstream(LOG_FATAL) 
+          << "Unexpected exception caught in thread pool destructor: " 
+          << error_str << std::endl;
+    }
+  }
+  for (auto& queue : spawn_queues) queue->start_blocking();
+}
+
+
 size_t thread_pool::size() const { return pool_size; }
 
 
+size_t thread_pool::worker_group(size_t worker) const {
+  if (num_groups <= 1) return 0;
+  return numa_topology::get_instance().node_of_worker(worker, pool_size);
+}
+
+
 /**
   Creates the thread group
   */
@@ -112,14 +122,25 @@ void thread_pool::spawn_thread_group() {
   config::init_cocoa_multithreaded_runtime();
 #endif
 
+  const numa_topology& topology = numa_topology::get_instance();
+  num_groups = cpu_affinity ? topology.num_worker_groups(pool_size) : 1;
+  next_group = 0;
+  while (spawn_queues.size() < num_groups) {
+    spawn_queues.emplace_back(new task_queue());
+  }
+
   size_t ncpus = thread::cpu_count();
   // start all the threads if CPU affinity is set
   for (size_t i = 0;i < pool_size; ++i) {
-    if (cpu_affinity) {
-      threads.launch(boost::bind(&thread_pool::wait_for_task, this), i % ncpus);
+    if (num_groups > 1) {
+      // the thread binds itself to the CPUs of its node
+      threads.launch(boost::bind(&thread_pool::wait_for_task, this,
+                                 worker_group(i)));
+    } else if (cpu_affinity) {
+      threads.launch(boost::bind(&thread_pool::wait_for_task, this, 0), i % ncpus);
     }
     else {
-      threads.launch(boost::bind(&thread_pool::wait_for_task, this));
+      threads.launch(boost::bind(&thread_pool::wait_for_task, this, 0));
     }
   }
 } // end of spawn_thread_group
@@ -127,9 +148,9 @@ void thread_pool::spawn_thread_group() {
 
 void thread_pool::destroy_all_threads() {
   // wait for all execution to complete
-  spawn_queue.wait_until_empty();
-  // kill the queue
-  spawn_queue.stop_blocking();
+  for (auto& queue : spawn_queues) queue->wait_until_empty();
+  // kill the queues
+  for (auto& queue : spawn_queues) queue->stop_blocking();
 
   // join the threads in the thread group
   while(1) {
@@ -150,22 +171,7 @@ void thread_pool::destroy_all_threads() {
 void thread_pool::set_cpu_affinity(bool affinity) {
   if (affinity != cpu_affinity) {
     cpu_affinity = affinity;
-    // stop the queue from blocking
-    spawn_queue.stop_blocking();
-
-    // join the threads in the thread group
-    while(1) {
-      try {
-        threads.join(); break;
-      } catch (const char* c) {
-        // this should not be possible!
-        logstream(LOG_FATAL) 
-            << "Unexpected exception caught in thread pool destructor: " 
-            << c << std::endl;
-        // ASSERT_TRUE(false); // unnecessary
-      }
-    }
-    spawn_queue.start_blocking();
+    join_all_threads();
     spawn_thread_group();
   }
 } // end of set_cpu_affinity
@@ -175,11 +181,24 @@ void thread_pool::launch(const boost::function<void (void)> &spawn_function,
                          int virtual_threadid) {
   std::lock_guard<mutex> lock(mut);
   ++tasks_inserted;
-  spawn_queue.enqueue(std::make_pair(spawn_function, virtual_threadid));
+  size_t group = 0;
+  if (num_groups > 1) {
+    if (virtual_threadid >= 0) {
+      group = worker_group(virtual_threadid % pool_size);
+    } else {
+      group = next_group;
+      next_group = (next_group + 1) % num_groups;
+    }
+  }
+  spawn_queues[group]->enqueue(std::make_pair(spawn_function, virtual_threadid));
 }
 
-void thread_pool::wait_for_task() {
+void thread_pool::wait_for_task(size_t group) {
   thread::get_tls_data().set_in_thread_flag(true);
+  if (num_groups > 1) {
+    numa_topology::get_instance().bind_current_thread(group);
+  }
+  task_queue& spawn_queue = *spawn_queues[group];
   while(1) {
     std::pair<std::pair<boost::function<void (void)>, int>, bool> queue_entry;
     // pop from the queue
@@ -207,7 +226,7 @@ void thread_pool::wait_for_task() {
 } // end of wait_for_task
 
 void thread_pool::join() {
-  spawn_queue.wait_until_empty();
+  for (auto& queue : spawn_queues) queue->wait_until_empty();
 
   std::unique_lock<mutex> lock(mut);
   waiting_on_join = true;
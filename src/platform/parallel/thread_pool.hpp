@@ -6,8 +6,11 @@
 #ifndef TURI_THREAD_POOL_HPP
 #define TURI_THREAD_POOL_HPP
 
+#include <memory>
+#include <vector>
 #include <boost/bind.hpp>
 #include <parallel/pthread_tools.hpp>
+#include <parallel/numa_topology.hpp>
 #include <util/blocking_queue.hpp>
 
 namespace turi {
@@ -97,12 +100,27 @@ class parallel_task_queue {
    * If multiple threads are running in the thread-group, the master should
    * test if running_threads() is > 0, and retry the join().
    *
+   * When CPU affinity is set on a machine with several NUMA nodes (see
+   * \ref numa_topology), the workers are split in one group per node, each
+   * bound to the CPUs of its node and with its own queue of tasks. Worker i
+   * belongs to group \ref worker_group(i), and the workers of a group are
+   * contiguous. A task launched with a virtual thread ID runs in the group
+   * of that worker, so that task i of \ref in_parallel or \ref parallel_for
+   * always runs on the same node, and the memory it first touches (per
+   * thread buffers, output segments) stays local to the node. Other tasks
+   * are spread over the groups in turn.
    */
   class thread_pool {
   private:
+    typedef blocking_queue<std::pair<boost::function<void (void)>, int> > task_queue;
     thread_group threads;
-    blocking_queue<std::pair<boost::function<void (void)>, int> > spawn_queue;
+    /// One queue of tasks per worker group. Only grows.
+    std::vector<std::unique_ptr<task_queue> > spawn_queues;
     size_t pool_size;
+    /// The number of worker groups (NUMA nodes) in use.
+    size_t num_groups = 1;
+    /// The group which gets the next task without a virtual thread ID.
+    size_t next_group = 0;
 
     mutex mut;
     conditional event_condition;  
@@ -116,9 +134,12 @@ class parallel_task_queue {
     thread_pool(const thread_pool&);
       
     /**
-       Called by each thread. Loops around a queue of tasks.
+       Called by each thread. Loops around the queue of tasks of its group.
     */
-    void wait_for_task();
+    void wait_for_task(size_t group);
+
+    /** Stops the threads once their queues are empty, and waits for them. */
+    void join_all_threads();
 
     /**
        Creates all the threads in the thread pool.
@@ -149,6 +170,18 @@ class parallel_task_queue {
      */
     size_t size() const;
 
+    /**
+     * The number of worker groups. 1 unless CPU affinity is set on a machine
+     * with several NUMA nodes.
+     */
+    size_t num_worker_groups() const { return num_groups; }
+
+    /**
+     * The worker group (and NUMA node) of worker i. Tasks launched with
+     * virtual thread ID i run in that group.
+     */
+    size_t worker_group(size_t worker) const;
+
 
     /** 
      * Queues a single task into the thread pool which calls spawn_function.
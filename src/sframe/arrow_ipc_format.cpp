@@ -0,0 +1,1109 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#include <sframe/arrow_ipc_format.hpp>
+#include <logger/logger.hpp>
+#include <logger/assertions.hpp>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <sstream>
+
+namespace turi {
+namespace arrow_ipc {
+
+namespace {
+
+////////////////////////////////////////////////////////////////////////////////
+// Constants of the Arrow format (Schema.fbs, Message.fbs, File.fbs)
+
+const char ARROW_MAGIC[] = "ARROW1";
+const size_t ARROW_MAGIC_SIZE = 6;
+const uint32_t CONTINUATION_MARKER = 0xFFFFFFFF;
+const int16_t METADATA_VERSION_V5 = 4;
+
+// MessageHeader union
+const uint8_t HEADER_SCHEMA = 1;
+const uint8_t HEADER_RECORD_BATCH = 3;
+
+// Type union
+const int TYPE_NULL = 1;
+const int TYPE_INT = 2;
+const int TYPE_FLOATING_POINT = 3;
+const int TYPE_BINARY = 4;
+const int TYPE_UTF8 = 5;
+const int TYPE_BOOL = 6;
+const int TYPE_TIMESTAMP = 10;
+const int TYPE_LIST = 12;
+
+// FloatingPoint precision
+const int16_t PRECISION_SINGLE = 1;
+const int16_t PRECISION_DOUBLE = 2;
+
+// Timestamp unit
+const int16_t TIME_UNIT_MICROSECOND = 2;
+
+inline size_t round_up(size_t val, size_t align) {
+  return (val + align - 1) / align * align;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Flatbuffer encoding
+//
+// The encoder writes objects front to back: a parent is always written
+// before its children, so every uoffset points forward as the format
+// requires. Vtables are written immediately before their table. Every table
+// is 8 byte aligned, and every field is aligned to its size.
+
+struct fb_node;
+typedef std::shared_ptr<fb_node> fb_ptr;
+
+struct fb_node {
+  enum kind_type { TABLE, STRING, TABLE_VECTOR, STRUCT_VECTOR };
+
+  struct field {
+    size_t size = 0;     // 0 = absent
+    uint64_t bits = 0;   // little endian scalar value
+    fb_ptr child;        // offset fields
+  };
+
+  kind_type kind = TABLE;
+  std::vector<field> fields;      // TABLE
+  std::string bytes;              // STRING, STRUCT_VECTOR
+  size_t struct_size = 1;         // STRUCT_VECTOR
+  size_t struct_align = 1;        // STRUCT_VECTOR
+  std::vector<fb_ptr> elements;   // TABLE_VECTOR
+
+  template <typename T>
+  void set_scalar(size_t id, T value) {
+    static_assert(sizeof(T) <= 8, "Scalar too large");
+    if (fields.size() <= id) fields.resize(id + 1);
+    fields[id].size = sizeof(T);
+    fields[id].bits = 0;
+    std::memcpy(&fields[id].bits, &value, sizeof(T));
+  }
+
+  void set_child(size_t id, fb_ptr child) {
+    if (fields.size() <= id) fields.resize(id + 1);
+    fields[id].size = sizeof(uint32_t);
+    fields[id].child = child;
+  }
+};
+
+fb_ptr fb_table() {
+  return std::make_shared<fb_node>();
+}
+
+fb_ptr fb_string(const std::string& s) {
+  auto ret = std::make_shared<fb_node>();
+  ret->kind = fb_node::STRING;
+  ret->bytes = s;
+  return ret;
+}
+
+fb_ptr fb_table_vector(const std::vector<fb_ptr>& elements) {
+  auto ret = std::make_shared<fb_node>();
+  ret->kind = fb_node::TABLE_VECTOR;
+  ret->elements = elements;
+  return ret;
+}
+
+fb_ptr fb_struct_vector(const std::string& bytes, size_t struct_size,
+                        size_t struct_align) {
+  auto ret = std::make_shared<fb_node>();
+  ret->kind = fb_node::STRUCT_VECTOR;
+  ret->bytes = bytes;
+  ret->struct_size = struct_size;
+  ret->struct_align = struct_align;
+  return ret;
+}
+
+template <typename T>
+void append_scalar(std::string& out, T value) {
+  out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+void patch_scalar(std::string& out, size_t pos, T value) {
+  std::memcpy(&out[pos], &value, sizeof(T));
+}
+
+class fb_encoder {
+ public:
+  /// Returns the flatbuffer rooted at root, padded to a multiple of 8 bytes.
+  std::string finish(const fb_node& root) {
+    m_buf.assign(sizeof(uint32_t), 0);
+    write(root, 0);
+    pad_to(8);
+    return std::move(m_buf);
+  }
+
+ private:
+  std::string m_buf;
+
+  void pad_to(size_t align) {
+    m_buf.resize(round_up(m_buf.size(), align), 0);
+  }
+
+  void set_offset(size_t slot, size_t target) {
+    patch_scalar<uint32_t>(m_buf, slot, uint32_t(target - slot));
+  }
+
+  void write(const fb_node& node, size_t slot) {
+    switch(node.kind) {
+      case fb_node::TABLE: write_table(node, slot); break;
+      case fb_node::STRING: {
+        pad_to(4);
+        set_offset(slot, m_buf.size());
+        append_scalar<uint32_t>(m_buf, node.bytes.size());
+        m_buf.append(node.bytes);
+        m_buf.push_back(0);
+        break;
+      }
+      case fb_node::STRUCT_VECTOR: {
+        size_t align = std::max<size_t>(node.struct_align, 4);
+        while ((m_buf.size() + sizeof(uint32_t)) % align) m_buf.push_back(0);
+        set_offset(slot, m_buf.size());
+        append_scalar<uint32_t>(m_buf, node.bytes.size() / node.struct_size);
+        m_buf.append(node.bytes);
+        break;
+      }
+      case fb_node::TABLE_VECTOR: {
+        pad_to(4);
+        set_offset(slot, m_buf.size());
+        append_scalar<uint32_t>(m_buf, node.elements.size());
+        size_t slots = m_buf.size();
+        m_buf.resize(slots + sizeof(uint32_t) * node.elements.size(), 0);
+        for (size_t i = 0; i < node.elements.size(); ++i) {
+          write(*node.elements[i], slots + sizeof(uint32_t) * i);
+        }
+        break;
+      }
+    }
+  }
+
+  void write_table(const fb_node& node, size_t slot) {
+    size_t nfields = node.fields.size();
+
+    // Lay out the fields after the vtable soffset, largest first.
+    std::vector<size_t> field_offset(nfields, 0);
+    size_t table_size = sizeof(int32_t);
+    for (size_t size : {8, 4, 2, 1}) {
+      for (size_t i = 0; i < nfields; ++i) {
+        if (node.fields[i].size != size) continue;
+        table_size = round_up(table_size, size);
+        field_offset[i] = table_size;
+        table_size += size;
+      }
+    }
+
+    // The vtable.
+    pad_to(2);
+    size_t vtable_pos = m_buf.size();
+    append_scalar<uint16_t>(m_buf, 4 + 2 * nfields);
+    append_scalar<uint16_t>(m_buf, table_size);
+    for (size_t i = 0; i < nfields; ++i) {
+      append_scalar<uint16_t>(m_buf, field_offset[i]);
+    }
+
+    // The table.
+    pad_to(8);
+    size_t table_pos = m_buf.size();
+    m_buf.resize(table_pos + table_size, 0);
+    patch_scalar<int32_t>(m_buf, table_pos, int32_t(table_pos - vtable_pos));
+    set_offset(slot, table_pos);
+    for (size_t i = 0; i < nfields; ++i) {
+      const auto& f = node.fields[i];
+      if (f.size > 0 && !f.child) {
+        std::memcpy(&m_buf[table_pos + field_offset[i]], &f.bits, f.size);
+      }
+    }
+
+    // And the children.
+    for (size_t i = 0; i < nfields; ++i) {
+      const auto& f = node.fields[i];
+      if (f.child) write(*f.child, table_pos + field_offset[i]);
+    }
+  }
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// Flatbuffer decoding
+
+class fb_view {
+ public:
+  fb_view(const char* buf, size_t size, size_t table_pos)
+      : m_buf(buf), m_size(size), m_pos(table_pos) {
+    int32_t soffset = read<int32_t>(m_pos);
+    m_vtable = size_t(int64_t(m_pos) - soffset);
+    m_vtable_size = read<uint16_t>(m_vtable);
+  }
+
+  /// Returns the root table of the flatbuffer in buf.
+  static fb_view root(const char* buf, size_t size) {
+    fb_view dummy;
+    dummy.m_buf = buf;
+    dummy.m_size = size;
+    return fb_view(buf, size, dummy.read<uint32_t>(0));
+  }
+
+  bool has(size_t id) const {
+    return field_pos(id) != 0;
+  }
+
+  template <typename T>
+  T scalar(size_t id, T default_value) const {
+    size_t pos = field_pos(id);
+    return pos == 0 ? default_value : read<T>(pos);
+  }
+
+  fb_view table(size_t id) const {
+    return fb_view(m_buf, m_size, deref(id));
+  }
+
+  std::string string(size_t id) const {
+    if (!has(id)) return "";
+    size_t pos = deref(id);
+    size_t len = read<uint32_t>(pos);
+    check(pos + 4, len);
+    return std::string(m_buf + pos + 4, len);
+  }
+
+  /// Returns the length of a vector field (0 if absent).
+  size_t vector_length(size_t id) const {
+    if (!has(id)) return 0;
+    return read<uint32_t>(deref(id));
+  }
+
+  /// Returns the i-th table of a vector of tables.
+  fb_view table_at(size_t id, size_t i) const {
+    size_t slot = deref(id) + 4 + 4 * i;
+    return fb_view(m_buf, m_size, slot + read<uint32_t>(slot));
+  }
+
+  /// Returns a scalar at byte offset `offset` of the i-th struct of a vector.
+  template <typename T>
+  T struct_at(size_t id, size_t i, size_t struct_size, size_t offset) const {
+    return read<T>(deref(id) + 4 + struct_size * i + offset);
+  }
+
+ private:
+  fb_view() = default;
+
+  const char* m_buf = nullptr;
+  size_t m_size = 0;
+  size_t m_pos = 0;
+  size_t m_vtable = 0;
+  size_t m_vtable_size = 0;
+
+  void check(size_t pos, size_t len) const {
+    if (pos > m_size || len > m_size - pos) {
+      log_and_throw("Corrupted Arrow metadata");
+    }
+  }
+
+  template <typename T>
+  T read(size_t pos) const {
+    check(pos, sizeof(T));
+    T ret;
+    std::memcpy(&ret, m_buf + pos, sizeof(T));
+    return ret;
+  }
+
+  size_t field_pos(size_t id) const {
+    size_t entry = 4 + 2 * id;
+    if (entry + 2 > m_vtable_size) return 0;
+    uint16_t offset = read<uint16_t>(m_vtable + entry);
+    return offset == 0 ? 0 : m_pos + offset;
+  }
+
+  size_t deref(size_t id) const {
+    size_t pos = field_pos(id);
+    if (pos == 0) log_and_throw("Corrupted Arrow metadata: missing field");
+    return pos + read<uint32_t>(pos);
+  }
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// Schema encoding
+
+fb_ptr encode_key_values(
+    const std::vector<std::pair<std::string, std::string>>& kvs) {
+  std::vector<fb_ptr> elements;
+  for (const auto& kv : kvs) {
+    auto e = fb_table();
+    e->set_child(0, fb_string(kv.first));
+    e->set_child(1, fb_string(kv.second));
+    elements.push_back(e);
+  }
+  return fb_table_vector(elements);
+}
+
+fb_ptr encode_field(const std::string& name, arrow_type type,
+                    const std::vector<std::pair<std::string, std::string>>& md) {
+  auto field = fb_table();
+  auto type_table = fb_table();
+  uint8_t type_id = 0;
+  std::vector<fb_ptr> children;
+
+  switch(type) {
+    case arrow_type::NULL_TYPE:
+      type_id = TYPE_NULL;
+      break;
+    case arrow_type::INT64:
+      type_id = TYPE_INT;
+      type_table->set_scalar<int32_t>(0, 64);
+      type_table->set_scalar<uint8_t>(1, 1);
+      break;
+    case arrow_type::FLOAT64:
+      type_id = TYPE_FLOATING_POINT;
+      type_table->set_scalar<int16_t>(0, PRECISION_DOUBLE);
+      break;
+    case arrow_type::UTF8:
+      type_id = TYPE_UTF8;
+      break;
+    case arrow_type::BINARY:
+      type_id = TYPE_BINARY;
+      break;
+    case arrow_type::TIMESTAMP_MICROS:
+      type_id = TYPE_TIMESTAMP;
+      type_table->set_scalar<int16_t>(0, TIME_UNIT_MICROSECOND);
+      type_table->set_child(1, fb_string("UTC"));
+      break;
+    case arrow_type::LIST_FLOAT64:
+      type_id = TYPE_LIST;
+      children.push_back(encode_field("item", arrow_type::FLOAT64, {}));
+      break;
+  }
+
+  field->set_child(0, fb_string(name));
+  field->set_scalar<uint8_t>(1, 1);
+  field->set_scalar<uint8_t>(2, type_id);
+  field->set_child(3, type_table);
+  field->set_child(5, fb_table_vector(children));
+  if (!md.empty()) field->set_child(6, encode_key_values(md));
+  return field;
+}
+
+fb_ptr encode_schema(const std::vector<field_desc>& schema) {
+  std::vector<fb_ptr> fields;
+  for (const auto& f : schema) {
+    fields.push_back(encode_field(f.name, f.type, f.metadata));
+  }
+  auto ret = fb_table();
+  ret->set_scalar<int16_t>(0, 0);  // little endian
+  ret->set_child(1, fb_table_vector(fields));
+  return ret;
+}
+
+/**
+ * Frames a message: continuation marker, metadata length, metadata.
+ * The returned string is a multiple of 8 bytes.
+ */
+std::string encode_message(uint8_t header_type, fb_ptr header,
+                           int64_t body_length) {
+  auto message = fb_table();
+  message->set_scalar<int16_t>(0, METADATA_VERSION_V5);
+  message->set_scalar<uint8_t>(1, header_type);
+  message->set_child(2, header);
+  message->set_scalar<int64_t>(3, body_length);
+
+  std::string metadata = fb_encoder().finish(*message);
+  std::string ret;
+  append_scalar<uint32_t>(ret, CONTINUATION_MARKER);
+  append_scalar<int32_t>(ret, metadata.size());
+  ret.append(metadata);
+  return ret;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Schema decoding
+
+std::string type_name(int type_id) {
+  static const char* names[] = {
+    "NONE", "Null", "Int", "FloatingPoint", "Binary", "Utf8", "Bool",
+    "Decimal", "Date", "Time", "Timestamp", "Interval", "List", "Struct",
+    "Union", "FixedSizeBinary", "FixedSizeList", "Map", "Duration",
+    "LargeBinary", "LargeUtf8", "LargeList"};
+  if (type_id >= 0 && type_id < int(sizeof(names) / sizeof(names[0]))) {
+    return names[type_id];
+  }
+  return "type " + std::to_string(type_id);
+}
+
+/**
+ * Decodes a numeric type (Int, Bool or FloatingPoint) into
+ * (type_id, bit_width, is_signed). Throws on other types.
+ */
+void decode_numeric_type(const fb_view& field, const std::string& name,
+                         int& type_id, int& bit_width, bool& is_signed) {
+  type_id = field.scalar<uint8_t>(2, 0);
+  if (type_id == TYPE_INT) {
+    fb_view t = field.table(3);
+    bit_width = t.scalar<int32_t>(0, 0);
+    is_signed = t.scalar<uint8_t>(1, 0) != 0;
+    if (bit_width != 8 && bit_width != 16 && bit_width != 32 && bit_width != 64) {
+      log_and_throw("Unsupported integer width in Arrow column " + name);
+    }
+  } else if (type_id == TYPE_FLOATING_POINT) {
+    int16_t precision = field.table(3).scalar<int16_t>(0, 0);
+    if (precision == PRECISION_SINGLE) {
+      bit_width = 32;
+    } else if (precision == PRECISION_DOUBLE) {
+      bit_width = 64;
+    } else {
+      log_and_throw("Half precision floats are not supported (Arrow column "
+                    + name + ")");
+    }
+  } else if (type_id == TYPE_BOOL) {
+    bit_width = 1;
+  } else {
+    log_and_throw("Unsupported Arrow type " + type_name(type_id) +
+                  " in column " + name);
+  }
+}
+
+void decode_field(const fb_view& field, field_desc& desc,
+                  file_reader::physical_type& phys) {
+  desc.name = field.string(0);
+  if (field.has(4)) {
+    log_and_throw("Dictionary encoded Arrow columns are not supported (column "
+                  + desc.name + ")");
+  }
+  for (size_t i = 0; i < field.vector_length(6); ++i) {
+    fb_view kv = field.table_at(6, i);
+    desc.metadata.push_back({kv.string(0), kv.string(1)});
+  }
+
+  phys = file_reader::physical_type();
+  phys.type_id = field.scalar<uint8_t>(2, 0);
+  switch(phys.type_id) {
+    case TYPE_NULL:
+      desc.type = arrow_type::NULL_TYPE;
+      break;
+    case TYPE_INT:
+    case TYPE_BOOL:
+    case TYPE_FLOATING_POINT:
+      decode_numeric_type(field, desc.name, phys.type_id, phys.bit_width,
+                          phys.is_signed);
+      desc.type = (phys.type_id == TYPE_FLOATING_POINT) ? arrow_type::FLOAT64
+                                                        : arrow_type::INT64;
+      break;
+    case TYPE_UTF8:
+      desc.type = arrow_type::UTF8;
+      break;
+    case TYPE_BINARY:
+      desc.type = arrow_type::BINARY;
+      break;
+    case TYPE_TIMESTAMP: {
+      int16_t unit = field.table(3).scalar<int16_t>(0, 0);
+      static const int64_t micros_per_tick[] = {1000000, 1000, 1, 1};
+      if (unit < 0 || unit > 3) log_and_throw("Corrupted Arrow metadata");
+      phys.time_unit_multiplier = micros_per_tick[unit];
+      phys.time_unit_divisor = (unit == 3) ? 1000 : 1;
+      desc.type = arrow_type::TIMESTAMP_MICROS;
+      break;
+    }
+    case TYPE_LIST: {
+      if (field.vector_length(5) != 1) log_and_throw("Corrupted Arrow metadata");
+      fb_view child = field.table_at(5, 0);
+      decode_numeric_type(child, desc.name, phys.child_type_id,
+                          phys.child_bit_width, phys.child_is_signed);
+      desc.type = arrow_type::LIST_FLOAT64;
+      break;
+    }
+    default:
+      log_and_throw("Unsupported Arrow type " + type_name(phys.type_id) +
+                    " in column " + desc.name);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Record batch body helpers
+
+struct body_writer {
+  std::string body;
+  std::string buffers;  // Buffer structs {offset, length}
+
+  void add(const void* data, size_t len) {
+    append_scalar<int64_t>(buffers, body.size());
+    append_scalar<int64_t>(buffers, len);
+    body.append(reinterpret_cast<const char*>(data), len);
+    body.resize(round_up(body.size(), 8), 0);
+  }
+};
+
+struct body_reader {
+  body_reader(const std::string& body, const fb_view& batch)
+      : body(body), batch(batch), num_buffers(batch.vector_length(2)) { }
+
+  const std::string& body;
+  fb_view batch;
+  size_t num_buffers;
+  size_t next_buffer = 0;
+
+  std::pair<const char*, size_t> next() {
+    if (next_buffer >= num_buffers) log_and_throw("Corrupted Arrow record batch");
+    int64_t offset = batch.struct_at<int64_t>(2, next_buffer, 16, 0);
+    int64_t length = batch.struct_at<int64_t>(2, next_buffer, 16, 8);
+    ++next_buffer;
+    if (offset < 0 || length < 0 || size_t(offset) > body.size() ||
+        size_t(length) > body.size() - size_t(offset)) {
+      log_and_throw("Corrupted Arrow record batch");
+    }
+    return {body.data() + offset, size_t(length)};
+  }
+};
+
+void require_size(const std::pair<const char*, size_t>& buf, size_t len) {
+  if (buf.second < len) log_and_throw("Corrupted Arrow record batch");
+}
+
+/// Decodes a validity buffer into col (col.length and null_count are set).
+void decode_validity(const std::pair<const char*, size_t>& buf,
+                     column_buffers& col) {
+  col.validity.clear();
+  if (col.null_count == 0) return;
+  size_t nbytes = (col.length + 7) / 8;
+  require_size(buf, nbytes);
+  col.validity.assign(reinterpret_cast<const uint8_t*>(buf.first),
+                      reinterpret_cast<const uint8_t*>(buf.first) + nbytes);
+}
+
+/// Reads value i of a numeric buffer as a double or an integer.
+template <typename T>
+T read_numeric(const char* data, size_t i, int type_id, int bit_width,
+               bool is_signed) {
+  if (type_id == TYPE_BOOL) {
+    return T((data[i >> 3] >> (i & 7)) & 1);
+  }
+  if (type_id == TYPE_FLOATING_POINT) {
+    if (bit_width == 32) {
+      float v;
+      std::memcpy(&v, data + 4 * i, 4);
+      return T(v);
+    }
+    double v;
+    std::memcpy(&v, data + 8 * i, 8);
+    return T(v);
+  }
+#define TURI_ARROW_READ_INT(signed_t, unsigned_t)                  \
+  {                                                                \
+    if (is_signed) {                                               \
+      signed_t v; std::memcpy(&v, data + sizeof(v) * i, sizeof(v)); \
+      return T(v);                                                 \
+    } else {                                                       \
+      unsigned_t v; std::memcpy(&v, data + sizeof(v) * i, sizeof(v)); \
+      return T(v);                                                 \
+    }                                                              \
+  }
+  switch(bit_width) {
+    case 8: TURI_ARROW_READ_INT(int8_t, uint8_t);
+    case 16: TURI_ARROW_READ_INT(int16_t, uint16_t);
+    case 32: TURI_ARROW_READ_INT(int32_t, uint32_t);
+    default: TURI_ARROW_READ_INT(int64_t, uint64_t);
+  }
+#undef TURI_ARROW_READ_INT
+}
+
+inline size_t numeric_buffer_size(size_t n, int type_id, int bit_width) {
+  return type_id == TYPE_BOOL ? (n + 7) / 8 : n * (bit_width / 8);
+}
+
+/**
+ * Decodes the length + 1 int32 offsets of col, rebasing them to start at 0.
+ * Returns the first offset (the start of the values in the data buffer).
+ * The offsets must be non-negative and non-decreasing.
+ */
+int32_t decode_offsets(const std::pair<const char*, size_t>& buf,
+                       column_buffers& col) {
+  require_size(buf, sizeof(int32_t) * (col.length + 1));
+  col.offsets.resize(col.length + 1);
+  std::memcpy(col.offsets.data(), buf.first, sizeof(int32_t) * (col.length + 1));
+  int32_t base = col.offsets[0];
+  if (base < 0) log_and_throw("Corrupted Arrow record batch");
+  for (size_t i = 0; i < col.length; ++i) {
+    if (col.offsets[i] > col.offsets[i + 1]) {
+      log_and_throw("Corrupted Arrow record batch: decreasing offsets");
+    }
+  }
+  for (auto& o : col.offsets) o -= base;
+  return base;
+}
+
+} // anonymous namespace
+
+////////////////////////////////////////////////////////////////////////////////
+// field_desc and column_buffers
+
+std::string field_desc::get_metadata(const std::string& key) const {
+  for (const auto& kv : metadata) {
+    if (kv.first == key) return kv.second;
+  }
+  return "";
+}
+
+void column_buffers::clear() {
+  length = 0;
+  null_count = 0;
+  validity.clear();
+  offsets.clear();
+  data.clear();
+}
+
+void column_buffers::append_validity(bool valid) {
+  if (valid && validity.empty()) return;
+  if (validity.empty()) {
+    // First null. Materialize the bitmap of the previous (valid) values.
+    validity.assign((length + 8) / 8, 0);
+    for (size_t i = 0; i < length; ++i) validity[i >> 3] |= uint8_t(1 << (i & 7));
+  }
+  if (validity.size() < (length + 8) / 8) validity.resize((length + 8) / 8, 0);
+  if (valid) {
+    validity[length >> 3] |= uint8_t(1 << (length & 7));
+  } else {
+    validity[length >> 3] &= uint8_t(~(1 << (length & 7)));
+  }
+}
+
+void column_buffers::append_null(arrow_type type) {
+  append_validity(false);
+  ++null_count;
+  switch(type) {
+    case arrow_type::NULL_TYPE:
+      break;
+    case arrow_type::INT64:
+    case arrow_type::TIMESTAMP_MICROS:
+    case arrow_type::FLOAT64:
+      data.append(sizeof(int64_t), 0);
+      break;
+    case arrow_type::UTF8:
+    case arrow_type::BINARY:
+    case arrow_type::LIST_FLOAT64:
+      if (offsets.empty()) offsets.push_back(0);
+      offsets.push_back(offsets.back());
+      break;
+  }
+  ++length;
+}
+
+void column_buffers::append_int64(int64_t value) {
+  append_validity(true);
+  append_scalar<int64_t>(data, value);
+  ++length;
+}
+
+void column_buffers::append_double(double value) {
+  append_validity(true);
+  append_scalar<double>(data, value);
+  ++length;
+}
+
+void column_buffers::append_bytes(const char* value, size_t len) {
+  append_validity(true);
+  if (offsets.empty()) offsets.push_back(0);
+  if (data.size() + len > size_t(std::numeric_limits<int32_t>::max())) {
+    log_and_throw("Arrow record batch too large");
+  }
+  data.append(value, len);
+  offsets.push_back(data.size());
+  ++length;
+}
+
+void column_buffers::append_double_list(const double* values, size_t len) {
+  append_validity(true);
+  if (offsets.empty()) offsets.push_back(0);
+  if ((data.size() / sizeof(double)) + len >
+      size_t(std::numeric_limits<int32_t>::max())) {
+    log_and_throw("Arrow record batch too large");
+  }
+  data.append(reinterpret_cast<const char*>(values), len * sizeof(double));
+  offsets.push_back(data.size() / sizeof(double));
+  ++length;
+}
+
+void column_buffers::truncate(size_t n, arrow_type type) {
+  if (n >= length) return;
+  switch(type) {
+    case arrow_type::NULL_TYPE:
+      break;
+    case arrow_type::INT64:
+    case arrow_type::TIMESTAMP_MICROS:
+    case arrow_type::FLOAT64:
+      data.resize(n * sizeof(int64_t));
+      break;
+    case arrow_type::UTF8:
+    case arrow_type::BINARY:
+      data.resize(offsets[n]);
+      offsets.resize(n + 1);
+      break;
+    case arrow_type::LIST_FLOAT64:
+      data.resize(offsets[n] * sizeof(double));
+      offsets.resize(n + 1);
+      break;
+  }
+  if (!validity.empty()) {
+    validity.resize((n + 7) / 8);
+    // clear the bits past the end
+    if (n & 7) validity.back() &= uint8_t((1 << (n & 7)) - 1);
+    null_count = 0;
+    for (size_t i = 0; i < n; ++i) null_count += !is_valid(i);
+  }
+  length = n;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Record batch encoding
+
+std::string encode_record_batch(const std::vector<field_desc>& schema,
+                                const std::vector<column_buffers>& columns) {
+  ASSERT_EQ(schema.size(), columns.size());
+  size_t num_rows = columns.empty() ? 0 : columns[0].length;
+
+  std::string nodes;
+  body_writer body;
+  const int32_t zero_offset = 0;
+
+  for (size_t i = 0; i < schema.size(); ++i) {
+    const column_buffers& col = columns[i];
+    ASSERT_EQ(col.length, num_rows);
+
+    append_scalar<int64_t>(nodes, col.length);
+    append_scalar<int64_t>(nodes, col.null_count);
+    if (schema[i].type == arrow_type::NULL_TYPE) continue;
+
+    if (col.null_count > 0) {
+      ASSERT_GE(col.validity.size(), (col.length + 7) / 8);
+      body.add(col.validity.data(), (col.length + 7) / 8);
+    } else {
+      body.add(nullptr, 0);
+    }
+
+    switch(schema[i].type) {
+      case arrow_type::INT64:
+      case arrow_type::FLOAT64:
+      case arrow_type::TIMESTAMP_MICROS:
+        ASSERT_EQ(col.data.size(), col.length * 8);
+        body.add(col.data.data(), col.data.size());
+        break;
+      case arrow_type::UTF8:
+      case arrow_type::BINARY:
+        if (col.offsets.empty()) {
+          body.add(&zero_offset, sizeof(int32_t));
+        } else {
+          ASSERT_EQ(col.offsets.size(), col.length + 1);
+          body.add(col.offsets.data(), col.offsets.size() * sizeof(int32_t));
+        }
+        body.add(col.data.data(), col.data.size());
+        break;
+      case arrow_type::LIST_FLOAT64: {
+        if (col.offsets.empty()) {
+          body.add(&zero_offset, sizeof(int32_t));
+        } else {
+          ASSERT_EQ(col.offsets.size(), col.length + 1);
+          body.add(col.offsets.data(), col.offsets.size() * sizeof(int32_t));
+        }
+        // the child Float64 array
+        append_scalar<int64_t>(nodes, col.data.size() / sizeof(double));
+        append_scalar<int64_t>(nodes, 0);
+        body.add(nullptr, 0);
+        body.add(col.data.data(), col.data.size());
+        break;
+      }
+      case arrow_type::NULL_TYPE:
+        break;
+    }
+  }
+
+  auto batch = fb_table();
+  batch->set_scalar<int64_t>(0, num_rows);
+  batch->set_child(1, fb_struct_vector(nodes, 16, 8));
+  batch->set_child(2, fb_struct_vector(body.buffers, 16, 8));
+
+  std::string ret = encode_message(HEADER_RECORD_BATCH, batch, body.body.size());
+  ret.append(body.body);
+  return ret;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// file_writer
+
+file_writer::file_writer(std::ostream& out, const std::vector<field_desc>& schema)
+    : m_out(out), m_schema(schema) {
+  std::string header(ARROW_MAGIC, ARROW_MAGIC_SIZE);
+  header.resize(8, 0);
+  header.append(encode_message(HEADER_SCHEMA, encode_schema(m_schema), 0));
+  m_out.write(header.data(), header.size());
+  m_position = header.size();
+}
+
+void file_writer::write_encoded_batch(const std::string& encoded_batch) {
+  ASSERT_FALSE(m_closed);
+  ASSERT_GE(encoded_batch.size(), 8);
+  int32_t metadata_size;
+  std::memcpy(&metadata_size, encoded_batch.data() + 4, sizeof(int32_t));
+
+  block b;
+  b.offset = m_position;
+  b.metadata_length = 8 + metadata_size;
+  b.body_length = encoded_batch.size() - b.metadata_length;
+  m_blocks.push_back(b);
+
+  m_out.write(encoded_batch.data(), encoded_batch.size());
+  m_position += encoded_batch.size();
+}
+
+void file_writer::close() {
+  if (m_closed) return;
+  m_closed = true;
+
+  // end of stream marker
+  std::string trailer;
+  append_scalar<uint32_t>(trailer, CONTINUATION_MARKER);
+  append_scalar<int32_t>(trailer, 0);
+
+  std::string blocks;
+  for (const auto& b : m_blocks) {
+    append_scalar<int64_t>(blocks, b.offset);
+    append_scalar<int32_t>(blocks, b.metadata_length);
+    append_scalar<int32_t>(blocks, 0);
+    append_scalar<int64_t>(blocks, b.body_length);
+  }
+  auto footer = fb_table();
+  footer->set_scalar<int16_t>(0, METADATA_VERSION_V5);
+  footer->set_child(1, encode_schema(m_schema));
+  footer->set_child(2, fb_struct_vector("", 24, 8));
+  footer->set_child(3, fb_struct_vector(blocks, 24, 8));
+  std::string footer_bytes = fb_encoder().finish(*footer);
+
+  trailer.append(footer_bytes);
+  append_scalar<int32_t>(trailer, footer_bytes.size());
+  trailer.append(ARROW_MAGIC, ARROW_MAGIC_SIZE);
+  m_out.write(trailer.data(), trailer.size());
+  m_out.flush();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// file_reader
+
+bool has_arrow_file_magic(std::istream& in) {
+  char magic[ARROW_MAGIC_SIZE];
+  in.read(magic, ARROW_MAGIC_SIZE);
+  return in.good() && std::memcmp(magic, ARROW_MAGIC, ARROW_MAGIC_SIZE) == 0;
+}
+
+file_reader::file_reader(std::istream& in) {
+  in.seekg(0, std::ios_base::end);
+  int64_t file_size = in.tellg();
+  const int64_t trailer_size = sizeof(int32_t) + ARROW_MAGIC_SIZE;
+  if (file_size < int64_t(8 + trailer_size)) {
+    log_and_throw("Not an Arrow IPC file: file too small");
+  }
+
+  in.seekg(0, std::ios_base::beg);
+  if (!has_arrow_file_magic(in)) {
+    log_and_throw("Not an Arrow IPC file: bad header magic");
+  }
+
+  std::string trailer(trailer_size, 0);
+  in.seekg(file_size - trailer_size, std::ios_base::beg);
+  in.read(&trailer[0], trailer_size);
+  if (!in.good() ||
+      std::memcmp(trailer.data() + 4, ARROW_MAGIC, ARROW_MAGIC_SIZE) != 0) {
+    log_and_throw("Not an Arrow IPC file: bad trailing magic");
+  }
+  int32_t footer_size;
+  std::memcpy(&footer_size, trailer.data(), sizeof(int32_t));
+  if (footer_size <= 0 || footer_size > file_size - trailer_size - 8) {
+    log_and_throw("Corrupted Arrow file footer");
+  }
+
+  std::string footer_bytes(footer_size, 0);
+  in.seekg(file_size - trailer_size - footer_size, std::ios_base::beg);
+  in.read(&footer_bytes[0], footer_size);
+  if (!in.good()) log_and_throw("Unable to read Arrow file footer");
+
+  fb_view footer = fb_view::root(footer_bytes.data(), footer_bytes.size());
+  if (footer.vector_length(2) > 0) {
+    log_and_throw("Dictionary encoded Arrow files are not supported");
+  }
+
+  fb_view schema = footer.table(1);
+  size_t num_fields = schema.vector_length(1);
+  m_schema.resize(num_fields);
+  m_physical_types.resize(num_fields);
+  for (size_t i = 0; i < num_fields; ++i) {
+    decode_field(schema.table_at(1, i), m_schema[i], m_physical_types[i]);
+  }
+
+  size_t num_batches = footer.vector_length(3);
+  for (size_t i = 0; i < num_batches; ++i) {
+    block b;
+    b.offset = footer.struct_at<int64_t>(3, i, 24, 0);
+    b.metadata_length = footer.struct_at<int32_t>(3, i, 24, 8);
+    b.body_length = footer.struct_at<int64_t>(3, i, 24, 16);
+    if (b.offset < 0 || b.metadata_length < 8 || b.body_length < 0 ||
+        b.offset + b.metadata_length + b.body_length > file_size) {
+      log_and_throw("Corrupted Arrow file footer");
+    }
+    m_blocks.push_back(b);
+  }
+}
+
+size_t file_reader::read_record_batch(std::istream& in, size_t batch_id,
+                                      std::vector<column_buffers>& columns) const {
+  ASSERT_LT(batch_id, m_blocks.size());
+  const block& b = m_blocks[batch_id];
+
+  std::string metadata(b.metadata_length, 0);
+  std::string body(b.body_length, 0);
+  in.seekg(b.offset, std::ios_base::beg);
+  in.read(&metadata[0], metadata.size());
+  if (b.body_length > 0) in.read(&body[0], body.size());
+  if (!in.good()) log_and_throw("Unable to read Arrow record batch");
+
+  // Skip the (optional) continuation marker and the metadata length prefix.
+  uint32_t prefix;
+  std::memcpy(&prefix, metadata.data(), sizeof(uint32_t));
+  size_t fb_start = (prefix == CONTINUATION_MARKER) ? 8 : 4;
+  fb_view message = fb_view::root(metadata.data() + fb_start,
+                                  metadata.size() - fb_start);
+  if (message.scalar<uint8_t>(1, 0) != HEADER_RECORD_BATCH) {
+    log_and_throw("Corrupted Arrow file: expected a record batch");
+  }
+  fb_view batch = message.table(2);
+  if (batch.has(3)) {
+    log_and_throw("Compressed Arrow record batches are not supported");
+  }
+
+  int64_t num_rows = batch.scalar<int64_t>(0, 0);
+  size_t num_nodes = batch.vector_length(1);
+  size_t next_node = 0;
+  body_reader buffers(body, batch);
+
+  auto read_node = [&](column_buffers& col) {
+    if (next_node >= num_nodes) log_and_throw("Corrupted Arrow record batch");
+    int64_t length = batch.struct_at<int64_t>(1, next_node, 16, 0);
+    int64_t null_count = batch.struct_at<int64_t>(1, next_node, 16, 8);
+    ++next_node;
+    if (length < 0 || null_count < 0 || null_count > length) {
+      log_and_throw("Corrupted Arrow record batch");
+    }
+    col.clear();
+    col.length = length;
+    col.null_count = null_count;
+  };
+
+  columns.resize(m_schema.size());
+  for (size_t i = 0; i < m_schema.size(); ++i) {
+    column_buffers& col = columns[i];
+    const physical_type& phys = m_physical_types[i];
+    read_node(col);
+    if (col.length != size_t(num_rows)) {
+      log_and_throw("Corrupted Arrow record batch: column length mismatch");
+    }
+
+    if (m_schema[i].type == arrow_type::NULL_TYPE) {
+      col.null_count = col.length;
+      col.validity.assign((col.length + 7) / 8, 0);
+      continue;
+    }
+
+    decode_validity(buffers.next(), col);
+
+    switch(m_schema[i].type) {
+      case arrow_type::INT64:
+      case arrow_type::FLOAT64: {
+        auto buf = buffers.next();
+        require_size(buf, numeric_buffer_size(col.length, phys.type_id,
+                                              phys.bit_width));
+        if (phys.bit_width == 64) {
+          col.data.assign(buf.first, col.length * 8);
+        } else {
+          col.data.resize(col.length * 8);
+          for (size_t j = 0; j < col.length; ++j) {
+            if (m_schema[i].type == arrow_type::INT64) {
+              int64_t v = read_numeric<int64_t>(buf.first, j, phys.type_id,
+                                                phys.bit_width, phys.is_signed);
+              std::memcpy(&col.data[8 * j], &v, 8);
+            } else {
+              double v = read_numeric<double>(buf.first, j, phys.type_id,
+                                              phys.bit_width, phys.is_signed);
+              std::memcpy(&col.data[8 * j], &v, 8);
+            }
+          }
+        }
+        break;
+      }
+      case arrow_type::TIMESTAMP_MICROS: {
+        auto buf = buffers.next();
+        require_size(buf, col.length * 8);
+        col.data.assign(buf.first, col.length * 8);
+        if (phys.time_unit_multiplier != 1 || phys.time_unit_divisor != 1) {
+          for (size_t j = 0; j < col.length; ++j) {
+            int64_t v = col.int64_at(j);
+            v = v * phys.time_unit_multiplier / phys.time_unit_divisor;
+            std::memcpy(&col.data[8 * j], &v, 8);
+          }
+        }
+        break;
+      }
+      case arrow_type::UTF8:
+      case arrow_type::BINARY: {
+        auto offsets_buf = buffers.next();
+        int32_t base = 0;
+        if (col.length > 0 || offsets_buf.second >= sizeof(int32_t)) {
+          base = decode_offsets(offsets_buf, col);
+        } else {
+          col.offsets.assign(1, 0);
+        }
+        auto data_buf = buffers.next();
+        size_t total = col.offsets.back();
+        if (size_t(base) > data_buf.second ||
+            total > data_buf.second - size_t(base)) {
+          log_and_throw("Corrupted Arrow record batch");
+        }
+        col.data.assign(data_buf.first + base, total);
+        break;
+      }
+      case arrow_type::LIST_FLOAT64: {
+        auto offsets_buf = buffers.next();
+        int32_t base = 0;
+        if (col.length > 0) {
+          base = decode_offsets(offsets_buf, col);
+        } else {
+          col.offsets.assign(1, 0);
+        }
+        column_buffers child;
+        read_node(child);
+        decode_validity(buffers.next(), child);
+        auto data_buf = buffers.next();
+        require_size(data_buf, numeric_buffer_size(child.length,
+                                                   phys.child_type_id,
+                                                   phys.child_bit_width));
+        size_t total = col.offsets.back();
+        if (size_t(base) + total > child.length) {
+          log_and_throw("Corrupted Arrow record batch");
+        }
+        col.data.resize(total * sizeof(double));
+        for (size_t j = 0; j < total; ++j) {
+          double v = child.is_valid(base + j)
+              ? read_numeric<double>(data_buf.first, base + j,
+                                     phys.child_type_id, phys.child_bit_width,
+                                     phys.child_is_signed)
+              : std::numeric_limits<double>::quiet_NaN();
+          std::memcpy(&col.data[sizeof(double) * j], &v, sizeof(double));
+        }
+        break;
+      }
+      case arrow_type::NULL_TYPE:
+        break;
+    }
+  }
+  return num_rows;
+}
+
+} // namespace arrow_ipc
+} // namespace turi
@@ -0,0 +1,254 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#ifndef TURI_SFRAME_ARROW_IPC_FORMAT_HPP
+#define TURI_SFRAME_ARROW_IPC_FORMAT_HPP
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <utility>
+#include <iostream>
+
+namespace turi {
+
+/**
+ * \ingroup sframe_physical
+ * \addtogroup arrow_ipc Arrow IPC Reading and Writing
+ * \{
+ */
+
+/**
+ * A minimal, dependency free implementation of the Apache Arrow IPC file
+ * format (the "Feather V2" / ".arrow" format).
+ *
+ * Only the subset of the format required to exchange SFrames is implemented:
+ *  - Flat columns of Null, Int64, Float64, Utf8, Binary and Timestamp
+ *    (microseconds) type, and List<Float64> columns.
+ *  - No dictionary batches and no body compression.
+ *
+ * On reading, the other common fixed width types (Int8-Int64 / UInt8-UInt64,
+ * Float32, Bool, Timestamp with any unit, and Lists of integers or floats)
+ * are accepted and normalized into one of the types above.
+ *
+ * All the values of a column in a record batch are held in a
+ * \ref column_buffers object, which has exactly the Arrow physical layout,
+ * so encoding and decoding a record batch are plain memory copies.
+ *
+ * The metadata (schema, record batch headers and footer) is encoded with
+ * flatbuffers. Since the layouts needed are tiny, a small flatbuffer encoder
+ * and decoder are embedded rather than depending on the flatbuffers library.
+ */
+namespace arrow_ipc {
+
+/**
+ * The (normalized) Arrow types which can be stored in a \ref column_buffers.
+ */
+enum class arrow_type: char {
+  NULL_TYPE = 0,        /**< Null. No buffers. */
+  INT64 = 1,            /**< Signed 64 bit integers. */
+  FLOAT64 = 2,          /**< Doubles. */
+  UTF8 = 3,             /**< UTF-8 strings: int32 offsets + bytes. */
+  BINARY = 4,           /**< Opaque bytes: int32 offsets + bytes. */
+  TIMESTAMP_MICROS = 5, /**< int64 microseconds since the UNIX epoch, UTC. */
+  LIST_FLOAT64 = 6      /**< List<Float64>: int32 offsets + child doubles. */
+};
+
+/**
+ * Describes one field (column) of the schema.
+ */
+struct field_desc {
+  std::string name;
+  arrow_type type = arrow_type::NULL_TYPE;
+  /// Key-value pairs stored in the custom_metadata of the field.
+  std::vector<std::pair<std::string, std::string>> metadata;
+
+  /// Returns the metadata value for the key, or an empty string.
+  std::string get_metadata(const std::string& key) const;
+};
+
+/**
+ * The values of one column of a record batch, in Arrow physical layout.
+ *
+ * - validity: LSB bitmap, 1 = valid. May be empty when null_count is 0.
+ * - offsets:  length + 1 entries for UTF8, BINARY and LIST_FLOAT64.
+ * - data:     the int64 / double values for INT64, FLOAT64 and
+ *             TIMESTAMP_MICROS, the bytes of UTF8 and BINARY, and the child
+ *             doubles of LIST_FLOAT64.
+ */
+struct column_buffers {
+  size_t length = 0;
+  size_t null_count = 0;
+  std::vector<uint8_t> validity;
+  std::vector<int32_t> offsets;
+  std::string data;
+
+  /// Resets the buffers to an empty column (keeping the allocations).
+  void clear();
+
+  /// Returns true if value i is not null.
+  inline bool is_valid(size_t i) const {
+    return validity.empty() || (validity[i >> 3] >> (i & 7)) & 1;
+  }
+
+  /// Appends a null value. The type of the column must be passed.
+  void append_null(arrow_type type);
+
+  /// Appends a value to an INT64 or TIMESTAMP_MICROS column.
+  void append_int64(int64_t value);
+
+  /// Appends a value to a FLOAT64 column.
+  void append_double(double value);
+
+  /// Appends a value to a UTF8 or BINARY column.
+  void append_bytes(const char* value, size_t len);
+
+  /// Appends a value to a LIST_FLOAT64 column.
+  void append_double_list(const double* values, size_t len);
+
+  /**
+   * Keeps only the first n values of a column of the given type. Does
+   * nothing if the column has n values or fewer.
+   */
+  void truncate(size_t n, arrow_type type);
+
+  /// Reads value i of an INT64 or TIMESTAMP_MICROS column.
+  inline int64_t int64_at(size_t i) const {
+    int64_t ret;
+    std::memcpy(&ret, data.data() + i * sizeof(int64_t), sizeof(int64_t));
+    return ret;
+  }
+
+  /// Reads value i of a FLOAT64 column.
+  inline double double_at(size_t i) const {
+    double ret;
+    std::memcpy(&ret, data.data() + i * sizeof(double), sizeof(double));
+    return ret;
+  }
+
+  /// Returns the byte range of value i of a UTF8 or BINARY column.
+  inline std::pair<const char*, size_t> bytes_at(size_t i) const {
+    return {data.data() + offsets[i], size_t(offsets[i + 1] - offsets[i])};
+  }
+
+  /// Returns the child range of value i of a LIST_FLOAT64 column.
+  inline std::pair<const double*, size_t> list_at(size_t i) const {
+    return {reinterpret_cast<const double*>(data.data()) + offsets[i],
+            size_t(offsets[i + 1] - offsets[i])};
+  }
+
+ private:
+  void append_validity(bool valid);
+};
+
+/**
+ * Encodes a record batch message (metadata and body) into a byte string
+ * which can be passed to \ref file_writer::write_encoded_batch.
+ *
+ * All columns must have the same length. This function does not touch
+ * any shared state and can be called concurrently.
+ */
+std::string encode_record_batch(const std::vector<field_desc>& schema,
+                                const std::vector<column_buffers>& columns);
+
+/**
+ * Writes an Arrow IPC file to a stream.
+ *
+ * \code
+ * arrow_ipc::file_writer writer(out, schema);
+ * writer.write_encoded_batch(arrow_ipc::encode_record_batch(schema, cols));
+ * ...
+ * writer.close();
+ * \endcode
+ *
+ * The stream does not need to be seekable.
+ */
+class file_writer {
+ public:
+  /// Writes the file header and the schema.
+  file_writer(std::ostream& out, const std::vector<field_desc>& schema);
+
+  /// Appends a batch produced by \ref encode_record_batch.
+  void write_encoded_batch(const std::string& encoded_batch);
+
+  /// Writes the footer. Must be called once all batches are written.
+  void close();
+
+ private:
+  struct block {
+    int64_t offset;
+    int32_t metadata_length;
+    int64_t body_length;
+  };
+
+  std::ostream& m_out;
+  std::vector<field_desc> m_schema;
+  std::vector<block> m_blocks;
+  int64_t m_position = 0;
+  bool m_closed = false;
+};
+
+/**
+ * Reads an Arrow IPC file.
+ *
+ * The constructor reads the footer and the schema. Record batches can then
+ * be read in any order, and concurrently as long as every thread passes its
+ * own stream over the same file to \ref read_record_batch.
+ *
+ * Throws a std::string on format errors or unsupported types.
+ */
+class file_reader {
+ public:
+  /// Opens the file read through the seekable stream in.
+  explicit file_reader(std::istream& in);
+
+  /// The normalized schema of the file.
+  inline const std::vector<field_desc>& schema() const { return m_schema; }
+
+  /// The number of record batches in the file.
+  inline size_t num_record_batches() const { return m_blocks.size(); }
+
+  /**
+   * Reads record batch batch_id into columns (one entry per field of
+   * \ref schema()). Returns the number of rows of the batch.
+   */
+  size_t read_record_batch(std::istream& in, size_t batch_id,
+                           std::vector<column_buffers>& columns) const;
+
+  /**
+   * The Arrow type of a field, as found in the file. Used internally to
+   * normalize the buffers of a record batch.
+   */
+  struct physical_type {
+    int type_id = 0;
+    int bit_width = 64;
+    bool is_signed = true;
+    int64_t time_unit_divisor = 1;  // timestamps: ticks per microsecond
+    int64_t time_unit_multiplier = 1; // timestamps: microseconds per tick
+    int child_type_id = 0;
+    int child_bit_width = 64;
+    bool child_is_signed = true;
+  };
+
+ private:
+  struct block {
+    int64_t offset;
+    int32_t metadata_length;
+    int64_t body_length;
+  };
+
+  std::vector<field_desc> m_schema;
+  std::vector<physical_type> m_physical_types;
+  std::vector<block> m_blocks;
+};
+
+/// Returns true if the stream starts with the Arrow IPC file magic.
+bool has_arrow_file_magic(std::istream& in);
+
+} // namespace arrow_ipc
+
+/// \}
+} // namespace turi
+#endif
@@ -0,0 +1,342 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+#include <sframe/column_sketch.hpp>
+#include <sframe/sarray.hpp>
+#include <sframe/sframe.hpp>
+#include <sframe/sframe_constants.hpp>
+#include <sframe/sarray_v2_block_types.hpp>
+#include <sframe/sarray_v2_type_encoding.hpp>
+#include <fileio/fs_utils.hpp>
+#include <fileio/general_fstream.hpp>
+#include <fileio/sanitize_url.hpp>
+#include <logger/logger.hpp>
+
+namespace turi {
+
+namespace {
+const std::string COLUMN_SKETCH_FILE_MAGIC = "column_sketch";
+const size_t COLUMN_SKETCH_FILE_VERSION = 2;
+}
+
+constexpr size_t column_sketch::HYPERLOGLOG_BITS;
+constexpr size_t column_sketch::MAX_FREQUENT_ITEMS;
+
+bool column_sketch::supports_type(flex_type_enum type) {
+  return type == flex_type_enum::INTEGER || type == flex_type_enum::FLOAT ||
+         type == flex_type_enum::STRING || type == flex_type_enum::DATETIME;
+}
+
+column_sketch::column_sketch()
+    : m_unique(HYPERLOGLOG_BITS),
+      m_frequent(new sketches::space_saving_flextype(1.0 / MAX_FREQUENT_ITEMS)) { }
+
+void column_sketch::add(const flexible_type& val) {
+  DASSERT_FALSE(m_finalized);
+  ++m_size;
+  switch (val.get_type()) {
+    case flex_type_enum::UNDEFINED:
+      ++m_num_undefined;
+      return;
+    case flex_type_enum::FLOAT:
+      if (std::isnan(val.get<flex_float>())) return;
+      // fall through
+    case flex_type_enum::INTEGER: {
+      double dval = val.to<double>();
+      m_quantiles.add(dval);
+      m_sum += dval;
+      ++m_num_numeric;
+      double delta = dval - m_mean;
+      m_mean += delta / m_num_numeric;
+      m_m2 += delta * (dval - m_mean);
+      break;
+    }
+    default:
+      break;
+  }
+  if (m_min.get_type() == flex_type_enum::UNDEFINED || val < m_min) m_min = val;
+  if (m_max.get_type() == flex_type_enum::UNDEFINED || m_max < val) m_max = val;
+  m_unique.add(val);
+  m_frequent->add(val);
+}
+
+void column_sketch::finalize() {
+  if (m_finalized) return;
+  if (m_num_numeric > 0) m_quantiles.substream_finalize();
+  m_frequent_items = m_frequent->frequent_items();
+  std::sort(m_frequent_items.begin(), m_frequent_items.end(),
+            [](const std::pair<flexible_type, size_t>& a,
+               const std::pair<flexible_type, size_t>& b) {
+              return a.second > b.second;
+            });
+  // The counts of a space saving sketch add up to the number of values it
+  // saw, and it tracks more than MAX_FREQUENT_ITEMS values before evicting
+  // any: if at most that many are listed and their counts add up, every
+  // value is listed with its exact count. Otherwise a value left out is
+  // less frequent than the least frequent one kept.
+  size_t listed_count = 0;
+  for (const auto& item: m_frequent_items) listed_count += item.second;
+  bool complete = m_frequent_items.size() <= MAX_FREQUENT_ITEMS &&
+                  listed_count == m_frequent->size();
+  if (m_frequent_items.size() > MAX_FREQUENT_ITEMS) {
+    m_frequent_items.resize(MAX_FREQUENT_ITEMS);
+  }
+  m_frequent_items_cutoff = 0;
+  if (!complete) {
+    m_frequent_items_cutoff = m_frequent_items.empty()
+                                  ? m_frequent->size()
+                                  : m_frequent_items.back().second;
+  }
+  m_frequent.reset();
+  m_finalized = true;
+}
+
+column_sketch column_sketch::merge(const std::vector<const column_sketch*>& sketches) {
+  column_sketch ret;
+  // The summed count of every value listed by some sketch, and the most it
+  // may miss: the cutoffs of the sketches not listing it.
+  std::unordered_map<flexible_type, std::pair<size_t, size_t>> frequent_counts;
+  size_t total_cutoff = 0;
+  for (const column_sketch* sketch: sketches) {
+    total_cutoff += sketch->m_frequent_items_cutoff;
+  }
+  for (const column_sketch* sketch: sketches) {
+    ASSERT_TRUE(sketch->m_finalized);
+    ret.m_size += sketch->m_size;
+    ret.m_num_undefined += sketch->m_num_undefined;
+    if (sketch->m_min.get_type() != flex_type_enum::UNDEFINED &&
+        (ret.m_min.get_type() == flex_type_enum::UNDEFINED ||
+         sketch->m_min < ret.m_min)) {
+      ret.m_min = sketch->m_min;
+    }
+    if (sketch->m_max.get_type() != flex_type_enum::UNDEFINED &&
+        (ret.m_max.get_type() == flex_type_enum::UNDEFINED ||
+         ret.m_max < sketch->m_max)) {
+      ret.m_max = sketch->m_max;
+    }
+    size_t num_numeric = ret.m_num_numeric + sketch->m_num_numeric;
+    if (num_numeric > 0) {
+      double delta = sketch->m_mean - ret.m_mean;
+      ret.m_mean = (ret.m_mean * ret.m_num_numeric +
+                    sketch->m_mean * sketch->m_num_numeric) / num_numeric;
+      ret.m_m2 += sketch->m_m2 + delta * delta * ret.m_num_numeric *
+                  sketch->m_num_numeric / num_numeric;
+    }
+    ret.m_num_numeric = num_numeric;
+    ret.m_sum += sketch->m_sum;
+    if (sketch->m_num_numeric > 0) ret.m_quantiles.combine(sketch->m_quantiles);
+    ret.m_unique.combine(sketch->m_unique);
+    for (const auto& item: sketch->m_frequent_items) {
+      auto& counts = frequent_counts[item.first];
+      if (counts.first == 0) counts.second = total_cutoff;
+      counts.first += item.second;
+      counts.second -= sketch->m_frequent_items_cutoff;
+    }
+  }
+  if (ret.m_num_numeric > 0) ret.m_quantiles.combine_finalize();
+  // A value left out of a sketch would be under-counted: only list the
+  // values whose counts are complete, and bound the others by the cutoff.
+  ret.m_frequent_items_cutoff = total_cutoff;
+  for (const auto& item: frequent_counts) {
+    if (item.second.second == 0) {
+      ret.m_frequent_items.emplace_back(item.first, item.second.first);
+    } else {
+      ret.m_frequent_items_cutoff =
+          std::max(ret.m_frequent_items_cutoff,
+                   item.second.first + item.second.second);
+    }
+  }
+  std::sort(ret.m_frequent_items.begin(), ret.m_frequent_items.end(),
+            [](const std::pair<flexible_type, size_t>& a,
+               const std::pair<flexible_type, size_t>& b) {
+              return a.second > b.second;
+            });
+  if (ret.m_frequent_items.size() > MAX_FREQUENT_ITEMS) {
+    ret.m_frequent_items_cutoff =
+        std::max(ret.m_frequent_items_cutoff,
+                 ret.m_frequent_items[MAX_FREQUENT_ITEMS].second);
+    ret.m_frequent_items.resize(MAX_FREQUENT_ITEMS);
+  }
+  ret.m_frequent.reset();
+  ret.m_finalized = true;
+  return ret;
+}
+
+void column_sketch::save(oarchive& oarc) const {
+  ASSERT_TRUE(m_finalized);
+  oarc << m_size << m_num_undefined << m_min << m_max
+       << m_num_numeric << m_sum << m_mean << m_m2
+       << m_quantiles << m_unique << m_frequent_items
+       << m_frequent_items_cutoff;
+}
+
+void column_sketch::load(iarchive& iarc) {
+  iarc >> m_size >> m_num_undefined >> m_min >> m_max
+       >> m_num_numeric >> m_sum >> m_mean >> m_m2
+       >> m_quantiles >> m_unique >> m_frequent_items
+       >> m_frequent_items_cutoff;
+  m_frequent.reset();
+  m_finalized = true;
+}
+
+std::string column_sketch_file_name(const std::string& group_index_file) {
+  return group_index_file + ".sketch";
+}
+
+void write_column_sketch_file(
+    const group_index_file_information& info,
+    const std::vector<std::vector<std::shared_ptr<column_sketch>>>& sketches) {
+  ASSERT_EQ(sketches.size(), info.columns.size());
+  oarchive oarc;
+  oarc << COLUMN_SKETCH_FILE_MAGIC << COLUMN_SKETCH_FILE_VERSION
+       << sketches.size();
+  // Every column is serialized apart, so that reading a column skips the
+  // columns before it without decoding them.
+  for (size_t i = 0; i < sketches.size(); ++i) {
+    oarchive column_oarc;
+    if (!sketches[i].empty()) {
+      ASSERT_EQ(sketches[i].size(), info.nsegments);
+      column_oarc << info.columns[i].segment_sizes;
+      for (const auto& sketch: sketches[i]) column_oarc << *sketch;
+    }
+    oarc << (column_oarc.off > 0 ? std::string(column_oarc.buf, column_oarc.off)
+                                 : std::string());
+    free(column_oarc.buf);
+  }
+
+  std::string fname = column_sketch_file_name(info.group_index_file);
+  general_ofstream fout(fname);
+  fout.write(oarc.buf, oarc.off);
+  free(oarc.buf);
+  if (!fout.good()) {
+    log_and_throw_io_failure("Fail to write. Disk may be full.");
+  }
+  fout.close();
+}
+
+std::vector<std::shared_ptr<column_sketch>>
+read_column_segment_sketches(const index_file_information& info) {
+  std::vector<std::shared_ptr<column_sketch>> ret;
+  if (info.version != 2 && info.version != NESTED_INDEX_FILE_VERSION) return ret;
+  auto parsed_fname = parse_v2_segment_filename(info.index_file);
+  size_t column_id = parsed_fname.second == (size_t)(-1) ? 0 : parsed_fname.second;
+  std::string fname = column_sketch_file_name(parsed_fname.first);
+  if (fileio::get_file_status(fname) != fileio::file_status::REGULAR_FILE) {
+    return ret;
+  }
+
+  try {
+    general_ifstream fin(fname);
+    std::string contents((std::istreambuf_iterator<char>(fin)),
+                         std::istreambuf_iterator<char>());
+    iarchive iarc(contents.data(), contents.size());
+    std::string magic;
+    size_t version = 0, num_columns = 0;
+    iarc >> magic;
+    if (magic != COLUMN_SKETCH_FILE_MAGIC) return ret;
+    iarc >> version >> num_columns;
+    if (version != COLUMN_SKETCH_FILE_VERSION || column_id >= num_columns) {
+      return ret;
+    }
+    std::string column_sketches;
+    for (size_t i = 0; i <= column_id; ++i) iarc >> column_sketches;
+    if (column_sketches.empty()) return ret;
+    iarchive column_iarc(column_sketches.data(), column_sketches.size());
+    std::vector<size_t> segment_sizes;
+    column_iarc >> segment_sizes;
+    // the sketches must describe the column as it is now
+    if (segment_sizes != info.segment_sizes) return ret;
+    for (size_t i = 0; i < segment_sizes.size(); ++i) {
+      auto sketch = std::make_shared<column_sketch>();
+      column_iarc >> *sketch;
+      ret.push_back(sketch);
+    }
+  } catch (...) {
+    logstream(LOG_WARNING) << "Unable to read column sketches from "
+                           << sanitize_url(fname) << std::endl;
+    ret.clear();
+  }
+  return ret;
+}
+
+std::shared_ptr<column_sketch> read_column_sketch(const index_file_information& info) {
+  auto segment_sketches = read_column_segment_sketches(info);
+  if (segment_sketches.empty()) return nullptr;
+  std::vector<const column_sketch*> sketches;
+  for (const auto& sketch: segment_sketches) sketches.push_back(sketch.get());
+  return std::make_shared<column_sketch>(column_sketch::merge(sketches));
+}
+
+std::shared_ptr<column_sketch> sarray_column_sketch(const sarray<flexible_type>& column) {
+  if (!column_sketch::supports_type(column.get_type())) return nullptr;
+  return read_column_sketch(column.get_index_info());
+}
+
+bool sketch_column_when_saving(flex_type_enum type) {
+  return SFRAME_SAVE_COLUMN_SKETCHES && column_sketch::supports_type(type);
+}
+
+bool sketch_column_when_saving(const sarray<flexible_type>& column) {
+  return sketch_column_when_saving(column.get_type());
+}
+
+std::vector<std::shared_ptr<column_sketch>>
+regroup_column_sketches(const index_file_information& info,
+                        const std::vector<size_t>& boundaries) {
+  std::vector<std::shared_ptr<column_sketch>> ret;
+  auto segment_sketches = read_column_segment_sketches(info);
+  if (segment_sketches.empty() || boundaries.empty()) return ret;
+
+  // Merge the source segments of every new segment, as long as the new
+  // segments begin where source segments do.
+  size_t source_segment = 0;
+  size_t row = 0;
+  for (size_t i = 0; i + 1 < boundaries.size(); ++i) {
+    if (row != boundaries[i]) return {};
+    std::vector<const column_sketch*> sketches;
+    while (row < boundaries[i + 1] && source_segment < segment_sketches.size()) {
+      sketches.push_back(segment_sketches[source_segment].get());
+      row += info.segment_sizes[source_segment];
+      ++source_segment;
+    }
+    // skip the empty source segments at the end of the new segment
+    while (source_segment < segment_sketches.size() &&
+           info.segment_sizes[source_segment] == 0) {
+      sketches.push_back(segment_sketches[source_segment].get());
+      ++source_segment;
+    }
+    if (row != boundaries[i + 1]) return {};
+    ret.push_back(std::make_shared<column_sketch>(column_sketch::merge(sketches)));
+  }
+  return ret;
+}
+
+bool add_block_to_sketch(const v2_block_impl::block_info& info,
+                         char* data, size_t len,
+                         column_sketch& sketch) {
+  if (!(info.flags & v2_block_impl::IS_FLEXIBLE_TYPE)) return false;
+  std::vector<flexible_type> values;
+  if (!v2_block_impl::typed_decode(info, data, len, values)) return false;
+  for (const auto& val: values) sketch.add(val);
+  return true;
+}
+
+bool estimate_num_distinct(const sframe& sf,
+                           const std::vector<size_t>& column_ids,
+                           double& ret) {
+  ret = 1;
+  for (size_t column_id: column_ids) {
+    auto sketch = sarray_column_sketch(*sf.select_column(column_id));
+    if (sketch == nullptr) return false;
+    ret *= sketch->num_unique() + (sketch->num_undefined() > 0 ? 1 : 0);
+  }
+  ret = std::min<double>(ret, sf.num_rows());
+  return true;
+}
+
+} // namespace turi
@@ -0,0 +1,227 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#ifndef TURI_SFRAME_COLUMN_SKETCH_HPP
+#define TURI_SFRAME_COLUMN_SKETCH_HPP
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#include <flexible_type/flexible_type.hpp>
+#include <sframe/sarray_index_file.hpp>
+#include <sketches/hyperloglog.hpp>
+#include <sketches/space_saving_flextype.hpp>
+#include <sketches/streaming_quantile_sketch.hpp>
+
+namespace turi {
+template <typename T>
+class sarray;
+class sframe;
+namespace v2_block_impl {
+struct block_info;
+}
+
+/**
+ * \ingroup sframe_physical
+ * \addtogroup sframe_internal SFrame Internal
+ * \{
+ */
+
+/**
+ * Mergeable summary of the values of (a segment of) a column: the number
+ * of values and of missing values, the minimum and maximum, the moments and
+ * quantiles of the numeric values, the number of unique values
+ * (hyperloglog) and the frequent values (space saving).
+ *
+ * A sketch is filled with \ref add, then \ref finalize'd before being
+ * queried, saved or merged. NaN values are counted, but are otherwise
+ * skipped like missing values, as in unity_sketch.
+ *
+ * Sketches of the segments of saved columns are written next to the
+ * array index file (see \ref write_column_sketch_file) and merged on
+ * demand by \ref read_column_sketch, so that summaries and the sizing of
+ * groupby and join tables do not need to scan the column.
+ */
+class column_sketch {
+ public:
+  /// The number of hyperloglog hash bins is 2^HYPERLOGLOG_BITS, as in
+  /// unity_sketch.
+  static constexpr size_t HYPERLOGLOG_BITS = 16;
+  /// The maximum number of frequent values kept.
+  static constexpr size_t MAX_FREQUENT_ITEMS = 1000;
+
+  /**
+   * Returns true if columns of the given type can be sketched. Only the
+   * scalar types are: integers, floats, strings and datetimes.
+   */
+  static bool supports_type(flex_type_enum type);
+
+  column_sketch();
+
+  /// Adds a value. Must not be called once the sketch is finalized.
+  void add(const flexible_type& val);
+
+  /// Prepares the sketch for queries, \ref save and \ref merge.
+  void finalize();
+
+  /**
+   * Merges finalized sketches of disjoint parts of a column into a
+   * finalized sketch of the whole.
+   */
+  static column_sketch merge(const std::vector<const column_sketch*>& sketches);
+
+  /// The number of values, including the missing values.
+  size_t size() const { return m_size; }
+
+  /// The number of missing (UNDEFINED) values.
+  size_t num_undefined() const { return m_num_undefined; }
+
+  /**
+   * The smallest and largest values which are neither missing nor NaN.
+   * UNDEFINED if there are none.
+   */
+  const flexible_type& min() const { return m_min; }
+  const flexible_type& max() const { return m_max; }
+
+  /// The number of integer and float values which are not NaN.
+  size_t num_numeric() const { return m_num_numeric; }
+  double sum() const { return m_sum; }
+  double mean() const { return m_mean; }
+  /// The sum of the squared differences of the numeric values to the mean.
+  double m2() const { return m_m2; }
+
+  /// The estimated number of unique values, without the missing values.
+  double num_unique() const { return m_unique.estimate(); }
+
+  /// The unique value count sketch.
+  const sketches::hyperloglog& unique_sketch() const { return m_unique; }
+
+  /**
+   * The quantile sketch of the numeric values. Only queryable if there is
+   * at least one numeric value.
+   */
+  const sketches::streaming_quantile_sketch<double>& quantiles() const {
+    return m_quantiles;
+  }
+
+  /**
+   * The most frequent values with their (over)estimated counts. A value
+   * which is not listed occurs at most \ref frequent_items_cutoff times.
+   */
+  const std::vector<std::pair<flexible_type, size_t>>& frequent_items() const {
+    return m_frequent_items;
+  }
+
+  /**
+   * An upper bound on the count of the values missing from
+   * \ref frequent_items. 0 if every value is listed.
+   */
+  size_t frequent_items_cutoff() const { return m_frequent_items_cutoff; }
+
+  void save(oarchive& oarc) const;
+  void load(iarchive& iarc);
+
+ private:
+  bool m_finalized = false;
+  size_t m_size = 0;
+  size_t m_num_undefined = 0;
+  flexible_type m_min = FLEX_UNDEFINED;
+  flexible_type m_max = FLEX_UNDEFINED;
+  size_t m_num_numeric = 0;
+  double m_sum = 0;
+  double m_mean = 0;
+  double m_m2 = 0;
+  sketches::streaming_quantile_sketch<double> m_quantiles;
+  sketches::hyperloglog m_unique;
+  /// Only used until the sketch is finalized.
+  std::unique_ptr<sketches::space_saving_flextype> m_frequent;
+  std::vector<std::pair<flexible_type, size_t>> m_frequent_items;
+  size_t m_frequent_items_cutoff = 0;
+};
+
+/**
+ * The name of the file holding the column sketches of an array group,
+ * next to its index file.
+ */
+std::string column_sketch_file_name(const std::string& group_index_file);
+
+/**
+ * Writes the sketches of the columns of an array group next to its index
+ * file. sketches[column][segment] is the finalized sketch of a segment of a
+ * column, and sketches[column] is empty for a column without sketches.
+ * Raises an exception on failure.
+ */
+void write_column_sketch_file(
+    const group_index_file_information& info,
+    const std::vector<std::vector<std::shared_ptr<column_sketch>>>& sketches);
+
+/**
+ * Reads and merges the segment sketches of the column described by info.
+ * Returns nullptr if the column has no sketches, or if they do not match
+ * the column (for instance, if the array was rewritten without them).
+ */
+std::shared_ptr<column_sketch> read_column_sketch(const index_file_information& info);
+
+/**
+ * Reads the finalized sketches of every segment of the column described by
+ * info, as written by \ref write_column_sketch_file. Returns an empty
+ * vector if there are none.
+ */
+std::vector<std::shared_ptr<column_sketch>>
+read_column_segment_sketches(const index_file_information& info);
+
+/**
+ * The persisted sketch of column, or nullptr. See \ref read_column_sketch.
+ */
+std::shared_ptr<column_sketch> sarray_column_sketch(const sarray<flexible_type>& column);
+
+/**
+ * Returns true if columns of the given type are sketched when they are
+ * saved: SFRAME_SAVE_COLUMN_SKETCHES is on, and the type is supported.
+ */
+bool sketch_column_when_saving(flex_type_enum type);
+
+/// Only arrays of flexible_type are sketched.
+template <typename T>
+bool sketch_column_when_saving(const sarray<T>&) {
+  return false;
+}
+
+bool sketch_column_when_saving(const sarray<flexible_type>& column);
+
+/**
+ * The sketches of the segments of a column which is saved with new segments
+ * beginning at the given rows (boundaries lists the first row of every new
+ * segment, followed by the number of rows), from the persisted sketches of
+ * the source column described by info. This is possible when every new
+ * segment is made of whole source segments, for instance when a column is
+ * saved as one segment. Returns an empty vector otherwise, or if the source
+ * has no sketches.
+ */
+std::vector<std::shared_ptr<column_sketch>>
+regroup_column_sketches(const index_file_information& info,
+                        const std::vector<size_t>& boundaries);
+
+/**
+ * Adds the values of an encoded typed block (as returned by
+ * block_manager::read_block) to sketch, as blocks are copied by a save.
+ * Returns false if the block could not be decoded.
+ */
+bool add_block_to_sketch(const v2_block_impl::block_info& info,
+                         char* data, size_t len,
+                         column_sketch& sketch);
+
+/**
+ * Estimates the number of distinct combinations of the values of columns
+ * column_ids of sf (missing values count as one value), from their
+ * persisted sketches. Returns false if a column has no sketch.
+ */
+bool estimate_num_distinct(const sframe& sf,
+                           const std::vector<size_t>& column_ids,
+                           double& ret);
+
+/// \}
+} // namespace turi
+#endif
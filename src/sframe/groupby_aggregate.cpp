@@ -3,11 +3,13 @@
  * Use of this source code is governed by a BSD-3-clause license that can
  * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
  */
+#include <numeric>
 #include <string>
 #include <vector>
 #include <logger/logger.hpp>
 #include <timer/timer.hpp>
 #include <sframe/sframe.hpp>
+#include <sframe/column_sketch.hpp>
 #include <sframe/group_aggregate_value.hpp>
 #include <sframe/groupby_aggregate_impl.hpp>
 #include <sframe/groupby_aggregate.hpp>
@@ -148,11 +150,75 @@ sframe groupby_aggregate(const sframe& source,
     column_types.push_back(output_type);
   }
 
+  // If the source is sorted on the key columns (in any order and direction),
+  // the rows of each group are contiguous: stream over them.
+  sframe_sort_order source_order = source.get_sort_order();
+  bool sorted_on_keys = !keys.empty() && source_order.size() >= keys.size();
+  for (size_t i = 0; sorted_on_keys && i < keys.size(); ++i) {
+    const std::string& name = source.column_name(source_order[i].first);
+    sorted_on_keys = key_columns.count(name) &&
+        source.column_type(source_order[i].first) != flex_type_enum::FLOAT;
+  }
+  if (sorted_on_keys) {
+    logstream(LOG_INFO) << "Streaming groupby over sorted keys" << std::endl;
+    output.open_for_write(column_names, column_types, "", thread::cpu_count());
+    std::vector<groupby_aggregate_impl::group_descriptor> group_descriptors;
+    for (const auto& group: groups) {
+      groupby_aggregate_impl::group_descriptor desc;
+      for(auto& col_name : group.first) {
+        desc.column_numbers.push_back(frame_with_relevant_cols.column_index(col_name));
+      }
+      desc.aggregator = group.second;
+      group_descriptors.push_back(desc);
+    }
+    turi::timer ti;
+    groupby_aggregate_impl::sorted_group_and_write(frame_with_relevant_cols,
+                                                   keys.size(),
+                                                   group_descriptors,
+                                                   output);
+    logstream(LOG_INFO) << "Output written in: " << ti.current_time() << std::endl;
+    output.close();
+    // the groups are written in the order of the source
+    sframe_sort_order output_order;
+    for (size_t i = 0; i < keys.size(); ++i) {
+      const std::string& name = source.column_name(source_order[i].first);
+      output_order.push_back({output.column_index(name), source_order[i].second});
+    }
+    output.set_sort_order(output_order);
+    return output;
+  }
+
   // done! now we can start on the groupby
   size_t nsegments = frame_with_relevant_cols.num_segments();
-  // either nsegments, or n*log n buckets
-  nsegments = std::max(nsegments,
-                       thread::cpu_count() * std::max<size_t>(1, log2(thread::cpu_count())));
+  // the persisted sketches of the key columns, if any, bound the number of
+  // groups (the key columns come first)
+  std::vector<size_t> key_column_ids(keys.size());
+  std::iota(key_column_ids.begin(), key_column_ids.end(), 0);
+  double num_groups = 0;
+  bool num_groups_known =
+      estimate_num_distinct(frame_with_relevant_cols, key_column_ids, num_groups);
+  bool groups_fit_in_memory =
+      num_groups_known && num_groups < double(max_buffer_size) * thread::cpu_count();
+  if (groups_fit_in_memory) {
+    // all the groups fit in memory: one segment per thread is enough
+    nsegments = std::max(nsegments, thread::cpu_count());
+    // and each segment only needs room for its share of the groups (with
+    // the slack of group_aggregate_container::reserve)
+    size_t per_segment = num_groups / nsegments;
+    max_buffer_size = std::min(max_buffer_size, per_segment + per_segment / 4 + 1);
+  } else {
+    // either nsegments, or n*log n buckets
+    nsegments = std::max(nsegments,
+                         thread::cpu_count() * std::max<size_t>(1, log2(thread::cpu_count())));
+  }
+  // buffer fewer groups, and flush more often, if the memory budget is short
+  fileio::memory_budget::reservation buffer_memory;
+  max_buffer_size = groupby_aggregate_impl::reserve_buffer_rows(
+      max_buffer_size, nsegments, buffer_memory);
+  logstream(LOG_INFO) << "Grouping into " << nsegments << " segments"
+                      << (num_groups_known ? ", estimated number of groups: " +
+                                             std::to_string(size_t(num_groups))
+                                           : std::string()) << std::endl;
 
   output.open_for_write(column_names,
                         column_types,
@@ -162,6 +228,7 @@ sframe groupby_aggregate(const sframe& source,
 
   groupby_aggregate_impl::group_aggregate_container
       container(max_buffer_size, nsegments);
+  if (groups_fit_in_memory) container.reserve(num_groups);
 
   // ok the input sframe (frame_with_relevant_cols) contains all the values
   // we care about. However, the challenge here is to figure out how the keys
@@ -178,18 +245,27 @@ sframe groupby_aggregate(const sframe& source,
   }
   // done. now we can begin parallel processing
 
-  // shuffle the rows based on the value of the key column.
-  auto input_reader = frame_with_relevant_cols.get_reader(thread::cpu_count());
+  // shuffle the rows based on the value of the key column, a batch of rows
+  // at a time.
+  auto input_reader = frame_with_relevant_cols.get_reader();
+  size_t num_rows = frame_with_relevant_cols.num_rows();
+  size_t num_workers = thread::cpu_count();
+  size_t rows_per_worker = num_rows / num_workers;
   turi::timer ti;
   logstream(LOG_INFO) << "Filling group container: " << std::endl;
-  parallel_for (0, input_reader->num_segments(),
-                [&](size_t i) {
-                  auto iter = input_reader->begin(i);
-                  auto enditer = input_reader->end(i);
-                  while(iter != enditer) {
-                    auto& row = *iter;
-                    container.add(row, num_keys);
-                    ++iter;
+  parallel_for (0, num_workers,
+                [&](size_t worker_id) {
+                  size_t start_row = worker_id * rows_per_worker;
+                  size_t end_row = (worker_id == (num_workers-1)) ?
+                      num_rows : (worker_id + 1) * rows_per_worker;
+                  sframe_rows rows;
+                  while (start_row < end_row) {
+                    size_t rows_to_read = std::min<size_t>(end_row - start_row,
+                                                           DEFAULT_SARRAY_READER_BUFFER_SIZE);
+                    start_row += input_reader->read_rows(start_row,
+                                                         start_row + rows_to_read,
+                                                         rows);
+                    container.add(rows, num_keys);
                   }
                 });
 
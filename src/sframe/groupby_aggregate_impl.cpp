@@ -7,6 +7,7 @@
 #include <queue>
 #include <sframe/groupby_aggregate_impl.hpp>
 #include <sframe/sarray_reader_buffer.hpp>
+#include <sframe/shuffle.hpp>
 #include <parallel/lambda_omp.hpp>
 #include <util/cityhash_tc.hpp>
 #include <sframe/groupby_aggregate.hpp>
@@ -226,6 +227,17 @@ group_aggregate_container::group_aggregate_container(size_t max_buffer_size,
   }
 }
 
+void group_aggregate_container::reserve(size_t num_groups) {
+  // keys are spread evenly by hash; leave some slack for the imbalance
+  size_t per_segment = num_groups / segments.size();
+  per_segment = std::min(per_segment + per_segment / 4 + 1, max_buffer_size);
+  // Allocate the tables from the workers which later flush the segments, so
+  // that they are first touched on the NUMA node of the worker.
+  parallel_for(0, segments.size(), [&](size_t i) {
+    segments[i].elements.rehash(per_segment);
+  });
+}
+
 void group_aggregate_container::define_group(std::vector<size_t> column_numbers,
                                              std::shared_ptr<group_aggregate_value> aggregator) {
   group_descriptor desc;
@@ -278,7 +290,23 @@ void group_aggregate_container::add(const std::vector<flexible_type>& val,
 
 void group_aggregate_container::add(const sframe_rows::row& val,
                                     size_t num_keys) {
-  size_t hash = groupby_element::hash_key(val, num_keys);
+  add(val, num_keys, groupby_element::hash_key(val, num_keys));
+}
+
+void group_aggregate_container::add(const sframe_rows& rows,
+                                    size_t num_keys) {
+  std::vector<size_t> key_columns(num_keys);
+  for (size_t i = 0;i < num_keys; ++i) key_columns[i] = i;
+  std::vector<size_t> hashes;
+  hash_key_columns(rows, key_columns, hashes);
+  for (size_t i = 0;i < hashes.size(); ++i) {
+    add(rows[i], num_keys, hashes[i]);
+  }
+}
+
+void group_aggregate_container::add(const sframe_rows::row& val,
+                                    size_t num_keys,
+                                    size_t hash) {
   size_t target_segment = hash % segments.size();
   // acquire lock on the segment
   std::unique_lock<turi::simple_spinlock> lock(segments[target_segment].in_memory_group_lock);
@@ -475,5 +503,95 @@ void group_aggregate_container::group_and_write_segment(sframe& out,
   }
 }
 
+void sorted_group_and_write(const sframe& input,
+                            size_t num_keys,
+                            const std::vector<group_descriptor>& group_descriptors,
+                            sframe& out) {
+  size_t num_rows = input.num_rows();
+  size_t num_segments = out.num_segments();
+  auto reader = input.get_reader();
+
+  // Split the rows evenly, then move each split forward past the rows
+  // having the key of the row before it, so that no group spans two ranges.
+  std::vector<size_t> splits(num_segments + 1, num_rows);
+  splits[0] = 0;
+  parallel_for(1, num_segments, [&](size_t i) {
+    size_t split = num_rows * i / num_segments;
+    if (split == 0 || split >= num_rows) {
+      splits[i] = split;
+      return;
+    }
+    std::vector<std::vector<flexible_type>> rows;
+    reader->read_rows(split - 1, split, rows);
+    std::vector<flexible_type> prev_key(rows[0].begin(), rows[0].begin() + num_keys);
+    while (split < num_rows) {
+      size_t end = std::min(split + DEFAULT_SARRAY_READER_BUFFER_SIZE, num_rows);
+      reader->read_rows(split, end, rows);
+      for (const auto& row: rows) {
+        if (!flexible_type_vector_equality(prev_key, num_keys, row, num_keys)) {
+          splits[i] = split;
+          return;
+        }
+        ++split;
+      }
+    }
+    splits[i] = num_rows;
+  });
+  // a group longer than a range can push a split past the next ones
+  for (size_t i = 1; i < num_segments; ++i) {
+    splits[i] = std::max(splits[i], splits[i - 1]);
+  }
+
+  parallel_for(0, num_segments, [&](size_t segmentid) {
+    auto outiter = out.get_output_iterator(segmentid);
+    groupby_element cur;
+    bool has_cur = false;
+    std::vector<flexible_type> emission_vector;
+    auto emit = [&]() {
+      emission_vector.resize(cur.key.size() + cur.values.size());
+      for (size_t i = 0;i < cur.key.size(); ++i) emission_vector[i] = cur.key[i];
+      for (size_t i = 0;i < cur.values.size(); ++i) {
+        emission_vector[i + cur.key.size()] = cur.values[i]->emit();
+      }
+      *outiter = emission_vector;
+      ++outiter;
+    };
+
+    sframe_rows rows;
+    for (size_t start = splits[segmentid]; start < splits[segmentid + 1];
+         start += DEFAULT_SARRAY_READER_BUFFER_SIZE) {
+      size_t end = std::min(start + DEFAULT_SARRAY_READER_BUFFER_SIZE,
+                            splits[segmentid + 1]);
+      reader->read_rows(start, end, rows);
+      for (const auto& row: rows) {
+        if (!has_cur ||
+            !flexible_type_vector_equality(cur.key, num_keys, row, num_keys)) {
+          if (has_cur) emit();
+          std::vector<flexible_type> key;
+          key.reserve(num_keys);
+          for (size_t i = 0;i < num_keys; ++i) key.push_back(row[i]);
+          cur.init(std::move(key), group_descriptors);
+          has_cur = true;
+        }
+        cur.add_element(row, group_descriptors);
+      }
+    }
+    if (has_cur) emit();
+  });
+}
+
+size_t reserve_buffer_rows(size_t max_buffer_size,
+                           size_t nsegments,
+                           fileio::memory_budget::reservation& reservation) {
+  // a buffered group holds its key and aggregator values, and every segment
+  // buffers up to max_buffer_size groups
+  constexpr size_t GROUP_SIZE_ESTIMATE = 64 * 5;
+  nsegments = std::max<size_t>(1, nsegments);
+  size_t desired = nsegments * max_buffer_size * GROUP_SIZE_ESTIMATE;
+  reservation = fileio::memory_budget::get_instance().reserve("groupby", desired,
+                                                              desired / 16);
+  return std::max<size_t>(1, reservation.size() / (nsegments * GROUP_SIZE_ESTIMATE));
+}
+
 } // namespace groupby_aggregate_impl
 } // namespace turi
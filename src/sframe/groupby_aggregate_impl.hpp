@@ -12,6 +12,7 @@
 #include <functional>
 #include <unordered_set>
 #include <sframe/sframe.hpp>
+#include <fileio/memory_budget.hpp>
 #include <util/cityhash_tc.hpp>
 #include <parallel/mutex.hpp>
 #include <sframe/group_aggregate_value.hpp>
@@ -216,6 +217,12 @@ class group_aggregate_container {
    void define_group(std::vector<size_t> column_numbers,
                      std::shared_ptr<group_aggregate_value> aggregator);
 
+   /**
+    * Sizes the in memory tables of the segments for an expected total
+    * number of groups, so that they are not rehashed as they fill up.
+    */
+   void reserve(size_t num_groups);
+
    /// Add a new element to the container.
    void add(const std::vector<flexible_type>& val,
             size_t num_keys);
@@ -224,6 +231,13 @@ class group_aggregate_container {
   void add(const sframe_rows::row& val,
             size_t num_keys);
 
+   /**
+    * Add a batch of elements to the container. The keys of the whole batch
+    * are hashed column by column before the elements are added.
+    */
+   void add(const sframe_rows& rows,
+            size_t num_keys);
+
    /// Sort all elements in the container and writes to the output.
    void group_and_write(sframe& out);
   private:
@@ -247,6 +261,11 @@ class group_aggregate_container {
      std::vector<size_t> chunk_size;
    };
 
+   /// Add a new element whose key hashes to hash.
+   void add(const sframe_rows::row& val,
+            size_t num_keys,
+            size_t hash);
+
    /// Writes the content into the sarray segment backend.
    void flush_segment(size_t segmentid);
 
@@ -262,6 +281,31 @@ class group_aggregate_container {
 };
 
 
+/**
+ * Aggregates a frame in which the rows of each group are contiguous, for
+ * instance a frame sorted on its key columns, in one streaming pass, and
+ * writes one row per group to out, in the order of the input.
+ *
+ * The first num_keys columns of input are the key columns. The rows are
+ * split into one range per segment of out, on group boundaries, and each
+ * range is aggregated by one thread without any intermediate storage.
+ */
+void sorted_group_and_write(const sframe& input,
+                            size_t num_keys,
+                            const std::vector<group_descriptor>& group_descriptors,
+                            sframe& out);
+
+/**
+ * Asks the memory budget for the memory of max_buffer_size buffered groups
+ * in each of nsegments segments (see \ref fileio::memory_budget), and
+ * returns the number of groups each segment buffers before flushing:
+ * max_buffer_size, or less if the budget is short, down to 1/16th of it.
+ * The memory is held by reservation.
+ */
+size_t reserve_buffer_rows(size_t max_buffer_size,
+                           size_t nsegments,
+                           fileio::memory_budget::reservation& reservation);
+
 } // namespace groupby_aggregate_impl
 
 /// \}
@@ -48,7 +48,7 @@ sframe join(sframe& sf_left,
     log_and_throw("Invalid join type given!");
   }
 
-  // execute join (perhaps multiplex algorithm based on something?)
+  // execute join, with the algorithm picked by the executor
   join_impl::hash_join_executor join_executor(sf_left,
                                               sf_right,
                                               left_join_positions,
@@ -56,7 +56,7 @@ sframe join(sframe& sf_left,
                                               in_join_type,
                                               max_buffer_size);
 
-  return join_executor.grace_hash_join();
+  return join_executor.execute();
 }
 
 } // end of turicreate
@@ -6,11 +6,109 @@
 #include <sframe/join_impl.hpp>
 #include <cppipc/server/cancel_ops.hpp>
 #include <util/cityhash_tc.hpp>
+#include <sframe/column_sketch.hpp>
 #include <sframe/sframe_constants.hpp>
+#include <sframe/sframe_reader.hpp>
+#include <sframe/shuffle.hpp>
+#include <atomic>
+#include <cmath>
 
 namespace turi {
 namespace join_impl {
 
+namespace {
+
+/// The estimated memory of a cell held in a join hash table.
+constexpr size_t CELL_SIZE_ESTIMATE = 64;
+
+/**
+ * Returns a frame made of the columns of sf at positions, in that order.
+ */
+sframe select_join_columns(const sframe &sf, const std::vector<size_t> &positions) {
+  std::vector<std::shared_ptr<sarray<flexible_type>>> columns;
+  std::vector<std::string> names;
+  for(size_t pos : positions) {
+    columns.push_back(sf.select_column(pos));
+    names.push_back(sf.column_name(pos));
+  }
+  return sframe(columns, names, false);
+}
+
+/**
+ * The positions 0 .. n-1, i.e. all the columns of a frame returned by
+ * select_join_columns().
+ */
+std::vector<size_t> all_positions(size_t n) {
+  std::vector<size_t> ret(n);
+  for(size_t i = 0; i < n; ++i) ret[i] = i;
+  return ret;
+}
+
+/**
+ * Returns the first row in [0, num_rows) of a sorted frame whose key is not
+ * less than key.
+ */
+size_t find_lower_bound(sframe::reader_type &reader,
+                        size_t num_rows,
+                        const std::vector<flexible_type> &key,
+                        const std::vector<size_t> &key_positions) {
+  std::vector<std::vector<flexible_type>> rows;
+  size_t lo = 0, hi = num_rows;
+  while(lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    reader.read_rows(mid, mid + 1, rows);
+    ASSERT_EQ(rows.size(), 1);
+    if(compare_join_keys(rows[0], key_positions, key, key_positions) < 0) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return lo;
+}
+
+/**
+ * Sequentially reads the rows [begin, end) of a frame, in batches.
+ */
+class row_range_cursor {
+ public:
+  row_range_cursor(sframe::reader_type &reader, size_t begin, size_t end)
+      : m_reader(reader), m_position(begin), m_end(end) {
+    fill();
+  }
+
+  inline bool done() const { return m_position >= m_end; }
+
+  inline const std::vector<flexible_type> &row() const {
+    return m_rows[m_index];
+  }
+
+  inline void next() {
+    ++m_position;
+    ++m_index;
+    if(m_index >= m_rows.size()) fill();
+  }
+
+ private:
+  void fill() {
+    m_index = 0;
+    m_rows.clear();
+    if(m_position < m_end) {
+      m_reader.read_rows(m_position,
+                         std::min(m_position + DEFAULT_SARRAY_READER_BUFFER_SIZE, m_end),
+                         m_rows);
+    }
+  }
+
+  sframe::reader_type &m_reader;
+  size_t m_position;
+  size_t m_end;
+  size_t m_index = 0;
+  std::vector<std::vector<flexible_type>> m_rows;
+};
+
+} // anonymous namespace
+
 /****************** join_hash_table **********************/
 bool join_hash_table::add_row(const std::vector<flexible_type> &row) {
 
@@ -108,6 +206,10 @@ bool join_hash_table::join_values_equal(const std::vector<flexible_type> &row,
   return true;
 }
 
+void join_hash_table::reserve(size_t num_keys) {
+  _hash_table.reserve(num_keys);
+}
+
 size_t join_hash_table::num_stored_rows() {
   size_t num_rows = 0;
   size_t num_unique_join_values = 0;
@@ -220,25 +322,76 @@ void hash_join_executor::init_result_frame(sframe &result_frame) {
   }
 }
 
-std::vector<flexible_type> hash_join_executor::unpack_row(
-    std::string val, size_t num_cols) {
-  iarchive iarc(val.c_str(), val.length());
-  std::vector<flexible_type> row(num_cols);
-  for(auto row_it = row.begin(); row_it != row.end(); ++row_it) {
-    iarc >> *row_it;
+join_strategy_t hash_join_executor::choose_join_strategy() {
+  // The left frame is the smaller one.
+  if(get_num_cells(_left_frame) < _max_buffer_size) {
+    return BROADCAST_HASH_JOIN;
   }
 
-  return row;
+  // Scanning the join columns is much cheaper than partitioning the frames,
+  // and stops at the first row out of order.
+  timer ti;
+  bool sorted = is_sorted_on_columns(_left_frame, _left_join_positions) &&
+                is_sorted_on_columns(_right_frame, _right_join_positions);
+  logstream(LOG_INFO) << "Checked join key order in: " << ti.current_time()
+                      << std::endl;
+  if(sorted) {
+    return SORT_MERGE_JOIN;
+  }
+  return GRACE_HASH_JOIN;
+}
+
+sframe hash_join_executor::execute() {
+  // The hash tables hold up to _max_buffer_size cells of the smaller frame.
+  // Ask the memory budget for them, and partition into more (smaller)
+  // partitions if it is short.
+  size_t desired_cells = std::min(_max_buffer_size, get_num_cells(_left_frame) + 1);
+  _memory = fileio::memory_budget::get_instance().reserve(
+      "join", desired_cells * CELL_SIZE_ESTIMATE,
+      desired_cells * CELL_SIZE_ESTIMATE / 16);
+  _max_buffer_size = std::max<size_t>(1, _memory.size() / CELL_SIZE_ESTIMATE);
+
+  switch(choose_join_strategy()) {
+    case BROADCAST_HASH_JOIN:
+      logstream(LOG_INFO) << "Using broadcast hash join" << std::endl;
+      return broadcast_hash_join();
+    case SORT_MERGE_JOIN:
+      logstream(LOG_INFO) << "Using sort-merge join" << std::endl;
+      // only holds the rows of one join key at a time
+      _memory.release();
+      return sort_merge_join();
+    default:
+      logstream(LOG_INFO) << "Using GRACE hash join" << std::endl;
+      return grace_hash_join();
+  }
 }
 
 sframe hash_join_executor::grace_hash_join() {
+  // Pick # of partitions
+  // TODO: Add estimated disk and memory size to SFrames.
+  // This way we can check when to do GRACE recursively
+  size_t left_partitions = choose_number_of_grace_partitions(_left_frame);
+  size_t right_partitions = choose_number_of_grace_partitions(_right_frame);
+  size_t num_partitions = std::min(left_partitions, right_partitions);
+
+  logstream(LOG_INFO) << "Chose " << num_partitions <<
+    " partitions for GRACE hash join\n";
+
+  return hash_join(num_partitions);
+}
+
+sframe hash_join_executor::broadcast_hash_join() {
+  return hash_join(1);
+}
+
+sframe hash_join_executor::hash_join(size_t num_partitions) {
   sframe result_frame;
 
   std::shared_ptr<sframe> grace_left;
   std::shared_ptr<sframe> grace_right;
   timer full_ti;
   timer ti;
-  std::tie(grace_left, grace_right) = this->grace_partition_frames();
+  std::tie(grace_left, grace_right) = this->grace_partition_frames(num_partitions);
   logstream(LOG_INFO) << "Partitioned frames in: " << ti.current_time() << std::endl;
   this->init_result_frame(result_frame);
   ASSERT_EQ(grace_left->size(), _left_frame.size());
@@ -307,6 +460,12 @@ sframe hash_join_executor::grace_hash_join() {
   }
   auto r_rdr = grace_right->get_reader(logical_right_segment_sizes);
 
+  // The persisted sketches of the left join columns, if any, bound the
+  // number of distinct keys, which the partitions share evenly.
+  double num_left_keys = 0;
+  bool num_left_keys_known =
+      estimate_num_distinct(_left_frame, _left_join_positions, num_left_keys);
+
   // Iterate over each segment of the left frame and add to a hash table.
   // These segments can not be read in parallel because they are
   // meant to represent the upper bound of the memory we can read in.
@@ -314,14 +473,11 @@ sframe hash_join_executor::grace_hash_join() {
   for(size_t i = 0; i < num_segments; ++i) {
     // Load the entire left partition into a hash table
     join_hash_table cur_ht(_left_join_positions);
+    if(num_left_keys_known) {
+      cur_ht.reserve(num_left_keys / num_segments);
+    }
     for(auto iter = l_rdr->begin(i); iter != l_rdr->end(i); ++iter) {
-      // Must unpack the row data from the serialized string it is stored as
-      std::vector<flexible_type> row;
-      if(_frames_partitioned) {
-        row = unpack_row(std::string(iter->at(0)), _left_frame.num_columns());
-      } else {
-        row = *iter;
-      }
+      std::vector<flexible_type> row = *iter;
       cur_ht.add_row(row);
     }
 
@@ -335,13 +491,7 @@ sframe hash_join_executor::grace_hash_join() {
               iter != r_rdr->end(cur_logical_segment);
               ++iter) {
 
-            // Must unpack the row data from the serialized string it is stored as
-            std::vector<flexible_type> row;
-            if(_frames_partitioned) {
-              row = unpack_row(std::string(iter->at(0)), _right_frame.num_columns());
-            } else {
-              row = *iter;
-            }
+            std::vector<flexible_type> row = *iter;
 
             // Merge any matching rows to the corresponding left row and write
             auto query_result = cur_ht.get_matching_rows(row, _right_join_positions);
@@ -376,8 +526,13 @@ sframe hash_join_executor::grace_hash_join() {
   }
   logstream(LOG_INFO) << "Hash join time: " << ti.current_time() << std::endl;
 
-  result_frame.close();
+  sframe ret = finalize_result_frame(result_frame);
   logstream(LOG_INFO) << "Full join time: " << full_ti.current_time() << std::endl;
+  return ret;
+}
+
+sframe hash_join_executor::finalize_result_frame(sframe &result_frame) {
+  result_frame.close();
 
   // If we swapped the join order for performance reasons, we need to make the
   // columns appear in the order the user was expecting.  This code does this.
@@ -434,6 +589,111 @@ sframe hash_join_executor::grace_hash_join() {
   return result_frame;
 }
 
+sframe hash_join_executor::sort_merge_join() {
+  sframe result_frame;
+  timer ti;
+  this->init_result_frame(result_frame);
+  size_t num_segments = result_frame.num_segments();
+  size_t left_rows = _left_frame.num_rows();
+  size_t right_rows = _right_frame.num_rows();
+
+  // Split the join key space in num_segments ranges, at evenly spaced rows
+  // of the left frame. Row range i of both frames holds exactly the keys in
+  // [split key i, split key i+1), so the ranges can be merged independently.
+  std::vector<size_t> left_splits(num_segments + 1, 0);
+  std::vector<size_t> right_splits(num_segments + 1, 0);
+  left_splits[num_segments] = left_rows;
+  right_splits[num_segments] = right_rows;
+  {
+    sframe left_keys = select_join_columns(_left_frame, _left_join_positions);
+    sframe right_keys = select_join_columns(_right_frame, _right_join_positions);
+    std::vector<size_t> key_positions = all_positions(_left_join_positions.size());
+    auto left_key_rdr = left_keys.get_reader();
+    auto right_key_rdr = right_keys.get_reader();
+    parallel_for(1, num_segments, [&](size_t i) {
+      std::vector<std::vector<flexible_type>> split_key;
+      left_key_rdr->read_rows(i * left_rows / num_segments,
+                              i * left_rows / num_segments + 1,
+                              split_key);
+      if(split_key.empty()) {
+        left_splits[i] = left_rows;
+        right_splits[i] = right_rows;
+      } else {
+        left_splits[i] = find_lower_bound(*left_key_rdr, left_rows,
+                                          split_key[0], key_positions);
+        right_splits[i] = find_lower_bound(*right_key_rdr, right_rows,
+                                           split_key[0], key_positions);
+      }
+    });
+  }
+
+  std::vector<sframe::iterator> result_output_iterators(num_segments);
+  for(size_t i = 0; i < num_segments; ++i) {
+    result_output_iterators[i] = result_frame.get_output_iterator(i);
+  }
+
+  auto l_rdr = _left_frame.get_reader();
+  auto r_rdr = _right_frame.get_reader();
+  const std::vector<std::vector<flexible_type>> no_rows;
+  parallel_for(0, num_segments, [&](size_t seg_num) {
+    auto writer = result_output_iterators[seg_num];
+    row_range_cursor left(*l_rdr, left_splits[seg_num], left_splits[seg_num + 1]);
+    row_range_cursor right(*r_rdr, right_splits[seg_num], right_splits[seg_num + 1]);
+
+    // All the left rows with the current join key. Only the rows sharing a
+    // single key are held in memory.
+    std::vector<std::vector<flexible_type>> left_group;
+    while(!left.done() && !right.done()) {
+      int cmp = compare_join_keys(left.row(), _left_join_positions,
+                                  right.row(), _right_join_positions);
+      if(cmp < 0) {
+        if(_left_join) {
+          merge_rows_for_output(result_frame, writer, {left.row()}, no_rows);
+        }
+        left.next();
+      } else if(cmp > 0) {
+        if(_right_join) {
+          merge_rows_for_output(result_frame, writer, no_rows, {right.row()});
+        }
+        right.next();
+      } else {
+        left_group.clear();
+        left_group.push_back(left.row());
+        left.next();
+        while(!left.done() &&
+              compare_join_keys(left.row(), _left_join_positions,
+                                left_group[0], _left_join_positions) == 0) {
+          left_group.push_back(left.row());
+          left.next();
+        }
+        while(!right.done() &&
+              compare_join_keys(left_group[0], _left_join_positions,
+                                right.row(), _right_join_positions) == 0) {
+          merge_rows_for_output(result_frame, writer, left_group, {right.row()});
+          right.next();
+        }
+      }
+    }
+    for(; _left_join && !left.done(); left.next()) {
+      merge_rows_for_output(result_frame, writer, {left.row()}, no_rows);
+    }
+    for(; _right_join && !right.done(); right.next()) {
+      merge_rows_for_output(result_frame, writer, no_rows, {right.row()});
+    }
+  });
+  logstream(LOG_INFO) << "Sort-merge join time: " << ti.current_time() << std::endl;
+
+  // The rows are written in the order of the join keys, which are at the
+  // positions of the frame the user passed first.
+  sframe ret = finalize_result_frame(result_frame);
+  const auto &key_positions = _reverse_output_column_order ? _right_join_positions
+                                                           : _left_join_positions;
+  sframe_sort_order sort_order;
+  for(size_t pos : key_positions) sort_order.push_back({pos, true});
+  ret.set_sort_order(sort_order);
+  return ret;
+}
+
 void hash_join_executor::merge_rows_for_output(sframe &result_frame,
                                                sframe::iterator result_iter,
                                                const std::vector<std::vector<flexible_type>> &left_rows,
@@ -527,17 +787,7 @@ size_t hash_join_executor::choose_number_of_grace_partitions(const sframe &sf) {
 }
 
 
-std::pair<std::shared_ptr<sframe>,std::shared_ptr<sframe>> hash_join_executor::grace_partition_frames() {
-  // Pick # of partitions
-  // TODO: Add estimated disk and memory size to SFrames.
-  // This way we can check when to do GRACE recursively
-  size_t left_partitions = choose_number_of_grace_partitions(_left_frame);
-  size_t right_partitions = choose_number_of_grace_partitions(_right_frame);
-  size_t num_partitions = std::min(left_partitions, right_partitions);
-
-  logstream(LOG_INFO) << "Chose " << num_partitions <<
-    " partitions for GRACE hash join\n";
-
+std::pair<std::shared_ptr<sframe>,std::shared_ptr<sframe>> hash_join_executor::grace_partition_frames(size_t num_partitions) {
   // Hash join columns into separate partitions
   // (each partition is a segment of an SFrame)
   auto parted_left_frame = grace_partition_frame(_left_frame, _left_join_positions, num_partitions);
@@ -559,49 +809,98 @@ std::shared_ptr<sframe> hash_join_executor::grace_partition_frame(
     log_and_throw("Cannot make < 1 partitions!");
   }
 
-  // Open the partitioned sframe
-  auto parted_array = std::make_shared<sframe>();
-  parted_array->open_for_write({"data"},{flex_type_enum::STRING},"",num_partitions);
+  // Hash the join columns of each batch of rows, and write the rows to the
+  // segment of their partition, keeping their columns.
+  auto parted_array = std::make_shared<sframe>(
+      hash_partition(sf, join_col_nums, num_partitions));
+
+  _frames_partitioned = true;
+
+  return parted_array;
+}
+
+int compare_join_keys(const std::vector<flexible_type> &row,
+                      const std::vector<size_t> &positions,
+                      const std::vector<flexible_type> &other,
+                      const std::vector<size_t> &other_positions) {
+  DASSERT_EQ(positions.size(), other_positions.size());
+  for(size_t i = 0; i < positions.size(); ++i) {
+    const flexible_type &v1 = row[positions[i]];
+    const flexible_type &v2 = other[other_positions[i]];
+    bool v1_missing = v1.get_type() == flex_type_enum::UNDEFINED;
+    bool v2_missing = v2.get_type() == flex_type_enum::UNDEFINED;
+    if(v1_missing || v2_missing) {
+      if(v1_missing && v2_missing) continue;
+      return v1_missing ? -1 : 1;
+    }
+    if(v1 < v2) return -1;
+    if(v2 < v1) return 1;
+  }
+  return 0;
+}
 
-  // Get all iterators
-  // Create a mutex for each iterator
-  std::vector<sframe::iterator> outiter_vector(num_partitions);
-  std::vector<mutex> outiter_mutexes(num_partitions);
-  for(size_t i = 0; i < num_partitions; ++i) {
-    outiter_vector[i] = parted_array->get_output_iterator(i);
+bool is_sorted_on_columns(const sframe &sf, const std::vector<size_t> &positions) {
+  if(positions.empty()) return false;
+  // Only the types with a total order
+  for(size_t pos : positions) {
+    flex_type_enum type = sf.column_type(pos);
+    if(type != flex_type_enum::INTEGER && type != flex_type_enum::FLOAT &&
+       type != flex_type_enum::STRING && type != flex_type_enum::DATETIME) {
+      return false;
+    }
   }
 
-  // Iterate over each row of the given SFrame, hash on the join columns,
-  // and write that row to the appropriate segment of the partitioned sframe
-  auto rdr = sf.get_reader(thread::cpu_count());
-  parallel_for(0, rdr->num_segments(), [&](size_t seg_num) {
-    oarchive oarc;
-    for(auto j = rdr->begin(seg_num); j != rdr->end(seg_num); ++j) {
-      // Hash the given columns
-      size_t hash_val = compute_hash_from_row(*j, join_col_nums);
-      size_t which_partition = hash_val % num_partitions;
+  // A frame recorded as sorted on the columns needs no scan, unless a column
+  // is a float column, which may contain NaN.
+  auto sort_order = sf.get_sort_order();
+  if(sort_order.size() >= positions.size()) {
+    bool known_sorted = true;
+    for(size_t i = 0; i < positions.size() && known_sorted; ++i) {
+      known_sorted = sort_order[i].first == positions[i] &&
+                     sort_order[i].second &&
+                     sf.column_type(positions[i]) != flex_type_enum::FLOAT;
+    }
+    if(known_sorted) return true;
+  }
 
-      // Serialize the row
-      for(auto &k : *j) {
-        oarc << k;
+  sframe keys = select_join_columns(sf, positions);
+  std::vector<size_t> key_positions = all_positions(positions.size());
+  size_t num_rows = keys.num_rows();
+  auto reader = keys.get_reader();
+  std::atomic<bool> sorted(true);
+
+  in_parallel([&](size_t thread_idx, size_t num_threads) {
+    // Each thread also checks the last row of the previous range.
+    size_t begin = num_rows * thread_idx / num_threads;
+    size_t end = num_rows * (thread_idx + 1) / num_threads;
+    if(begin > 0) --begin;
+
+    std::vector<std::vector<flexible_type>> rows;
+    std::vector<flexible_type> prev;
+    for(size_t start = begin; start < end && sorted;
+        start += DEFAULT_SARRAY_READER_BUFFER_SIZE) {
+      reader->read_rows(start,
+                        std::min(start + DEFAULT_SARRAY_READER_BUFFER_SIZE, end),
+                        rows);
+      for(auto &row : rows) {
+        for(const auto &v : row) {
+          if(v.get_type() == flex_type_enum::FLOAT &&
+             std::isnan(v.get<flex_float>())) {
+            sorted = false;
+            return;
+          }
+        }
+        if(!prev.empty() &&
+           compare_join_keys(prev, key_positions, row, key_positions) > 0) {
+          sorted = false;
+          return;
+        }
+        prev.swap(row);
       }
-      std::string s = std::string(oarc.buf, oarc.off);
-      flexible_type f(std::move(s));
-      outiter_mutexes[which_partition].lock();
-      *(outiter_vector[which_partition]) = std::vector<flexible_type>{std::move(f)};
-      ++outiter_vector[which_partition];
-      outiter_mutexes[which_partition].unlock();
-      oarc.off = 0;
     }
-    free(oarc.buf);
   });
 
-  // We're done writing. Close all output iterators.
-  parted_array->close();
-  
-  _frames_partitioned = true;
-
-  return parted_array;
+  return sorted;
 }
 
 size_t compute_hash_from_row(const std::vector<flexible_type> &row,
@@ -8,6 +8,7 @@
 #include <unordered_map>
 
 #include <sframe/sframe.hpp>
+#include <fileio/memory_budget.hpp>
 
 //TODO: What happens if a join key (or part of one) is NULL?
 enum join_type_t {INNER_JOIN = 0, LEFT_JOIN, RIGHT_JOIN, FULL_JOIN};
@@ -30,6 +31,43 @@ size_t hash_key(const std::vector<flexible_type>& key);
 size_t compute_hash_from_row(const std::vector<flexible_type> &row,
                              const std::vector<size_t> &positions);
 
+/**
+ * The algorithms the join can be executed with.
+ */
+enum join_strategy_t {
+  /// Partition both frames to disk by hash, then hash join each partition.
+  GRACE_HASH_JOIN = 0,
+  /// Hash the smaller frame in memory and stream the larger one through it.
+  BROADCAST_HASH_JOIN,
+  /// Stream both frames, already sorted on the join keys, side by side.
+  SORT_MERGE_JOIN
+};
+
+/**
+ * Three-way comparison of the join keys of two rows. The keys of row
+ * are at positions, and the keys of other are at other_positions.
+ *
+ * Keys are compared lexicographically; missing values are smaller than
+ * all other values, as in the ascending order produced by the sort
+ * algorithms. Returns a negative value, 0 or a positive value if the key
+ * of row is less than, equal to or greater than the key of other.
+ */
+int compare_join_keys(const std::vector<flexible_type> &row,
+                      const std::vector<size_t> &positions,
+                      const std::vector<flexible_type> &other,
+                      const std::vector<size_t> &other_positions);
+
+/**
+ * Returns true if the frame is sorted in ascending order on the columns at
+ * positions (in the order of \ref compare_join_keys). Only the given
+ * columns are read, in parallel, and the scan stops at the first row out
+ * of order. Float columns containing NaN are never reported as sorted.
+ * A frame whose recorded sort order (see sframe::get_sort_order) starts
+ * with the columns, in ascending order, is not scanned unless one of them
+ * is a float column.
+ */
+bool is_sorted_on_columns(const sframe &sf, const std::vector<size_t> &positions);
+
 typedef struct {
   std::vector<std::vector<flexible_type>> rows;
   bool matched;
@@ -59,6 +97,12 @@ class join_hash_table {
    */
   bool add_row(const std::vector<flexible_type> &row);
 
+  /**
+   * Sizes the hash table for an expected number of distinct join keys, so
+   * that it is not rehashed as rows are added.
+   */
+  void reserve(size_t num_keys);
+
   /**
    * Returns all rows whose join keys match the given row's join keys.
    *
@@ -99,11 +143,10 @@ class join_hash_table {
 };
 
 /**
- * The hash_join_executor class executes a hash join.  It is only meant
- * to perform one join.  Could eventually inherit from a generic join class
- * and have further OOP design patterns to choose the algorithm (or just
- * different function calls).  Only one algorithm implemented thus far, 
- * so no need for that yet.
+ * The hash_join_executor class executes a join.  It is only meant
+ * to perform one join.  Three algorithms are implemented (see
+ * \ref join_strategy_t), and \ref execute() picks one of them with
+ * \ref choose_join_strategy().
  */
 class hash_join_executor {
  public:
@@ -117,8 +160,36 @@ class hash_join_executor {
 
   ~hash_join_executor() {}
 
+  /**
+   * Picks the join algorithm:
+   *  - If the smaller frame has fewer than max_buffer_size cells, it is
+   *    hashed in memory (BROADCAST_HASH_JOIN).
+   *  - Otherwise, if both frames are already sorted on the join keys
+   *    (checked by scanning the join columns only), they are merged
+   *    without repartitioning (SORT_MERGE_JOIN).
+   *  - Otherwise, both frames are partitioned to disk (GRACE_HASH_JOIN).
+   */
+  join_strategy_t choose_join_strategy();
+
+  /**
+   * Executes the join with the algorithm chosen by
+   * \ref choose_join_strategy().
+   */
+  sframe execute();
+
   sframe grace_hash_join();
 
+  sframe broadcast_hash_join();
+
+  /**
+   * Joins two frames which are both sorted in ascending order on the join
+   * keys. The frames are split into num_segments ranges of join keys,
+   * found by binary search, and each range is merged by one thread, so
+   * nothing is written to disk but the result. The result is also sorted
+   * on the join keys.
+   */
+  sframe sort_merge_join();
+
  private:
   // The original frames we were passed
   sframe _left_frame;
@@ -132,12 +203,20 @@ class hash_join_executor {
   bool _reverse_output_column_order;
   std::unordered_map<size_t, std::string> _changed_dup_names;
   bool _frames_partitioned;
+  // The memory budget for the hash tables, held during execute()
+  fileio::memory_budget::reservation _memory;
 
   /**
    * Partition the left and right frames for the GRACE hash join algorithm and
    * write these partitions out to disk.
    */
-  std::pair<std::shared_ptr<sframe>,std::shared_ptr<sframe>> grace_partition_frames();
+  std::pair<std::shared_ptr<sframe>,std::shared_ptr<sframe>> grace_partition_frames(size_t num_partitions);
+
+  /**
+   * Hash joins the frames, first partitioning them in num_partitions
+   * partitions if num_partitions > 1.
+   */
+  sframe hash_join(size_t num_partitions);
 
   /**
    * Partition one SFrame for the GRACE hash join algorithm.
@@ -164,6 +243,12 @@ class hash_join_executor {
    */
   void init_result_frame(sframe &result_frame);
 
+  /**
+   * Closes the result frame, and restores the column order the user
+   * expects if the frames were swapped.
+   */
+  sframe finalize_result_frame(sframe &result_frame);
+
   /**
    * Join a vector of rows from the left frame with a vector of rows from the
    * right frame and write to the given output iterator.
@@ -177,8 +262,6 @@ class hash_join_executor {
                              sframe::iterator result_iter,
                              const std::vector<std::vector<flexible_type>> &left_rows,
                              const std::vector<std::vector<flexible_type>> &right_rows);
-
-  std::vector<flexible_type> unpack_row(std::string val, size_t num_cols);
 };
 
 } // end of join_impl
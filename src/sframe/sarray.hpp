@@ -460,13 +460,20 @@ class sarray : public swriter_base<swriter_impl::output_iterator<T> > {
     if (!other.inited) return *this;
     if (!inited) return other;
 
-    // cannot combine across format version
-    ASSERT_EQ(index_info.version, other.index_info.version);
+    // cannot combine across format version, but v2 arrays with and without
+    // shredded blocks can be combined
+    auto is_v2 = [](int version) {
+      return version == 2 || version == NESTED_INDEX_FILE_VERSION;
+    };
+    if (!is_v2(index_info.version) || !is_v2(other.index_info.version)) {
+      ASSERT_EQ(index_info.version, other.index_info.version);
+    }
     ASSERT_EQ(index_info.block_size, other.index_info.block_size);
 
     sarray ret;
     ret.inited = true;
     ret.index_info = index_info;
+    ret.index_info.version = std::max(index_info.version, other.index_info.version);
     ret.files_managed = files_managed;
 
     ret.index_info.nsegments += other.index_info.nsegments;
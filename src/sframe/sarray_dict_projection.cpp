@@ -0,0 +1,152 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#include <sframe/sarray_dict_projection.hpp>
+#include <sframe/sarray_v2_block_manager.hpp>
+#include <sframe/sarray_v2_type_encoding.hpp>
+#include <parallel/lambda_omp.hpp>
+#include <parallel/pthread_tools.hpp>
+#include <logger/logger.hpp>
+
+namespace turi {
+
+namespace {
+
+/**
+ * Calls fn(info, start, len) on every block of segment segment_id of
+ * column, in order.
+ */
+template <typename Fn>
+void for_each_block_in_segment(const index_file_information& index_info,
+                               size_t segment_id,
+                               Fn&& fn) {
+  auto& manager = v2_block_impl::block_manager::get_instance();
+  auto column = manager.open_column(index_info.segment_files[segment_id]);
+  size_t nblocks = manager.num_blocks_in_column(column);
+  for (size_t b = 0; b < nblocks; ++b) {
+    v2_block_impl::block_address addr{std::get<0>(column), std::get<1>(column), b};
+    v2_block_impl::block_info* info = nullptr;
+    auto data = manager.read_block(addr, &info);
+    if (data == nullptr) {
+      manager.close_column(column);
+      log_and_throw("Unable to read block " + std::to_string(b) + " of " +
+                    index_info.segment_files[segment_id]);
+    }
+    fn(*info, data->data(), data->size());
+  }
+  manager.close_column(column);
+}
+
+void throw_decode_failure(const index_file_information& index_info) {
+  log_and_throw("Unable to decode the dictionaries of " + index_info.index_file);
+}
+
+} // anonymous namespace
+
+bool sarray_dict_projection_supported(const sarray<flexible_type>& column) {
+  if (column.get_type() != flex_type_enum::DICT) return false;
+  const auto index_info = column.get_index_info();
+  return (index_info.version == 2 ||
+          index_info.version == NESTED_INDEX_FILE_VERSION) &&
+         index_info.segment_files.size() == index_info.segment_sizes.size();
+}
+
+std::shared_ptr<sarray<flexible_type>>
+sarray_dict_keys(const sarray<flexible_type>& column) {
+  ASSERT_TRUE(sarray_dict_projection_supported(column));
+  const auto index_info = column.get_index_info();
+  const size_t nsegments = index_info.segment_files.size();
+
+  auto ret = std::make_shared<sarray<flexible_type>>();
+  ret->open_for_write(nsegments);
+  ret->set_type(flex_type_enum::LIST);
+  parallel_for(0, nsegments, [&](size_t segment_id) {
+    auto out = ret->get_output_iterator(segment_id);
+    std::vector<flexible_type> keys;
+    for_each_block_in_segment(index_info, segment_id,
+                              [&](const v2_block_impl::block_info& info,
+                                  char* start, size_t len) {
+      if (!v2_block_impl::typed_decode_dict_keys(info, start, len, keys)) {
+        throw_decode_failure(index_info);
+      }
+      for (auto& row_keys: keys) {
+        *out = std::move(row_keys);
+        ++out;
+      }
+    });
+  });
+  ret->close();
+  return ret;
+}
+
+sframe sarray_dict_unpack(const sarray<flexible_type>& column,
+                          const std::vector<flexible_type>& keys,
+                          const std::vector<std::string>& column_names,
+                          const std::vector<flex_type_enum>& column_types,
+                          const flexible_type& na_value) {
+  ASSERT_TRUE(sarray_dict_projection_supported(column));
+  ASSERT_EQ(keys.size(), column_names.size());
+  ASSERT_EQ(keys.size(), column_types.size());
+  const auto index_info = column.get_index_info();
+  const size_t nsegments = index_info.segment_files.size();
+
+  sframe ret;
+  ret.open_for_write(column_names, column_types, "", nsegments);
+  parallel_for(0, nsegments, [&](size_t segment_id) {
+    auto out = ret.get_output_iterator(segment_id);
+    std::vector<std::vector<flexible_type>> values;
+    std::vector<flexible_type> row(keys.size());
+    for_each_block_in_segment(index_info, segment_id,
+                              [&](const v2_block_impl::block_info& info,
+                                  char* start, size_t len) {
+      if (!v2_block_impl::typed_decode_dict_values(info, start, len, keys, values)) {
+        throw_decode_failure(index_info);
+      }
+      for (size_t i = 0; i < info.num_elem; ++i) {
+        for (size_t k = 0; k < keys.size(); ++k) {
+          flexible_type& value = values[k][i];
+          if (value != na_value) {
+            row[k] = std::move(value);
+          } else {
+            row[k] = FLEX_UNDEFINED;
+          }
+        }
+        *out = row;
+        ++out;
+      }
+    });
+  });
+  ret.close();
+  return ret;
+}
+
+std::map<flexible_type, std::set<flex_type_enum>>
+sarray_dict_value_types(const sarray<flexible_type>& column) {
+  ASSERT_TRUE(sarray_dict_projection_supported(column));
+  const auto index_info = column.get_index_info();
+  const size_t nsegments = index_info.segment_files.size();
+
+  std::vector<std::map<flexible_type, std::set<flex_type_enum>>> segment_types(nsegments);
+  parallel_for(0, nsegments, [&](size_t segment_id) {
+    for_each_block_in_segment(index_info, segment_id,
+                              [&](const v2_block_impl::block_info& info,
+                                  char* start, size_t len) {
+      if (!v2_block_impl::typed_decode_dict_value_types(
+              info, start, len, segment_types[segment_id])) {
+        throw_decode_failure(index_info);
+      }
+    });
+  });
+
+  std::map<flexible_type, std::set<flex_type_enum>> ret;
+  for (const auto& types: segment_types) {
+    for (const auto& key_types: types) {
+      ret[key_types.first].insert(key_types.second.begin(), key_types.second.end());
+    }
+  }
+  return ret;
+}
+
+} // namespace turi
@@ -0,0 +1,74 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#ifndef TURI_SFRAME_SARRAY_DICT_PROJECTION_HPP
+#define TURI_SFRAME_SARRAY_DICT_PROJECTION_HPP
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+#include <flexible_type/flexible_type.hpp>
+#include <sframe/sarray.hpp>
+#include <sframe/sframe.hpp>
+
+namespace turi {
+
+/**
+ * \ingroup sframe_physical
+ * \addtogroup sframe_internal SFrame Internal
+ * \{
+ */
+
+/**
+ * Projections of a DICT sarray read block by block from its v2 files.
+ *
+ * Dictionary blocks are stored shredded (see \ref v2_block_impl::typed_encode):
+ * the keys are stored apart from the values, and when keys repeat, the
+ * values of every key are stored apart. The functions below only decode
+ * the parts of the blocks they need: the keys for \ref sarray_dict_keys,
+ * the values of the requested keys for \ref sarray_dict_unpack, and the
+ * block headers of the values for \ref sarray_dict_value_types. Blocks
+ * written before the shredded layout are fully decoded.
+ *
+ * The segments of the column are processed in parallel; the outputs have
+ * the same segments as the column.
+ */
+
+/**
+ * Returns true if column is a DICT sarray stored in the v2 format, which
+ * the functions below can read.
+ */
+bool sarray_dict_projection_supported(const sarray<flexible_type>& column);
+
+/**
+ * The keys of every dictionary of column, as a LIST sarray (UNDEFINED rows
+ * stay UNDEFINED).
+ */
+std::shared_ptr<sarray<flexible_type>>
+sarray_dict_keys(const sarray<flexible_type>& column);
+
+/**
+ * Unpacks keys of the dictionaries of column to columns: column k holds
+ * the value of keys[k] in every row, or UNDEFINED if the row does not have
+ * the key or if the value is equal to na_value. Values are converted to
+ * column_types[k].
+ */
+sframe sarray_dict_unpack(const sarray<flexible_type>& column,
+                          const std::vector<flexible_type>& keys,
+                          const std::vector<std::string>& column_names,
+                          const std::vector<flex_type_enum>& column_types,
+                          const flexible_type& na_value);
+
+/**
+ * The types of the values (including UNDEFINED) of every key of the
+ * dictionaries of column.
+ */
+std::map<flexible_type, std::set<flex_type_enum>>
+sarray_dict_value_types(const sarray<flexible_type>& column);
+
+/// \}
+} // namespace turi
+#endif
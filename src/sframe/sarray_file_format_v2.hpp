@@ -22,6 +22,7 @@
 #include <sframe/sframe_constants.hpp>
 #include <sframe/sarray_v2_block_manager.hpp>
 #include <sframe/sarray_v2_block_writer.hpp>
+#include <sframe/sarray_v2_decoded_block_cache.hpp>
 #include <sframe/sarray_v2_encoded_block.hpp>
 #include <cppipc/server/cancel_ops.hpp>
 namespace turi {
@@ -72,14 +73,17 @@ class sarray_format_reader_v2: public sarray_format_reader<T> {
     close();
     m_index_info = index;
     m_block_list.clear();
+    m_block_segment.clear();
     m_start_row.clear();
     m_segment_list.clear();
+    m_segment_file_list.clear();
     m_num_rows = 0;
     size_t row_count = 0;
 
     for (size_t i = 0;i < index.segment_files.size(); ++i) {
       auto columnaddr =  m_manager.open_column(index.segment_files[i]);
       m_segment_list.push_back(columnaddr);
+      m_segment_file_list.push_back(parse_v2_segment_filename(index.segment_files[i]).first);
       size_t nblocks = m_manager.num_blocks_in_column(columnaddr);
 
       size_t segment_id, column_id, block_id;
@@ -92,6 +96,7 @@ class sarray_format_reader_v2: public sarray_format_reader<T> {
         m_start_row.push_back(row_count);
         row_count += segment_blocks[column_id][j].num_elem;
         m_block_list.push_back(blockaddr);
+        m_block_segment.push_back(i);
       }
     }
     for (auto& ssize: m_index_info.segment_sizes) m_num_rows += ssize;
@@ -202,8 +207,12 @@ class sarray_format_reader_v2: public sarray_format_reader<T> {
   /// NUmber of rows of this array
   size_t m_num_rows;
   std::vector<block_address> m_block_list;
+  /// The segment (index into m_segment_file_list) of each block
+  std::vector<size_t> m_block_segment;
   std::vector<size_t> m_start_row;
   std::vector<column_address> m_segment_list;
+  /// The segment file of each segment, without the column number
+  std::vector<std::string> m_segment_file_list;
 
   /**
    * this describes one cache block.
@@ -229,6 +238,10 @@ class sarray_format_reader_v2: public sarray_format_reader<T> {
    *  - When an eviction happens, we pick a random block number and search
    *  for the next block number which contains a cache entry, and try to evict
    *  that.
+   *
+   * Decoded flexible_type blocks may also come from, or be shared with, the
+   * process wide decoded_block_cache. Such buffers (is_shared) are never
+   * modified nor returned to the buffer pool.
    */
   struct cache_entry {
     cache_entry() = default;
@@ -237,6 +250,7 @@ class sarray_format_reader_v2: public sarray_format_reader<T> {
     cache_entry(cache_entry&& other) {
       buffer_start_row = std::move(other.buffer_start_row);
       is_encoded = std::move(other.is_encoded);
+      is_shared = std::move(other.is_shared);
       buffer = std::move(other.buffer);
       encoded_buffer = std::move(other.encoded_buffer);
       encoded_buffer_reader = std::move(other.encoded_buffer_reader);
@@ -247,6 +261,7 @@ class sarray_format_reader_v2: public sarray_format_reader<T> {
     cache_entry& operator=(cache_entry&& other) {
       buffer_start_row = std::move(other.buffer_start_row);
       is_encoded = std::move(other.is_encoded);
+      is_shared = std::move(other.is_shared);
       buffer = std::move(other.buffer);
       encoded_buffer = std::move(other.encoded_buffer);
       encoded_buffer_reader = std::move(other.encoded_buffer_reader);
@@ -256,6 +271,8 @@ class sarray_format_reader_v2: public sarray_format_reader<T> {
     size_t buffer_start_row = 0;
     // whether this cache entry is held encoded or decoded
     bool is_encoded = false;
+    // whether the decoded buffer is shared with the decoded_block_cache
+    bool is_shared = false;
     bool has_data = false;
     // if it is held decoded
     std::shared_ptr<std::vector<T> > buffer;
@@ -298,8 +315,7 @@ class sarray_format_reader_v2: public sarray_format_reader<T> {
     // if there is something to release
     if (m_cache[block_number].has_data) {
 //       std::cerr << "Releasing cache : " << block_number << std::endl;
-      m_buffer_pool.release_buffer(std::move(m_cache[block_number].buffer));
-      m_cache[block_number].buffer.reset();
+      release_buffer(m_cache[block_number]);
       m_cache[block_number].encoded_buffer.release();
       m_cache[block_number].encoded_buffer_reader.release();
       m_cache[block_number].has_data = false;
@@ -308,6 +324,18 @@ class sarray_format_reader_v2: public sarray_format_reader<T> {
     }
   }
 
+  /**
+   * Releases the decoded buffer of a cache entry, returning it to the pool
+   * unless it is shared with the decoded_block_cache.
+   */
+  void release_buffer(cache_entry& cache) {
+    if (cache.buffer && !cache.is_shared) {
+      m_buffer_pool.release_buffer(std::move(cache.buffer));
+    }
+    cache.buffer.reset();
+    cache.is_shared = false;
+  }
+
   /**
    * Picks a random number and evicts the next block after the number
    * (looping around).
@@ -361,22 +389,45 @@ inline void
 sarray_format_reader_v2<flexible_type>::
 fetch_cache_from_file(size_t block_number, cache_entry& ret) {
 //   std::cerr << "Fetching from file: " << block_number << std::endl;
-  // don't use the buffer. hold as encoded always when reading from a 
-  // flexible_type file
-  if (ret.buffer) {
-    m_buffer_pool.release_buffer(std::move(ret.buffer));
-    ret.buffer.reset();
-  }
+  // hold as encoded when reading from a flexible_type file, unless the
+  // block is (or should be) in the decoded block cache
+  release_buffer(ret);
   block_address block_addr = m_block_list[block_number];
-  v2_block_impl::block_info* info; 
-  auto buffer = m_manager.read_block(block_addr, &info);
-  if (buffer == nullptr) {
-    log_and_throw("Unexpected block read failure. Bad file?");
+  const std::string& segment_file = m_segment_file_list[m_block_segment[block_number]];
+  auto& decoded_cache = v2_block_impl::decoded_block_cache::get_instance();
+  bool should_admit = false;
+  if (decoded_cache.enabled()) {
+    ret.buffer = decoded_cache.find(segment_file,
+                                    std::get<1>(block_addr),
+                                    std::get<2>(block_addr),
+                                    should_admit);
+  }
+  if (ret.buffer == nullptr) {
+    v2_block_impl::block_info* info;
+    auto buffer = m_manager.read_block(block_addr, &info);
+    if (buffer == nullptr) {
+      log_and_throw("Unexpected block read failure. Bad file?");
+    }
+    if (should_admit) {
+      ret.buffer = std::make_shared<std::vector<flexible_type>>();
+      if (!v2_block_impl::typed_decode(*info, buffer->data(), buffer->size(),
+                                       *ret.buffer)) {
+        log_and_throw("Unexpected block read failure. Bad file?");
+      }
+      decoded_cache.insert(segment_file,
+                           std::get<1>(block_addr),
+                           std::get<2>(block_addr),
+                           ret.buffer,
+                           v2_block_impl::decoded_block_cache::estimate_block_size(
+                               info->block_size, info->num_elem));
+    } else {
+      ret.encoded_buffer.init(*info, buffer);
+      ret.encoded_buffer_reader = ret.encoded_buffer.get_range();
+    }
   }
+  ret.is_encoded = (ret.buffer == nullptr);
+  ret.is_shared = !ret.is_encoded;
   ret.buffer_start_row = m_start_row[block_number];
-  ret.encoded_buffer.init(*info, buffer);
-  ret.encoded_buffer_reader = ret.encoded_buffer.get_range();
-  ret.is_encoded = true;
   ret.has_data = true;
   if (m_used_cache_entries.get(block_number) == false) m_cache_size.inc();
   m_used_cache_entries.set_bit(block_number);
@@ -422,12 +473,30 @@ template <>
 inline void sarray_format_reader_v2<flexible_type>::
 ensure_cache_decoded(cache_entry& cache, size_t block_number) {
   if (cache.is_encoded) {
-    cache.buffer = m_buffer_pool.get_new_buffer();
+    // a block read at random is likely to be read again: share it with the
+    // decoded block cache
+    auto& decoded_cache = v2_block_impl::decoded_block_cache::get_instance();
+    cache.is_shared = decoded_cache.enabled();
+    if (cache.is_shared) {
+      cache.buffer = std::make_shared<std::vector<flexible_type>>();
+    } else {
+      cache.buffer = m_buffer_pool.get_new_buffer();
+    }
     auto data = cache.encoded_buffer.get_block_data();
-    v2_block_impl::typed_decode(cache.encoded_buffer.get_block_info(),
+    const auto& info = cache.encoded_buffer.get_block_info();
+    v2_block_impl::typed_decode(info,
                                 data->data(),
                                 data->size(),
                                 *cache.buffer);
+    if (cache.is_shared) {
+      const block_address& block_addr = m_block_list[block_number];
+      decoded_cache.insert(m_segment_file_list[m_block_segment[block_number]],
+                           std::get<1>(block_addr),
+                           std::get<2>(block_addr),
+                           cache.buffer,
+                           v2_block_impl::decoded_block_cache::estimate_block_size(
+                               info.block_size, info.num_elem));
+    }
     // clear the encoded buffer information
     cache.encoded_buffer.release();
     cache.encoded_buffer_reader.release();
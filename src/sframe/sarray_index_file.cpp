@@ -87,7 +87,7 @@ group_index_file_information read_array_group_index_file(std::string group_index
   try {
     // the comon stuff are version, num_segments and segment_files
     ret.version = std::atoi(data.get<std::string>("sarray.version").c_str());
-    if (ret.version != 2) {
+    if (ret.version != 2 && ret.version != NESTED_INDEX_FILE_VERSION) {
       log_and_throw(std::string("Only v2 format is supported"));
     }
 
@@ -182,7 +182,7 @@ void write_array_group_index_file(std::string group_index_file,
                                   const group_index_file_information& info) {
 #define LEGACY_INDEX_FORMAT
 
-  ASSERT_EQ(info.version, 2);
+  ASSERT_TRUE(info.version == 2 || info.version == NESTED_INDEX_FILE_VERSION);
   using boost::filesystem::path;
   using boost::algorithm::starts_with;
 
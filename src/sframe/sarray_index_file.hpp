@@ -22,6 +22,14 @@ class iarchive;
  * \{
  */
 
+/**
+ * The index file version of the v2 arrays holding shredded LIST or DICT
+ * blocks. Their blocks cannot be told apart from the serialized blocks
+ * written before, so they are only written with this version, which older
+ * readers refuse to open instead of misreading the blocks.
+ */
+static const int NESTED_INDEX_FILE_VERSION = 3;
+
 /**
  * Describes all the information in an sarray index file.
  * The index_file_information struct contains all the information assocaited
@@ -34,6 +42,9 @@ class iarchive;
  * Column numbers are 0 indexed. segment_files are similar. In the v1 format,
  * the segment_files point to the actual files. In the v2 format, the segment
  * files are of the form [file_location]:[column_number].
+ *
+ * A version 3 SArray is a version 2 SArray which holds shredded LIST or
+ * DICT blocks (see \ref NESTED_INDEX_FILE_VERSION).
  */
 struct index_file_information {
   /// Input file name
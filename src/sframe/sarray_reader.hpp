@@ -538,6 +538,7 @@ class sarray_reader: public siterable<sarray_iterator<T> > {
        log_and_throw("Format version 1 deprecated");
        break;
      case 2:
+     case NESTED_INDEX_FILE_VERSION:
        reader = new sarray_format_reader_v2<T>();
        reader->open(array.get_index_info());
        break;
@@ -8,6 +8,7 @@
 #include <sframe/sarray.hpp>
 #include <sframe/sarray_v2_block_manager.hpp>
 #include <sframe/sframe_saving_impl.hpp>
+#include <sframe/column_sketch.hpp>
 namespace turi {
 
 template <typename T>
@@ -54,6 +55,18 @@ void sarray_save_blockwise(const sarray<T>& cur_column,
 
 
     writer.get_index_info().columns[0].metadata = col.column_index.metadata;
+    // The sketch is the merge of the persisted sketches of the source, or
+    // else is built while the blocks are copied.
+    std::vector<std::shared_ptr<column_sketch> > sketches;
+    bool build_sketch = false;
+    if (sketch_column_when_saving(cur_column)) {
+      sketches = regroup_column_sketches(col.column_index,
+                                         {0, cur_column.size()});
+      if (sketches.empty()) {
+        build_sketch = true;
+        sketches.push_back(std::make_shared<column_sketch>());
+      }
+    }
 
     while(!col.eof) {
       // read a block
@@ -67,11 +80,19 @@ void sarray_save_blockwise(const sarray<T>& cur_column,
       info = *infoptr;
       // write to segment 0. We have only 1 segment 
       writer.write_block(0, col.column_number, data->data(), info);
+      if (build_sketch &&
+          !add_block_to_sketch(info, data->data(), data->size(), *sketches[0])) {
+        build_sketch = false;
+        sketches.clear();
+      }
       // increment the block number
       advance_column_blocks_to_next_block(block_manager, col);
       // if there are still blocks. push it back 
     }
 
+    if (build_sketch) sketches[0]->finalize();
+    if (!sketches.empty()) writer.set_column_sketches(0, sketches);
+
     // close writers.
     writer.close_segment(0);
     writer.write_index_file();
@@ -35,12 +35,20 @@ enum BLOCK_FLAGS {
 };
 
 /**
- * Floating point encoding formats
+ * Floating point encoding formats.
+ *
+ * Older readers accept the values 0 to 2 but only decode 0 and 1, so 2 is
+ * never written: the encodings added later start at 3, which older readers
+ * reject instead of misreading.
  */
 namespace DOUBLE_RESERVED_FLAGS {
 enum FLAGS {
   LEGACY_ENCODING = 0,
-  INTEGER_ENCODING = 1
+  INTEGER_ENCODING = 1,
+  UNUSED_ENCODING = 2,   // never written, see above
+  DECIMAL_ENCODING = 3,  // integers scaled by a power of 10
+  FLOAT32_ENCODING = 4,  // values which are exactly single precision floats
+  XOR_ENCODING = 5       // XOR with the previous value
 };
 }
 
@@ -52,6 +60,16 @@ enum FLAGS {
   NEW_ENCODING = 0
 };
 }
+
+/**
+ * List and dictionary (shredded) encoding formats
+ */
+namespace NESTED_RESERVED_FLAGS {
+enum FLAGS {
+  SHREDDED = 0,        // elements (or keys, then values) in one sub-block
+  SHREDDED_BY_KEY = 1  // dictionaries only: one value sub-block per key
+};
+}
 /**
  * A column address is a tuple of segment_id, 
  * column number within the segment
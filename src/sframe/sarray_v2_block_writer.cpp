@@ -10,6 +10,8 @@ extern "C" {
 #include <sframe/sarray_index_file.hpp>
 #include <sframe/sframe_constants.hpp>
 #include <sframe/sarray_v2_type_encoding.hpp>
+#include <sframe/sarray_v2_decoded_block_cache.hpp>
+#include <fileio/fs_utils.hpp>
 
 namespace turi {
 namespace v2_block_impl {
@@ -32,6 +34,8 @@ void block_writer::init(std::string group_index_file,
   m_index_info.nsegments = num_segments;
   m_index_info.segment_files.resize(num_segments);
   m_index_info.columns.resize(num_columns);
+  m_column_sketches.clear();
+  m_column_sketches.resize(num_columns);
 
   // fill in the per column information of m_index_info. 
   for (size_t col = 0;col < m_index_info.columns.size(); ++col) {
@@ -51,6 +55,8 @@ void block_writer::init(std::string group_index_file,
 void block_writer::open_segment(size_t segmentid, std::string filename) {
   ASSERT_LT(segmentid, m_index_info.nsegments);
   ASSERT_TRUE(m_output_files[segmentid] == NULL);
+  // blocks of a previous file of the same name must not be read again
+  decoded_block_cache::get_instance().invalidate_file(filename);
   m_output_files[segmentid].reset(new general_ofstream(filename, 
                                                     /* must not compress! 
                                                      * We need the blocks!*/
@@ -71,6 +77,24 @@ void block_writer::open_segment(size_t segmentid, std::string filename) {
 
 static char padding_bytes[4096] = {0};
 
+/**
+ * Returns true if the (uncompressed) block holds values written by
+ * typed_encode() in the shredded LIST or DICT encoding, i.e. a block of
+ * one type (possibly with UNDEFINED values), with the encoding extension.
+ */
+static bool is_shredded_block(const char* data, const block_info& block) {
+  if (!(block.flags & IS_FLEXIBLE_TYPE) ||
+      !(block.flags & BLOCK_ENCODING_EXTENSION) ||
+      (block.flags & MULTIPLE_TYPE_BLOCK) ||
+      block.block_size < 2) {
+    return false;
+  }
+  // the number of types, then the type
+  flex_type_enum type = (flex_type_enum)data[1];
+  return (data[0] == 1 || data[0] == 2) &&
+         (type == flex_type_enum::LIST || type == flex_type_enum::DICT);
+}
+
 size_t block_writer::write_block(size_t segment_id,
                                  size_t column_id, 
                                  char* data,
@@ -78,6 +102,14 @@ size_t block_writer::write_block(size_t segment_id,
   DASSERT_LT(segment_id, m_index_info.nsegments);
   DASSERT_LT(column_id, m_index_info.columns.size());
   DASSERT_TRUE(m_output_files[segment_id] != NULL);
+  if (is_shredded_block(data, block)) {
+    // older readers must not open the array, see NESTED_INDEX_FILE_VERSION
+    std::lock_guard<turi::mutex> guard(m_index_version_lock);
+    m_index_info.version = NESTED_INDEX_FILE_VERSION;
+    for (auto& column: m_index_info.columns) {
+      column.version = NESTED_INDEX_FILE_VERSION;
+    }
+  }
   // try to compress the data
   size_t compress_bound = LZ4_compressBound(block.block_size);
   auto compression_buffer = m_buffer_pool.get_new_buffer();
@@ -145,9 +177,27 @@ group_index_file_information& block_writer::get_index_info() {
   return m_index_info; 
 }
 
+void block_writer::set_column_sketches(size_t column_id,
+                                       std::vector<std::shared_ptr<column_sketch>> sketches) {
+  ASSERT_LT(column_id, m_column_sketches.size());
+  ASSERT_EQ(sketches.size(), m_index_info.nsegments);
+  m_column_sketches[column_id] = std::move(sketches);
+}
+
 void block_writer::write_index_file() {
   write_array_group_index_file(m_index_info.group_index_file, 
                                m_index_info);
+  bool has_sketches = false;
+  for (const auto& sketches: m_column_sketches) {
+    if (!sketches.empty()) has_sketches = true;
+  }
+  std::string sketch_file = column_sketch_file_name(m_index_info.group_index_file);
+  if (has_sketches) {
+    write_column_sketch_file(m_index_info, m_column_sketches);
+  } else if (fileio::get_file_status(sketch_file) == fileio::file_status::REGULAR_FILE) {
+    // the sketches of the array which was overwritten
+    fileio::delete_path(sketch_file);
+  }
 }
 
 void block_writer::emit_footer(size_t segment_id) {
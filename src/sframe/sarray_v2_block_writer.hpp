@@ -16,6 +16,7 @@
 #include <flexible_type/flexible_type.hpp>
 #include <util/buffer_pool.hpp>
 #include <sframe/sarray_v2_block_types.hpp>
+#include <sframe/column_sketch.hpp>
 
 namespace turi {
 
@@ -134,7 +135,14 @@ class block_writer {
   group_index_file_information& get_index_info();
 
   /**
-   * Writes the index file
+   * Sets the sketches of every segment of a column, written next to the
+   * index file by write_index_file(). See \ref column_sketch.
+   */
+  void set_column_sketches(size_t column_id,
+                           std::vector<std::shared_ptr<column_sketch>> sketches);
+
+  /**
+   * Writes the index file, and the column sketches if any were set.
    */
   void write_index_file();
  private:
@@ -147,6 +155,8 @@ class block_writer {
   std::vector<turi::mutex> m_output_file_locks;
   /// Number of bytes written to each output segments
   std::vector<size_t> m_output_bytes_written;
+  /// Lock on the version of m_index_info
+  turi::mutex m_index_version_lock;
 
   group_index_file_information m_index_info;
 
@@ -162,6 +172,9 @@ class block_writer {
   /// For each segment, for each column the number of rows written so far
   std::vector<std::vector<size_t> > m_column_row_counter;
 
+  /// For each column, the sketch of every segment (or nothing)
+  std::vector<std::vector<std::shared_ptr<column_sketch>>> m_column_sketches;
+
   /// Writes the file footer
   void emit_footer(size_t segment_id);
 };
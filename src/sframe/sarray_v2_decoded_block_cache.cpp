@@ -0,0 +1,165 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#include <sframe/sarray_v2_decoded_block_cache.hpp>
+#include <sframe/sframe_constants.hpp>
+#include <fileio/memory_budget.hpp>
+#include <util/cityhash_tc.hpp>
+#include <logger/logger.hpp>
+
+namespace turi {
+namespace v2_block_impl {
+
+static const char BUDGET_CONSUMER[] = "decoded_block_cache";
+
+decoded_block_cache::decoded_block_cache() {
+  // Evict unpinned blocks when another consumer runs short of memory.
+  fileio::memory_budget::get_instance().register_reclaimer(
+      BUDGET_CONSUMER, [this](size_t bytes) {
+        std::lock_guard<turi::mutex> guard(m_lock);
+        make_room(0, m_size_in_bytes > bytes ? m_size_in_bytes - bytes : 0);
+      });
+}
+
+decoded_block_cache& decoded_block_cache::get_instance() {
+  static decoded_block_cache* cache = new decoded_block_cache();
+  return *cache;
+}
+
+size_t decoded_block_cache::block_key_hash::operator()(const block_key& key) const {
+  return hash64(hash64(key.segment_file), key.column_id, key.block_id);
+}
+
+bool decoded_block_cache::enabled() const {
+  return SFRAME_DECODED_BLOCK_CACHE_CAPACITY > 0;
+}
+
+decoded_block_cache::block_ptr
+decoded_block_cache::find(const std::string& segment_file, size_t column_id,
+                          size_t block_id, bool& should_admit) {
+  should_admit = false;
+  block_key key{segment_file, column_id, block_id};
+  std::lock_guard<turi::mutex> guard(m_lock);
+  auto iter = m_slot_of_key.find(key);
+  if (iter != m_slot_of_key.end()) {
+    slot& s = m_slots[iter->second];
+    s.referenced = true;
+    m_hits.inc();
+    return s.block;
+  }
+  m_misses.inc();
+
+  // admit on the second miss
+  size_t key_hash = block_key_hash()(key);
+  if (m_recent_misses.count(key_hash)) {
+    should_admit = true;
+  } else {
+    m_recent_misses.insert(key_hash);
+    m_recent_miss_order.push_back(key_hash);
+    if (m_recent_miss_order.size() > MAX_RECENT_MISSES) {
+      m_recent_misses.erase(m_recent_miss_order.front());
+      m_recent_miss_order.pop_front();
+    }
+  }
+  return block_ptr();
+}
+
+void decoded_block_cache::insert(const std::string& segment_file, size_t column_id,
+                                 size_t block_id, block_ptr block,
+                                 size_t size_in_bytes) {
+  size_t capacity = SFRAME_DECODED_BLOCK_CACHE_CAPACITY;
+  if (!block || size_in_bytes > capacity) return;
+  // Charged before taking the lock, since the budget may call the reclaim
+  // functions of other consumers.
+  auto& budget = fileio::memory_budget::get_instance();
+  if (!budget.try_acquire(BUDGET_CONSUMER, size_in_bytes)) return;
+  block_key key{segment_file, column_id, block_id};
+  std::lock_guard<turi::mutex> guard(m_lock);
+  // a concurrent reader may have inserted it already
+  if (m_slot_of_key.count(key) || !make_room(size_in_bytes, capacity)) {
+    budget.release(BUDGET_CONSUMER, size_in_bytes);
+    return;
+  }
+
+  size_t slot_id;
+  if (!m_free_slots.empty()) {
+    slot_id = m_free_slots.back();
+    m_free_slots.pop_back();
+  } else {
+    slot_id = m_slots.size();
+    m_slots.emplace_back();
+  }
+  slot& s = m_slots[slot_id];
+  s.key = std::move(key);
+  s.block = std::move(block);
+  s.size_in_bytes = size_in_bytes;
+  s.referenced = false;
+  m_slot_of_key[s.key] = slot_id;
+  m_size_in_bytes += size_in_bytes;
+}
+
+void decoded_block_cache::invalidate_file(const std::string& segment_file) {
+  std::lock_guard<turi::mutex> guard(m_lock);
+  if (m_slot_of_key.empty()) return;
+  for (size_t i = 0; i < m_slots.size(); ++i) {
+    if (m_slots[i].block && m_slots[i].key.segment_file == segment_file) {
+      release_slot(i);
+    }
+  }
+}
+
+void decoded_block_cache::clear() {
+  std::lock_guard<turi::mutex> guard(m_lock);
+  for (size_t i = 0; i < m_slots.size(); ++i) {
+    if (m_slots[i].block && m_slots[i].block.unique()) release_slot(i);
+  }
+}
+
+decoded_block_cache::cache_stats decoded_block_cache::get_stats() const {
+  cache_stats ret;
+  ret.hits = m_hits.value;
+  ret.misses = m_misses.value;
+  ret.evictions = m_evictions.value;
+  std::lock_guard<turi::mutex> guard(m_lock);
+  ret.num_blocks = m_slot_of_key.size();
+  ret.size_in_bytes = m_size_in_bytes;
+  return ret;
+}
+
+bool decoded_block_cache::make_room(size_t size_in_bytes, size_t capacity) {
+  // Each slot is visited at most twice: once to clear its reference bit,
+  // once to evict it.
+  size_t remaining_visits = 2 * m_slots.size();
+  while (m_size_in_bytes + size_in_bytes > capacity && remaining_visits > 0) {
+    if (m_hand >= m_slots.size()) m_hand = 0;
+    slot& s = m_slots[m_hand];
+    if (s.block && s.block.unique()) {
+      if (s.referenced) {
+        s.referenced = false;
+      } else {
+        release_slot(m_hand);
+        m_evictions.inc();
+      }
+    }
+    ++m_hand;
+    --remaining_visits;
+  }
+  return m_size_in_bytes + size_in_bytes <= capacity;
+}
+
+void decoded_block_cache::release_slot(size_t slot_id) {
+  slot& s = m_slots[slot_id];
+  m_slot_of_key.erase(s.key);
+  m_size_in_bytes -= s.size_in_bytes;
+  fileio::memory_budget::get_instance().release(BUDGET_CONSUMER, s.size_in_bytes);
+  s.block.reset();
+  s.key.segment_file.clear();
+  s.size_in_bytes = 0;
+  s.referenced = false;
+  m_free_slots.push_back(slot_id);
+}
+
+} // namespace v2_block_impl
+} // namespace turi
@@ -0,0 +1,163 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#ifndef TURI_SFRAME_SARRAY_V2_DECODED_BLOCK_CACHE_HPP
+#define TURI_SFRAME_SARRAY_V2_DECODED_BLOCK_CACHE_HPP
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <parallel/mutex.hpp>
+#include <parallel/atomic.hpp>
+#include <flexible_type/flexible_type.hpp>
+
+namespace turi {
+
+/**
+ * \internal
+ * \ingroup sframe_physical
+ * \addtogroup sframe_internal SFrame Internal
+ * \{
+ */
+
+namespace v2_block_impl {
+
+/**
+ * A process wide cache of decoded blocks of flexible_type columns, shared by
+ * all the readers of the v2 file format.
+ *
+ * Blocks are identified by their segment file, column and block number
+ * within the segment, so that readers opened at different times on the same
+ * array share the blocks. The total (estimated) size of the decoded blocks is
+ * kept within SFRAME_DECODED_BLOCK_CACHE_CAPACITY bytes: blocks are evicted
+ * with the CLOCK algorithm. A block held by a reader (i.e. whose shared
+ * pointer is not only held by the cache) is pinned, and is not evicted.
+ * Cached blocks must never be modified.
+ *
+ * To keep single scans of large arrays from flushing the cache, a block is
+ * only admitted on its second miss: \ref find reports whether the block
+ * was missed recently, and the caller then decodes it and \ref insert's it.
+ * Random accesses, which decode whole blocks anyway, are inserted directly.
+ *
+ * Writing a segment file invalidates its cached blocks (see
+ * \ref invalidate_file).
+ *
+ * The cached blocks are also charged to the process wide
+ * \ref fileio::memory_budget: a block is not inserted if the budget is
+ * exhausted, and unpinned blocks are evicted when another consumer of the
+ * budget runs short.
+ */
+class decoded_block_cache {
+ public:
+  typedef std::shared_ptr<std::vector<flexible_type>> block_ptr;
+
+  struct cache_stats {
+    size_t hits = 0;
+    size_t misses = 0;
+    size_t evictions = 0;
+    size_t num_blocks = 0;
+    size_t size_in_bytes = 0;
+  };
+
+  /// Get singleton instance
+  static decoded_block_cache& get_instance();
+
+  /// Returns true if the cache has a non zero capacity.
+  bool enabled() const;
+
+  /**
+   * Returns the cached block, or an empty pointer on a miss. On a miss,
+   * should_admit is set to true if the block was missed recently, in which
+   * case the caller should decode and \ref insert it.
+   */
+  block_ptr find(const std::string& segment_file, size_t column_id,
+                 size_t block_id, bool& should_admit);
+
+  /**
+   * Inserts a decoded block, evicting unpinned blocks as needed. The block
+   * is not inserted if it does not fit. size_in_bytes is the estimated
+   * memory used by the block (see \ref estimate_block_size).
+   */
+  void insert(const std::string& segment_file, size_t column_id,
+              size_t block_id, block_ptr block, size_t size_in_bytes);
+
+  /// Drops the cached blocks of a segment file, for instance when it is rewritten.
+  void invalidate_file(const std::string& segment_file);
+
+  /// Drops all the unpinned blocks.
+  void clear();
+
+  /// Returns the hit, miss and eviction counters and the cache occupancy.
+  cache_stats get_stats() const;
+
+  /**
+   * Estimates the memory used by a decoded block from the decompressed
+   * size of its encoding and its number of elements.
+   */
+  static size_t estimate_block_size(size_t encoded_size, size_t num_elem) {
+    return encoded_size + num_elem * sizeof(flexible_type);
+  }
+
+ private:
+  decoded_block_cache();
+
+  struct block_key {
+    std::string segment_file;
+    size_t column_id;
+    size_t block_id;
+    bool operator==(const block_key& other) const {
+      return block_id == other.block_id && column_id == other.column_id &&
+          segment_file == other.segment_file;
+    }
+  };
+
+  struct block_key_hash {
+    size_t operator()(const block_key& key) const;
+  };
+
+  struct slot {
+    block_key key;
+    block_ptr block;
+    size_t size_in_bytes = 0;
+    bool referenced = false;
+  };
+
+  /// The maximum number of recently missed blocks remembered for admission.
+  static constexpr size_t MAX_RECENT_MISSES = 65536;
+
+  mutable turi::mutex m_lock;
+  /// The CLOCK. Empty slots have no block and are listed in m_free_slots.
+  std::vector<slot> m_slots;
+  std::vector<size_t> m_free_slots;
+  size_t m_hand = 0;
+  std::unordered_map<block_key, size_t, block_key_hash> m_slot_of_key;
+  size_t m_size_in_bytes = 0;
+
+  /// Hashes of the recently missed blocks, in a FIFO.
+  std::unordered_set<size_t> m_recent_misses;
+  std::deque<size_t> m_recent_miss_order;
+
+  turi::atomic<size_t> m_hits;
+  turi::atomic<size_t> m_misses;
+  turi::atomic<size_t> m_evictions;
+
+  /**
+   * Evicts unpinned blocks with the CLOCK algorithm until size_in_bytes
+   * more bytes fit. Returns false if they cannot fit. m_lock must be held.
+   */
+  bool make_room(size_t size_in_bytes, size_t capacity);
+
+  /// Empties a slot. m_lock must be held.
+  void release_slot(size_t slot_id);
+};
+
+} // namespace v2_block_impl
+
+/// \}
+} // namespace turi
+#endif
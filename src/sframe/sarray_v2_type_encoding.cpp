@@ -3,7 +3,10 @@
  * Use of this source code is governed by a BSD-3-clause license that can
  * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
  */
+#include <cmath>
+#include <cstring>
 #include <functional>
+#include <unordered_map>
 #include <flexible_type/flexible_type.hpp>
 #include <sframe/sarray_v2_block_types.hpp>
 #include <sframe/sarray_v2_type_encoding.hpp>
@@ -107,6 +110,227 @@ void encode_double_legacy(block_info& info,
 }
 
 
+/**
+ * The exactly representable powers of 10 used by the decimal encoding.
+ */
+static const double DECIMAL_POWERS_OF_10[] = {
+  1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9,
+  1e10, 1e11, 1e12, 1e13, 1e14, 1e15};
+static const size_t MAX_DECIMAL_EXPONENT = 15;
+/// Above this magnitude, the scaled integers lose precision.
+static const double MAX_DECIMAL_MAGNITUDE = double(1LL << 52);
+
+static inline uint64_t double_bits(double d) {
+  uint64_t ret;
+  std::memcpy(&ret, &d, sizeof(ret));
+  return ret;
+}
+
+static inline uint64_t zigzag_encode(int64_t v) {
+  return (uint64_t(v) << 1) ^ uint64_t(v >> 63);
+}
+
+static inline int64_t zigzag_decode(uint64_t v) {
+  return int64_t(v >> 1) ^ -int64_t(v & 1);
+}
+
+/**
+ * Returns true if val == n / 10^exponent, with n = round(val * 10^exponent)
+ * small enough to be exact.
+ */
+static inline bool is_decimal(double val, size_t exponent, int64_t& n) {
+  double scaled = val * DECIMAL_POWERS_OF_10[exponent];
+  if (!(std::fabs(scaled) < MAX_DECIMAL_MAGNITUDE)) return false;
+  n = std::llround(scaled);
+  return double(n) / DECIMAL_POWERS_OF_10[exponent] == val &&
+      (val != 0 || !std::signbit(val));
+}
+
+/**
+ * Finds the smallest exponent e such that every value is an integer divided
+ * by 10^e (ALP without exceptions). Returns false if there is none.
+ */
+static bool find_decimal_exponent(const std::vector<double>& values,
+                                  size_t& exponent) {
+  exponent = 0;
+  int64_t n;
+  for (double val: values) {
+    while (!is_decimal(val, exponent, n)) {
+      if (++exponent > MAX_DECIMAL_EXPONENT) return false;
+    }
+  }
+  // an exponent found for a later value must also work for the earlier ones
+  for (double val: values) {
+    if (!is_decimal(val, exponent, n)) return false;
+  }
+  return true;
+}
+
+/**
+ * Writes the len XORs of a block of the XOR encoding (see
+ * decode_double_extension()): a bitmap of the non-zero XORs, then the
+ * meaningful bits of the non-zero XORs, all with the same width.
+ */
+static void encode_xor_block(const uint64_t* xors, size_t len, oarchive& oarc) {
+  unsigned char nonzero[MAX_INTEGERS_PER_BLOCK / 8] = {0};
+  unsigned char leading = 64, trailing = 64;
+  size_t num_nonzero = 0;
+  for (size_t j = 0; j < len; ++j) {
+    if (xors[j] == 0) continue;
+    nonzero[j / 8] |= (1 << (j % 8));
+    leading = std::min<unsigned char>(leading, __builtin_clzll(xors[j]));
+    trailing = std::min<unsigned char>(trailing, __builtin_ctzll(xors[j]));
+    ++num_nonzero;
+  }
+  oarc.write((char*)nonzero, (len + 7) / 8);
+  if (num_nonzero == 0) return;
+  unsigned char width = 64 - leading - trailing;
+  oarc << trailing << width;
+  // 8 bytes of padding so that every value is written with 2 word accesses
+  char packed[MAX_INTEGERS_PER_BLOCK * sizeof(uint64_t) + 8] = {0};
+  size_t bit = 0;
+  for (size_t j = 0; j < len; ++j) {
+    if (xors[j] == 0) continue;
+    uint64_t val = xors[j] >> trailing;
+    size_t shift = bit % 8;
+    uint64_t word;
+    std::memcpy(&word, packed + bit / 8, sizeof(word));
+    word |= val << shift;
+    std::memcpy(packed + bit / 8, &word, sizeof(word));
+    if (shift + width > 64) packed[bit / 8 + 8] |= (char)(val >> (64 - shift));
+    bit += width;
+  }
+  oarc.write(packed, (bit + 7) / 8);
+}
+
+/**
+ * Reads the len XORs of a block written by encode_xor_block().
+ */
+static void decode_xor_block(iarchive& iarc, size_t len, uint64_t* xors) {
+  unsigned char nonzero[MAX_INTEGERS_PER_BLOCK / 8];
+  iarc.read((char*)nonzero, (len + 7) / 8);
+  size_t num_nonzero = 0;
+  for (size_t j = 0; j < (len + 7) / 8; ++j) {
+    num_nonzero += __builtin_popcount(nonzero[j]);
+  }
+  if (num_nonzero == 0) {
+    std::fill(xors, xors + len, 0);
+    return;
+  }
+  unsigned char trailing, width;
+  iarc >> trailing >> width;
+  ASSERT_LE((size_t)trailing + width, 64);
+  const uint64_t mask = width == 64 ? uint64_t(-1) : (uint64_t(1) << width) - 1;
+  char packed[MAX_INTEGERS_PER_BLOCK * sizeof(uint64_t) + 8] = {0};
+  iarc.read(packed, (num_nonzero * width + 7) / 8);
+  size_t bit = 0;
+  for (size_t j = 0; j < len; ++j) {
+    if ((nonzero[j / 8] & (1 << (j % 8))) == 0) {
+      xors[j] = 0;
+      continue;
+    }
+    size_t shift = bit % 8;
+    uint64_t val;
+    std::memcpy(&val, packed + bit / 8, sizeof(val));
+    val >>= shift;
+    if (shift + width > 64) {
+      val |= uint64_t((unsigned char)packed[bit / 8 + 8]) << (64 - shift);
+    }
+    xors[j] = (val & mask) << trailing;
+    bit += width;
+  }
+}
+
+/**
+ * Encodes the values with the given extension encoding
+ * (DECIMAL_ENCODING, FLOAT32_ENCODING or XOR_ENCODING), 128 at a time.
+ * See decode_double_extension() for the formats.
+ */
+static void encode_double_extension(char encoding,
+                                    size_t decimal_exponent,
+                                    oarchive& oarc,
+                                    const std::vector<double>& values) {
+  if (encoding == DOUBLE_RESERVED_FLAGS::DECIMAL_ENCODING) {
+    oarc << (char)decimal_exponent;
+  }
+  uint64_t prev = 0;
+  uint64_t encode_buf[MAX_INTEGERS_PER_BLOCK];
+  for (size_t i = 0; i < values.size(); i += MAX_INTEGERS_PER_BLOCK) {
+    size_t encode_buflen = std::min<size_t>(values.size() - i, MAX_INTEGERS_PER_BLOCK);
+    if (encoding == DOUBLE_RESERVED_FLAGS::DECIMAL_ENCODING) {
+      for (size_t j = 0; j < encode_buflen; ++j) {
+        int64_t n = 0;
+        is_decimal(values[i + j], decimal_exponent, n);
+        encode_buf[j] = zigzag_encode(n);
+      }
+      frame_of_reference_encode_128(encode_buf, encode_buflen, oarc);
+    } else if (encoding == DOUBLE_RESERVED_FLAGS::FLOAT32_ENCODING) {
+      for (size_t j = 0; j < encode_buflen; ++j) {
+        float f = values[i + j];
+        uint32_t bits;
+        std::memcpy(&bits, &f, sizeof(bits));
+        encode_buf[j] = (bits << 1) | (bits >> 31);
+      }
+      frame_of_reference_encode_128(encode_buf, encode_buflen, oarc);
+    } else {
+      for (size_t j = 0; j < encode_buflen; ++j) {
+        uint64_t bits = double_bits(values[i + j]);
+        encode_buf[j] = bits ^ prev;
+        prev = bits;
+      }
+      encode_xor_block(encode_buf, encode_buflen, oarc);
+    }
+  }
+}
+
+void decode_double_extension(iarchive& iarc,
+                             char encoding,
+                             std::vector<flexible_type>& ret,
+                             size_t num_undefined) {
+  size_t decimal_exponent = 0;
+  if (encoding == DOUBLE_RESERVED_FLAGS::DECIMAL_ENCODING) {
+    char c;
+    iarc >> c;
+    decimal_exponent = c;
+    ASSERT_LE(decimal_exponent, MAX_DECIMAL_EXPONENT);
+  }
+  const double power_of_10 = DECIMAL_POWERS_OF_10[decimal_exponent];
+  uint64_t prev = 0;
+  uint64_t buf[MAX_INTEGERS_PER_BLOCK];
+  size_t num_values_to_read = ret.size() - num_undefined;
+  size_t i = 0;
+  while (num_values_to_read > 0) {
+    size_t buflen = std::min<size_t>(num_values_to_read, MAX_INTEGERS_PER_BLOCK);
+    if (encoding == DOUBLE_RESERVED_FLAGS::DECIMAL_ENCODING) {
+      frame_of_reference_decode_128(iarc, buflen, buf);
+      for (size_t j = 0; j < buflen; ++j) {
+        buf[j] = double_bits(double(zigzag_decode(buf[j])) / power_of_10);
+      }
+    } else if (encoding == DOUBLE_RESERVED_FLAGS::FLOAT32_ENCODING) {
+      frame_of_reference_decode_128(iarc, buflen, buf);
+      for (size_t j = 0; j < buflen; ++j) {
+        uint32_t bits = uint32_t(buf[j] >> 1) | uint32_t(buf[j] << 31);
+        float f;
+        std::memcpy(&f, &bits, sizeof(f));
+        buf[j] = double_bits(f);
+      }
+    } else {
+      ASSERT_EQ(encoding, DOUBLE_RESERVED_FLAGS::XOR_ENCODING);
+      decode_xor_block(iarc, buflen, buf);
+      for (size_t j = 0; j < buflen; ++j) {
+        prev ^= buf[j];
+        buf[j] = prev;
+      }
+    }
+    for (size_t j = 0; j < buflen; ++j) {
+      while (ret[i].get_type() == flex_type_enum::UNDEFINED) ++i;
+      ret[i].reinterpret_mutable_get<flex_int>() = buf[j];
+      ++i;
+    }
+    num_values_to_read -= buflen;
+  }
+}
+
 void encode_double(block_info& info, 
                    oarchive& oarc, 
                    const std::vector<flexible_type>& data) {
@@ -126,14 +350,7 @@ void encode_double(block_info& info,
   }
   if (safe_for_integer_code) {
     reserved = DOUBLE_RESERVED_FLAGS::INTEGER_ENCODING;
-  } else {
-    reserved = DOUBLE_RESERVED_FLAGS::LEGACY_ENCODING;
-  }
-  oarc.write(&(reserved), sizeof(reserved));
-  if (reserved == DOUBLE_RESERVED_FLAGS::LEGACY_ENCODING) {
-    encode_double_legacy(info, oarc, data);
-    return;
-  } else if (reserved == DOUBLE_RESERVED_FLAGS::INTEGER_ENCODING) {
+    oarc.write(&(reserved), sizeof(reserved));
     std::vector<flexible_type> copy = data;
     for (auto& i : copy) {
       if (i.get_type() == flex_type_enum::FLOAT) {
@@ -142,7 +359,45 @@ void encode_double(block_info& info,
     }
     encode_number(info, oarc, copy);
     return;
-  } 
+  }
+
+  // Otherwise, try the encodings which apply and keep the smallest.
+  std::vector<double> values;
+  values.reserve(data.size());
+  bool is_float32 = true;
+  for (const auto& val: data) {
+    if (val.get_type() != flex_type_enum::UNDEFINED) {
+      double d = val.reinterpret_get<flex_float>();
+      values.push_back(d);
+      if (is_float32 && double_bits(double(float(d))) != double_bits(d)) {
+        is_float32 = false;
+      }
+    }
+  }
+  size_t decimal_exponent = 0;
+  bool decimal_applies = find_decimal_exponent(values, decimal_exponent);
+
+  oarchive best;
+  reserved = DOUBLE_RESERVED_FLAGS::LEGACY_ENCODING;
+  encode_double_legacy(info, best, data);
+  for (char encoding : {(char)DOUBLE_RESERVED_FLAGS::DECIMAL_ENCODING,
+                        (char)DOUBLE_RESERVED_FLAGS::FLOAT32_ENCODING,
+                        (char)DOUBLE_RESERVED_FLAGS::XOR_ENCODING}) {
+    if (encoding == DOUBLE_RESERVED_FLAGS::DECIMAL_ENCODING && !decimal_applies) continue;
+    if (encoding == DOUBLE_RESERVED_FLAGS::FLOAT32_ENCODING && !is_float32) continue;
+    oarchive trial;
+    encode_double_extension(encoding, decimal_exponent, trial, values);
+    if (trial.off < best.off) {
+      std::swap(trial.buf, best.buf);
+      std::swap(trial.off, best.off);
+      std::swap(trial.len, best.len);
+      reserved = encoding;
+    }
+    free(trial.buf);
+  }
+  oarc.write(&(reserved), sizeof(reserved));
+  oarc.write(best.buf, best.off);
+  free(best.buf);
 }
 
 
@@ -183,7 +438,8 @@ void decode_double(iarchive& iarc,
   // we reserve one character so we can add new encoders as needed in the future
   char reserved = 0;
   iarc.read(&(reserved), sizeof(reserved));
-  ASSERT_LT(reserved, 3);
+  ASSERT_LE(reserved, DOUBLE_RESERVED_FLAGS::XOR_ENCODING);
+  ASSERT_NE(reserved, DOUBLE_RESERVED_FLAGS::UNUSED_ENCODING);
   if (reserved == DOUBLE_RESERVED_FLAGS::LEGACY_ENCODING) {
     decode_double_legacy(iarc, ret, num_undefined);
     return;
@@ -198,7 +454,9 @@ void decode_double(iarchive& iarc,
       }
     }
     return;
-  } 
+  } else {
+    decode_double_extension(iarc, reserved, ret, num_undefined);
+  }
 }
 
 /**
@@ -427,6 +685,321 @@ static void decode_nd_vector(iarchive& iarc,
                        }, new_format);
 }
 
+/**
+ * Writes data as a nested typed block: the block flags and the length in
+ * bytes of the typed_encode()d data, then the data. The number of values is
+ * not stored.
+ */
+static void encode_sub_block(oarchive& oarc,
+                             const std::vector<flexible_type>& data) {
+  block_info info;
+  oarchive sub_oarc;
+  typed_encode(data, info, sub_oarc);
+  variable_encode(oarc, info.flags);
+  variable_encode(oarc, sub_oarc.off);
+  oarc.write(sub_oarc.buf, sub_oarc.off);
+  free(sub_oarc.buf);
+}
+
+/**
+ * Decodes num_elem values written by encode_sub_block().
+ */
+static void decode_sub_block(iarchive& iarc,
+                             size_t num_elem,
+                             std::vector<flexible_type>& ret) {
+  block_info info;
+  uint64_t length;
+  variable_decode(iarc, info.flags);
+  variable_decode(iarc, length);
+  info.num_elem = num_elem;
+  ASSERT_TRUE(typed_decode(info, const_cast<char*>(iarc.buf + iarc.off),
+                           length, ret));
+  iarc.off += length;
+}
+
+/**
+ * Skips a sub-block written by encode_sub_block().
+ */
+static void skip_sub_block(iarchive& iarc) {
+  uint64_t flags, length;
+  variable_decode(iarc, flags);
+  variable_decode(iarc, length);
+  iarc.off += length;
+}
+
+/**
+ * Adds the types of the num_elem values of a sub-block written by
+ * encode_sub_block() to types, reading only the header of the sub-block
+ * unless it mixes types.
+ */
+static void sub_block_types(iarchive& iarc,
+                            size_t num_elem,
+                            std::set<flex_type_enum>& types) {
+  size_t begin = iarc.off;
+  block_info info;
+  uint64_t length;
+  variable_decode(iarc, info.flags);
+  variable_decode(iarc, length);
+  if (info.flags & MULTIPLE_TYPE_BLOCK) {
+    iarc.off = begin;
+    std::vector<flexible_type> values;
+    decode_sub_block(iarc, num_elem, values);
+    for (const auto& val: values) types.insert(val.get_type());
+    return;
+  }
+  char num_types = iarc.buf[iarc.off];
+  if (num_types >= 1) {
+    types.insert((flex_type_enum)iarc.buf[iarc.off + 1]);
+  }
+  if (num_types == 2) types.insert(flex_type_enum::UNDEFINED);
+  iarc.off += length;
+}
+
+/**
+ * Encodes a collection of lists in data, skipping all UNDEFINED values.
+ *
+ *  - one byte: NESTED_RESERVED_FLAGS::SHREDDED
+ *  - encode a list of integers with all the list lengths
+ *  - a sub-block with all the elements of all the lists
+ */
+static void encode_list(block_info& info,
+                        oarchive& oarc,
+                        const std::vector<flexible_type>& data) {
+  char reserved = NESTED_RESERVED_FLAGS::SHREDDED;
+  oarc.write(&(reserved), sizeof(reserved));
+  std::vector<flexible_type> lengths;
+  std::vector<flexible_type> elements;
+  for (const auto& val: data) {
+    if (val.get_type() != flex_type_enum::UNDEFINED) {
+      const flex_list& list = val.get<flex_list>();
+      lengths.push_back(list.size());
+      elements.insert(elements.end(), list.begin(), list.end());
+    }
+  }
+  encode_number(info, oarc, lengths);
+  encode_sub_block(oarc, elements);
+}
+
+/**
+ * Dictionary keys are only merged if they have the same type and value, so
+ * that a key decodes to the type it was written with.
+ */
+struct same_key {
+  bool operator()(const flexible_type& a, const flexible_type& b) const {
+    return a.get_type() == b.get_type() && a == b;
+  }
+};
+
+/**
+ * Encodes a collection of dictionaries in data, skipping all UNDEFINED
+ * values.
+ *
+ *  - one byte: NESTED_RESERVED_FLAGS format
+ *  - encode a list of integers with all the dictionary sizes
+ *  - If SHREDDED:
+ *     - a sub-block with all the keys
+ *     - a sub-block with all the values
+ *  - If SHREDDED_BY_KEY:
+ *     - variable_encode() the number of distinct keys
+ *     - a sub-block with the distinct keys
+ *     - encode a list of integers with the key id of every entry
+ *     - for each distinct key, a sub-block with its values
+ *
+ * Blocks are shredded by key when keys repeat (on average, each key appears
+ * at least 4 times), as in dictionaries parsed from JSON records. Then
+ * reading one key only decodes the values of that key.
+ */
+static void encode_dict(block_info& info,
+                        oarchive& oarc,
+                        const std::vector<flexible_type>& data) {
+  std::vector<flexible_type> lengths;
+  std::vector<flexible_type> key_ids;
+  std::vector<flexible_type> distinct_keys;
+  std::unordered_map<flexible_type, size_t,
+                     std::hash<flexible_type>, same_key> key_index;
+  for (const auto& val: data) {
+    if (val.get_type() != flex_type_enum::UNDEFINED) {
+      const flex_dict& dict = val.get<flex_dict>();
+      lengths.push_back(dict.size());
+      for (const auto& entry: dict) {
+        auto iter = key_index.find(entry.first);
+        if (iter == key_index.end()) {
+          iter = key_index.emplace(entry.first, distinct_keys.size()).first;
+          distinct_keys.push_back(entry.first);
+        }
+        key_ids.push_back(iter->second);
+      }
+    }
+  }
+  char reserved = distinct_keys.size() * 4 <= key_ids.size() ?
+      NESTED_RESERVED_FLAGS::SHREDDED_BY_KEY : NESTED_RESERVED_FLAGS::SHREDDED;
+  oarc.write(&(reserved), sizeof(reserved));
+  encode_number(info, oarc, lengths);
+
+  if (reserved == NESTED_RESERVED_FLAGS::SHREDDED) {
+    std::vector<flexible_type> keys, values;
+    keys.reserve(key_ids.size());
+    values.reserve(key_ids.size());
+    for (const auto& val: data) {
+      if (val.get_type() != flex_type_enum::UNDEFINED) {
+        for (const auto& entry: val.get<flex_dict>()) {
+          keys.push_back(entry.first);
+          values.push_back(entry.second);
+        }
+      }
+    }
+    encode_sub_block(oarc, keys);
+    encode_sub_block(oarc, values);
+  } else {
+    std::vector<std::vector<flexible_type>> values(distinct_keys.size());
+    size_t entry_ctr = 0;
+    for (const auto& val: data) {
+      if (val.get_type() != flex_type_enum::UNDEFINED) {
+        for (const auto& entry: val.get<flex_dict>()) {
+          values[key_ids[entry_ctr++].get<flex_int>()].push_back(entry.second);
+        }
+      }
+    }
+    variable_encode(oarc, distinct_keys.size());
+    encode_sub_block(oarc, distinct_keys);
+    encode_number(info, oarc, key_ids);
+    for (const auto& key_values: values) {
+      encode_sub_block(oarc, key_values);
+    }
+  }
+}
+
+/**
+ * The keys of a shredded dict block, decoded up to the values.
+ */
+struct shredded_dict_keys {
+  char format;
+  /// The size of every dictionary
+  std::vector<flexible_type> lengths;
+  /// SHREDDED: the key of every entry
+  std::vector<flexible_type> keys;
+  /// SHREDDED_BY_KEY: the distinct keys, and the key id of every entry
+  std::vector<flexible_type> distinct_keys;
+  std::vector<flexible_type> key_ids;
+  /// SHREDDED_BY_KEY: the number of values of every distinct key
+  std::vector<size_t> key_counts;
+};
+
+static void decode_dict_keys(iarchive& iarc,
+                             size_t num_elements,
+                             shredded_dict_keys& ret) {
+  iarc.read(&(ret.format), sizeof(ret.format));
+  ret.lengths.resize(num_elements);
+  decode_number(iarc, ret.lengths, 0);
+  size_t num_entries = 0;
+  for (const auto& length: ret.lengths) num_entries += length.get<flex_int>();
+
+  if (ret.format == NESTED_RESERVED_FLAGS::SHREDDED) {
+    ret.keys.resize(num_entries);
+    decode_sub_block(iarc, num_entries, ret.keys);
+  } else {
+    ASSERT_EQ(ret.format, NESTED_RESERVED_FLAGS::SHREDDED_BY_KEY);
+    uint64_t num_distinct_keys;
+    variable_decode(iarc, num_distinct_keys);
+    ret.distinct_keys.resize(num_distinct_keys);
+    decode_sub_block(iarc, num_distinct_keys, ret.distinct_keys);
+    ret.key_ids.resize(num_entries);
+    decode_number(iarc, ret.key_ids, 0);
+    ret.key_counts.assign(num_distinct_keys, 0);
+    for (const auto& id: ret.key_ids) ++ret.key_counts[id.get<flex_int>()];
+  }
+}
+
+void decode_nested(iarchive& iarc,
+                   flex_type_enum column_type,
+                   size_t num_elements,
+                   std::vector<flexible_type>& ret) {
+  if (column_type == flex_type_enum::LIST) {
+    char reserved = 0;
+    iarc.read(&(reserved), sizeof(reserved));
+    ASSERT_EQ(reserved, NESTED_RESERVED_FLAGS::SHREDDED);
+    std::vector<flexible_type> lengths(num_elements);
+    decode_number(iarc, lengths, 0);
+    size_t num_values = 0;
+    for (const auto& length: lengths) num_values += length.get<flex_int>();
+    std::vector<flexible_type> elements(num_values);
+    decode_sub_block(iarc, num_values, elements);
+
+    auto element = elements.begin();
+    for (const auto& length: lengths) {
+      flexible_type list(flex_type_enum::LIST);
+      flex_list& output = list.mutable_get<flex_list>();
+      output.assign(std::make_move_iterator(element),
+                    std::make_move_iterator(element + length.get<flex_int>()));
+      element += length.get<flex_int>();
+      ret.push_back(std::move(list));
+    }
+    return;
+  }
+
+  ASSERT_TRUE(column_type == flex_type_enum::DICT);
+  shredded_dict_keys keys;
+  decode_dict_keys(iarc, num_elements, keys);
+  if (keys.format == NESTED_RESERVED_FLAGS::SHREDDED) {
+    std::vector<flexible_type> values(keys.keys.size());
+    decode_sub_block(iarc, values.size(), values);
+    size_t entry_ctr = 0;
+    for (const auto& length: keys.lengths) {
+      flexible_type dict(flex_type_enum::DICT);
+      flex_dict& output = dict.mutable_get<flex_dict>();
+      output.resize(length.get<flex_int>());
+      for (auto& entry: output) {
+        entry.first = std::move(keys.keys[entry_ctr]);
+        entry.second = std::move(values[entry_ctr]);
+        ++entry_ctr;
+      }
+      ret.push_back(std::move(dict));
+    }
+  } else {
+    std::vector<std::vector<flexible_type>> values(keys.distinct_keys.size());
+    for (size_t k = 0; k < values.size(); ++k) {
+      values[k].resize(keys.key_counts[k]);
+      decode_sub_block(iarc, values[k].size(), values[k]);
+    }
+    std::vector<size_t> value_ctr(values.size(), 0);
+    size_t entry_ctr = 0;
+    for (const auto& length: keys.lengths) {
+      flexible_type dict(flex_type_enum::DICT);
+      flex_dict& output = dict.mutable_get<flex_dict>();
+      output.resize(length.get<flex_int>());
+      for (auto& entry: output) {
+        size_t id = keys.key_ids[entry_ctr++].get<flex_int>();
+        entry.first = keys.distinct_keys[id];
+        entry.second = std::move(values[id][value_ctr[id]++]);
+      }
+      ret.push_back(std::move(dict));
+    }
+  }
+}
+
+/**
+ * Decodes a collection of lists or dictionaries in data, skipping all
+ * UNDEFINED values. Wrapper around decode_nested().
+ */
+static void decode_nested(iarchive& iarc,
+                          std::vector<flexible_type>& ret,
+                          flex_type_enum column_type,
+                          size_t num_undefined) {
+  std::vector<flexible_type> values;
+  values.reserve(ret.size() - num_undefined);
+  decode_nested(iarc, column_type, ret.size() - num_undefined, values);
+  size_t last_id = 0;
+  for (auto& val: values) {
+    while(last_id < ret.size() &&
+          ret[last_id].get_type() == flex_type_enum::UNDEFINED) {
+      ++last_id;
+    }
+    DASSERT_LT(last_id, ret.size());
+    ret[last_id] = std::move(val);
+    ++last_id;
+  }
+}
+
 void typed_encode(const std::vector<flexible_type>& data, 
                   block_info& block,
                   oarchive& oarc) {
@@ -491,6 +1064,12 @@ void typed_encode(const std::vector<flexible_type>& data,
     } else if (types_appeared.get((char)flex_type_enum::ND_VECTOR)) {
       block.flags |=  BLOCK_ENCODING_EXTENSION;
       encode_nd_vector(block, oarc, data);
+    } else if (types_appeared.get((char)flex_type_enum::LIST)) {
+      block.flags |=  BLOCK_ENCODING_EXTENSION;
+      encode_list(block, oarc, data);
+    } else if (types_appeared.get((char)flex_type_enum::DICT)) {
+      block.flags |=  BLOCK_ENCODING_EXTENSION;
+      encode_dict(block, oarc, data);
     } else {
       flexible_type_impl::serializer s{oarc};
       for (size_t i = 0;i < data.size(); ++i) {
@@ -572,6 +1151,10 @@ bool typed_decode(const block_info& info,
     } else if (column_type == flex_type_enum::ND_VECTOR) {
       decode_nd_vector(iarc, ret, num_undefined, 
                     info.flags & BLOCK_ENCODING_EXTENSION);
+    } else if ((column_type == flex_type_enum::LIST ||
+                column_type == flex_type_enum::DICT) &&
+               (info.flags & BLOCK_ENCODING_EXTENSION)) {
+      decode_nested(iarc, ret, column_type, num_undefined);
     } else {
       flexible_type_impl::deserializer s{iarc};
       for (size_t i = 0;i < dsize; ++i) {
@@ -591,6 +1174,203 @@ bool typed_decode(const block_info& info,
   return true;
 }
 
+/**
+ * Reads the header of a typed block (see typed_encode()) up to the
+ * shredded dictionaries. Returns false if the block is not a shredded DICT
+ * block (possibly with UNDEFINED values), in which case it has to be decoded
+ * with typed_decode().
+ */
+static bool read_shredded_dict_header(const block_info& info,
+                                      iarchive& iarc,
+                                      turi::dense_bitset& undefined,
+                                      size_t& num_undefined) {
+  num_undefined = 0;
+  if (!(info.flags & IS_FLEXIBLE_TYPE) ||
+      (info.flags & MULTIPLE_TYPE_BLOCK) ||
+      !(info.flags & BLOCK_ENCODING_EXTENSION)) {
+    return false;
+  }
+  char num_types;
+  iarc >> num_types;
+  if (num_types != 1 && num_types != 2) return false;
+  char c;
+  iarc >> c;
+  if ((flex_type_enum)c != flex_type_enum::DICT) return false;
+  if (num_types == 2) {
+    undefined.resize(info.num_elem);
+    undefined.clear();
+    iarc.read((char*)undefined.array, sizeof(size_t) * undefined.arrlen);
+    num_undefined = undefined.popcount();
+  }
+  return true;
+}
+
+/**
+ * Fully decodes a DICT block. Returns false if it contains values which
+ * are neither dictionaries nor UNDEFINED.
+ */
+static bool decode_dict_block(const block_info& info,
+                              char* start, size_t len,
+                              std::vector<flexible_type>& ret) {
+  if (!typed_decode(info, start, len, ret)) return false;
+  for (const auto& val: ret) {
+    if (val.get_type() != flex_type_enum::DICT &&
+        val.get_type() != flex_type_enum::UNDEFINED) {
+      logstream(LOG_ERROR) << "Attempting to decode the keys of a "
+                           << flex_type_enum_to_name(val.get_type())
+                           << " value" << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+bool typed_decode_dict_keys(const block_info& info,
+                            char* start, size_t len,
+                            std::vector<flexible_type>& ret) {
+  turi::iarchive iarc(start, len);
+  turi::dense_bitset undefined;
+  size_t num_undefined;
+  if (!read_shredded_dict_header(info, iarc, undefined, num_undefined)) {
+    if (!decode_dict_block(info, start, len, ret)) return false;
+    for (auto& val: ret) {
+      if (val.get_type() == flex_type_enum::UNDEFINED) continue;
+      flex_list keys;
+      for (const auto& entry: val.get<flex_dict>()) keys.push_back(entry.first);
+      val = std::move(keys);
+    }
+    return true;
+  }
+
+  shredded_dict_keys keys;
+  decode_dict_keys(iarc, info.num_elem - num_undefined, keys);
+  ret.assign(info.num_elem, FLEX_UNDEFINED);
+  size_t entry_ctr = 0;
+  size_t length_ctr = 0;
+  for (size_t i = 0; i < ret.size(); ++i) {
+    if (num_undefined && undefined.get(i)) continue;
+    size_t length = keys.lengths[length_ctr++].get<flex_int>();
+    flex_list row_keys(length);
+    for (auto& key: row_keys) {
+      if (keys.format == NESTED_RESERVED_FLAGS::SHREDDED) {
+        key = std::move(keys.keys[entry_ctr]);
+      } else {
+        key = keys.distinct_keys[keys.key_ids[entry_ctr].get<flex_int>()];
+      }
+      ++entry_ctr;
+    }
+    ret[i] = std::move(row_keys);
+  }
+  return true;
+}
+
+bool typed_decode_dict_values(const block_info& info,
+                              char* start, size_t len,
+                              const std::vector<flexible_type>& keys,
+                              std::vector<std::vector<flexible_type>>& ret) {
+  ret.assign(keys.size(), std::vector<flexible_type>(info.num_elem, FLEX_UNDEFINED));
+  turi::iarchive iarc(start, len);
+  turi::dense_bitset undefined;
+  size_t num_undefined;
+  shredded_dict_keys dict_keys;
+  bool shredded_by_key =
+      read_shredded_dict_header(info, iarc, undefined, num_undefined);
+  if (shredded_by_key) {
+    decode_dict_keys(iarc, info.num_elem - num_undefined, dict_keys);
+    shredded_by_key = dict_keys.format == NESTED_RESERVED_FLAGS::SHREDDED_BY_KEY;
+  }
+  if (!shredded_by_key) {
+    std::vector<flexible_type> values;
+    if (!decode_dict_block(info, start, len, values)) return false;
+    for (size_t i = 0; i < values.size(); ++i) {
+      if (values[i].get_type() == flex_type_enum::UNDEFINED) continue;
+      const flex_dict& dict = values[i].get<flex_dict>();
+      for (size_t k = 0; k < keys.size(); ++k) {
+        for (const auto& entry: dict) {
+          if (entry.first == keys[k]) {
+            ret[k][i] = entry.second;
+            break;
+          }
+        }
+      }
+    }
+    return true;
+  }
+
+  // the requested keys every distinct key matches
+  const size_t num_distinct_keys = dict_keys.distinct_keys.size();
+  std::vector<std::vector<size_t>> matches(num_distinct_keys);
+  for (size_t id = 0; id < num_distinct_keys; ++id) {
+    for (size_t k = 0; k < keys.size(); ++k) {
+      if (dict_keys.distinct_keys[id] == keys[k]) matches[id].push_back(k);
+    }
+  }
+  // only decode the values of the matching keys
+  std::vector<std::vector<flexible_type>> values(num_distinct_keys);
+  for (size_t id = 0; id < num_distinct_keys; ++id) {
+    if (matches[id].empty()) {
+      skip_sub_block(iarc);
+    } else {
+      values[id].resize(dict_keys.key_counts[id]);
+      decode_sub_block(iarc, values[id].size(), values[id]);
+    }
+  }
+
+  std::vector<size_t> value_ctr(num_distinct_keys, 0);
+  // the last row in which a requested key was found; only the first entry
+  // matching a key counts
+  std::vector<size_t> found_in_row(keys.size(), (size_t)(-1));
+  size_t entry_ctr = 0;
+  size_t length_ctr = 0;
+  for (size_t i = 0; i < info.num_elem; ++i) {
+    if (num_undefined && undefined.get(i)) continue;
+    size_t length = dict_keys.lengths[length_ctr++].get<flex_int>();
+    for (size_t j = 0; j < length; ++j) {
+      size_t id = dict_keys.key_ids[entry_ctr++].get<flex_int>();
+      if (matches[id].empty()) continue;
+      const flexible_type& value = values[id][value_ctr[id]++];
+      for (size_t k: matches[id]) {
+        if (found_in_row[k] != i) {
+          found_in_row[k] = i;
+          ret[k][i] = value;
+        }
+      }
+    }
+  }
+  return true;
+}
+
+bool typed_decode_dict_value_types(
+    const block_info& info,
+    char* start, size_t len,
+    std::map<flexible_type, std::set<flex_type_enum>>& ret) {
+  turi::iarchive iarc(start, len);
+  turi::dense_bitset undefined;
+  size_t num_undefined;
+  shredded_dict_keys dict_keys;
+  bool shredded_by_key =
+      read_shredded_dict_header(info, iarc, undefined, num_undefined);
+  if (shredded_by_key) {
+    decode_dict_keys(iarc, info.num_elem - num_undefined, dict_keys);
+    shredded_by_key = dict_keys.format == NESTED_RESERVED_FLAGS::SHREDDED_BY_KEY;
+  }
+  if (!shredded_by_key) {
+    std::vector<flexible_type> values;
+    if (!decode_dict_block(info, start, len, values)) return false;
+    for (const auto& val: values) {
+      if (val.get_type() == flex_type_enum::UNDEFINED) continue;
+      for (const auto& entry: val.get<flex_dict>()) {
+        ret[entry.first].insert(entry.second.get_type());
+      }
+    }
+    return true;
+  }
+  for (size_t id = 0; id < dict_keys.distinct_keys.size(); ++id) {
+    sub_block_types(iarc, dict_keys.key_counts[id],
+                    ret[dict_keys.distinct_keys[id]]);
+  }
+  return true;
+}
 
 
 
@@ -5,6 +5,8 @@
  */
 #ifndef TURI_SFRAME_SARRAY_V2_TYPE_ENCODING_HPP
 #define TURI_SFRAME_SARRAY_V2_TYPE_ENCODING_HPP
+#include <map>
+#include <set>
 #include <flexible_type/flexible_type.hpp>
 #include <sframe/sarray_v2_block_types.hpp>
 #include <util/dense_bitset.hpp>
@@ -64,6 +66,10 @@ void decode_number(iarchive& iarc,
  * This is the 2nd generation vector decoder. its use is flagged by
  * turning on the block flag BLOCK_ENCODING_EXTENSION. 
  *
+ * If all the values are integral, the INTEGER encoding is used. Otherwise
+ * the LEGACY, DECIMAL, FLOAT32 and XOR encodings which apply to the values
+ * are all tried, and the smallest is kept.
+ *
  * \note The coding does not store the number of values stored. The decoder
  * \ref decode_number() requires the number of values to decode correctly.
  */
@@ -80,16 +86,40 @@ void encode_double(block_info& info,
  * This is the 2nd generation floating point encoder. its use is flagged by
  * turning on the block flag BLOCK_ENCODING_EXTENSION. 
  * The format is basically: 
- * - one byte: encoding format. LEGACY, or INTEGER.
+ * - one byte: encoding format. LEGACY, INTEGER, DECIMAL, FLOAT32 or XOR.
  * If LEGACY:
  *   The old encoder is used
  * If INTEGER:
  *   The floating point values are encoded as integers.
+ * Otherwise:
+ *   See \ref decode_double_extension().
  */
 void decode_double(iarchive& iarc,
                    std::vector<flexible_type>& ret,
                    size_t num_undefined);
 
+/**
+ * Decodes doubles written with the DECIMAL, FLOAT32 or XOR encodings
+ * (see DOUBLE_RESERVED_FLAGS), after the encoding byte, into the entries
+ * of ret which are not UNDEFINED. Like \ref decode_double_legacy(), the bits
+ * of the doubles are written without changing the type of the entries.
+ *
+ * - DECIMAL: one byte exponent e, then blocks of
+ *   frame_of_reference_encode_128() of the zigzag encoded integers
+ *   value * 10^e.
+ * - FLOAT32: blocks of frame_of_reference_encode_128() of the single
+ *   precision bits, with the sign bit rotated to the lowest bit.
+ * - XOR: the bits of every value are XORed with the bits of the previous
+ *   one (Gorilla style). For every block of 128 XORs: a bitmap of the
+ *   non-zero XORs, then (if any) one byte t and one byte w, the smallest
+ *   number of trailing and the width of the meaningful bits, then the
+ *   non-zero XORs shifted right by t, bit packed with w bits each.
+ */
+void decode_double_extension(iarchive& iarc,
+                             char encoding,
+                             std::vector<flexible_type>& ret,
+                             size_t num_undefined);
+
 /**
  * Decodes a collection of doubles into 'data'. Entries in data which are 
  * of type flex_type_enum::UNDEFINED will be skipped, and there must be exactly
@@ -142,6 +172,8 @@ bool typed_decode_stream_callback(const block_info& info,
  * - type specific encoding:
  *     - if integer or float, encode_number() is called
  *     - if string, encode_string() is called
+ *     - if list or dict, the values are shredded: the lengths, then the
+ *       elements (the keys, then the values) typed_encode()d as sub-blocks
  *     - otherwise, direct serialization is currently used.
  *     - If UNDEFINED (i.e. array is of all UNDEFINED values, nothing is written)
  *
@@ -205,7 +237,8 @@ static void decode_double_stream(size_t num_elements,
   // we reserve one character so we can add new encoders as needed in the future
   char reserved = 0;
   iarc.read(&(reserved), sizeof(reserved));
-  ASSERT_LT(reserved, 3);
+  ASSERT_LE(reserved, DOUBLE_RESERVED_FLAGS::XOR_ENCODING);
+  ASSERT_NE(reserved, DOUBLE_RESERVED_FLAGS::UNUSED_ENCODING);
   if (reserved == DOUBLE_RESERVED_FLAGS::LEGACY_ENCODING) {
     decode_double_stream_legacy(num_elements, iarc, callback);
     return;
@@ -215,7 +248,11 @@ static void decode_double_stream(size_t num_elements,
                            flex_float ret = flex_float(val.get<flex_int>());
                            callback(ret);
                          });
-  } 
+  } else {
+    std::vector<flexible_type> values(num_elements, flex_float(0));
+    decode_double_extension(iarc, reserved, values, 0);
+    for (const auto& val: values) callback(val);
+  }
 }
 
 
@@ -380,6 +417,56 @@ static void decode_nd_vector_stream(size_t num_elements,
 
 
 
+/**
+ * Decodes num_elements lists or dictionaries (column_type) stored in the
+ * shredded layout of \ref typed_encode(), appending them to ret.
+ *
+ * This is the shredded list / dict decoder. Its use is flagged by
+ * turning on the block flag BLOCK_ENCODING_EXTENSION.
+ */
+void decode_nested(iarchive& iarc,
+                   flex_type_enum column_type,
+                   size_t num_elements,
+                   std::vector<flexible_type>& ret);
+
+/**
+ * Decodes the keys of every dictionary of a DICT block: ret[i] is the
+ * LIST of the keys of row i, in order, or UNDEFINED.
+ *
+ * On a shredded block, the values are not decoded. Other blocks are fully
+ * decoded. Returns false on failure, or if the block is not a DICT block.
+ */
+bool typed_decode_dict_keys(const block_info& info,
+                            char* start, size_t len,
+                            std::vector<flexible_type>& ret);
+
+/**
+ * Decodes the values of a few keys in every dictionary of a DICT block:
+ * ret[k][i] is the value of the first entry of row i whose key is equal to
+ * keys[k], or UNDEFINED (as flex_dict_view would find it).
+ *
+ * On a block shredded by key, only the values of the matching keys are
+ * decoded. Other blocks are fully decoded. Returns false on failure, or if
+ * the block is not a DICT block.
+ */
+bool typed_decode_dict_values(const block_info& info,
+                              char* start, size_t len,
+                              const std::vector<flexible_type>& keys,
+                              std::vector<std::vector<flexible_type>>& ret);
+
+/**
+ * Collects the types of the values of every key of a DICT block:
+ * ret[key] holds the type of every value of key (including UNDEFINED).
+ *
+ * On a block shredded by key, the types are read from the headers of the
+ * value sub-blocks, which are only decoded if they mix types. Returns false
+ * on failure, or if the block is not a DICT block.
+ */
+bool typed_decode_dict_value_types(
+    const block_info& info,
+    char* start, size_t len,
+    std::map<flexible_type, std::set<flex_type_enum>>& ret);
+
 /**
  * Decodes a collection of flexible_type values. The array must be of 
  * contiguous type, but permitting undefined values.
@@ -480,6 +567,12 @@ static bool typed_decode_stream_callback(const block_info& info,
     } else if (column_type == flex_type_enum::ND_VECTOR) {
       decode_nd_vector_stream(elements_to_decode, iarc, stream_callback, 
                            info.flags & BLOCK_ENCODING_EXTENSION); 
+    } else if ((column_type == flex_type_enum::LIST ||
+                column_type == flex_type_enum::DICT) &&
+               (info.flags & BLOCK_ENCODING_EXTENSION)) {
+      std::vector<flexible_type> values;
+      decode_nested(iarc, column_type, elements_to_decode, values);
+      for (const auto& val: values) stream_callback(val);
     } else {
       flexible_type_impl::deserializer s{iarc};
       flexible_type ret(column_type);
@@ -10,6 +10,8 @@
 #include <sframe/parallel_csv_parser.hpp>
 #include <sframe/csv_writer.hpp>
 #include <boost/algorithm/string/predicate.hpp>
+#include <boost/algorithm/string/split.hpp>
+#include <boost/algorithm/string/classification.hpp>
 #include <fileio/temp_files.hpp>
 #include <boost/filesystem.hpp>
 #include <sframe/sframe_constants.hpp>
@@ -18,6 +20,9 @@
 #include <exceptions/error_types.hpp>
 namespace turi {
 
+/// The frame metadata key of the sort order of the rows
+static const char* SORT_ORDER_METADATA_KEY = "__sort_order__";
+
 sframe::sframe(const sframe& other) {
   Dlog_func_entry();
   if (other.inited) {
@@ -326,6 +331,15 @@ sframe sframe::append(const sframe& other) const {
         (ret.columns[i]->append(*other.columns[i]));
   }
   ret.index_info.nrows += other.index_info.nrows;
+  // the rows of other do not continue the sort order of this frame, so the
+  // order only survives if one of the two is empty
+  if (other.num_rows() == 0) {
+    // keep the order of this frame
+  } else if (num_rows() == 0) {
+    ret.set_sort_order(other.get_sort_order());
+  } else {
+    ret.set_sort_order(sframe_sort_order());
+  }
   return ret;
 }
 
@@ -678,6 +692,43 @@ bool sframe::set_metadata(const std::string& key, std::string val) {
   return true;
 }
 
+sframe_sort_order sframe::get_sort_order() const {
+  ASSERT_MSG(inited, "Invalid SFrame");
+  sframe_sort_order ret;
+  auto iter = index_info.metadata.find(SORT_ORDER_METADATA_KEY);
+  if (iter == index_info.metadata.end()) return ret;
+  // comma separated column indices, each followed by + or -
+  std::vector<std::string> entries;
+  boost::algorithm::split(entries, iter->second, boost::is_any_of(","));
+  for (const auto& entry: entries) {
+    if (entry.size() < 2 || (entry.back() != '+' && entry.back() != '-')) {
+      return sframe_sort_order();
+    }
+    std::string column = entry.substr(0, entry.size() - 1);
+    if (!std::all_of(column.begin(), column.end(), ::isdigit)) {
+      return sframe_sort_order();
+    }
+    size_t column_id = std::stoull(column);
+    if (column_id >= num_columns()) return sframe_sort_order();
+    ret.push_back({column_id, entry.back() == '+'});
+  }
+  return ret;
+}
+
+void sframe::set_sort_order(const sframe_sort_order& sort_order) {
+  ASSERT_MSG(inited, "Invalid SFrame");
+  if (sort_order.empty()) {
+    index_info.metadata.erase(SORT_ORDER_METADATA_KEY);
+    return;
+  }
+  std::string val;
+  for (const auto& column: sort_order) {
+    ASSERT_LT(column.first, num_columns());
+    if (!val.empty()) val += ",";
+    val += std::to_string(column.first) + (column.second ? "+" : "-");
+  }
+  index_info.metadata[SORT_ORDER_METADATA_KEY] = val;
+}
 
 void sframe::reset() {
   Dlog_func_entry();
@@ -32,6 +32,12 @@ typedef turi::sframe_function_output_iterator<
     std::function<void(const sframe_rows&)> >
     sframe_output_iterator;
 
+/**
+ * The columns a frame is sorted by, most significant first, as
+ * (column index, ascending) pairs.
+ */
+typedef std::vector<std::pair<size_t, bool>> sframe_sort_order;
+
 
 /**
  * \ingroup sframe_physical
@@ -655,6 +661,22 @@ class sframe : public swriter_base<sframe_output_iterator> {
    */
   bool set_metadata(const std::string& key, std::string val);
 
+  /**
+   * Returns the columns the frame is known to be sorted by (see
+   * \ref set_sort_order). Empty if the order of the rows is not known.
+   */
+  sframe_sort_order get_sort_order() const;
+
+  /**
+   * Records that the rows of the frame are sorted by the given columns.
+   * The order is kept in the frame metadata, and is saved with the frame.
+   * Unlike \ref set_metadata, this does not require the frame to be opened
+   * for writing. Frames made from the columns of this frame (for instance
+   * by \ref select_columns) do not inherit the order, and \ref append
+   * drops it unless one of the two frames is empty.
+   */
+  void set_sort_order(const sframe_sort_order& sort_order);
+
   /**
    * Saves a copy of the current sframe into a different location.
    * Does not modify the current sframe.
@@ -0,0 +1,412 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#include <sframe/sframe_arrow_io.hpp>
+#include <sframe/arrow_ipc_format.hpp>
+#include <sframe/sframe_rows.hpp>
+#include <sframe/sframe_constants.hpp>
+#include <sframe/sframe_saving_impl.hpp>
+#include <fileio/general_fstream.hpp>
+#include <fileio/sanitize_url.hpp>
+#include <parallel/lambda_omp.hpp>
+#include <parallel/pthread_tools.hpp>
+#include <serialization/serialization_includes.hpp>
+#include <logger/logger.hpp>
+#include <limits>
+
+namespace turi {
+
+namespace {
+
+const char TURI_DTYPE_KEY[] = "turi.dtype";
+const int64_t MICROSECONDS_PER_SECOND = 1000000;
+
+/**
+ * The Arrow type a column of the given SFrame type is written as.
+ */
+arrow_ipc::arrow_type arrow_type_of(flex_type_enum type) {
+  switch(type) {
+    case flex_type_enum::INTEGER: return arrow_ipc::arrow_type::INT64;
+    case flex_type_enum::FLOAT: return arrow_ipc::arrow_type::FLOAT64;
+    case flex_type_enum::STRING: return arrow_ipc::arrow_type::UTF8;
+    case flex_type_enum::VECTOR: return arrow_ipc::arrow_type::LIST_FLOAT64;
+    case flex_type_enum::DATETIME: return arrow_ipc::arrow_type::TIMESTAMP_MICROS;
+    case flex_type_enum::UNDEFINED: return arrow_ipc::arrow_type::NULL_TYPE;
+    default: return arrow_ipc::arrow_type::BINARY;
+  }
+}
+
+/**
+ * The SFrame type an Arrow field is read as.
+ */
+flex_type_enum flex_type_of(const arrow_ipc::field_desc& field) {
+  // Restore the original type if the file was written by us.
+  std::string dtype = field.get_metadata(TURI_DTYPE_KEY);
+  if (!dtype.empty()) {
+    try {
+      flex_type_enum type = flex_type_enum_from_name(dtype);
+      if (arrow_type_of(type) == field.type) return type;
+    } catch (...) { }
+  }
+  switch(field.type) {
+    case arrow_ipc::arrow_type::NULL_TYPE: return flex_type_enum::UNDEFINED;
+    case arrow_ipc::arrow_type::INT64: return flex_type_enum::INTEGER;
+    case arrow_ipc::arrow_type::FLOAT64: return flex_type_enum::FLOAT;
+    case arrow_ipc::arrow_type::UTF8: return flex_type_enum::STRING;
+    case arrow_ipc::arrow_type::BINARY: return flex_type_enum::STRING;
+    case arrow_ipc::arrow_type::TIMESTAMP_MICROS: return flex_type_enum::DATETIME;
+    case arrow_ipc::arrow_type::LIST_FLOAT64: return flex_type_enum::VECTOR;
+  }
+  return flex_type_enum::UNDEFINED;
+}
+
+/**
+ * Appends the decoded values [begin, end) of an SFrame column to the Arrow
+ * buffers of a column. Stops before the first value which would take the
+ * data buffer of the column past max_bytes, and returns the number of values
+ * appended.
+ */
+size_t append_column(std::vector<flexible_type>::const_iterator begin,
+                     std::vector<flexible_type>::const_iterator end,
+                     flex_type_enum type,
+                     arrow_ipc::arrow_type atype,
+                     size_t max_bytes,
+                     arrow_ipc::column_buffers& out) {
+  std::vector<char> serialization_buffer;
+  auto fits = [&](size_t len) { return out.data.size() + len <= max_bytes; };
+  for (auto it = begin; it != end; ++it) {
+    const flexible_type& v = *it;
+    if (v.get_type() == flex_type_enum::UNDEFINED) {
+      bool fixed_width = atype == arrow_ipc::arrow_type::INT64 ||
+                         atype == arrow_ipc::arrow_type::FLOAT64 ||
+                         atype == arrow_ipc::arrow_type::TIMESTAMP_MICROS;
+      if (!fits(fixed_width ? sizeof(int64_t) : 0)) return it - begin;
+      out.append_null(atype);
+      continue;
+    }
+    switch(type) {
+      case flex_type_enum::INTEGER:
+        if (!fits(sizeof(int64_t))) return it - begin;
+        out.append_int64(v.get<flex_int>());
+        break;
+      case flex_type_enum::FLOAT:
+        if (!fits(sizeof(double))) return it - begin;
+        out.append_double(v.get<flex_float>());
+        break;
+      case flex_type_enum::STRING: {
+        const flex_string& s = v.get<flex_string>();
+        if (!fits(s.size())) return it - begin;
+        out.append_bytes(s.data(), s.size());
+        break;
+      }
+      case flex_type_enum::VECTOR: {
+        const flex_vec& vec = v.get<flex_vec>();
+        if (!fits(vec.size() * sizeof(double))) return it - begin;
+        out.append_double_list(vec.data(), vec.size());
+        break;
+      }
+      case flex_type_enum::DATETIME: {
+        if (!fits(sizeof(int64_t))) return it - begin;
+        const flex_date_time& dt = v.get<flex_date_time>();
+        out.append_int64(dt.posix_timestamp() * MICROSECONDS_PER_SECOND +
+                         dt.microsecond());
+        break;
+      }
+      default: {
+        oarchive oarc(serialization_buffer);
+        oarc << v;
+        if (!fits(oarc.off)) return it - begin;
+        out.append_bytes(oarc.buf, oarc.off);
+        break;
+      }
+    }
+  }
+  return end - begin;
+}
+
+/**
+ * The blocks of a (v2) column, and the row at which each of them ends.
+ */
+struct column_block_list {
+  index_file_information column_index;
+  std::vector<sframe_saving_impl::column_block> blocks;
+  std::vector<size_t> block_ends;
+};
+
+/**
+ * Appends the rows [row_start, row_end) of a column to the Arrow buffers of
+ * a column, decoding the blocks holding them one at a time straight from the
+ * block manager. Stops early, like \ref append_column, when the data buffer
+ * of the column reaches max_bytes. Returns the row it stopped at.
+ */
+size_t append_column_blocks(v2_block_impl::block_manager& block_manager,
+                            const column_block_list& column,
+                            size_t row_start, size_t row_end,
+                            flex_type_enum type,
+                            arrow_ipc::arrow_type atype,
+                            size_t max_bytes,
+                            arrow_ipc::column_buffers& out) {
+  const auto& ends = column.block_ends;
+  size_t b = std::upper_bound(ends.begin(), ends.end(), row_start) - ends.begin();
+
+  // the segment of the column currently opened
+  size_t open_segment = (size_t)(-1);
+  v2_block_impl::column_address segment_address;
+  std::vector<flexible_type> values;
+  try {
+    for (; b < column.blocks.size() && row_start < row_end; ++b) {
+      const auto& block = column.blocks[b];
+      if (block.segment_number != open_segment) {
+        if (open_segment != (size_t)(-1)) block_manager.close_column(segment_address);
+        open_segment = (size_t)(-1);
+        segment_address = block_manager.open_column(
+            column.column_index.segment_files[block.segment_number]);
+        open_segment = block.segment_number;
+      }
+      v2_block_impl::block_address address{std::get<0>(segment_address),
+                                           std::get<1>(segment_address),
+                                           block.block_number};
+      if (!block_manager.read_typed_block(address, values)) {
+        log_and_throw("Unable to read block while saving SFrame as Arrow");
+      }
+      size_t block_start = ends[b] - block.num_elem;
+      size_t first = row_start - block_start;
+      size_t last = std::min(row_end, ends[b]) - block_start;
+      size_t appended = append_column(values.begin() + first,
+                                      values.begin() + last,
+                                      type, atype, max_bytes, out);
+      row_start = block_start + first + appended;
+      if (appended < last - first) break;
+    }
+  } catch (...) {
+    if (open_segment != (size_t)(-1)) {
+      try {
+        block_manager.close_column(segment_address);
+      } catch (...) { }
+    }
+    throw;
+  }
+  if (open_segment != (size_t)(-1)) block_manager.close_column(segment_address);
+  return row_start;
+}
+
+/**
+ * Converts value i of the Arrow buffers of a column into a flexible_type.
+ */
+flexible_type value_at(const arrow_ipc::column_buffers& col,
+                       arrow_ipc::arrow_type atype,
+                       flex_type_enum type,
+                       size_t i) {
+  if (!col.is_valid(i)) return FLEX_UNDEFINED;
+  switch(atype) {
+    case arrow_ipc::arrow_type::NULL_TYPE:
+      return FLEX_UNDEFINED;
+    case arrow_ipc::arrow_type::INT64:
+      return flex_int(col.int64_at(i));
+    case arrow_ipc::arrow_type::FLOAT64:
+      return flex_float(col.double_at(i));
+    case arrow_ipc::arrow_type::UTF8:
+    case arrow_ipc::arrow_type::BINARY: {
+      auto bytes = col.bytes_at(i);
+      if (type == flex_type_enum::STRING) {
+        return flex_string(bytes.first, bytes.second);
+      }
+      flexible_type ret;
+      iarchive iarc(bytes.first, bytes.second);
+      iarc >> ret;
+      return ret;
+    }
+    case arrow_ipc::arrow_type::TIMESTAMP_MICROS: {
+      int64_t micros = col.int64_at(i);
+      int64_t seconds = micros / MICROSECONDS_PER_SECOND;
+      int64_t remainder = micros % MICROSECONDS_PER_SECOND;
+      if (remainder < 0) {
+        remainder += MICROSECONDS_PER_SECOND;
+        seconds -= 1;
+      }
+      return flex_date_time(seconds, flex_date_time::EMPTY_TIMEZONE, remainder);
+    }
+    case arrow_ipc::arrow_type::LIST_FLOAT64: {
+      auto values = col.list_at(i);
+      return flex_vec(values.first, values.first + values.second);
+    }
+  }
+  return FLEX_UNDEFINED;
+}
+
+} // anonymous namespace
+
+
+void sframe_save_as_arrow(const sframe& sf, const std::string& url) {
+  logstream(LOG_INFO) << "Saving SFrame as Arrow to " << sanitize_url(url)
+                      << std::endl;
+
+  size_t num_columns = sf.num_columns();
+  std::vector<flex_type_enum> types = sf.column_types();
+  std::vector<arrow_ipc::field_desc> schema(num_columns);
+  for (size_t i = 0; i < num_columns; ++i) {
+    schema[i].name = sf.column_name(i);
+    schema[i].type = arrow_type_of(types[i]);
+    schema[i].metadata.push_back({TURI_DTYPE_KEY,
+                                  flex_type_enum_to_name(types[i])});
+  }
+
+  size_t num_rows = sf.size();
+  size_t rows_per_batch =
+      std::max<size_t>(1, SFRAME_ARROW_BATCH_NUM_CELLS / std::max<size_t>(num_columns, 1));
+  size_t num_batches = (num_rows + rows_per_batch - 1) / rows_per_batch;
+
+  general_ofstream fout(url);
+  if (!fout.good()) {
+    log_and_throw_io_failure("Unable to open " + sanitize_url(url) + " for writing");
+  }
+  arrow_ipc::file_writer writer(fout, schema);
+
+  // Stream the blocks of the columns from the block manager when they are
+  // all typed v2 blocks (the usual case); otherwise go through a reader.
+  auto& block_manager = v2_block_impl::block_manager::get_instance();
+  std::vector<column_block_list> column_blocks(num_columns);
+  bool stream_blocks = true;
+  for (size_t i = 0; i < num_columns && stream_blocks; ++i) {
+    auto& column = column_blocks[i];
+    column.column_index = sf.select_column(i)->get_index_info();
+    if (column.column_index.version < 2) {
+      stream_blocks = false;
+      break;
+    }
+    column.blocks = sframe_saving_impl::list_column_blocks(
+        block_manager, column.column_index);
+    size_t row = 0;
+    for (const auto& block : column.blocks) {
+      if (!block.is_typed) stream_blocks = false;
+      row += block.num_elem;
+      column.block_ends.push_back(row);
+    }
+  }
+  std::unique_ptr<sframe::reader_type> reader;
+  if (!stream_blocks) reader = sf.get_reader();
+
+  // Encode up to ncpus ranges of rows at a time, then append them in order.
+  // A range holding more than max_bytes of values in a column is written as
+  // several record batches.
+  size_t max_bytes = std::min<size_t>(SFRAME_ARROW_BATCH_MAX_BYTES,
+                                      std::numeric_limits<int32_t>::max());
+  size_t num_threads = thread::cpu_count();
+  std::vector<std::vector<std::string>> encoded_batches(num_threads);
+  for (size_t first = 0; first < num_batches; first += num_threads) {
+    size_t num_in_round = std::min(num_threads, num_batches - first);
+    parallel_for(0, num_in_round, [&](size_t i) {
+      size_t row_start = (first + i) * rows_per_batch;
+      size_t row_end = std::min(row_start + rows_per_batch, num_rows);
+
+      sframe_rows rows;
+      if (!stream_blocks) reader->read_rows(row_start, row_end, rows);
+      std::vector<arrow_ipc::column_buffers> columns(num_columns);
+      for (size_t start = row_start; start < row_end; ) {
+        // every column can only end the batch earlier
+        size_t end = row_end;
+        for (size_t c = 0; c < num_columns; ++c) {
+          columns[c].clear();
+          if (stream_blocks) {
+            end = append_column_blocks(block_manager, column_blocks[c],
+                                       start, end, types[c], schema[c].type,
+                                       max_bytes, columns[c]);
+          } else {
+            const auto& values = *(rows.cget_columns()[c]);
+            end = start + append_column(values.begin() + (start - row_start),
+                                        values.begin() + (end - row_start),
+                                        types[c], schema[c].type, max_bytes,
+                                        columns[c]);
+          }
+        }
+        if (end == start) {
+          log_and_throw("Unable to save the SFrame as Arrow: a value is "
+                        "larger than SFRAME_ARROW_BATCH_MAX_BYTES");
+        }
+        for (size_t c = 0; c < num_columns; ++c) {
+          columns[c].truncate(end - start, schema[c].type);
+        }
+        encoded_batches[i].push_back(
+            arrow_ipc::encode_record_batch(schema, columns));
+        start = end;
+      }
+    });
+    for (size_t i = 0; i < num_in_round; ++i) {
+      for (const auto& batch : encoded_batches[i]) {
+        writer.write_encoded_batch(batch);
+      }
+      encoded_batches[i].clear();
+      encoded_batches[i].shrink_to_fit();
+    }
+  }
+  writer.close();
+  if (!fout.good()) {
+    log_and_throw_io_failure("Fail to write " + sanitize_url(url));
+  }
+  fout.close();
+}
+
+
+sframe sframe_load_from_arrow(const std::string& url) {
+  logstream(LOG_INFO) << "Loading Arrow file " << sanitize_url(url)
+                      << std::endl;
+
+  general_ifstream fin(url);
+  if (!fin.good()) {
+    log_and_throw_io_failure("Unable to open " + sanitize_url(url));
+  }
+  arrow_ipc::file_reader file(fin);
+  const auto& schema = file.schema();
+  size_t num_columns = schema.size();
+  size_t num_batches = file.num_record_batches();
+
+  std::vector<std::string> column_names(num_columns);
+  std::vector<flex_type_enum> types(num_columns);
+  for (size_t i = 0; i < num_columns; ++i) {
+    column_names[i] = schema[i].name.empty() ? "X" + std::to_string(i + 1)
+                                             : schema[i].name;
+    types[i] = flex_type_of(schema[i]);
+  }
+
+  // Every segment is written by one thread, from a contiguous range of
+  // record batches, so the row order is preserved.
+  size_t num_segments = std::max<size_t>(
+      1, std::min<size_t>(thread::cpu_count(), num_batches));
+  std::vector<std::shared_ptr<sarray<flexible_type>>> columns(num_columns);
+  for (size_t i = 0; i < num_columns; ++i) {
+    columns[i] = std::make_shared<sarray<flexible_type>>();
+    columns[i]->open_for_write(num_segments);
+    columns[i]->set_type(types[i]);
+  }
+
+  parallel_for(0, num_segments, [&](size_t segment_id) {
+    size_t batch_begin = segment_id * num_batches / num_segments;
+    size_t batch_end = (segment_id + 1) * num_batches / num_segments;
+    if (batch_begin == batch_end) return;
+
+    general_ifstream segment_fin(url);
+    std::vector<arrow_ipc::column_buffers> buffers;
+    std::vector<sarray<flexible_type>::iterator> outputs;
+    for (size_t c = 0; c < num_columns; ++c) {
+      outputs.push_back(columns[c]->get_output_iterator(segment_id));
+    }
+
+    for (size_t b = batch_begin; b < batch_end; ++b) {
+      size_t num_rows = file.read_record_batch(segment_fin, b, buffers);
+      for (size_t c = 0; c < num_columns; ++c) {
+        auto& out = outputs[c];
+        for (size_t i = 0; i < num_rows; ++i) {
+          *out = value_at(buffers[c], schema[c].type, types[c], i);
+          ++out;
+        }
+      }
+    }
+  });
+
+  for (auto& column : columns) column->close();
+  return sframe(columns, column_names, false);
+}
+
+} // namespace turi
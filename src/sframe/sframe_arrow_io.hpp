@@ -0,0 +1,66 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#ifndef TURI_SFRAME_ARROW_IO_HPP
+#define TURI_SFRAME_ARROW_IO_HPP
+#include <string>
+#include <sframe/sframe.hpp>
+
+namespace turi {
+
+/**
+ * \ingroup sframe_physical
+ * \addtogroup arrow_ipc Arrow IPC Reading and Writing
+ * \{
+ */
+
+/**
+ * Writes an SFrame to url as an Arrow IPC file (the ".arrow" / Feather V2
+ * format).
+ *
+ * Columns are mapped as follows:
+ *  - integer  -> Int64
+ *  - float    -> Float64
+ *  - string   -> Utf8
+ *  - array    -> List<Float64>
+ *  - datetime -> Timestamp(microsecond, UTC). The timezone of the
+ *                individual values is not preserved.
+ *  - undefined -> Null
+ *  - list, dictionary, ndarray, image -> Binary, holding the serialized
+ *                flexible_type value.
+ *
+ * The SFrame type of every column is also stored in the "turi.dtype" field
+ * metadata, so \ref sframe_load_from_arrow restores exactly the same types.
+ *
+ * The SFrame is written in record batches of about
+ * SFRAME_ARROW_BATCH_NUM_CELLS cells, encoded in parallel. A batch is cut
+ * short when the values of one of its columns reach
+ * SFRAME_ARROW_BATCH_MAX_BYTES bytes, so that large strings, images or
+ * vectors stay addressable by the 32 bit Arrow offsets. Each batch
+ * decodes the blocks of the columns holding its rows straight from the block
+ * manager, one block at a time, without going through an sframe_reader; a
+ * block straddling two batches is decoded by both. Frames with legacy (v1)
+ * columns are read through an sframe_reader instead.
+ */
+void sframe_save_as_arrow(const sframe& sf, const std::string& url);
+
+/**
+ * Reads an Arrow IPC file written by \ref sframe_save_as_arrow or by any
+ * other Arrow implementation.
+ *
+ * Apart from the types written by \ref sframe_save_as_arrow, all integer and
+ * boolean types are read as integer columns, Float32 as float, Binary as
+ * string, Timestamps of any unit as datetime and lists of numbers as array.
+ * Other types (and dictionary encoded files) are rejected.
+ *
+ * The record batches are decoded in parallel, each thread writing one
+ * segment of the resulting columns.
+ */
+sframe sframe_load_from_arrow(const std::string& url);
+
+/// \}
+} // namespace turi
+
+#endif
@@ -26,12 +26,18 @@ EXPORT size_t SFRAME_WRITER_MAX_BUFFERED_CELLS = 32*1024*1024; // 64M elements
 EXPORT size_t SFRAME_WRITER_MAX_BUFFERED_CELLS_PER_BLOCK = 256*1024; // 1M elements.
 EXPORT // will be modified at startup to be 4x nCPUS
 EXPORT size_t SFRAME_MAX_BLOCKS_IN_CACHE = 32;
+EXPORT size_t SFRAME_DECODED_BLOCK_CACHE_CAPACITY = 256 * 1024 * 1024; // 256MB
 EXPORT size_t SFRAME_CSV_PARSER_READ_SIZE = 50 * 1024 * 1024; // 50MB
 EXPORT size_t SFRAME_GROUPBY_BUFFER_NUM_ROWS = 1024 * 1024;
 EXPORT size_t SFRAME_JOIN_BUFFER_NUM_CELLS = 50*1024*1024;
 EXPORT size_t SFRAME_IO_READ_LOCK = false;
 EXPORT size_t SFRAME_SORT_PIVOT_ESTIMATION_SAMPLE_SIZE = 2000000;
 EXPORT size_t SFRAME_SORT_MAX_SEGMENTS = 128;
+EXPORT size_t SFRAME_ARROW_BATCH_NUM_CELLS = 1024 * 1024;
+EXPORT size_t SFRAME_ARROW_BATCH_MAX_BYTES = 1024 * 1024 * 1024; // 1GB
+EXPORT size_t SFRAME_KEY_INDEX_RUNS_PER_BLOCK = 1024;
+EXPORT size_t SFRAME_SAVE_COLUMN_SKETCHES = true;
+EXPORT size_t SFRAME_SAVE_MIN_SEGMENT_SIZE = 64 * 1024 * 1024; // 64MB
 EXPORT const size_t SFRAME_IO_LOCK_FILE_SIZE_THRESHOLD = 4 * 1024 * 1024;
 
 
@@ -59,6 +65,12 @@ REGISTER_GLOBAL_WITH_CHECKS(int64_t,
                             +[](int64_t val){ return val >= 1; });
 
 
+REGISTER_GLOBAL_WITH_CHECKS(int64_t, 
+                            SFRAME_DECODED_BLOCK_CACHE_CAPACITY, 
+                            true, 
+                            +[](int64_t val){ return val >= 0; });
+
+
 REGISTER_GLOBAL_WITH_CHECKS(int64_t, 
                             SFRAME_CSV_PARSER_READ_SIZE, 
                             true, 
@@ -104,4 +116,28 @@ REGISTER_GLOBAL_WITH_CHECKS(int64_t,
                             true,
                             +[](int64_t val){ return val > 1; });
 
+REGISTER_GLOBAL_WITH_CHECKS(int64_t, 
+                            SFRAME_ARROW_BATCH_NUM_CELLS,
+                            true,
+                            +[](int64_t val){ return val >= 1024; });
+
+REGISTER_GLOBAL_WITH_CHECKS(int64_t, 
+                            SFRAME_ARROW_BATCH_MAX_BYTES,
+                            true,
+                            +[](int64_t val){
+                              return val >= 1024 &&
+                                  val <= std::numeric_limits<int32_t>::max(); });
+
+REGISTER_GLOBAL_WITH_CHECKS(int64_t, 
+                            SFRAME_KEY_INDEX_RUNS_PER_BLOCK,
+                            true,
+                            +[](int64_t val){ return val >= 1; });
+
+REGISTER_GLOBAL(int64_t, SFRAME_SAVE_COLUMN_SKETCHES, true);
+
+REGISTER_GLOBAL_WITH_CHECKS(int64_t,
+                            SFRAME_SAVE_MIN_SEGMENT_SIZE,
+                            true,
+                            +[](int64_t val){ return val >= 1024 * 1024; });
+
 } // namespace turi
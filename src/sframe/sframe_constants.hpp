@@ -122,6 +122,13 @@ extern size_t SFRAME_WRITER_MAX_BUFFERED_CELLS;
  */
 extern size_t SFRAME_MAX_BLOCKS_IN_CACHE;
 
+/**
+ * The maximum number of bytes of decoded blocks kept in the process wide
+ * decoded block cache shared by all readers (see decoded_block_cache).
+ * 0 disables the cache.
+ */
+extern size_t SFRAME_DECODED_BLOCK_CACHE_CAPACITY;
+
 /**
  * The amount to read from the file each time by the CSV parser. (this block
  * is then parsed in parallel by a collection of threads)
@@ -167,6 +174,44 @@ extern size_t SFRAME_SORT_PIVOT_ESTIMATION_SAMPLE_SIZE;
  */
 extern size_t SFRAME_SORT_MAX_SEGMENTS;
 
+/**
+ * The number of cells (rows x columns) in each record batch of an Arrow
+ * file written by \ref sframe_save_as_arrow.
+ */
+extern size_t SFRAME_ARROW_BATCH_NUM_CELLS;
+
+/**
+ * The maximum number of bytes of values held by one column of a record
+ * batch of an Arrow file written by \ref sframe_save_as_arrow. Batches are
+ * cut short when a column reaches it, since Arrow strings, binaries and lists
+ * address their values with 32 bit offsets. At most 2^31 - 1.
+ */
+extern size_t SFRAME_ARROW_BATCH_MAX_BYTES;
+
+/**
+ * The number of runs in each block of a key index built by
+ * \ref sframe_key_index::build. Only one hash per block is kept in memory,
+ * and a lookup reads about one block per key.
+ */
+extern size_t SFRAME_KEY_INDEX_RUNS_PER_BLOCK;
+
+/**
+ * If true (the default), saving an SFrame or SArray also saves a sketch of
+ * every segment of its scalar columns (see \ref column_sketch), used by
+ * summaries and to size groupby and join tables. The sketches are built
+ * while the blocks are copied (decoding them in memory, without reading
+ * the column again), or merged from the persisted sketches of the source
+ * when its segments line up with the saved ones.
+ */
+extern size_t SFRAME_SAVE_COLUMN_SKETCHES;
+
+/**
+ * Saving an SFrame writes one segment per SFRAME_SAVE_MIN_SEGMENT_SIZE bytes
+ * of (decoded) blocks, and at most SFRAME_DEFAULT_NUM_SEGMENTS segments,
+ * which are written in parallel. See \ref sframe_save_blockwise.
+ */
+extern size_t SFRAME_SAVE_MIN_SEGMENT_SIZE;
+
 /// \} 
 } // namespace turi
 #endif
@@ -0,0 +1,371 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#include <algorithm>
+#include <cmath>
+#include <unordered_set>
+#include <sframe/sframe_key_index.hpp>
+#include <sframe/sframe_index_file.hpp>
+#include <sframe/sframe_constants.hpp>
+#include <fileio/general_fstream.hpp>
+#include <fileio/fs_utils.hpp>
+#include <fileio/temp_files.hpp>
+#include <fileio/sanitize_url.hpp>
+#include <parallel/lambda_omp.hpp>
+#include <parallel/pthread_tools.hpp>
+#include <serialization/serialization_includes.hpp>
+#include <logger/logger.hpp>
+
+namespace turi {
+
+namespace {
+
+const uint64_t KEY_INDEX_MAGIC = 0x3158444979654b54ULL; // "TKeyIDX1"
+const char KEY_INDEX_METADATA_PREFIX[] = "__key_index_";
+
+std::string key_index_metadata_key(size_t column_id) {
+  return KEY_INDEX_METADATA_PREFIX + std::to_string(column_id) + "__";
+}
+
+/**
+ * Converts a key to the representation stored in a column of the given
+ * type. Returns false if the key can never be equal to a value of the
+ * column.
+ */
+bool normalize_key(const flexible_type& key, flex_type_enum column_type,
+                   flexible_type& out) {
+  if (key.get_type() == flex_type_enum::FLOAT &&
+      column_type == flex_type_enum::INTEGER) {
+    flex_float v = key.get<flex_float>();
+    if (std::floor(v) != v) return false;
+    out = flex_int(v);
+  } else if (key.get_type() == flex_type_enum::INTEGER &&
+             column_type == flex_type_enum::FLOAT) {
+    out = flex_float(key.get<flex_int>());
+  } else if (key.get_type() == column_type ||
+             key.get_type() == flex_type_enum::UNDEFINED) {
+    out = key;
+  } else {
+    return false;
+  }
+  // -0.0 == 0.0 but they hash differently
+  if (out.get_type() == flex_type_enum::FLOAT && out.get<flex_float>() == 0) {
+    out = flex_float(0);
+  }
+  return true;
+}
+
+uint64_t key_hash(const flexible_type& value) {
+  if (value.get_type() == flex_type_enum::FLOAT && value.get<flex_float>() == 0) {
+    return flexible_type(flex_float(0)).hash();
+  }
+  return value.hash();
+}
+
+} // anonymous namespace
+
+
+bool sframe_key_index::supports_column_type(flex_type_enum column_type) {
+  return column_type == flex_type_enum::INTEGER ||
+         column_type == flex_type_enum::FLOAT ||
+         column_type == flex_type_enum::STRING;
+}
+
+std::vector<flexible_type>
+sframe_key_index::normalize_keys(const std::vector<flexible_type>& keys,
+                                 flex_type_enum column_type) {
+  std::vector<flexible_type> ret;
+  for (const auto& key : keys) {
+    flexible_type normalized;
+    if (normalize_key(key, column_type, normalized)) ret.push_back(normalized);
+  }
+  return ret;
+}
+
+bool sframe_key_index::supports_key(const flexible_type& key,
+                                    flex_type_enum column_type) {
+  return supports_column_type(column_type) &&
+         key.get_type() != flex_type_enum::DATETIME;
+}
+
+void sframe_key_index::build(const sframe& sf, size_t column_id,
+                             const std::string& url) {
+  ASSERT_LT(column_id, sf.num_columns());
+  if (!supports_column_type(sf.column_type(column_id))) {
+    log_and_throw("A key index can only be built on an integer, float or string column");
+  }
+  size_t num_rows = sf.size();
+  auto reader = sf.select_column(column_id)->get_reader();
+
+  // Every thread collects the runs of a contiguous range of rows.
+  size_t num_threads = thread::cpu_count();
+  std::vector<std::vector<run_record>> thread_runs(num_threads);
+  parallel_for(0, num_threads, [&](size_t thread_id) {
+    size_t row_begin = thread_id * num_rows / num_threads;
+    size_t row_end = (thread_id + 1) * num_rows / num_threads;
+    auto& runs = thread_runs[thread_id];
+    std::vector<flexible_type> values;
+    for (size_t start = row_begin; start < row_end;
+         start += DEFAULT_SARRAY_READER_BUFFER_SIZE) {
+      size_t end = std::min(start + DEFAULT_SARRAY_READER_BUFFER_SIZE, row_end);
+      reader->read_rows(start, end, values);
+      for (size_t i = 0; i < values.size(); ++i) {
+        uint64_t h = key_hash(values[i]);
+        if (!runs.empty() && runs.back().hash == h &&
+            runs.back().row_end == start + i) {
+          ++runs.back().row_end;
+        } else {
+          runs.push_back(run_record{h, start + i, start + i + 1});
+        }
+      }
+    }
+  });
+
+  std::vector<run_record> runs;
+  for (auto& r : thread_runs) {
+    runs.insert(runs.end(), r.begin(), r.end());
+    std::vector<run_record>().swap(r);
+  }
+  std::sort(runs.begin(), runs.end(),
+            [](const run_record& a, const run_record& b) {
+              return a.hash < b.hash ||
+                     (a.hash == b.hash && a.row_begin < b.row_begin);
+            });
+
+  size_t runs_per_block = SFRAME_KEY_INDEX_RUNS_PER_BLOCK;
+  std::vector<uint64_t> fences;
+  for (size_t i = 0; i < runs.size(); i += runs_per_block) {
+    fences.push_back(runs[i].hash);
+  }
+
+  std::string column_file;
+  const auto& column_files = sf.get_index_info().column_files;
+  if (column_id < column_files.size()) {
+    column_file = fileio::get_filename(column_files[column_id]);
+  }
+
+  std::vector<char> header_buffer;
+  oarchive oarc(header_buffer);
+  oarc << sf.column_name(column_id) << column_file << num_rows
+       << runs.size() << runs_per_block << fences;
+
+  general_ofstream fout(url);
+  if (!fout.good()) {
+    log_and_throw_io_failure("Unable to open " + sanitize_url(url) + " for writing");
+  }
+  uint64_t header_size = oarc.off;
+  fout.write(reinterpret_cast<const char*>(&KEY_INDEX_MAGIC), sizeof(KEY_INDEX_MAGIC));
+  fout.write(reinterpret_cast<const char*>(&header_size), sizeof(header_size));
+  fout.write(oarc.buf, oarc.off);
+  fout.write(reinterpret_cast<const char*>(runs.data()),
+             runs.size() * sizeof(run_record));
+  if (!fout.good()) {
+    log_and_throw_io_failure("Fail to write " + sanitize_url(url));
+  }
+  fout.close();
+}
+
+
+sframe_key_index::sframe_key_index(const std::string& url) : m_url(url) {
+  general_ifstream fin(url);
+  if (!fin.good()) {
+    log_and_throw_io_failure("Unable to open " + sanitize_url(url));
+  }
+  uint64_t magic = 0;
+  uint64_t header_size = 0;
+  fin.read(reinterpret_cast<char*>(&magic), sizeof(magic));
+  fin.read(reinterpret_cast<char*>(&header_size), sizeof(header_size));
+  if (!fin.good() || magic != KEY_INDEX_MAGIC) {
+    log_and_throw(sanitize_url(url) + " is not a key index file");
+  }
+  std::string header(header_size, '\0');
+  fin.read(&(header[0]), header_size);
+  if (!fin.good()) {
+    log_and_throw_io_failure("Fail to read " + sanitize_url(url));
+  }
+  iarchive iarc(header.data(), header.size());
+  iarc >> m_column_name >> m_column_file >> m_num_rows
+       >> m_num_runs >> m_runs_per_block >> m_fences;
+  m_data_offset = sizeof(magic) + sizeof(header_size) + header_size;
+}
+
+
+std::vector<std::pair<size_t, size_t>>
+sframe_key_index::find_row_ranges(const std::vector<flexible_type>& keys,
+                                  flex_type_enum column_type) const {
+  std::vector<uint64_t> hashes;
+  for (const auto& key : keys) {
+    flexible_type normalized;
+    if (normalize_key(key, column_type, normalized)) {
+      hashes.push_back(key_hash(normalized));
+    }
+  }
+  std::sort(hashes.begin(), hashes.end());
+  hashes.erase(std::unique(hashes.begin(), hashes.end()), hashes.end());
+
+  std::vector<std::pair<size_t, size_t>> ranges;
+  if (hashes.empty() || m_num_runs == 0) return ranges;
+
+  general_ifstream fin(m_url);
+  std::vector<run_record> block;
+  for (uint64_t h : hashes) {
+    // Runs with hash h may start in the block before the first fence >= h,
+    // and end in the block of the last fence <= h.
+    size_t first_block = std::lower_bound(m_fences.begin(), m_fences.end(), h)
+                         - m_fences.begin();
+    if (first_block > 0) --first_block;
+    size_t end_block = std::upper_bound(m_fences.begin(), m_fences.end(), h)
+                       - m_fences.begin();
+    if (end_block <= first_block) continue;
+
+    size_t run_begin = first_block * m_runs_per_block;
+    size_t run_end = std::min(end_block * m_runs_per_block, m_num_runs);
+    block.resize(run_end - run_begin);
+    fin.seekg(m_data_offset + run_begin * sizeof(run_record));
+    fin.read(reinterpret_cast<char*>(block.data()),
+             block.size() * sizeof(run_record));
+    if (!fin.good()) {
+      log_and_throw_io_failure("Fail to read " + sanitize_url(m_url));
+    }
+    auto range = std::equal_range(block.begin(), block.end(), run_record{h, 0, 0},
+                                  [](const run_record& a, const run_record& b) {
+                                    return a.hash < b.hash;
+                                  });
+    for (auto it = range.first; it != range.second; ++it) {
+      ranges.push_back({it->row_begin, it->row_end});
+    }
+  }
+
+  // sort and coalesce
+  std::sort(ranges.begin(), ranges.end());
+  std::vector<std::pair<size_t, size_t>> ret;
+  for (const auto& r : ranges) {
+    if (!ret.empty() && r.first <= ret.back().second) {
+      ret.back().second = std::max(ret.back().second, r.second);
+    } else {
+      ret.push_back(r);
+    }
+  }
+  return ret;
+}
+
+
+sframe sframe_key_index::lookup(const sframe& sf, size_t column_id,
+                                const std::vector<flexible_type>& keys) const {
+  ASSERT_LT(column_id, sf.num_columns());
+  if (sf.size() != m_num_rows) {
+    log_and_throw("The key index does not match the SFrame");
+  }
+  flex_type_enum column_type = sf.column_type(column_id);
+  auto normalized_keys = normalize_keys(keys, column_type);
+  std::unordered_set<flexible_type> key_set(normalized_keys.begin(),
+                                            normalized_keys.end());
+
+  sframe ret;
+  ret.open_for_write(sf.column_names(), sf.column_types(), "", 1);
+  auto out = ret.get_output_iterator(0);
+  auto reader = sf.get_reader();
+  std::vector<std::vector<flexible_type>> rows;
+  for (const auto& range : find_row_ranges(keys, column_type)) {
+    for (size_t start = range.first; start < range.second;
+         start += DEFAULT_SARRAY_READER_BUFFER_SIZE) {
+      size_t end = std::min(start + DEFAULT_SARRAY_READER_BUFFER_SIZE, range.second);
+      reader->read_rows(start, end, rows);
+      for (const auto& row : rows) {
+        const flexible_type& value = row[column_id];
+        if (key_set.count(value)) {
+          *out = row;
+          ++out;
+        }
+      }
+    }
+  }
+  ret.close();
+  return ret;
+}
+
+
+sframe sframe_add_key_index(const sframe& sf,
+                            const std::vector<std::string>& column_names,
+                            std::string index_file) {
+  const std::string& source_index_file = sf.get_index_file();
+  if (source_index_file.empty()) {
+    log_and_throw("A key index can only be added to a saved SFrame");
+  }
+  if (index_file.empty()) index_file = get_temp_name() + ".frame_idx";
+  if (index_file == source_index_file) {
+    log_and_throw("A key index cannot be added to a saved SFrame in place");
+  }
+  std::vector<size_t> column_ids;
+  for (const auto& column_name : column_names) {
+    column_ids.push_back(sf.column_index(column_name));
+  }
+
+  // The indexes sf already has are referred to from the new index file,
+  // by file name if they are in the same directory.
+  auto info = read_sframe_index_file(source_index_file);
+  std::string source_dir = fileio::get_dirname(source_index_file);
+  std::string target_dir = fileio::get_dirname(index_file);
+  for (auto& kv : info.metadata) {
+    if (kv.first.compare(0, sizeof(KEY_INDEX_METADATA_PREFIX) - 1,
+                         KEY_INDEX_METADATA_PREFIX) != 0) {
+      continue;
+    }
+    kv.second = fileio::make_absolute_path(source_dir, kv.second);
+    if (fileio::get_dirname(kv.second) == target_dir) {
+      kv.second = fileio::get_filename(kv.second);
+    }
+  }
+
+  for (size_t column_id : column_ids) {
+    std::string key_index_file = index_file + "." + std::to_string(column_id) + ".kidx";
+    sframe_key_index::build(sf, column_id, key_index_file);
+    info.metadata[key_index_metadata_key(column_id)] =
+        fileio::get_filename(key_index_file);
+  }
+  write_sframe_index_file(index_file, info);
+  return sframe(index_file);
+}
+
+
+bool sframe_has_key_index(const sframe& sf, size_t column_id) {
+  std::string key_index_file;
+  return !sf.get_index_file().empty() &&
+         sf.get_metadata(key_index_metadata_key(column_id), key_index_file);
+}
+
+
+std::shared_ptr<sframe_key_index> sframe_get_key_index(const sframe& sf,
+                                                       size_t column_id) {
+  std::string key_index_file;
+  if (sf.get_index_file().empty() ||
+      !sf.get_metadata(key_index_metadata_key(column_id), key_index_file)) {
+    return nullptr;
+  }
+  key_index_file = fileio::make_absolute_path(
+      fileio::get_dirname(sf.get_index_file()), key_index_file);
+
+  std::shared_ptr<sframe_key_index> ret;
+  try {
+    ret = std::make_shared<sframe_key_index>(key_index_file);
+  } catch (...) {
+    logstream(LOG_WARNING) << "Unable to open the key index "
+                           << sanitize_url(key_index_file) << std::endl;
+    return nullptr;
+  }
+  // The index is only valid for the column it was built from.
+  const auto& column_files = sf.get_index_info().column_files;
+  if (ret->num_rows() != sf.size() ||
+      ret->column_name() != sf.column_name(column_id) ||
+      column_id >= column_files.size() ||
+      ret->column_file() != fileio::get_filename(column_files[column_id])) {
+    logstream(LOG_WARNING) << "Ignoring the stale key index "
+                           << sanitize_url(key_index_file) << std::endl;
+    return nullptr;
+  }
+  return ret;
+}
+
+} // namespace turi
@@ -0,0 +1,149 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#ifndef TURI_SFRAME_KEY_INDEX_HPP
+#define TURI_SFRAME_KEY_INDEX_HPP
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include <sframe/sframe.hpp>
+
+namespace turi {
+
+/**
+ * \ingroup sframe_physical
+ * \addtogroup sframe_key_index SFrame Key Index
+ * \{
+ */
+
+/**
+ * An on-disk index over one column of a saved SFrame, used to find the
+ * rows holding a given set of keys without scanning the frame.
+ *
+ * The index is a sequence of runs (hash of key, first row, end row) sorted
+ * by hash, where every run covers consecutive rows whose keys have the same
+ * hash. Only a sparse table holding the hash of every
+ * SFRAME_KEY_INDEX_RUNS_PER_BLOCK-th run is kept in memory; a lookup reads
+ * the one or two blocks of runs which may hold the hash of the key, then
+ * reads the candidate row ranges with sframe_reader::read_rows and keeps
+ * the rows whose key is actually equal (hash collisions are thus harmless).
+ *
+ * The index is stored in a file next to a frame index file, and is
+ * referenced from the frame metadata, see \ref sframe_add_key_index.
+ *
+ * Only integer, float and string columns can be indexed. Keys are compared
+ * with the semantics of the "==" operator: integer keys match float columns
+ * and integral float keys match integer columns.
+ */
+class sframe_key_index {
+ public:
+  /**
+   * Builds the index of column column_id of sf, writing it to url.
+   */
+  static void build(const sframe& sf, size_t column_id, const std::string& url);
+
+  /**
+   * Opens an index written by \ref build. Only the header and the sparse
+   * hash table are read.
+   */
+  explicit sframe_key_index(const std::string& url);
+
+  /**
+   * Returns true if a column of the given type can be indexed.
+   */
+  static bool supports_column_type(flex_type_enum column_type);
+
+  /**
+   * Returns true if the rows of a column of the given type equal to key can
+   * be found with the index. Datetime keys are not supported, since they
+   * compare equal to some numbers.
+   */
+  static bool supports_key(const flexible_type& key, flex_type_enum column_type);
+
+  /**
+   * Converts the keys to the representation stored in a column of the
+   * given type, dropping the keys which can never be equal to a value of
+   * the column. A value of the column is equal to one of the keys if it is
+   * (as a flexible_type) one of the returned values.
+   */
+  static std::vector<flexible_type>
+  normalize_keys(const std::vector<flexible_type>& keys, flex_type_enum column_type);
+
+  /// The name of the indexed column when the index was built.
+  const std::string& column_name() const { return m_column_name; }
+
+  /// The file name (without directory) of the indexed column.
+  const std::string& column_file() const { return m_column_file; }
+
+  /// The number of rows of the frame the index was built from.
+  size_t num_rows() const { return m_num_rows; }
+
+  /**
+   * Returns the sorted, disjoint row ranges [begin, end) which may hold
+   * one of the keys. Every row holding one of the keys is in a range.
+   */
+  std::vector<std::pair<size_t, size_t>>
+  find_row_ranges(const std::vector<flexible_type>& keys,
+                  flex_type_enum column_type) const;
+
+  /**
+   * Returns the rows of sf whose column column_id is equal to one of the
+   * keys, in their original order. sf must be the frame the index was
+   * built from.
+   */
+  sframe lookup(const sframe& sf, size_t column_id,
+                const std::vector<flexible_type>& keys) const;
+
+ private:
+  struct run_record {
+    uint64_t hash;
+    uint64_t row_begin;
+    uint64_t row_end;
+  };
+
+  std::string m_url;
+  std::string m_column_name;
+  std::string m_column_file;
+  size_t m_num_rows = 0;
+  size_t m_num_runs = 0;
+  size_t m_runs_per_block = 0;
+  size_t m_data_offset = 0;
+  std::vector<uint64_t> m_fences;
+};
+
+/**
+ * Builds a key index for each of the columns column_names of sf, which must
+ * have been saved to (or loaded from) a frame index file.
+ *
+ * The saved frame is left untouched: a new frame index file, referring to
+ * the same column files and recording the indexes in its metadata, is
+ * written to index_file (a temporary file if empty), and the indexes are
+ * written next to it. The key indexes sf already has are kept.
+ *
+ * Returns the frame opened from the new index file.
+ */
+sframe sframe_add_key_index(const sframe& sf,
+                            const std::vector<std::string>& column_names,
+                            std::string index_file = "");
+
+/**
+ * Returns true if the metadata of sf refers to a key index of column
+ * column_id. The index file is not opened: it may still be missing or
+ * stale, see \ref sframe_get_key_index.
+ */
+bool sframe_has_key_index(const sframe& sf, size_t column_id);
+
+/**
+ * Returns the key index of column column_id of sf, or an empty pointer if
+ * there is none or if it does not match the frame any more.
+ */
+std::shared_ptr<sframe_key_index> sframe_get_key_index(const sframe& sf,
+                                                       size_t column_id);
+
+/// \}
+} // namespace turi
+
+#endif
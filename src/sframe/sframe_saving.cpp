@@ -3,6 +3,9 @@
  * Use of this source code is governed by a BSD-3-clause license that can
  * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
  */
+#include <algorithm>
+#include <iterator>
+#include <sstream>
 #include <sframe/sframe.hpp>
 #include <sframe/sframe_index_file.hpp>
 #include <sframe/sarray_index_file.hpp>
@@ -10,7 +13,10 @@
 #include <sframe/sarray_v2_block_writer.hpp>
 #include <sframe/sarray_v2_block_types.hpp>
 #include <sframe/sframe_saving_impl.hpp>
+#include <sframe/column_sketch.hpp>
+#include <parallel/lambda_omp.hpp>
 #include <fileio/fs_utils.hpp>
+#include <fileio/temp_files.hpp>
 #include <logger/assertions.hpp>
 #include <boost/lexical_cast.hpp>
 #include <boost/uuid/uuid.hpp>
@@ -74,10 +80,82 @@ void sframe_save_naive(const sframe& sf_source,
 
 
 
+/**
+ * Writes the blocks [begin, end) of a column to a segment of the writer,
+ * merging the runs of small blocks picked by group_small_blocks. Other blocks
+ * are copied without being decoded, unless sketch is set: the values of all
+ * the blocks are then added to it. Returns false if a block could not be
+ * sketched.
+ */
+static bool copy_column_blocks(v2_block_impl::block_manager& block_manager,
+                               v2_block_impl::block_writer& writer,
+                               const index_file_information& column_index,
+                               const std::vector<column_block>& blocks,
+                               size_t begin, size_t end,
+                               size_t segment_id, size_t column_id,
+                               column_sketch* sketch) {
+  auto runs = group_small_blocks(blocks, begin, end,
+                                 SFRAME_DEFAULT_BLOCK_SIZE,
+                                 SFRAME_WRITER_MAX_BUFFERED_CELLS_PER_BLOCK);
+  // the segment of the column currently opened
+  size_t open_segment = (size_t)(-1);
+  v2_block_impl::column_address segment_address;
+  auto address_of = [&](const column_block& block) {
+    if (block.segment_number != open_segment) {
+      if (open_segment != (size_t)(-1)) block_manager.close_column(segment_address);
+      open_segment = (size_t)(-1);
+      segment_address =
+          block_manager.open_column(column_index.segment_files[block.segment_number]);
+      open_segment = block.segment_number;
+    }
+    return v2_block_impl::block_address{std::get<0>(segment_address),
+                                        std::get<1>(segment_address),
+                                        block.block_number};
+  };
+
+  bool sketched = true;
+  try {
+    std::vector<flexible_type> merged, values;
+    for (const auto& run: runs) {
+      if (run.second - run.first == 1) {
+        v2_block_impl::block_info* infoptr = nullptr;
+        auto data = block_manager.read_block(address_of(blocks[run.first]), &infoptr);
+        if (!data) log_and_throw("Unable to read block while saving SFrame");
+        writer.write_block(segment_id, column_id, data->data(), *infoptr);
+        if (sketch && sketched) {
+          sketched = add_block_to_sketch(*infoptr, data->data(), data->size(),
+                                         *sketch);
+        }
+      } else {
+        merged.clear();
+        for (size_t i = run.first; i < run.second; ++i) {
+          if (!block_manager.read_typed_block(address_of(blocks[i]), values)) {
+            log_and_throw("Unable to read block while saving SFrame");
+          }
+          std::move(values.begin(), values.end(), std::back_inserter(merged));
+        }
+        if (sketch) {
+          for (const auto& val: merged) sketch->add(val);
+        }
+        writer.write_typed_block(segment_id, column_id, merged,
+                                 v2_block_impl::block_info());
+      }
+    }
+  } catch (...) {
+    if (open_segment != (size_t)(-1)) {
+      try {
+        block_manager.close_column(segment_address);
+      } catch (...) { }
+    }
+    throw;
+  }
+  if (open_segment != (size_t)(-1)) block_manager.close_column(segment_address);
+  return sketched;
+}
+
 void sframe_save_blockwise(const sframe& sf_source,
                            std::string index_file) {
   // this will hit the sframe at a lower level
-  // This is slightly complicated and slightly annoying.
   //
   // SFrame: 
   // An SFrame is an arbitrary collection of columns listed in a
@@ -89,13 +167,13 @@ void sframe_save_blockwise(const sframe& sf_source,
   //
   // Segments : Each segment is made up of a collection of blocks.
   //
-  //
-  // Essentially, we are going to maintain a collection of columns and advance
-  // each column through their segments and blocks.
-  //
-  // Now, the input number of segments may not match the output number of 
-  // segments and so we probably need to do some shuffling around here.
-  // Also, while we are here, it might be nice to reorder the blocks a bit
+  // The input segments of the columns need not line up (appended columns
+  // for instance), so we list the blocks of every column, and cut the output
+  // in segments at rows where every column has a block boundary. Each
+  // (segment, column) pair can then be written in parallel by copying
+  // whole blocks. Runs of small blocks, as left behind by many small
+  // appends, are merged into blocks of about SFRAME_DEFAULT_BLOCK_SIZE
+  // while we are at it; the other blocks are copied without decoding them.
 
   // initialize reader and writer
   auto& block_manager = v2_block_impl::block_manager::get_instance();
@@ -110,95 +188,101 @@ void sframe_save_blockwise(const sframe& sf_source,
     base_name = index_file;
   } 
   auto index = base_name + ".sidx";
-  auto segment_file = base_name + ".0000";
-  // we are going to emit only 1 segment. We should be rather IO bound anyway
-  writer.init(index, 1, sf_source.num_columns());
-  writer.open_segment(0, segment_file);
-  
+  size_t num_columns = sf_source.num_columns();
 
-  // this is going to be a max heap with each entry referencing a column.
-  std::vector<column_blocks> cols;
-  try {
-    for (size_t i = 0;i < sf_source.num_columns(); ++i) {
-      column_blocks col;
-      auto cur_column = sf_source.select_column(i);
-      col.column_index = cur_column->get_index_info();
-      if (col.column_index.segment_files.size() > 0) {
-        col.segment_address = 
-            block_manager.open_column(col.column_index.segment_files[0]);
-        // the block address is basically a tuple beginning with 
-        // the column address
-        col.num_blocks_in_current_segment = 
-            block_manager.num_blocks_in_column(col.segment_address);
-        col.next_row = 0; 
-        col.column_number = i;
-        col.num_segments = col.column_index.segment_files.size();
-        if (col.current_block_number >= col.num_blocks_in_current_segment) {
-          advance_column_blocks_to_next_block(block_manager, col);
-        }
-        if (!col.eof) cols.push_back(col);
+  std::vector<index_file_information> column_indices(num_columns);
+  std::vector<std::vector<column_block> > blocks(num_columns);
+  std::vector<std::vector<size_t> > block_ends(num_columns);
+  size_t total_bytes = 0;
+  for (size_t i = 0;i < num_columns; ++i) {
+    column_indices[i] = sf_source.select_column(i)->get_index_info();
+    blocks[i] = list_column_blocks(block_manager, column_indices[i]);
+    size_t row = 0;
+    for (const auto& block: blocks[i]) {
+      row += block.num_elem;
+      block_ends[i].push_back(row);
+      total_bytes += block.block_size;
+    }
+  }
+
+  size_t max_segments = std::min<size_t>(
+      SFRAME_DEFAULT_NUM_SEGMENTS, total_bytes / SFRAME_SAVE_MIN_SEGMENT_SIZE);
+  auto boundaries = choose_segment_boundaries(block_ends, sf_source.num_rows(),
+                                              std::max<size_t>(1, max_segments));
+  size_t num_segments = boundaries.size() - 1;
+
+  writer.init(index, num_segments, num_columns);
+  for (size_t i = 0; i < num_segments; ++i) {
+    std::stringstream strm;
+    strm << base_name << ".";
+    strm.fill('0'); strm.width(4);
+    strm << i;
+    writer.open_segment(i, strm.str());
+  }
+
+  // The sketch of every (segment, column) is the merge of persisted sketches
+  // of the source if its segments line up with the new ones; otherwise it is
+  // built while the blocks are copied.
+  std::vector<std::vector<std::shared_ptr<column_sketch> > > sketches(num_columns);
+  std::vector<char> build_sketches(num_columns, false);
+  for (size_t i = 0;i < num_columns; ++i) {
+    writer.get_index_info().columns[i].metadata = column_indices[i].metadata;
+    if (!sketch_column_when_saving(sf_source.column_type(i))) continue;
+    sketches[i] = regroup_column_sketches(column_indices[i], boundaries);
+    if (sketches[i].empty()) {
+      build_sketches[i] = true;
+      for (size_t j = 0; j < num_segments; ++j) {
+        sketches[i].push_back(std::make_shared<column_sketch>());
       }
+    }
+  }
 
-      writer.get_index_info().columns[i].metadata = col.column_index.metadata;
+  // one flag per task, so that tasks never write the same flag
+  std::vector<char> sketch_failed(num_segments * num_columns, false);
+  parallel_for(0, num_segments * num_columns, [&](size_t task) {
+    size_t segment_id = task / num_columns;
+    size_t column_id = task % num_columns;
+    const auto& ends = block_ends[column_id];
+    // every boundary is the end of a block of every column
+    size_t begin = std::upper_bound(ends.begin(), ends.end(),
+                                    boundaries[segment_id]) - ends.begin();
+    size_t end = std::upper_bound(ends.begin(), ends.end(),
+                                  boundaries[segment_id + 1]) - ends.begin();
+    if (segment_id == 0) begin = 0;
+    column_sketch* sketch = build_sketches[column_id] ?
+        sketches[column_id][segment_id].get() : nullptr;
+    if (!copy_column_blocks(block_manager, writer, column_indices[column_id],
+                            blocks[column_id], begin, end, segment_id,
+                            column_id, sketch)) {
+      sketch_failed[task] = true;
     }
-    // we are going to reorder the blocks so that the column with the lowest
-    // row number get written first. So this is to be a min-heap
-    auto comparator = [](
-        const column_blocks& a,
-        const column_blocks& b)->bool {
-      return a.next_row > b.next_row;
-    };
-    std::make_heap(cols.begin(), cols.end(), comparator);
-
-    while(!cols.empty()) {
-      auto cur = *(cols.begin());
-      std::pop_heap(cols.begin(), cols.end(), comparator);
-      cols.pop_back();
-      // read a block
-      v2_block_impl::block_info* infoptr = nullptr;
-      v2_block_impl::block_info info;
-      v2_block_impl::block_address block_address
-                          {std::get<0>(cur.segment_address),
-                           std::get<1>(cur.segment_address),
-                           cur.current_block_number};
-      auto data = block_manager.read_block(block_address , &infoptr);
-      info = *infoptr;
-      // write to segment 0. We have only 1 segment 
-      writer.write_block(0, cur.column_number, data->data(), info);
-      // increment the block number
-      advance_column_blocks_to_next_block(block_manager, cur);
-      // increment the row number
-      cur.next_row += info.num_elem;
-      // if there are still blocks. push it back 
-      if (!cur.eof) {
-        cols.push_back(cur);
-        std::push_heap(cols.begin(), cols.end(), comparator);
-      }
-    };
-
-    // close writers.
-    writer.close_segment(0);
-    writer.write_index_file();
-    auto output_index = writer.get_index_info();
-
-    // ok. now we need to write the actual frame index file
-    // get the original frame index
-    // and fill in the column data from the writer output
-    auto frame_index = sf_source.get_index_info();
-    frame_index.column_files.clear();
-    for (auto col : output_index.columns) {
-      frame_index.column_files.push_back(col.index_file);
+    if (sketch) sketch->finalize();
+  });
+
+  for (size_t i = 0;i < num_columns; ++i) {
+    bool failed = false;
+    for (size_t j = 0; j < num_segments; ++j) {
+      if (sketch_failed[j * num_columns + i]) failed = true;
     }
-    write_sframe_index_file(index_file, frame_index);
-  } catch (...) {
-    // cleanup. close any open columns
-    for(auto& col: cols) {
-      try {
-        block_manager.close_column(col.segment_address);
-      } catch (...) { }
+    if (!sketches[i].empty() && !failed) {
+      writer.set_column_sketches(i, sketches[i]);
     }
-    throw;
   }
+
+  // close writers.
+  for (size_t i = 0; i < num_segments; ++i) writer.close_segment(i);
+  writer.write_index_file();
+  auto output_index = writer.get_index_info();
+
+  // ok. now we need to write the actual frame index file
+  // get the original frame index
+  // and fill in the column data from the writer output
+  auto frame_index = sf_source.get_index_info();
+  frame_index.column_files.clear();
+  for (auto col : output_index.columns) {
+    frame_index.column_files.push_back(col.index_file);
+  }
+  write_sframe_index_file(index_file, frame_index);
 }
 
 void sframe_save(const sframe& sf_source,
@@ -217,6 +301,34 @@ void sframe_save(const sframe& sf_source,
   }
 }
 
+bool sframe_is_fragmented(const sframe& sf) {
+  if (sf.num_columns() == 0 || sf.num_rows() == 0) return false;
+  if (sf.num_segments() > 2 * SFRAME_DEFAULT_NUM_SEGMENTS) return true;
+  auto& block_manager = v2_block_impl::block_manager::get_instance();
+  size_t num_blocks = 0, num_small_blocks = 0;
+  for (size_t i = 0;i < sf.num_columns(); ++i) {
+    auto column_index = sf.select_column(i)->get_index_info();
+    // legacy columns cannot be inspected, and are rewritten by sframe_save
+    if (column_index.version < 2) return true;
+    for (const auto& block: list_column_blocks(block_manager, column_index)) {
+      ++num_blocks;
+      if (block.is_typed && block.block_size < SFRAME_DEFAULT_BLOCK_SIZE / 2) {
+        ++num_small_blocks;
+      }
+    }
+  }
+  // a column may well end with a small block in every segment
+  return num_small_blocks > sf.num_columns() * sf.num_segments() &&
+      num_small_blocks * 2 > num_blocks;
+}
+
+sframe sframe_compact(const sframe& sf, bool force) {
+  if (!force && !sframe_is_fragmented(sf)) return sf;
+  std::string index_file = get_temp_name() + ".frame_idx";
+  sframe_save(sf, index_file);
+  return sframe(index_file);
+}
+
 
 void sframe_save_weak_reference(const sframe& sf_source,
                                 std::string index_file) {
@@ -320,7 +432,7 @@ void sframe_save_weak_reference(const sframe& sf_source,
 
       // convert to a group index of 1 column
       group_index_file_information group_index; 
-      group_index.version = 2;
+      group_index.version = column_index.version;
       group_index.nsegments = column_index.segment_files.size();
       group_index.segment_files = column_index.segment_files;
 
@@ -5,6 +5,7 @@
  */
 #ifndef TURI_SFRAME_SAVING_HPP
 #define TURI_SFRAME_SAVING_HPP
+#include <string>
 namespace turi {
 class sframe;
 
@@ -26,6 +27,12 @@ void sframe_save_naive(const sframe& sf,
 /**
  * Saves an SFrame to another index file location using a more efficient method,
  * block by block.
+ *
+ * The output is split in up to SFRAME_DEFAULT_NUM_SEGMENTS segments (one per
+ * SFRAME_SAVE_MIN_SEGMENT_SIZE bytes) written in parallel. Blocks are copied
+ * without being decoded, except for runs of small blocks which are merged
+ * into blocks of about SFRAME_DEFAULT_BLOCK_SIZE bytes: saving compacts
+ * SFrames fragmented by many small appends.
  */
 void sframe_save_blockwise(const sframe& sf, 
                            std::string index_file);
@@ -57,6 +64,21 @@ void sframe_save(const sframe& sf,
 void sframe_save_weak_reference(const sframe& sf,
                                 std::string index_file);
 
+/**
+ * Returns true if the SFrame is fragmented enough to be worth compacting
+ * with \ref sframe_compact: it has many more segments than
+ * SFRAME_DEFAULT_NUM_SEGMENTS, or mostly small blocks (as left behind by
+ * many small appends).
+ */
+bool sframe_is_fragmented(const sframe& sf);
+
+/**
+ * Returns a compacted copy of the SFrame, saved to temporary files with
+ * \ref sframe_save_blockwise. Unless force is set, the SFrame itself is
+ * returned if it is not \ref sframe_is_fragmented.
+ */
+sframe sframe_compact(const sframe& sf, bool force = false);
+
 
 /// \}
 }; // naemspace turicreate
@@ -3,6 +3,8 @@
  * Use of this source code is governed by a BSD-3-clause license that can
  * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
  */
+#include <algorithm>
+#include <iterator>
 #include <sstream>
 #include <sframe/sframe.hpp>
 #include <sframe/sarray_v2_block_manager.hpp>
@@ -42,5 +44,86 @@ void advance_column_blocks_to_next_block(
     }
   }
 }
+
+std::vector<column_block> list_column_blocks(
+    v2_block_impl::block_manager& block_manager,
+    const index_file_information& column_index) {
+  std::vector<column_block> ret;
+  for (size_t i = 0; i < column_index.segment_files.size(); ++i) {
+    auto address = block_manager.open_column(column_index.segment_files[i]);
+    size_t num_blocks = block_manager.num_blocks_in_column(address);
+    for (size_t j = 0; j < num_blocks; ++j) {
+      const v2_block_impl::block_info& info = block_manager.get_block_info(
+          v2_block_impl::block_address{std::get<0>(address),
+                                       std::get<1>(address), j});
+      column_block block;
+      block.segment_number = i;
+      block.block_number = j;
+      block.num_elem = info.num_elem;
+      block.block_size = info.block_size;
+      block.is_typed = info.flags & v2_block_impl::IS_FLEXIBLE_TYPE;
+      ret.push_back(block);
+    }
+    block_manager.close_column(address);
+  }
+  return ret;
+}
+
+std::vector<size_t> choose_segment_boundaries(
+    const std::vector<std::vector<size_t> >& column_block_ends,
+    size_t num_rows,
+    size_t num_segments) {
+  // the rows at which a block ends in every column
+  std::vector<size_t> common;
+  if (!column_block_ends.empty()) common = column_block_ends[0];
+  for (size_t i = 1; i < column_block_ends.size(); ++i) {
+    std::vector<size_t> intersection;
+    std::set_intersection(common.begin(), common.end(),
+                          column_block_ends[i].begin(),
+                          column_block_ends[i].end(),
+                          std::back_inserter(intersection));
+    common.swap(intersection);
+  }
+
+  std::vector<size_t> ret{0};
+  for (size_t i = 1; i < num_segments; ++i) {
+    size_t target = num_rows * i / num_segments;
+    auto iter = std::lower_bound(common.begin(), common.end(), target);
+    if (iter == common.end() || *iter >= num_rows) break;
+    if (*iter > ret.back()) ret.push_back(*iter);
+  }
+  ret.push_back(num_rows);
+  return ret;
+}
+
+std::vector<std::pair<size_t, size_t> > group_small_blocks(
+    const std::vector<column_block>& blocks,
+    size_t begin, size_t end,
+    size_t target_block_size,
+    size_t max_elements) {
+  auto is_small = [&](const column_block& block) {
+    return block.is_typed && block.block_size < target_block_size / 2;
+  };
+  std::vector<std::pair<size_t, size_t> > ret;
+  size_t i = begin;
+  while (i < end) {
+    size_t run_end = i + 1;
+    if (is_small(blocks[i])) {
+      size_t run_size = blocks[i].block_size;
+      size_t run_elem = blocks[i].num_elem;
+      while (run_end < end && is_small(blocks[run_end]) &&
+             run_size + blocks[run_end].block_size <= target_block_size &&
+             run_elem + blocks[run_end].num_elem <= max_elements) {
+        run_size += blocks[run_end].block_size;
+        run_elem += blocks[run_end].num_elem;
+        ++run_end;
+      }
+    }
+    ret.push_back({i, run_end});
+    i = run_end;
+  }
+  return ret;
+}
+
 } // sframe_saving_impl
 } // namespace turi
@@ -5,6 +5,10 @@
  */
 #ifndef TURI_SFRAME_SAVING_IMPL_HPP
 #define TURI_SFRAME_SAVING_IMPL_HPP
+#include <utility>
+#include <vector>
+#include <sframe/sarray_index_file.hpp>
+#include <sframe/sarray_v2_block_manager.hpp>
 #include <sframe/sarray_v2_block_types.hpp>
 namespace turi {
 
@@ -54,6 +58,59 @@ struct column_blocks {
 void advance_column_blocks_to_next_block(
     v2_block_impl::block_manager& block_manager,
     column_blocks& block);
+
+/**
+ * A block of a column, listed in the order of the rows of the column.
+ */
+struct column_block {
+  // the segment of the column the block is in
+  size_t segment_number = 0;
+  // the block number within the segment
+  size_t block_number = 0;
+  size_t num_elem = 0;
+  // the decoded size of the block in bytes
+  size_t block_size = 0;
+  // typed blocks can be decoded and merged with their neighbours
+  bool is_typed = false;
+};
+
+/**
+ * Lists the blocks of a (v2) column, in row order.
+ */
+std::vector<column_block> list_column_blocks(
+    v2_block_impl::block_manager& block_manager,
+    const index_file_information& column_index);
+
+/**
+ * Picks the row boundaries of num_segments output segments of about the
+ * same number of rows, such that every column can be copied block by block:
+ * each boundary must be the end of a block in every column.
+ * column_block_ends[i] lists the row at which each block of column i ends,
+ * in increasing order.
+ *
+ * Returns the boundaries, beginning with 0 and ending with num_rows. There
+ * may be fewer segments than asked for if the blocks of the columns do not
+ * line up.
+ */
+std::vector<size_t> choose_segment_boundaries(
+    const std::vector<std::vector<size_t> >& column_block_ends,
+    size_t num_rows,
+    size_t num_segments);
+
+/**
+ * Groups the blocks [begin, end) of a column in runs of consecutive blocks
+ * to be written as a single block. Typed blocks smaller than half of
+ * target_block_size are merged with their small neighbours, as long as a run
+ * has at most target_block_size bytes and max_elements elements. Every
+ * other block is a run of its own, copied without being decoded.
+ *
+ * Returns the [begin, end) block ranges of the runs.
+ */
+std::vector<std::pair<size_t, size_t> > group_small_blocks(
+    const std::vector<column_block>& blocks,
+    size_t begin, size_t end,
+    size_t target_block_size,
+    size_t max_elements);
 } // sframe_saving_impl
 } // turicreate
 #endif
@@ -5,11 +5,123 @@
  */
 #include<sframe/shuffle.hpp>
 #include<sframe/sframe_rows.hpp>
-#include<fileio/buffered_writer.hpp>
+#include<util/cityhash_tc.hpp>
 #include<memory>
 
 namespace turi {
 
+void partition_rows(const sframe& sframe_in,
+                    std::vector<sframe::iterator>& outputs,
+                    partition_function assign_fn) {
+  size_t n = outputs.size();
+  ASSERT_GT(n, 0);
+
+  // split the work to threads
+  size_t num_rows = sframe_in.num_rows();
+  size_t num_columns = sframe_in.num_columns();
+  size_t num_workers = turi::thread::cpu_count();
+  size_t rows_per_worker = num_rows / num_workers;
+  size_t flush_limit = std::max<size_t>(SFRAME_WRITER_BUFFER_SOFT_LIMIT, 1);
+
+  std::vector<std::unique_ptr<turi::mutex>> output_locks;
+  for (size_t i = 0; i < n; ++i) {
+    output_locks.push_back(std::unique_ptr<turi::mutex>(new turi::mutex));
+  }
+
+  auto reader = sframe_in.get_reader();
+  parallel_for(0, num_workers, [&](size_t worker_id) {
+      size_t start_row = worker_id * rows_per_worker;
+      size_t end_row = (worker_id == (num_workers-1)) ? num_rows
+                                                      : (worker_id + 1) * rows_per_worker;
+
+      // thread local output buffer for each partition
+      std::vector<sframe_rows> buffers(n);
+      for (auto& buffer: buffers) buffer.resize(num_columns, 0);
+
+      auto flush_buffer = [&](size_t partition) {
+        sframe_rows& buffer = buffers[partition];
+        if (buffer.num_rows() == 0) return;
+        {
+          std::lock_guard<turi::mutex> guard(*output_locks[partition]);
+          *(outputs[partition]) = buffer;
+        }
+        for (auto& col: buffer.get_columns()) col->clear();
+      };
+
+      sframe_rows rows;
+      std::vector<size_t> partitions;
+      while (start_row < end_row) {
+        // read a chunk of rows to partition
+        size_t rows_to_read = std::min<size_t>((end_row - start_row), DEFAULT_SARRAY_READER_BUFFER_SIZE);
+        size_t rows_read = reader->read_rows(start_row, start_row + rows_to_read, rows);
+        DASSERT_EQ(rows_read, rows_to_read);
+        start_row += rows_read;
+
+        partitions.resize(rows.num_rows());
+        assign_fn(rows, worker_id, partitions);
+
+        // gather the rows into the buffers, one column at a time
+        const auto& in_columns = rows.cget_columns();
+        for (size_t c = 0; c < num_columns; ++c) {
+          const auto& in_column = *(in_columns[c]);
+          for (size_t r = 0; r < in_column.size(); ++r) {
+            DASSERT_LT(partitions[r], n);
+            buffers[partitions[r]].get_columns()[c]->push_back(in_column[r]);
+          }
+        }
+        for (size_t i = 0; i < n; ++i) {
+          if (buffers[i].num_rows() >= flush_limit) flush_buffer(i);
+        }
+      } // end of while
+
+      // flush the rest of the buffers
+      for (size_t i = 0; i < n; ++i) {
+        flush_buffer(i);
+      }
+  });
+}
+
+void hash_key_columns(const sframe_rows& rows,
+                      const std::vector<size_t>& key_columns,
+                      std::vector<size_t>& hashes) {
+  hashes.assign(rows.num_rows(), 0);
+  const auto& columns = rows.cget_columns();
+  for (size_t key: key_columns) {
+    DASSERT_LT(key, columns.size());
+    const auto& column = *(columns[key]);
+    for (size_t r = 0; r < column.size(); ++r) {
+      hashes[r] = hash64_combine(hashes[r], column[r].hash());
+    }
+  }
+}
+
+sframe hash_partition(const sframe& sframe_in,
+                      const std::vector<size_t>& key_columns,
+                      size_t n) {
+  ASSERT_GT(n, 0);
+  for (size_t key: key_columns) ASSERT_LT(key, sframe_in.num_columns());
+
+  sframe sframe_out;
+  sframe_out.open_for_write(sframe_in.column_names(), sframe_in.column_types(), "", n);
+  std::vector<sframe::iterator> sframe_out_iter;
+  for (size_t i = 0; i < n; ++i) {
+    sframe_out_iter.push_back(sframe_out.get_output_iterator(i));
+  }
+
+  std::vector<std::vector<size_t>> thread_hashes(turi::thread::cpu_count());
+  partition_rows(sframe_in, sframe_out_iter,
+                 [&](const sframe_rows& rows, size_t thread_id,
+                     std::vector<size_t>& partitions) {
+                   auto& hashes = thread_hashes[thread_id];
+                   hash_key_columns(rows, key_columns, hashes);
+                   for (size_t i = 0; i < hashes.size(); ++i) {
+                     partitions[i] = hashes[i] % n;
+                   }
+                 });
+  sframe_out.close();
+  return sframe_out;
+}
+
 std::vector<sframe> shuffle(
     sframe sframe_in,
     size_t n,
@@ -18,12 +130,6 @@ std::vector<sframe> shuffle(
 
     ASSERT_GT(n, 0);
 
-    // split the work to threads
-    // for n bins let's assign n / log(n) workers, assuming rows are evenly distributed.
-    size_t num_rows = sframe_in.num_rows();
-    size_t num_workers = turi::thread::cpu_count();
-    size_t rows_per_worker = num_rows / num_workers;
-
     // prepare the out sframe
     std::vector<sframe> sframe_out;
     std::vector<sframe::iterator> sframe_out_iter;
@@ -32,49 +138,20 @@ std::vector<sframe> shuffle(
       sf.open_for_write(sframe_in.column_names(), sframe_in.column_types(), "",  1);
       sframe_out_iter.push_back(sf.get_output_iterator(0));
     }
-    std::vector<std::unique_ptr<turi::mutex>> sframe_out_locks;
-    for (size_t i = 0; i < n; ++i) {
-      sframe_out_locks.push_back(std::unique_ptr<turi::mutex>(new turi::mutex));
-    }
 
-    auto reader = sframe_in.get_reader();
-    parallel_for(0, num_workers, [&](size_t worker_id) {
-        size_t start_row = worker_id * rows_per_worker;
-        size_t end_row = (worker_id == (num_workers-1)) ? num_rows
-                                                        : (worker_id + 1) * rows_per_worker;
-
-        // prepare thread local output buffer for each sframe
-        std::vector<buffered_writer<std::vector<flexible_type>, sframe::iterator>> writers;
-        for (size_t i = 0; i < n; ++i) {
-          writers.push_back(
-            buffered_writer<std::vector<flexible_type>, sframe::iterator>
-            (sframe_out_iter[i], *sframe_out_locks[i],
-             SFRAME_WRITER_BUFFER_SOFT_LIMIT, SFRAME_WRITER_BUFFER_HARD_LIMIT)
-          );
-        }
-
-        while (start_row < end_row) {
-          // read a chunk of rows to shuffle
-          sframe_rows rows;
-          size_t rows_to_read = std::min<size_t>((end_row - start_row), DEFAULT_SARRAY_READER_BUFFER_SIZE);
-          size_t rows_read = reader->read_rows(start_row, start_row + rows_to_read, rows);
-          DASSERT_EQ(rows_read, rows_to_read);
-          start_row += rows_read;
-
-          for (auto& row : rows) {
-            size_t out_index = hash_fn(row) % n;
-            if (emit_call_back) {
-              emit_call_back(row, worker_id);
-            }
-            writers[out_index].write(std::move(row));
-          }
-        } // end of while
-
-        // flush the rest of the buffer
-        for (size_t i = 0; i < n; ++i) {
-          writers[i].flush();
-        }
-    });
+    std::vector<std::vector<flexible_type>> thread_rows(turi::thread::cpu_count());
+    partition_rows(sframe_in, sframe_out_iter,
+                   [&](const sframe_rows& rows, size_t worker_id,
+                       std::vector<size_t>& partitions) {
+                     auto& row = thread_rows[worker_id];
+                     for (size_t i = 0; i < rows.num_rows(); ++i) {
+                       row = rows[i];
+                       partitions[i] = hash_fn(row) % n;
+                       if (emit_call_back) {
+                         emit_call_back(row, worker_id);
+                       }
+                     }
+                   });
 
     // close all sframe writers
     for (auto& sf: sframe_out) {
@@ -6,8 +6,10 @@
 #ifndef TURI_SFRAME_SHUFFLE_HPP
 #define TURI_SFRAME_SHUFFLE_HPP
 
+#include <functional>
 #include <vector>
 #include <sframe/sframe.hpp>
+#include <sframe/sframe_rows.hpp>
 
 namespace turi {
 
@@ -51,6 +53,49 @@ std::vector<sframe> shuffle(
      std::function<void(const std::vector<flexible_type>&, size_t)> emit_call_back
       = std::function<void(const std::vector<flexible_type>&, size_t)>());
 
+/**
+ * Assigns each row of a batch of rows to an output partition:
+ * partitions[i] must be set to the partition of row i. The partitions
+ * vector is resized to rows.num_rows() before the call. thread_id is the
+ * id of the calling worker, in [0, thread::cpu_count()).
+ */
+typedef std::function<void(const sframe_rows& rows,
+                           size_t thread_id,
+                           std::vector<size_t>& partitions)> partition_function;
+
+/**
+ * Writes every row of sframe_in to the output iterator of its partition, as
+ * assigned by assign_fn. outputs[i] is the output iterator of partition i,
+ * and must write rows with the columns of sframe_in.
+ *
+ * The rows are read in batches by thread::cpu_count() workers. Each worker
+ * gathers the rows of each partition in its own buffer, column by column,
+ * and writes full buffers to the output iterators. The order of the rows
+ * within a partition is not deterministic.
+ */
+void partition_rows(const sframe& sframe_in,
+                    std::vector<sframe::iterator>& outputs,
+                    partition_function assign_fn);
+
+/**
+ * Computes the hash of the key columns of each row of rows: hashes[i] is
+ * hash64_combine, from 0, of the flexible_type hashes of the key columns of
+ * row i. This is the hash join and groupby use for their keys. The columns
+ * are hashed one after the other over the whole batch.
+ */
+void hash_key_columns(const sframe_rows& rows,
+                      const std::vector<size_t>& key_columns,
+                      std::vector<size_t>& hashes);
+
+/**
+ * Partitions the rows of sframe_in by the hash of its key columns (see
+ * \ref hash_key_columns) into an sframe with the same columns and n
+ * segments: segment i holds the rows whose hash % n is i.
+ */
+sframe hash_partition(const sframe& sframe_in,
+                      const std::vector<size_t>& key_columns,
+                      size_t n);
+
 /// \}
 //
 } // turi
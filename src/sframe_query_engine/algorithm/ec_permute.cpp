@@ -13,6 +13,7 @@
 #include <sframe/sframe_constants.hpp>
 #include <sframe/sframe_config.hpp>
 #include <sframe/sarray_v2_block_manager.hpp>
+#include <fileio/memory_budget.hpp>
 #include <flexible_type/flexible_type.hpp>
 namespace turi {
 namespace query_eval {
@@ -151,7 +152,8 @@ static std::vector<size_t> column_row_boundaries(std::shared_ptr<sarray<flexible
 static sframe ec_scatter_partitions(sframe input,
                                     size_t rows_per_bucket,
                                     const std::vector<bool>& indirect_column,
-                                    std::shared_ptr<sarray<flexible_type> > forward_map) {
+                                    std::shared_ptr<sarray<flexible_type> > forward_map,
+                                    size_t sort_buffer_size) {
   //  - For each (c,r,v) in data:
   //        Write (c,v) to bucket `bucket of forward_map(r)`
   //  - For each (c,r,v) in forward_map:
@@ -180,10 +182,11 @@ static sframe ec_scatter_partitions(sframe input,
   // now. the challenge here is that the natural order of the sframe is not
   // necessarily good for forward map lookups. The forward map lookup has to
   // really fast. Instead we are going to do it this way:
-  //  - Use the SFRAME_SORT_BUFFER_SIZE to estimate how much forward map
+  //  - Use the sort buffer size to estimate how much forward map
   //  we can keep in memory at any one time. Then in parallel over
   //  columns of the sframe.
-  size_t max_forward_map_in_memory = SFRAME_SORT_BUFFER_SIZE / sizeof(flexible_type);
+  size_t max_forward_map_in_memory =
+      std::max<size_t>(1, sort_buffer_size / sizeof(flexible_type));
   auto forward_map_reader = forward_map->get_reader();
   std::vector<flexible_type> forward_map_buffer;
   logstream(LOG_INFO) << "Beginning Scatter"  << std::endl;
@@ -288,7 +291,8 @@ sframe ec_permute_partitions(sframe input,
                              sframe& original_input,
                              size_t rows_per_bucket,
                              const std::vector<size_t>& column_bytes_per_value,
-                             const std::vector<bool>& indirect_column) {
+                             const std::vector<bool>& indirect_column,
+                             size_t sort_buffer_size) {
 //     For each Bucket b:
 //         Allocate Output vector of (Length of bucket) * (#columns)
 //         Let S be the starting index of bucket b (i.e. b*N/k)
@@ -330,7 +334,7 @@ sframe ec_permute_partitions(sframe input,
 
 
   auto forward_map_reader = input.select_column(num_input_columns)->get_reader();
-  size_t MAX_SORT_BUFFER = SFRAME_SORT_BUFFER_SIZE / thread::cpu_count();
+  size_t MAX_SORT_BUFFER = sort_buffer_size / thread::cpu_count();
 
   atomic<size_t> atomic_bucket_id = 0;
   // for each bucket
@@ -485,6 +489,11 @@ sframe permute_sframe(sframe &values_sframe,
   std::vector<size_t> column_bytes_per_value(num_value_columns, 0);
   std::vector<bool> indirect_column(num_value_columns, false);
   size_t num_buckets = 0;
+  // Ask the memory budget for the sort buffer. If it is short, the values
+  // are permuted in more, smaller buckets.
+  auto sort_memory = fileio::memory_budget::get_instance().reserve(
+      "sort", SFRAME_SORT_BUFFER_SIZE, SFRAME_SORT_BUFFER_SIZE / 16);
+  size_t sort_buffer_size = std::max<size_t>(2, sort_memory.size());
   {
     // First lets get an estimate of the column sizes and we use that
     // to estimate the number of buckets needed.
@@ -514,7 +523,7 @@ sframe permute_sframe(sframe &values_sframe,
                                                column_num_bytes.end());
     // maximum size of column / sort buffer size. round up
     // at least 1 bucket
-    size_t HALF_SORT_BUFFER = SFRAME_SORT_BUFFER_SIZE / 2;
+    size_t HALF_SORT_BUFFER = sort_buffer_size / 2;
     num_buckets = (max_column_num_bytes + HALF_SORT_BUFFER - 1) / HALF_SORT_BUFFER;
     num_buckets = std::max<size_t>(1, num_buckets);
     num_buckets *= thread::cpu_count();
@@ -573,14 +582,16 @@ sframe permute_sframe(sframe &values_sframe,
   sframe scatter_sframe = ec_scatter_partitions(values_sframe,
                                                 rows_per_bucket,
                                                 indirect_column,
-                                                forward_map);
+                                                forward_map,
+                                                sort_buffer_size);
   logstream(LOG_INFO) << "Scatter finished in " << ti.current_time() << std::endl;
 
   sframe sorted_values_sframe = ec_permute_partitions(scatter_sframe,
                                                       values_sframe,
                                                       rows_per_bucket,
                                                       column_bytes_per_value,
-                                                      indirect_column);
+                                                      indirect_column,
+                                                      sort_buffer_size);
   return sorted_values_sframe;
 }
 
@@ -46,6 +46,11 @@ std::shared_ptr<sframe> ec_sort(
   //      - value_column_types
   //
   size_t num_columns = column_names.size();
+  // already sorted, e.g. by an earlier sort
+  if (is_sorted_by(sframe_planner_node, key_column_indices, sort_orders)) {
+    logstream(LOG_INFO) << "SFrame is already sorted" << std::endl;
+    return std::make_shared<sframe>(planner().materialize(sframe_planner_node));
+  }
   int64_t num_rows = infer_planner_node_length(sframe_planner_node);
   if (num_rows == -1) {
     planner().materialize(sframe_planner_node);
@@ -190,6 +195,11 @@ std::shared_ptr<sframe> ec_sort(
     final_sframe_columns[i] = final_name_to_column[column_names[i]];
   }
   sframe final_sframe(final_sframe_columns, column_names);
+  sframe_sort_order sort_order;
+  for (size_t i = 0;i < num_key_columns; ++i) {
+    sort_order.push_back({key_column_indices[i], sort_orders[i]});
+  }
+  final_sframe.set_sort_order(sort_order);
   return std::make_shared<sframe>(final_sframe);
 }
 
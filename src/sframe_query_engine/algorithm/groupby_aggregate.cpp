@@ -174,6 +174,43 @@ std::shared_ptr<sframe>
     column_types.push_back(output_type);
   }
 
+  // If the relevant columns are sorted on the key columns (in any order and
+  // direction), the rows of each group are contiguous: stream over them.
+  size_t num_keys = keys.size();
+  auto relevant_order = infer_planner_node_sort_order(frame_with_relevant_cols);
+  bool sorted_on_keys = num_keys > 0 && relevant_order.size() >= num_keys;
+  for (size_t i = 0; sorted_on_keys && i < num_keys; ++i) {
+    // the key columns come first, in the relevant columns and in the output
+    sorted_on_keys = relevant_order[i].first < num_keys &&
+        column_types[relevant_order[i].first] != flex_type_enum::FLOAT;
+  }
+  if (sorted_on_keys) {
+    logstream(LOG_INFO) << "Streaming groupby over sorted keys" << std::endl;
+    sframe input = planner().materialize(frame_with_relevant_cols);
+    output->open_for_write(column_names,
+                           column_types,
+                           "",
+                           thread::cpu_count());
+    std::vector<groupby_aggregate_impl::group_descriptor> group_descriptors;
+    for (const auto& group: groups) {
+      groupby_aggregate_impl::group_descriptor desc;
+      for(auto& col_name : group.first) {
+        desc.column_numbers.push_back(relevant_column_to_index.at(col_name));
+      }
+      desc.aggregator = group.second;
+      group_descriptors.push_back(desc);
+    }
+    timer ti;
+    groupby_aggregate_impl::sorted_group_and_write(input, num_keys,
+                                                   group_descriptors, *output);
+    logstream(LOG_INFO) << "Output written in: " << ti.current_time() << std::endl;
+    output->close();
+    // the groups are written in the order of the input
+    output->set_sort_order(sframe_sort_order(relevant_order.begin(),
+                                             relevant_order.begin() + num_keys));
+    return output;
+  }
+
   size_t nsegments = thread::cpu_count() * std::max<size_t>(1, log2(thread::cpu_count()));
 
   output->open_for_write(column_names,
@@ -182,14 +219,17 @@ std::shared_ptr<sframe>
                          nsegments);
 
 
+  // buffer fewer groups, and flush more often, if the memory budget is short
+  fileio::memory_budget::reservation buffer_memory;
+  size_t max_buffer_size = groupby_aggregate_impl::reserve_buffer_rows(
+      SFRAME_GROUPBY_BUFFER_NUM_ROWS, nsegments, buffer_memory);
   groupby_aggregate_impl::group_aggregate_container
-      container(SFRAME_GROUPBY_BUFFER_NUM_ROWS, nsegments);
+      container(max_buffer_size, nsegments);
 
   // ok the input sframe (frame_with_relevant_cols) contains all the values
   // we care about. However, the challenge here is to figure out how the keys
   // and values line up. By construction, all the key columns come first.
   // which is good. But group columns can be pretty much anywhere.
-  size_t num_keys = keys.size();
   for (const auto& group: groups) {
     std::vector<size_t> column_numbers;
     for(auto& col_name : group.first) {
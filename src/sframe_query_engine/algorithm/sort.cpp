@@ -12,12 +12,14 @@
 #include <sframe/sarray.hpp>
 #include <sframe/sframe.hpp>
 #include <sframe/sframe_config.hpp>
+#include <fileio/memory_budget.hpp>
 #include <sketches/quantile_sketch.hpp>
 #include <sketches/streaming_quantile_sketch.hpp>
 #include <sframe_query_engine/planning/planner_node.hpp>
 #include <sframe_query_engine/planning/planner.hpp>
 #include <sframe_query_engine/operators/project.hpp>
 #include <sframe_query_engine/operators/union.hpp>
+#include <sframe_query_engine/operators/operator_properties.hpp>
 #include <sframe_query_engine/algorithm/sort_and_merge.hpp>
 #include <sframe_query_engine/algorithm/sort_comparator.hpp>
 
@@ -294,6 +296,39 @@ std::shared_ptr<sframe> sort_sframe_in_memory(
   return ret;
 }
 
+/**
+ * Records on a sorted frame the columns it is sorted by.
+ */
+static std::shared_ptr<sframe> set_sort_order(
+    std::shared_ptr<sframe> sorted_sframe,
+    const std::vector<size_t>& sort_column_indices,
+    const std::vector<bool>& sort_orders) {
+  sframe_sort_order sort_order;
+  for (size_t i = 0;i < sort_column_indices.size(); ++i) {
+    sort_order.push_back({sort_column_indices[i], sort_orders[i]});
+  }
+  sorted_sframe->set_sort_order(sort_order);
+  return sorted_sframe;
+}
+
+bool is_sorted_by(std::shared_ptr<planner_node> sframe_planner_node,
+                  const std::vector<size_t>& sort_column_indices,
+                  const std::vector<bool>& sort_orders) {
+  DASSERT_EQ(sort_column_indices.size(), sort_orders.size());
+  auto sort_order = infer_planner_node_sort_order(sframe_planner_node);
+  if (sort_column_indices.empty() ||
+      sort_order.size() < sort_column_indices.size()) {
+    return false;
+  }
+  for (size_t i = 0;i < sort_column_indices.size(); ++i) {
+    if (sort_order[i].first != sort_column_indices[i] ||
+        sort_order[i].second != sort_orders[i]) {
+      return false;
+    }
+  }
+  return true;
+}
+
 /**
  * Main implementation of the top level sort API.
  */
@@ -347,11 +382,24 @@ std::shared_ptr<sframe> sort(
     }
   }
 
+  // Shortcut -- already sorted, e.g. by an earlier sort
+  if (is_sorted_by(sframe_planner_node, sort_column_indices, sort_orders)) {
+    logstream(LOG_INFO) << "SFrame is already sorted" << std::endl;
+    return std::make_shared<sframe>(planner().materialize(sframe_planner_node));
+  }
+
   // TODO: Estimate the size of the sframe so that we could decide number of
   // chunks. To account for strings, we estimate each cell is 64 bytes.
   // I'd love to estimate better.
   size_t estimated_sframe_size = num_rows * num_columns * CELL_SIZE_ESTIMATE+ num_rows * ROW_SIZE_ESTIMATE;
-  size_t num_partitions = std::ceil((1.0 * estimated_sframe_size) / sframe_config::SFRAME_SORT_BUFFER_SIZE);
+  // Ask the memory budget for the sort buffer. If it is short, the frame is
+  // sorted in more, smaller partitions.
+  size_t desired_buffer_size = std::min(sframe_config::SFRAME_SORT_BUFFER_SIZE,
+                                        estimated_sframe_size);
+  auto sort_memory = fileio::memory_budget::get_instance().reserve(
+      "sort", desired_buffer_size, desired_buffer_size / 16);
+  size_t sort_buffer_size = std::max<size_t>(1, sort_memory.size());
+  size_t num_partitions = std::ceil((1.0 * estimated_sframe_size) / sort_buffer_size);
 
   // Make partitions small enough for each thread to (theoretically) sort at once
   num_partitions = num_partitions * thread::cpu_count();
@@ -367,7 +415,7 @@ std::shared_ptr<sframe> sort(
                                      column_names,
                                      sort_column_indices,
                                      sort_orders);
-    return ret;
+    return set_sort_order(ret, sort_column_indices, sort_orders);
   }
 
   // This is a collection of partition keys sorted in the required order.
@@ -388,7 +436,8 @@ std::shared_ptr<sframe> sort(
   // In rare case all values in the SFrame are the same, so no need to sort
   if (all_sorted)  {
     auto ret = planner().materialize(sframe_planner_node);
-    return std::make_shared<sframe>(ret);
+    return set_sort_order(std::make_shared<sframe>(ret),
+                          sort_column_indices, sort_orders);
   }
 
   // scatter partition the sframe into multiple chunks, chunks are relatively
@@ -465,10 +514,11 @@ std::shared_ptr<sframe> sort(
     sort_orders,
     permute_ordering,
     column_names,
-    column_types);
+    column_types,
+    sort_buffer_size);
   logstream(LOG_INFO) << "Sort and merge step: " << ti.current_time() << std::endl;
 
-  return ret;
+  return set_sort_order(ret, sort_column_indices, sort_orders);
 }
 
 
@@ -41,6 +41,10 @@ struct planner_node;
  *     memory sort
  *   - if some partitions of the sframe have the same sorting key, then that partition
  *     will not be sorted
+ *   - if the sframe is already known to be sorted on the sort columns (see
+ *     \ref is_sorted_by), it is only materialized
+ *
+ * The returned sframe records its sort order (see sframe::set_sort_order).
  *
  * Also see \ref ec_sort for another sort implementation
  *
@@ -55,6 +59,14 @@ std::shared_ptr<sframe> sort(
     const std::vector<size_t>& sort_column_indices,
     const std::vector<bool>& sort_orders);
 
+/**
+ * Returns true if the lazy sframe is known to be sorted on the sort columns,
+ * in the given orders (see infer_planner_node_sort_order).
+ */
+bool is_sorted_by(std::shared_ptr<planner_node> sframe_planner_node,
+                  const std::vector<size_t>& sort_column_indices,
+                  const std::vector<bool>& sort_orders);
+
 } // end of query_eval
 } // end of turicreate
 
@@ -130,7 +130,8 @@ std::shared_ptr<sframe> sort_and_merge(
     const std::vector<bool>& sort_orders,
     const std::vector<size_t>& permute_order,
     const std::vector<std::string>& column_names,
-    const std::vector<flex_type_enum>& column_types) {
+    const std::vector<flex_type_enum>& column_types,
+    size_t sort_buffer_size) {
 
   size_t num_segments = partition_array->num_segments();
   auto reader = partition_array->get_reader();
@@ -158,8 +159,8 @@ std::shared_ptr<sframe> sort_and_merge(
         write_one_chunk(reader, permute_order, segment_id, num_columns, outiterator);
       } else {
         mem_used_mutex.lock();
-        while((mem_used+partition_sizes[segment_id]) > sframe_config::SFRAME_SORT_BUFFER_SIZE) {
-          if(((partition_sizes[segment_id] > sframe_config::SFRAME_SORT_BUFFER_SIZE) && (mem_used == 0)) ||
+        while((mem_used+partition_sizes[segment_id]) > sort_buffer_size) {
+          if(((partition_sizes[segment_id] > sort_buffer_size) && (mem_used == 0)) ||
             (partition_sizes[segment_id] == 0)) {
             break;
           }
@@ -36,6 +36,7 @@ namespace query_eval {
  * will be stored in column i of the final SFrame
  * \param column_names column names of the final sframe
  * \param column_types column types of the final sframe
+ * \param sort_buffer_size the memory in which partitions are sorted at once
  *
  * \return a sorted sframe.
  */
@@ -46,7 +47,8 @@ std::shared_ptr<sframe> sort_and_merge(
     const std::vector<bool>& sort_orders,
     const std::vector<size_t>& permute_order,
     const std::vector<std::string>& column_names,
-    const std::vector<flex_type_enum>& column_types);
+    const std::vector<flex_type_enum>& column_types,
+    size_t sort_buffer_size);
 
 /// \}
 } // enfd of query_eval
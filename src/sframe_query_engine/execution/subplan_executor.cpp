@@ -188,6 +188,9 @@ sframe subplan_executor::run_concat(
                                           exec_params.output_index_file,
                                           exec_params.output_column_names);
 
+    // With CPU affinity on a NUMA machine, the pool runs the contiguous
+    // ranges of segments parallel_for makes in the worker group of their
+    // range, so each segment's buffers are first touched on that node.
     parallel_for(0, stuff_to_run_in_parallel.size(), [&](size_t i) {
         generate_to_sframe_segment(stuff_to_run_in_parallel[i], ret, i);
       });
@@ -9,6 +9,7 @@
 #include <sframe_query_engine/operators/append.hpp>
 #include <sframe_query_engine/operators/binary_transform.hpp>
 #include <sframe_query_engine/operators/constant.hpp>
+#include <sframe_query_engine/operators/key_index_lookup.hpp>
 #include <sframe_query_engine/operators/logical_filter.hpp>
 #include <sframe_query_engine/operators/project.hpp>
 #include <sframe_query_engine/operators/range.hpp>
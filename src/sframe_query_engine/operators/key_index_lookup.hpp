@@ -0,0 +1,198 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#ifndef TURI_SFRAME_QUERY_MANAGER_KEY_INDEX_LOOKUP_HPP
+#define TURI_SFRAME_QUERY_MANAGER_KEY_INDEX_LOOKUP_HPP
+#include <algorithm>
+#include <unordered_set>
+#include <flexible_type/flexible_type.hpp>
+#include <sframe_query_engine/operators/operator.hpp>
+#include <sframe_query_engine/execution/query_context.hpp>
+#include <sframe_query_engine/operators/operator_properties.hpp>
+#include <sframe/sframe.hpp>
+#include <sframe/sframe_key_index.hpp>
+
+namespace turi {
+namespace query_eval {
+
+/**
+ * \ingroup sframe_query_engine
+ * \addtogroup operators Logical Operators
+ * \{
+ */
+
+/**
+ * A "key_index_lookup" operator which takes one input: a (possibly sliced)
+ * source of a saved sframe, and outputs the rows whose column "column_id"
+ * is equal to one of "keys".
+ *
+ * The key index of the column is opened when the operator is executed, and
+ * only the blocks of the input holding one of the row ranges it returns
+ * are read; the other blocks are skipped. If the index is missing or stale
+ * by then, every block is read, so the output is the same.
+ */
+template<>
+class operator_impl<planner_node_type::KEY_INDEX_LOOKUP_NODE> : public query_operator {
+ public:
+
+  planner_node_type type() const { return planner_node_type::KEY_INDEX_LOOKUP_NODE; }
+
+  static std::string name() { return "key_index_lookup"; }
+
+  inline operator_impl(const sframe& source, size_t column_id,
+                       const flex_list& keys,
+                       size_t begin_index, size_t end_index)
+      : m_source(source), m_column_id(column_id), m_keys(keys)
+      , m_begin_index(begin_index), m_end_index(end_index) { }
+
+  static query_operator_attributes attributes() {
+    query_operator_attributes ret;
+    ret.attribute_bitfield = query_operator_attributes::SUB_LINEAR;
+    ret.num_inputs = 1;
+    return ret;
+  }
+
+  inline std::shared_ptr<query_operator> clone() const {
+    return std::make_shared<operator_impl>(*this);
+  }
+
+  inline void execute(query_context& context) {
+    std::vector<flexible_type> keys(m_keys.begin(), m_keys.end());
+    flex_type_enum column_type = m_source.column_type(m_column_id);
+
+    // The row ranges of [m_begin_index, m_end_index) which may hold a key
+    std::vector<std::pair<size_t, size_t>> ranges;
+    auto key_index = sframe_get_key_index(m_source, m_column_id);
+    if (key_index != nullptr) {
+      for (const auto& range : key_index->find_row_ranges(keys, column_type)) {
+        size_t range_begin = std::max(range.first, m_begin_index);
+        size_t range_end = std::min(range.second, m_end_index);
+        if (range_begin < range_end) ranges.push_back({range_begin, range_end});
+      }
+    } else {
+      ranges.push_back({m_begin_index, m_end_index});
+    }
+    auto normalized_keys = sframe_key_index::normalize_keys(keys, column_type);
+    std::unordered_set<flexible_type> key_set(normalized_keys.begin(),
+                                              normalized_keys.end());
+
+    // set up the output shape
+    auto output_buffer = context.get_output_buffer();
+    size_t cur_output_index = 0;
+    size_t ncols = m_source.num_columns();
+    size_t nrows = context.block_size();
+    output_buffer->resize(ncols, nrows);
+
+    // The input is read in blocks of context.block_size() rows.
+    size_t cur_range = 0;
+    size_t start = m_begin_index;
+    while (start < m_end_index) {
+      size_t end = std::min(start + nrows, m_end_index);
+      while (cur_range < ranges.size() && ranges[cur_range].second <= start) {
+        ++cur_range;
+      }
+      if (cur_range == ranges.size() || ranges[cur_range].first >= end) {
+        context.skip_next(0);
+        start = end;
+        continue;
+      }
+
+      auto rows = context.get_next(0);
+      if (rows == nullptr) break;
+      size_t row_index = start;
+      for (const auto& row : *rows) {
+        while (cur_range < ranges.size() && ranges[cur_range].second <= row_index) {
+          ++cur_range;
+        }
+        if (cur_range < ranges.size() && ranges[cur_range].first <= row_index &&
+            key_set.count(row[m_column_id])) {
+          (*output_buffer)[cur_output_index] = row;
+          ++cur_output_index;
+          if (cur_output_index == nrows) {
+            context.emit(output_buffer);
+            output_buffer = context.get_output_buffer();
+            output_buffer->resize(ncols, nrows);
+            cur_output_index = 0;
+          }
+        }
+        ++row_index;
+      }
+      start += rows->num_rows();
+    }
+    // drain the input
+    while (context.get_next(0) != nullptr) { }
+
+    if (cur_output_index > 0) {
+      output_buffer->resize(ncols, cur_output_index);
+      context.emit(output_buffer);
+    }
+  }
+
+  static std::shared_ptr<planner_node> make_planner_node(
+      std::shared_ptr<planner_node> source,
+      const sframe& sf, size_t column_id, const flex_list& keys) {
+    return planner_node::make_shared(planner_node_type::KEY_INDEX_LOOKUP_NODE,
+                                     {{"column_id", column_id},
+                                      {"keys", keys}},
+                                     {{"sframe", any(sf)}},
+                                     {source});
+  }
+
+  static std::shared_ptr<query_operator> from_planner_node(
+      std::shared_ptr<planner_node> pnode) {
+    ASSERT_EQ((int)pnode->operator_type,
+              (int)planner_node_type::KEY_INDEX_LOOKUP_NODE);
+    ASSERT_EQ(pnode->inputs.size(), 1);
+    ASSERT_TRUE(pnode->any_operator_parameters.count("sframe"));
+    auto source = pnode->any_operator_parameters.at("sframe").as<sframe>();
+    size_t column_id = pnode->operator_parameters.at("column_id");
+    const flex_list& keys = pnode->operator_parameters.at("keys").get<flex_list>();
+
+    // The input is a slice of the sframe, read at the same rate as the
+    // source it comes from.
+    auto input = pnode->inputs[0];
+    while (!is_source_node(input)) {
+      ASSERT_TRUE(is_linear_transform(input) && !input->inputs.empty());
+      input = input->inputs[0];
+    }
+    size_t begin_index = input->operator_parameters.at("begin_index");
+    size_t end_index = input->operator_parameters.at("end_index");
+
+    return std::make_shared<operator_impl>(source, column_id, keys,
+                                           begin_index, end_index);
+  }
+
+  static std::vector<flex_type_enum> infer_type(
+      std::shared_ptr<planner_node> pnode) {
+    ASSERT_EQ((int)pnode->operator_type,
+              (int)planner_node_type::KEY_INDEX_LOOKUP_NODE);
+    ASSERT_EQ(pnode->inputs.size(), 1);
+    return infer_planner_node_type(pnode->inputs[0]);
+  }
+
+  static int64_t infer_length(std::shared_ptr<planner_node> pnode) {
+    return -1;
+  }
+
+  static std::string repr(std::shared_ptr<planner_node> pnode, pnode_tagger& get_tag) {
+    ASSERT_EQ(pnode->inputs.size(), 1);
+    return std::string("KeyLookup(") + get_tag(pnode->inputs[0]) + ")";
+  }
+
+ private:
+  sframe m_source;
+  size_t m_column_id = 0;
+  flex_list m_keys;
+  size_t m_begin_index = 0;
+  size_t m_end_index = 0;
+};
+
+typedef operator_impl<planner_node_type::KEY_INDEX_LOOKUP_NODE> op_key_index_lookup;
+
+/// \}
+} // query_eval
+} // turicreate
+
+#endif // TURI_SFRAME_QUERY_MANAGER_KEY_INDEX_LOOKUP_HPP
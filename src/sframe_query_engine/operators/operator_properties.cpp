@@ -50,6 +50,8 @@ RetType extract_field(planner_node_type ptype, CallArgs... call_args) {
       return FieldExtractionVisitor<planner_node_type::GENERALIZED_UNION_PROJECT_NODE>::get(call_args...);
     case planner_node_type::TERNARY_OPERATOR:
       return FieldExtractionVisitor<planner_node_type::TERNARY_OPERATOR>::get(call_args...);
+    case planner_node_type::KEY_INDEX_LOOKUP_NODE:
+      return FieldExtractionVisitor<planner_node_type::KEY_INDEX_LOOKUP_NODE>::get(call_args...);
     case planner_node_type::IDENTITY_NODE:
       return FieldExtractionVisitor<planner_node_type::IDENTITY_NODE>::get(call_args...);
     case planner_node_type::INVALID:
@@ -109,6 +111,100 @@ int64_t infer_planner_node_length(pnode_ptr pnode) {
 
 ////////////////////////////////////////////////////////////////////////////////
 
+typedef std::vector<std::pair<size_t, bool>> sort_order_type;
+
+/**
+ * Maps the sort order of an input column by column through
+ * output_column_of (which returns -1 for a column not in the output),
+ * keeping the most significant columns that are in the output.
+ */
+static sort_order_type map_sort_order(
+    const sort_order_type& input_order,
+    const std::function<ssize_t(size_t)>& output_column_of) {
+  sort_order_type ret;
+  for (const auto& column: input_order) {
+    ssize_t output_column = output_column_of(column.first);
+    if (output_column < 0) break;
+    ret.push_back({size_t(output_column), column.second});
+  }
+  return ret;
+}
+
+static sort_order_type _infer_sort_order(pnode_ptr pnode) {
+  switch(pnode->operator_type) {
+    case planner_node_type::SFRAME_SOURCE_NODE:
+      // any contiguous range of a sorted frame is sorted
+      return pnode->any_operator_parameters.at("sframe").as<sframe>().get_sort_order();
+    case planner_node_type::RANGE_NODE:
+      return {{0, true}};
+    case planner_node_type::LOGICAL_FILTER_NODE:
+    case planner_node_type::KEY_INDEX_LOOKUP_NODE:
+    case planner_node_type::IDENTITY_NODE:
+      return infer_planner_node_sort_order(pnode->inputs[0]);
+    case planner_node_type::PROJECT_NODE: {
+      const flex_list& indices =
+          pnode->operator_parameters.at("indices").get<flex_list>();
+      return map_sort_order(
+          infer_planner_node_sort_order(pnode->inputs[0]),
+          [&](size_t column) -> ssize_t {
+            for (size_t i = 0; i < indices.size(); ++i) {
+              if (size_t(indices[i]) == column) return i;
+            }
+            return -1;
+          });
+    }
+    case planner_node_type::UNION_NODE: {
+      // the inputs are read at the same rate: the order of the first sorted
+      // input holds, its columns shifted by the columns of the previous inputs
+      size_t offset = 0;
+      for (const auto& input: pnode->inputs) {
+        auto input_order = infer_planner_node_sort_order(input);
+        if (!input_order.empty()) {
+          return map_sort_order(input_order, [&](size_t column) -> ssize_t {
+                                  return column + offset;
+                                });
+        }
+        offset += infer_planner_node_num_output_columns(input);
+      }
+      return {};
+    }
+    case planner_node_type::GENERALIZED_UNION_PROJECT_NODE: {
+      const flex_dict& index_map =
+          pnode->operator_parameters.at("index_map").get<flex_dict>();
+      sort_order_type ret;
+      for (size_t input = 0; input < pnode->inputs.size(); ++input) {
+        auto input_order = map_sort_order(
+            infer_planner_node_sort_order(pnode->inputs[input]),
+            [&](size_t column) -> ssize_t {
+              for (size_t i = 0; i < index_map.size(); ++i) {
+                if (size_t(index_map[i].first) == input &&
+                    size_t(index_map[i].second) == column) return i;
+              }
+              return -1;
+            });
+        if (input_order.size() > ret.size()) ret = std::move(input_order);
+      }
+      return ret;
+    }
+    default:
+      return {};
+  }
+}
+
+sort_order_type infer_planner_node_sort_order(pnode_ptr pnode) {
+  std::lock_guard<recursive_mutex> GLOBAL_LOCK(global_query_lock);
+
+  if (pnode->any_operator_parameters.count("__sort_order_memo__")) {
+    return pnode->any_operator_parameters["__sort_order_memo__"].as<sort_order_type>();
+  }
+
+  sort_order_type retval = _infer_sort_order(pnode);
+  pnode->any_operator_parameters["__sort_order_memo__"] = retval;
+  return retval;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 size_t infer_planner_node_num_output_columns(pnode_ptr pnode) {
   return infer_planner_node_type(pnode).size();
 }
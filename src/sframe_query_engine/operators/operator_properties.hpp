@@ -37,6 +37,7 @@ enum class planner_node_type : int {
     GENERALIZED_UNION_PROJECT_NODE,
     REDUCE_NODE,
     TERNARY_OPERATOR,
+    KEY_INDEX_LOOKUP_NODE,
 
       // These are used as logical-node-only types.  Do not actually become an operator.
       IDENTITY_NODE,
@@ -60,6 +61,18 @@ std::vector<flex_type_enum> infer_planner_node_type(std::shared_ptr<planner_node
  */
 int64_t infer_planner_node_length(std::shared_ptr<planner_node> pnode);
 
+/**
+ *  Infers the columns the output of a planner node is sorted by, most
+ *  significant first, as (column index, ascending) pairs, by backtracking
+ *  its dependencies to the sort order of its sources (see
+ *  sframe::get_sort_order). Only order preserving operators (project,
+ *  logical filter, union) propagate the order of their inputs.
+ *
+ *  Returns an empty vector if the order is not known.
+ */
+std::vector<std::pair<size_t, bool>>
+infer_planner_node_sort_order(std::shared_ptr<planner_node> pnode);
+
 /**
  *  Infers the number of columns present in the output.
  */
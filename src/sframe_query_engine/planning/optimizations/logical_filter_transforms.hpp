@@ -12,6 +12,7 @@
 #include <sframe_query_engine/planning/optimization_node_info.hpp>
 #include <sframe_query_engine/operators/operator_properties.hpp>
 #include <flexible_type/flexible_type.hpp>
+#include <sframe/sframe_key_index.hpp>
 
 #include <array>
 
@@ -24,6 +25,107 @@ class opt_logical_filter_transform : public opt_transform {
   }
 };
 
+/** A logical filter on a saved sframe, with a mask comparing one of its
+ *  columns to constants (sa == key or sa.is_in(keys)), is answered with the
+ *  key index of the column, if it has one.
+ *
+ *  Only the frame metadata is inspected here: the index is opened and read
+ *  by the key_index_lookup operator, when the graph is executed. The keys
+ *  are removed from the mask once they have been moved to the lookup.
+ */
+class opt_logical_filter_key_index_lookup
+    : public opt_logical_filter_transform {
+
+  std::string description() {
+    return "logical_filter(source, transform_keys(source_column)) -> key_index_lookup(source)";
+  }
+
+  /** The sarray a mask is computed from, if it is a full column of a
+   *  source.
+   */
+  const sarray<flexible_type>* get_source_column(const cnode_info_ptr& n) {
+    cnode_info_ptr src = n;
+    size_t column_id = 0;
+    if (n->type == planner_node_type::PROJECT_NODE) {
+      const auto& indices = n->p("indices").get<flex_list>();
+      if (indices.size() != 1) return nullptr;
+      column_id = indices[0];
+      src = n->inputs[0];
+    }
+
+    if (src->type == planner_node_type::SFRAME_SOURCE_NODE) {
+      sframe sf = src->any_p<sframe>("sframe");
+      if (size_t(src->p("begin_index")) != 0 ||
+          size_t(src->p("end_index")) != sf.size() ||
+          column_id >= sf.num_columns()) {
+        return nullptr;
+      }
+      return sf.select_column(column_id).get();
+    } else if (src->type == planner_node_type::SARRAY_SOURCE_NODE) {
+      auto sa = src->any_p<std::shared_ptr<sarray<flexible_type> > >("sarray");
+      if (size_t(src->p("begin_index")) != 0 ||
+          size_t(src->p("end_index")) != sa->size()) {
+        return nullptr;
+      }
+      return sa.get();
+    }
+    return nullptr;
+  }
+
+  bool apply_transform(optimization_engine *opt_manager, cnode_info_ptr n) {
+    DASSERT_TRUE(n->type == planner_node_type::LOGICAL_FILTER_NODE);
+
+    const cnode_info_ptr& data = n->inputs[0];
+    const cnode_info_ptr& mask = n->inputs[1];
+
+    if(data->type != planner_node_type::SFRAME_SOURCE_NODE
+       || mask->type != planner_node_type::TRANSFORM_NODE
+       || !mask->has_p("key_lookup_values"))
+      return false;
+
+    sframe sf = data->any_p<sframe>("sframe");
+    if(sf.get_index_file().empty()
+       || size_t(data->p("begin_index")) != 0
+       || size_t(data->p("end_index")) != sf.size())
+      return false;
+
+    // Transforms which carry the keys select the same rows as the key
+    // comparison (e.g. the binarization of the mask).
+    cnode_info_ptr column_node = mask->inputs[0];
+    while(column_node->type == planner_node_type::TRANSFORM_NODE
+          && column_node->has_p("key_lookup_values"))
+      column_node = column_node->inputs[0];
+
+    const sarray<flexible_type>* column = get_source_column(column_node);
+    if(column == nullptr)
+      return false;
+
+    size_t column_id = 0;
+    while(column_id < sf.num_columns() && sf.select_column(column_id).get() != column)
+      ++column_id;
+    if(column_id == sf.num_columns())
+      return false;
+
+    flex_list keys = mask->p("key_lookup_values").get<flex_list>();
+    for(const auto& key : keys) {
+      if(!sframe_key_index::supports_key(key, sf.column_type(column_id)))
+        return false;
+    }
+
+    if(!sframe_has_key_index(sf, column_id))
+      return false;
+
+    pnode_ptr lookup = op_key_index_lookup::make_planner_node(
+        data->pnode, sf, column_id, keys);
+
+    for(cnode_info_ptr m = mask; m != column_node; m = m->inputs[0])
+      m->pnode->operator_parameters.erase("key_lookup_values");
+
+    opt_manager->replace_node(n, lookup);
+    return true;
+  }
+};
+
 class opt_logical_filter_linear_transform_exchange
     : public opt_logical_filter_transform {
 
@@ -76,6 +76,7 @@ void populate_transforms(optimization_transform_registry *otr) {
   otr->register_optimization({1, 2, 3}, std::make_shared<opt_union_project_exchange>());
   otr->register_optimization({1, 2, 3}, std::make_shared<opt_project_append_exchange>());
   otr->register_optimization({1, 2, 3}, std::make_shared<opt_eliminate_singleton_union>());
+  otr->register_optimization({1, 2, 3}, std::make_shared<opt_logical_filter_key_index_lookup>());
 
   ////////////////////////////////////////////////////////////////////////////////
   // Optimizations that are allowed to turn the graph into a state
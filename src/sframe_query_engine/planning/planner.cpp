@@ -142,6 +142,19 @@ static sframe execute_node(pnode_ptr input_n, const materialize_options& exec_pa
 }
 ////////////////////////////////////////////////////////////////////////////////
 
+/**
+ * Executes an optimized query plan, recording on the result the sort order
+ * of the rows inferred from the plan before it was optimized.
+ */
+static sframe execute_node_keeping_order(pnode_ptr n,
+                                         pnode_ptr optimized_n,
+                                         const materialize_options& exec_params) {
+  auto sort_order = infer_planner_node_sort_order(n);
+  sframe ret = execute_node(optimized_n, exec_params);
+  ret.set_sort_order(sort_order);
+  return ret;
+}
+
 /** 
  * Materializes deeper nodes, leaving with just a single linearly executable 
  * execution node.
@@ -189,7 +202,8 @@ static pnode_ptr partial_materialize_impl(pnode_ptr n,
     for(auto& i: n->inputs) {
       // logprogress_stream << "Partial Materializing: " << i << std::endl;
       auto optimized_i = optimization_engine::optimize_planner_graph(i, exec_params);
-      (*i) = (*op_sframe_source::make_planner_node(execute_node(optimized_i, exec_params)));
+      (*i) = (*op_sframe_source::make_planner_node(
+          execute_node_keeping_order(i, optimized_i, exec_params)));
     }
     // logprogress_stream << "Reduced Plan: " << n << std::endl;
   }
@@ -202,7 +216,8 @@ static pnode_ptr partial_materialize_impl(pnode_ptr n,
   // logprogress_stream << "Partial Materializing: " << n << std::endl;
   // Otherwise, instantiate this node.
   auto optimized_n = optimization_engine::optimize_planner_graph(n, exec_params);
-  (*n) = (*op_sframe_source::make_planner_node(execute_node(optimized_n, exec_params)));
+  (*n) = (*op_sframe_source::make_planner_node(
+      execute_node_keeping_order(n, optimized_n, exec_params)));
   memo[n] = n;
   return memo[n];
 }
@@ -276,7 +291,7 @@ sframe planner::materialize(pnode_ptr ptip,
   if (exec_params.write_callback == nullptr) {
     // no write callback
     // Rewrite the query node to be materialized source node
-    auto ret_sf = execute_node(final_node, exec_params);
+    auto ret_sf = execute_node_keeping_order(original_ptip, final_node, exec_params);
     (*original_ptip) = (*(op_sframe_source::make_planner_node(ret_sf)));
     return ret_sf;
   } else {
@@ -10,6 +10,8 @@
 #include <sframe/sarray_sorted_buffer.hpp>
 #include <sframe/sarray_reader_buffer.hpp>
 #include <sframe/sframe_saving.hpp>
+#include <sframe/sframe_key_index.hpp>
+#include <fileio/fs_utils.hpp>
 #include <atomic>
 #include <timer/timer.hpp>
 #include <sparsehash/sparse_hash_set>
@@ -219,7 +221,20 @@ sframe sgraph::get_vertices(const std::vector<flexible_type>& vid_vec,
                 };
   }
 
-  for (auto& sf_in: vgroup) {
+  // A vertex is stored in the partition its id hashes to, so only those
+  // partitions need to be read when the ids are given.
+  std::vector<std::vector<flexible_type>> partition_vids(m_num_partitions);
+  for (const auto& vid : vid_constraint) {
+    partition_vids[vid.hash() % m_num_partitions].push_back(vid);
+  }
+
+  for (size_t i = 0; i < m_num_partitions; ++i) {
+    if (!vid_vec.empty() && partition_vids[i].empty()) continue;
+    sframe sf_in = vgroup[i];
+    if (!vid_vec.empty()) {
+      auto index = sframe_get_key_index(sf_in, vid_column_idx);
+      if (index) sf_in = index->lookup(sf_in, vid_column_idx, partition_vids[i]);
+    }
     sframe sf_out;
     sf_out.open_for_write(sf_in.column_names(), sf_in.column_types(), "", sf_in.num_segments());
     copy_if (sf_in, sf_out, filter_fn);
@@ -383,23 +398,63 @@ sframe sgraph::get_edges(const std::vector<flexible_type>& source_vids,
         vid_constraints[{source_pid, target_pid}].insert({source, target});
       }
     }
-    sgraph_compute::hilbert_blocked_parallel_for(
-        get_num_partitions(),
-        load_partition_vids,
-        [&](std::pair<size_t, size_t> coordinate) {
+    // Only the edge partitions which may hold a matching edge are read: the
+    // rows of the source partitions of wildcard target constraints, the
+    // columns of the target partitions of wildcard source constraints, and
+    // the partitions of the (source, target) pairs.
+    std::vector<std::pair<size_t, size_t>> coordinates;
+    for (size_t i = 0; i < m_num_partitions; ++i) {
+      for (size_t j = 0; j < m_num_partitions; ++j) {
+        if (!wild_source_vids[i].empty() || !wild_target_vids[j].empty() ||
+            !vid_constraints.at({i, j}).empty()) {
+          coordinates.push_back({i, j});
+        }
+      }
+    }
+
+    // Returns the edges of edge_sframe whose id column column_idx is the
+    // row of one of the vids in partition_vids, through the key index of
+    // the column. Returns edge_sframe if the column has no key index.
+    auto lookup_edges = [&](const sframe& edge_sframe, size_t column_idx,
+                            const std::vector<flexible_type>& partition_vids,
+                            const std::unordered_set<flexible_type>& vids) {
+      auto index = sframe_get_key_index(edge_sframe, column_idx);
+      if (!index) return edge_sframe;
+      std::vector<flexible_type> rows;
+      for (size_t k = 0; k < partition_vids.size(); ++k) {
+        if (vids.count(partition_vids[k])) rows.push_back(flex_int(k));
+      }
+      return index->lookup(edge_sframe, column_idx, rows);
+    };
+
+    auto process_partition = [&](std::pair<size_t, size_t> coordinate) {
         size_t i = coordinate.first;
         size_t j = coordinate.second;
         const std::vector<flexible_type>& src_partition_vids = partition_vid_cache.at({i, groupa});
         const std::vector<flexible_type>& dst_partition_vids = partition_vid_cache.at({j, groupb});
+        const auto& pair_constraints = vid_constraints.at({i, j});
         sframe edge_sframe = edge_partition(i, j, groupa, groupb);
 
         std::vector<flex_type_enum> out_column_types = edge_sframe.column_types();
         out_column_types[src_column_idx] = m_vid_type;
         out_column_types[dst_column_idx] = m_vid_type;
 
+        // When all the constraints of the partition are on the same side,
+        // only the edges adjacent to the constrained vertices are read.
+        sframe candidate_sframe = edge_sframe;
+        if (wild_target_vids[j].empty()) {
+          std::unordered_set<flexible_type> sources = wild_source_vids[i];
+          for (const auto& st : pair_constraints) sources.insert(st.first);
+          candidate_sframe = lookup_edges(edge_sframe, src_column_idx,
+                                          src_partition_vids, sources);
+        } else if (wild_source_vids[i].empty() && pair_constraints.empty()) {
+          candidate_sframe = lookup_edges(edge_sframe, dst_column_idx,
+                                          dst_partition_vids, wild_target_vids[j]);
+        }
+
         sframe out_sframe;
         out_sframe.open_for_write(edge_sframe.column_names(), out_column_types,
-                                  "", edge_sframe.num_segments());
+                                  "", candidate_sframe.num_segments());
 
         // The filter function checks the id constraints and then value constraints
         std::function<bool(const std::vector<flexible_type>&)> filter_fn = 
@@ -408,28 +463,134 @@ sframe sgraph::get_edges(const std::vector<flexible_type>& source_vids,
               size_t dst_idx = row[dst_column_idx];
               const flexible_type& source = src_partition_vids[src_idx];
               const flexible_type& target = dst_partition_vids[dst_idx];
-              std::pair<size_t, size_t> partition_addr{i, j};
               std::pair<flexible_type, flexible_type> source_target_pair{source, target};
               if ((wild_source_vids[i].count(source) || wild_target_vids[j].count(target)) ||
-                  (vid_constraints.at(partition_addr).count(source_target_pair) > 0)) {
+                  (pair_constraints.count(source_target_pair) > 0)) {
                return satisfy_value_constraint(row);
               }
               return false;
             };
 
-        copy_transform_if(edge_sframe, out_sframe, filter_fn,
+        copy_transform_if(candidate_sframe, out_sframe, filter_fn,
                           boost::bind(edge_id_transform, _1,
                                       boost::cref(src_partition_vids),
                                       boost::cref(dst_partition_vids)));
         out_sframe.close();
         out_edge_blocks[i * m_num_partitions + j] = std::move(out_sframe);
-    });
+    };
+
+    if (coordinates.size() == m_num_partitions * m_num_partitions) {
+      sgraph_compute::hilbert_blocked_parallel_for(
+          get_num_partitions(), load_partition_vids, process_partition);
+    } else {
+      // Process the partitions in blocks, loading only the vertex ids the
+      // block needs, as hilbert_blocked_parallel_for does.
+      size_t block_size = SGRAPH_HILBERT_CURVE_PARALLEL_FOR_NUM_THREADS;
+      for (size_t begin = 0; begin < coordinates.size(); begin += block_size) {
+        size_t end = std::min(begin + block_size, coordinates.size());
+        std::vector<std::pair<size_t, size_t>> block(coordinates.begin() + begin,
+                                                     coordinates.begin() + end);
+        load_partition_vids(block);
+        parallel_for(0, block.size(), [&](size_t k) {
+          process_partition(block[k]);
+        });
+      }
+    }
+
+    // Partitions which cannot hold a matching edge contribute nothing.
+    for (size_t k = 0; k < out_edge_blocks.size(); ++k) {
+      if (out_edge_blocks[k].is_opened_for_read()) continue;
+      sframe edge_sframe = edge_partition(k / m_num_partitions,
+                                          k % m_num_partitions, groupa, groupb);
+      std::vector<flex_type_enum> out_column_types = edge_sframe.column_types();
+      out_column_types[src_column_idx] = m_vid_type;
+      out_column_types[dst_column_idx] = m_vid_type;
+      out_edge_blocks[k].open_for_write(edge_sframe.column_names(), out_column_types);
+      out_edge_blocks[k].close();
+    }
   }
   for (auto& sf : out_edge_blocks)
     ret = ret.append(sf);
   return ret;
 }
 
+std::pair<sframe, sframe> sgraph::get_neighborhood(const std::vector<flexible_type>& vids,
+                                                   size_t num_hops,
+                                                   edge_direction direction,
+                                                   size_t groupid) const {
+  bool follow_out_edges = (int)direction & (int)edge_direction::OUT_EDGE;
+  bool follow_in_edges = (int)direction & (int)edge_direction::IN_EDGE;
+
+  // visited: all vertices reached so far.
+  // previous: the vertices of the frontiers before the current one.
+  std::unordered_set<flexible_type> visited;
+  std::unordered_set<flexible_type> previous;
+  std::vector<flexible_type> frontier;
+  for (const auto& vid : vids) {
+    if (vid.get_type() != flex_type_enum::UNDEFINED && visited.insert(vid).second) {
+      frontier.push_back(vid);
+    }
+  }
+
+  sframe edges;
+  edges.open_for_write(get_edge_fields(groupid, groupid),
+                       get_edge_field_types(groupid, groupid));
+  edges.close();
+
+  for (size_t hop = 0; hop < num_hops && !frontier.empty(); ++hop) {
+    std::unordered_set<flexible_type> frontier_set(frontier.begin(), frontier.end());
+    std::vector<flexible_type> next_frontier;
+    std::vector<flexible_type> wildcards(frontier.size(), FLEX_UNDEFINED);
+    for (int is_out : {1, 0}) {
+      if (is_out ? !follow_out_edges : !follow_in_edges) continue;
+      sframe hop_edges = is_out ? get_edges(frontier, wildcards, {}, groupid, groupid)
+                                : get_edges(wildcards, frontier, {}, groupid, groupid);
+      size_t src_column_idx = hop_edges.column_index(SRC_COLUMN_NAME);
+      size_t dst_column_idx = hop_edges.column_index(DST_COLUMN_NAME);
+      // An in edge from a frontier vertex was returned as an out edge, and
+      // when following both directions, an edge from a vertex of a previous
+      // frontier was returned by the hop of that frontier.
+      bool skip_out_of_frontier = !is_out && follow_out_edges;
+      bool skip_previous = follow_out_edges && follow_in_edges;
+      sframe new_edges;
+      new_edges.open_for_write(hop_edges.column_names(), hop_edges.column_types(),
+                               "", hop_edges.num_segments());
+      copy_if(hop_edges, new_edges, [&](const std::vector<flexible_type>& row) {
+                const flexible_type& source = row[src_column_idx];
+                const flexible_type& target = row[dst_column_idx];
+                if (skip_out_of_frontier && frontier_set.count(source)) return false;
+                if (skip_previous && (previous.count(source) || previous.count(target))) {
+                  return false;
+                }
+                return true;
+              });
+      new_edges.close();
+
+      for (size_t column_idx : {src_column_idx, dst_column_idx}) {
+        auto column = new_edges.select_column(column_idx);
+        auto reader = column->get_reader();
+        auto reader_buffer = sarray_reader_buffer<flexible_type>(std::move(reader), 0, column->size());
+        while (reader_buffer.has_next()) {
+          const flexible_type& vid = reader_buffer.next();
+          if (visited.insert(vid).second) next_frontier.push_back(vid);
+        }
+      }
+      edges = edges.append(new_edges);
+    }
+    previous.insert(frontier.begin(), frontier.end());
+    frontier = std::move(next_frontier);
+  }
+
+  sframe vertices;
+  if (visited.empty()) {
+    vertices.open_for_write(get_vertex_fields(groupid), get_vertex_field_types(groupid));
+    vertices.close();
+  } else {
+    vertices = get_vertices({visited.begin(), visited.end()}, {}, groupid);
+  }
+  return {vertices, edges};
+}
+
 /**************************************************************************/
 /*                                                                        */
 /*                               Modifiers                                */
@@ -461,6 +622,141 @@ bool sgraph::add_vertices(sframe vertices,
   return true;
 }
 
+/**
+ * Writes the rows [0, num_rows) into an sframe with segments of
+ * SGRAPH_PARTITION_SEGMENT_ROWS rows. read_rows(begin, end, buffer) must
+ * fill buffer with the rows [begin, end).
+ */
+template <typename ReadRows>
+static sframe write_partition(const std::vector<std::string>& column_names,
+                              const std::vector<flex_type_enum>& column_types,
+                              size_t num_rows,
+                              ReadRows read_rows) {
+  size_t segment_rows = SGRAPH_PARTITION_SEGMENT_ROWS;
+  size_t num_segments = std::max<size_t>(1, (num_rows + segment_rows - 1) / segment_rows);
+  sframe ret;
+  ret.open_for_write(column_names, column_types, "", num_segments);
+  std::vector<std::vector<flexible_type>> buffer;
+  for (size_t i = 0; i < num_segments; ++i) {
+    size_t begin = std::min(i * segment_rows, num_rows);
+    size_t end = std::min(begin + segment_rows, num_rows);
+    read_rows(begin, end, buffer);
+    auto out = ret.get_output_iterator(i);
+    for (auto& row : buffer) {
+      *out = std::move(row);
+      ++out;
+    }
+  }
+  ret.close();
+  return ret;
+}
+
+/**
+ * Returns the number of segments of a partition beyond those it has once
+ * compacted, i.e. the segments appended since the last compaction.
+ */
+static size_t num_delta_segments(const sframe& sf) {
+  size_t segment_rows = SGRAPH_PARTITION_SEGMENT_ROWS;
+  size_t compacted = std::max<size_t>(1, (sf.num_rows() + segment_rows - 1) / segment_rows);
+  return sf.num_segments() > compacted ? sf.num_segments() - compacted : 0;
+}
+
+/**
+ * Rewrites the partition into segments of SGRAPH_PARTITION_SEGMENT_ROWS
+ * rows, keeping the order of the rows.
+ */
+static sframe compact_partition(const sframe& sf) {
+  auto reader = sf.get_reader();
+  return write_partition(sf.column_names(), sf.column_types(), sf.num_rows(),
+                         [&](size_t begin, size_t end,
+                             std::vector<std::vector<flexible_type>>& buffer) {
+                           reader->read_rows(begin, end, buffer);
+                         });
+}
+
+/**
+ * Returns the segments [begin, end) of column as an sarray sharing the
+ * segment files of column.
+ */
+static std::shared_ptr<sarray<flexible_type>>
+segment_slice(const sarray<flexible_type>& column, size_t begin, size_t end) {
+  auto info = column.get_index_info();
+  info.index_file = "";
+  info.nsegments = end - begin;
+  info.segment_sizes = std::vector<size_t>(info.segment_sizes.begin() + begin,
+                                           info.segment_sizes.begin() + end);
+  info.segment_files = std::vector<std::string>(info.segment_files.begin() + begin,
+                                                info.segment_files.begin() + end);
+  auto ret = std::make_shared<sarray<flexible_type>>();
+  ret->open_for_read(info);
+  return ret;
+}
+
+/**
+ * Returns column with the values of some rows replaced. updates holds
+ * (row, value) pairs sorted by row. Only the segments holding one of the
+ * rows are rewritten; the other segments are shared with column.
+ */
+static std::shared_ptr<sarray<flexible_type>>
+update_rows(const sarray<flexible_type>& column,
+            const std::vector<std::pair<size_t, flexible_type>>& updates) {
+  auto info = column.get_index_info();
+  auto reader = column.get_reader();
+  auto write_values = [&](const std::vector<flexible_type>& values) {
+    auto ret = std::make_shared<sarray<flexible_type>>();
+    ret->open_for_write(1);
+    ret->set_type(column.get_type());
+    auto out = ret->get_output_iterator(0);
+    for (const auto& value : values) {
+      *out = value;
+      ++out;
+    }
+    ret->close();
+    return ret;
+  };
+
+  std::vector<std::shared_ptr<sarray<flexible_type>>> pieces;
+  std::vector<flexible_type> values;
+  size_t segment_begin = 0;
+  size_t untouched_begin = 0;
+  size_t u = 0;
+  for (size_t i = 0; i < info.nsegments && u < updates.size(); ++i) {
+    size_t segment_end = segment_begin + info.segment_sizes[i];
+    if (updates[u].first < segment_end) {
+      if (untouched_begin < i) {
+        pieces.push_back(segment_slice(column, untouched_begin, i));
+      }
+      reader->read_rows(segment_begin, segment_end, values);
+      for (; u < updates.size() && updates[u].first < segment_end; ++u) {
+        values[updates[u].first - segment_begin] = updates[u].second;
+      }
+      pieces.push_back(write_values(values));
+      untouched_begin = i + 1;
+    }
+    segment_begin = segment_end;
+  }
+  if (untouched_begin < info.nsegments) {
+    pieces.push_back(segment_slice(column, untouched_begin, info.nsegments));
+  }
+
+  // Segments of an older format cannot be combined with new ones; rewrite
+  // the whole column then.
+  for (const auto& piece : pieces) {
+    auto piece_info = piece->get_index_info();
+    if (piece_info.version != info.version || piece_info.block_size != info.block_size) {
+      reader->read_rows(0, column.size(), values);
+      for (const auto& update : updates) values[update.first] = update.second;
+      return write_values(values);
+    }
+  }
+
+  auto ret = std::make_shared<sarray<flexible_type>>(*pieces[0]);
+  for (size_t i = 1; i < pieces.size(); ++i) {
+    *ret = ret->append(*pieces[i]);
+  }
+  return ret;
+}
+
 void sgraph::commit_vertex_buffer(size_t group,
                                   std::vector<sframe>& vertex_partitions) {
   DASSERT_EQ(vertex_partitions.size(), m_num_partitions);
@@ -497,6 +793,9 @@ void sgraph::commit_vertex_buffer(size_t group,
     reorder_and_add_new_columns(new_partition, all_column_names, all_column_types);
     new_partition = merge_vertex_partition(old_partition, new_partition);
     num_vertex_added[i] = (new_partition.size() - old_partition.size());
+    if (num_delta_segments(new_partition) > SGRAPH_PARTITION_MAX_DELTA_SEGMENTS) {
+      new_partition = compact_partition(new_partition);
+    }
     old_partition = new_partition;
   });
   // }
@@ -510,51 +809,97 @@ sframe sgraph::merge_vertex_partition(sframe& current_data,
 
   size_t id_column_idx = current_data.column_index(VID_COLUMN_NAME);
 
-  std::vector<std::vector<flexible_type>> buffer_a, buffer_b;
-  std::unordered_map<flexible_type, std::vector<flexible_type>*> join_hash_map;
-
-  // read both sframe in memory
-  current_data.get_reader()->read_rows(0, current_data.size(), buffer_a);
-  new_data.get_reader()->read_rows(0, new_data.size(), buffer_b);
-
-  for (auto& row : buffer_a) {
-    flexible_type vid = row[id_column_idx];
-    join_hash_map[vid] = &row;
+  // The row of every vertex of the partition; only the id column is read.
+  vid_hash_map_type current_rows;
+  {
+    auto vid_sarray = current_data.select_column(id_column_idx);
+    auto reader_buffer = sarray_reader_buffer<flexible_type>(vid_sarray->get_reader(),
+                                                             0, vid_sarray->size());
+    size_t i = 0;
+    while (reader_buffer.has_next()) {
+      current_rows.insert({reader_buffer.next(), i});
+      ++i;
+    }
   }
 
-  for (auto& row : buffer_b) {
-    flexible_type vid = row[id_column_idx];
+  std::vector<std::vector<flexible_type>> buffer;
+  new_data.get_reader()->read_rows(0, new_data.size(), buffer);
+
+  // The last row of every vertex of new_data wins. New vertices are
+  // appended in the order they are first seen.
+  std::unordered_map<flexible_type, size_t> new_rows;
+  std::vector<size_t> inserted;
+  std::vector<std::pair<size_t, size_t>> updated;  // (current row, new row)
+  for (size_t k = 0; k < buffer.size(); ++k) {
+    const flexible_type& vid = buffer[k][id_column_idx];
     if (vid.get_type() == flex_type_enum::UNDEFINED) {
       std::string error_message =
           std::string("Vertex id column cannot contain missing value. ") +
           "Please use dropna() to drop the missing value from the input and try again.";
       log_and_throw(error_message);
     }
-    join_hash_map[vid] = &row;
+    auto iter = new_rows.find(vid);
+    if (iter != new_rows.end()) {
+      iter->second = k;
+      continue;
+    }
+    new_rows[vid] = k;
+    auto current_iter = current_rows.find(vid);
+    if (current_iter == current_rows.end()) {
+      inserted.push_back(k);
+    } else {
+      updated.push_back({current_iter->second, k});
+    }
   }
 
-  // prepare the return sframe.
-  sframe ret;
-  size_t num_segments = 1; // use one logical segment
-  ret.open_for_write(current_data.column_names(),
-                     current_data.column_types(),
-                     "", num_segments);
-
-  auto out = ret.get_output_iterator(0);
-  for (auto& row: buffer_a) {
-    decltype(join_hash_map)::const_iterator iter = join_hash_map.find(row[id_column_idx]);
-    *out = std::move(*(iter->second));
-    ++out;
-    join_hash_map.erase(iter);
-  }
-  for (auto& kv : join_hash_map) {
-    *out = std::move(*(kv.second));
-    ++out;
+  sframe ret = current_data;
+  if (!updated.empty()) {
+    std::sort(updated.begin(), updated.end());
+    std::vector<std::shared_ptr<sarray<flexible_type>>> columns(current_data.num_columns());
+    parallel_for(0, columns.size(), [&](size_t c) {
+      std::vector<std::pair<size_t, flexible_type>> updates;
+      updates.reserve(updated.size());
+      for (const auto& u : updated) {
+        updates.push_back({u.first, buffer[new_rows.at(buffer[u.second][id_column_idx])][c]});
+      }
+      columns[c] = update_rows(*current_data.select_column(c), updates);
+    });
+    ret = sframe(columns, current_data.column_names());
+  }
+
+  if (!inserted.empty()) {
+    sframe new_vertices = write_partition(
+        current_data.column_names(), current_data.column_types(), inserted.size(),
+        [&](size_t begin, size_t end, std::vector<std::vector<flexible_type>>& rows) {
+          rows.clear();
+          for (size_t k = begin; k < end; ++k) {
+            size_t row = new_rows.at(buffer[inserted[k]][id_column_idx]);
+            rows.push_back(std::move(buffer[row]));
+          }
+        });
+    ret = (ret.num_rows() == 0) ? new_vertices : ret.append(new_vertices);
   }
-  ret.close();
   return ret;
 }
 
+void sgraph::compact() {
+  for (auto& vgroup : m_vertex_groups) {
+    parallel_for(0, vgroup.size(), [&](size_t i) {
+      if (num_delta_segments(vgroup[i]) > 0) {
+        vgroup[i] = compact_partition(vgroup[i]);
+      }
+    });
+  }
+  for (auto& kv : m_edge_groups) {
+    auto& egroup = kv.second;
+    parallel_for(0, egroup.size(), [&](size_t i) {
+      if (num_delta_segments(egroup[i]) > 0) {
+        egroup[i] = compact_partition(egroup[i]);
+      }
+    });
+  }
+}
+
 bool sgraph::add_vertices(const dataframe_t& vertices,
                           const std::string& id_field_name,
                           size_t group) {
@@ -766,9 +1111,12 @@ void sgraph::commit_edge_buffer(size_t groupa,
     logstream(LOG_INFO) << "Finish writing new vertices in partition " << partitionid 
                         << " in " << timer.current_time() << " secs" << std::endl;
 
-    sframe& old_vertices = vertex_partition(partitionid, groupid);
-    ASSERT_TRUE(union_columns(old_vertices, new_vertices));
-    old_vertices = old_vertices.append(new_vertices);
+    // Appending nothing would still add an empty segment.
+    if (new_vertices_cnt > 0) {
+      sframe& old_vertices = vertex_partition(partitionid, groupid);
+      ASSERT_TRUE(union_columns(old_vertices, new_vertices));
+      old_vertices = old_vertices.append(new_vertices);
+    }
 
     // debug print
     // std::cerr << "New vertices in partition " << i << ":\n";
@@ -883,8 +1231,13 @@ void sgraph::commit_edge_buffer(size_t groupa,
         ASSERT_TRUE(union_columns(old_edges, normalized_edges));
 
         size_t prev_size = old_edges.num_rows(); 
-        old_edges = old_edges.append(normalized_edges);
+        if (normalized_edges.num_rows() > 0) {
+          old_edges = old_edges.append(normalized_edges);
+        }
         edges_added += (old_edges.num_rows() - prev_size);
+        if (num_delta_segments(old_edges) > SGRAPH_PARTITION_MAX_DELTA_SEGMENTS) {
+          old_edges = compact_partition(old_edges);
+        }
       });
 
   logstream(LOG_EMPH) << "Done in " << local_timer.current_time() << " secs" << std::endl;
@@ -1278,9 +1631,15 @@ size_t sgraph::get_edge_field_id(std::string column_name, size_t groupa, size_t
 /*                                                                        */
 /**************************************************************************/
 
+/**
+ * Saves every sframe of sf_vec to the next prefix of oarc. Unless saving
+ * references, key indexes are then built on the index_columns of the saved
+ * sframes, if SGRAPH_SAVE_ID_INDEXES is set.
+ */
 void parallel_save_sframes(const std::vector<sframe>& sf_vec,
                            oarchive& oarc,
-                           bool save_reference) {
+                           bool save_reference,
+                           const std::vector<std::string>& index_columns = {}) {
   std::vector<std::string> prefixes;
   for (size_t i = 0; i < sf_vec.size(); ++i) {
     prefixes.push_back(oarc.dir->get_next_write_prefix());
@@ -1290,6 +1649,14 @@ void parallel_save_sframes(const std::vector<sframe>& sf_vec,
     std::string name = prefixes[i] + ".frame_idx";
     if (save_reference) {
       sframe_save_weak_reference(sf_vec[i], name);
+    } else if (SGRAPH_SAVE_ID_INDEXES && sf_vec[i].num_rows() > 0 &&
+               !index_columns.empty()) {
+      // The frame index file recording the key indexes is written last,
+      // next to the columns saved under another index file name.
+      std::string data_name = prefixes[i] + ".data.frame_idx";
+      sf_vec[i].save(data_name);
+      sframe_add_key_index(sframe(data_name), index_columns, name);
+      fileio::delete_path(data_name);
     } else {
       sf_vec[i].save(name);
     }
@@ -1310,12 +1677,13 @@ void sgraph::save(oarchive& oarc) const {
     // This relies on the serialization format of vector,
     // otherwise old will not load.
     oarc << vgroup.size();
-    parallel_save_sframes(vgroup, oarc, save_reference);
+    parallel_save_sframes(vgroup, oarc, save_reference, {VID_COLUMN_NAME});
   }
   for (const auto& kv : m_edge_groups) {
     oarc << kv.first;
     oarc << kv.second.size();
-    parallel_save_sframes(kv.second, oarc, save_reference);
+    parallel_save_sframes(kv.second, oarc, save_reference,
+                          {SRC_COLUMN_NAME, DST_COLUMN_NAME});
   }
 }
 
@@ -135,6 +135,10 @@ class sgraph {
 
   /** 
    * Returns a sframe of vertices satisfying the id and field constraints.
+   *
+   * When vid_vec is not empty, only the partitions the ids hash to are
+   * read, through the key index of the vertex id column when the graph was
+   * loaded from a save with SGRAPH_SAVE_ID_INDEXES set.
    */
   sframe get_vertices(const std::vector<flexible_type>& vid_vec = {},
                       const options_map_t& field_constraint = options_map_t(),
@@ -148,12 +152,30 @@ class sgraph {
    *
    * If source_vids and target_vids are empty, a universal
    * "UNDEFINED-->UNDEFINED" query is assumed
+   *
+   * With id constraints, only the edge partitions which may hold a matching
+   * edge are read, through the key indexes of the source or target id
+   * columns when available.
    */
    sframe get_edges(const std::vector<flexible_type>& source_vids = {},
                     const std::vector<flexible_type>& target_vids = {},
                     const options_map_t& field_constraint = options_map_t(),
                     size_t groupa = 0, size_t groupb = 0) const;
 
+  /**
+   * Returns the vertices within num_hops hops of the vertices in vids, and
+   * the edges followed to reach them, as a (vertices, edges) pair. Edges
+   * are followed along the given direction, and each edge is returned once.
+   *
+   * Every hop is an id constrained \ref get_edges query, so only the
+   * partitions holding the frontier vertices are read.
+   */
+  std::pair<sframe, sframe> get_neighborhood(
+      const std::vector<flexible_type>& vids,
+      size_t num_hops,
+      edge_direction direction = edge_direction::ANY_EDGE,
+      size_t groupid = 0) const;
+
   /**
    * Returns a list of fields for given vertex group in the graph.
    */
@@ -259,6 +281,15 @@ class sgraph {
    */
   bool clear();
 
+  /**
+   * Rewrites every vertex and edge partition holding segments appended by
+   * add_vertices or add_edges into segments of
+   * SGRAPH_PARTITION_SEGMENT_ROWS rows. Partitions are also compacted
+   * automatically once they hold more than
+   * SGRAPH_PARTITION_MAX_DELTA_SEGMENTS such segments.
+   */
+  void compact();
+
   /**
    * Returns the collection of SFrames containing all the vertices
    * in group groupid.
@@ -682,6 +713,10 @@ class sgraph {
 
   /**
    * Helper function to merge a single vertex partition.
+   *
+   * New vertices are appended as new segments. Existing vertices are
+   * updated in place, rewriting only the segments holding them, so that the
+   * row ids of all vertices, which the edge partitions refer to, are kept.
    */
   sframe merge_vertex_partition(sframe& current_vdata, sframe& new_vdata);
 
@@ -17,6 +17,9 @@ EXPORT size_t SGRAPH_TRIPLE_APPLY_EDGE_BATCH_SIZE = 1024;
 EXPORT size_t SGRAPH_DEFAULT_NUM_PARTITIONS = 8;
 EXPORT size_t SGRAPH_INGRESS_VID_BUFFER_SIZE = 1024 * 1024 * 1;
 EXPORT size_t SGRAPH_HILBERT_CURVE_PARALLEL_FOR_NUM_THREADS = thread::cpu_count();
+EXPORT size_t SGRAPH_SAVE_ID_INDEXES = 1;
+EXPORT size_t SGRAPH_PARTITION_SEGMENT_ROWS = 64 * 1024;
+EXPORT size_t SGRAPH_PARTITION_MAX_DELTA_SEGMENTS = 32;
 
 REGISTER_GLOBAL_WITH_CHECKS(int64_t, 
                             SGRAPH_TRIPLE_APPLY_LOCK_ARRAY_SIZE, 
@@ -49,4 +52,13 @@ REGISTER_GLOBAL_WITH_CHECKS(int64_t,
                             SGRAPH_HILBERT_CURVE_PARALLEL_FOR_NUM_THREADS,
                             true,
                             +[](int64_t val){ return val >= 1; });
+
+REGISTER_GLOBAL(int64_t, SGRAPH_SAVE_ID_INDEXES, true);
+
+REGISTER_GLOBAL_WITH_CHECKS(int64_t,
+                            SGRAPH_PARTITION_SEGMENT_ROWS,
+                            true,
+                            +[](int64_t val){ return val >= 1; });
+
+REGISTER_GLOBAL(int64_t, SGRAPH_PARTITION_MAX_DELTA_SEGMENTS, true);
 }
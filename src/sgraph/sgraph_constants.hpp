@@ -48,6 +48,27 @@ extern size_t SGRAPH_INGRESS_VID_BUFFER_SIZE;
  * Number of threads used for hilber curve parallel for
  */
 extern size_t SGRAPH_HILBERT_CURVE_PARALLEL_FOR_NUM_THREADS;
+
+/**
+ * If non-zero, saving a graph also builds key indexes on the vertex id
+ * column of the vertex partitions and on the source and target id columns
+ * of the edge partitions, which vertex and edge queries on the loaded
+ * graph use instead of scanning the partitions.
+ */
+extern size_t SGRAPH_SAVE_ID_INDEXES;
+
+/**
+ * Number of rows of each segment of a vertex or edge partition when it is
+ * written or compacted. Updating a vertex rewrites only the segments of
+ * its partition holding it.
+ */
+extern size_t SGRAPH_PARTITION_SEGMENT_ROWS;
+
+/**
+ * Number of segments appended to a partition by add_vertices and add_edges
+ * beyond which the partition is compacted.
+ */
+extern size_t SGRAPH_PARTITION_MAX_DELTA_SEGMENTS;
 }
 
 /// \}
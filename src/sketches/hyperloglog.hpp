@@ -10,6 +10,7 @@
 #include <functional>
 #include <util/cityhash_tc.hpp>
 #include <logger/assertions.hpp>
+#include <serialization/serialization_includes.hpp>
 namespace turi {
 namespace sketches {
 /**
@@ -107,14 +108,14 @@ class hyperloglog {
   /**
    * Returns the standard error of the estimate.
    */
-  inline double error_bound() {
+  inline double error_bound() const {
     return estimate() * 1.04 / std::sqrt(m_m);
   }
 
   /**
    * Returns the estimate of the number of unique items.
    */
-  inline double estimate() {
+  inline double estimate() const {
     double E = 0;
     for (size_t i = 0;i < m_buckets.size(); ++i) {
       E += std::pow(2.0, -(double)m_buckets[i]);
@@ -130,6 +131,17 @@ class hyperloglog {
     // collisions are unlikely
     return E;
   }
+
+  void save(oarchive& oarc) const {
+    oarc << m_b << m_buckets;
+  }
+  void load(iarchive& iarc) {
+    size_t b;
+    iarc >> b;
+    *this = hyperloglog(b);
+    iarc >> m_buckets;
+    ASSERT_EQ(m_buckets.size(), m_m);
+  }
 }; // hyperloglog
 } // namespace sketch 
 } // namespace turi
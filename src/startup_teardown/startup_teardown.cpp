@@ -197,6 +197,9 @@ void configure_global_environment(std::string argv0) {
     turi::sframe_config::SFRAME_SORT_BUFFER_SIZE = total_system_memory / 4;
     turi::fileio::FILEIO_MAXIMUM_CACHE_CAPACITY_PER_FILE = total_system_memory / 2;
     turi::fileio::FILEIO_MAXIMUM_CACHE_CAPACITY = total_system_memory / 2;
+    // The limits above add up to more than the working memory; the budget
+    // keeps them from all peaking at once.
+    turi::fileio::FILEIO_MEMORY_BUDGET = total_system_memory;
   }
   turi::globals::initialize_globals_from_environment(argv0);
 
@@ -27,6 +27,7 @@ GENERATE_INTERFACE_AND_PROXY(unity_sframe_base, unity_sframe_proxy,
       (void, construct_from_dataframe, (const dataframe_t&))
       (void, construct_from_sframe_index, (std::string))
       (csv_parsing_errors, construct_from_csvs, (std::string)(csv_parsing_config_map)(str_flex_type_map))
+      (void, construct_from_arrow, (std::string))
       (void, clear, )
       (size_t, size, )
       (std::shared_ptr<unity_sarray_base>, transform, (const std::string&)(flex_type_enum)(bool)(int))
@@ -54,6 +55,9 @@ GENERATE_INTERFACE_AND_PROXY(unity_sframe_base, unity_sframe_proxy,
       (void, begin_iterator, )
       (std::vector<std::vector<flexible_type>>, iterator_get_next, (size_t))
       (void, save_as_csv, (const std::string&)(csv_parsing_config_map))
+      (void, save_as_arrow, (const std::string&))
+      (void, build_key_index, (const std::string&))
+      (std::shared_ptr<unity_sframe_base>, lookup_by_key, (const std::string&)(const std::vector<flexible_type>&))
       (std::shared_ptr<unity_sframe_base>, sample, (float)(int)(bool))
       (std::list<std::shared_ptr<unity_sframe_base>>, random_split, (float)(int)(bool))
       (std::shared_ptr<unity_sframe_base>, groupby_aggregate, (const std::vector<std::string>&)
@@ -63,6 +67,8 @@ GENERATE_INTERFACE_AND_PROXY(unity_sframe_base, unity_sframe_proxy,
       (std::shared_ptr<unity_sframe_base>, append, (std::shared_ptr<unity_sframe_base>))
       (void, materialize, )
       (bool, is_materialized, )
+      (bool, is_fragmented, )
+      (void, compact, )
       (bool, has_size, )
       (std::string, query_plan_string, )
       (std::shared_ptr<unity_sframe_base>, join, (std::shared_ptr<unity_sframe_base>)(const std::string)(string_map))
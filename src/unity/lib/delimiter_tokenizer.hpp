@@ -0,0 +1,300 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#ifndef TURI_UNITY_DELIMITER_TOKENIZER_HPP
+#define TURI_UNITY_DELIMITER_TOKENIZER_HPP
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unordered_map>
+#include <flexible_type/flexible_type.hpp>
+#include <parallel/atomic.hpp>
+#include <parallel/mutex.hpp>
+#include <util/cityhash_tc.hpp>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace turi {
+
+/**
+ * Interns tokens: equal tokens get the same id, and the same string
+ * flexible_type, so emitting a token already seen is a reference count
+ * increment instead of a string allocation.
+ *
+ * A vocabulary is not thread safe; each \ref delimiter_tokenizer keeps one
+ * per thread using it (see \ref delimiter_tokenizer::vocabulary), released
+ * with the tokenizer. Ids are only stable until \ref trim drops the
+ * vocabulary.
+ */
+class token_vocabulary {
+ public:
+  /// Above this many tokens, \ref trim drops the vocabulary.
+  static constexpr size_t MAX_SIZE = 1024 * 1024;
+
+  /**
+   * The id of the token [str, str + len), adding it if it is new.
+   */
+  size_t intern(const char* str, size_t len) {
+    uint64_t h = hash64(str, len);
+    while (true) {
+      auto it = m_ids.find(h);
+      if (it == m_ids.end()) {
+        size_t id = m_tokens.size();
+        m_tokens.push_back(flexible_type(flex_string(str, len)));
+        m_ids.emplace(h, id);
+        return id;
+      }
+      const flex_string& t = m_tokens[it->second].get<flex_string>();
+      if (t.size() == len && std::memcmp(t.data(), str, len) == 0) {
+        return it->second;
+      }
+      // A hash collision between distinct tokens; probe the next hash.
+      h = hash64(h, 1);
+    }
+  }
+
+  /**
+   * Like \ref intern, converting the token to lower case first if to_lower
+   * is set.
+   */
+  size_t intern(const char* str, size_t len, bool to_lower) {
+    if (!to_lower) return intern(str, len);
+    m_lower_buffer.assign(str, len);
+    std::transform(m_lower_buffer.begin(), m_lower_buffer.end(),
+                   m_lower_buffer.begin(), ::tolower);
+    return intern(m_lower_buffer.data(), len);
+  }
+
+  const flexible_type& token(size_t id) const { return m_tokens[id]; }
+
+  size_t size() const { return m_tokens.size(); }
+
+  /**
+   * Drops the vocabulary if it holds more than MAX_SIZE tokens. Must only be
+   * called when no token id is held.
+   */
+  void trim() {
+    if (m_tokens.size() > MAX_SIZE) {
+      m_tokens.clear();
+      m_ids.clear();
+    }
+  }
+
+ private:
+  std::vector<flexible_type> m_tokens;
+  std::unordered_map<uint64_t, size_t> m_ids;
+  std::string m_lower_buffer;
+};
+
+/**
+ * The vocabularies of the threads using a tokenizer, and of its copies.
+ */
+class token_vocabulary_set {
+ public:
+  token_vocabulary_set() : m_id(next_id()) { }
+
+  /**
+   * The vocabulary of the calling thread. Only takes a lock the first time
+   * a thread asks, or when it switches between tokenizers.
+   */
+  token_vocabulary& local() {
+    static thread_local size_t cached_set_id = 0;
+    static thread_local token_vocabulary* cached_vocabulary = nullptr;
+    if (cached_set_id == m_id) return *cached_vocabulary;
+
+    std::lock_guard<turi::mutex> guard(m_lock);
+    auto& vocabulary = m_vocabularies[std::this_thread::get_id()];
+    if (!vocabulary) vocabulary.reset(new token_vocabulary);
+    cached_set_id = m_id;
+    cached_vocabulary = vocabulary.get();
+    return *vocabulary;
+  }
+
+ private:
+  /// Ids are never reused, so a stale thread local cache never matches.
+  static size_t next_id() {
+    static atomic<size_t> counter(0);
+    return counter.inc();
+  }
+
+  size_t m_id;
+  turi::mutex m_lock;
+  std::unordered_map<std::thread::id, std::unique_ptr<token_vocabulary>>
+      m_vocabularies;
+};
+
+/**
+ * Splits strings into the maximal runs of characters which are not
+ * delimiters, where the delimiters are the first characters of the strings
+ * of a list (the count_words / WordCounter convention).
+ *
+ * Delimiters are looked up in a 256 entry byte class table. When there are
+ * at most 16 delimiters (the default whitespace list has 6), the scan for
+ * the end of a token is done 16 bytes at a time with SSE2 compares.
+ *
+ * Tokens are reported as (pointer, length) pairs into the tokenized string;
+ * no string is allocated.
+ *
+ * Copies of a tokenizer (as captured by transformation lambdas) share its
+ * per thread \ref token_vocabulary, which is released with the last copy.
+ */
+class delimiter_tokenizer {
+ public:
+  delimiter_tokenizer()
+      : m_vocabularies(std::make_shared<token_vocabulary_set>()) {
+    std::fill(m_is_delimiter, m_is_delimiter + 256, false);
+  }
+
+  /**
+   * Empty strings in delimiter_list are ignored.
+   */
+  explicit delimiter_tokenizer(const flex_list& delimiter_list)
+      : delimiter_tokenizer() {
+    for (const auto& d : delimiter_list) {
+      flex_string delimiter = d.to<flex_string>();
+      if (delimiter.empty()) continue;
+      unsigned char c = delimiter[0];
+      if (!m_is_delimiter[c]) {
+        m_is_delimiter[c] = true;
+        m_delimiters.push_back(c);
+      }
+    }
+#ifdef __SSE2__
+    for (size_t i = 0; i < m_delimiters.size() && i < 16; ++i) {
+      m_delimiter_vectors[i] = _mm_set1_epi8(static_cast<char>(m_delimiters[i]));
+    }
+#endif
+  }
+
+  bool is_delimiter(char c) const {
+    return m_is_delimiter[static_cast<unsigned char>(c)];
+  }
+
+  /**
+   * Calls fn(const char* token, size_t length) for every token of
+   * [str, str + len), in order.
+   */
+  template <typename Fn>
+  void for_each_token(const char* str, size_t len, Fn&& fn) const {
+    const char* end = str + len;
+    const char* p = str;
+    while (true) {
+      while (p < end && is_delimiter(*p)) ++p;
+      if (p == end) return;
+      const char* token_end = find_delimiter(p, end);
+      fn(p, size_t(token_end - p));
+      p = token_end;
+    }
+  }
+
+  /**
+   * The vocabulary the calling thread interns the tokens of this tokenizer
+   * in.
+   */
+  token_vocabulary& vocabulary() const { return m_vocabularies->local(); }
+
+ private:
+  /// The first delimiter in [p, end), or end.
+  const char* find_delimiter(const char* p, const char* end) const {
+#ifdef __SSE2__
+    size_t num_delimiters = m_delimiters.size();
+    if (num_delimiters > 0 && num_delimiters <= 16) {
+      const __m128i* delims = m_delimiter_vectors;
+      while (end - p >= 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        __m128i hits = _mm_cmpeq_epi8(chunk, delims[0]);
+        for (size_t i = 1; i < num_delimiters; ++i) {
+          hits = _mm_or_si128(hits, _mm_cmpeq_epi8(chunk, delims[i]));
+        }
+        int mask = _mm_movemask_epi8(hits);
+        if (mask != 0) return p + __builtin_ctz(mask);
+        p += 16;
+      }
+    }
+#endif
+    while (p < end && !is_delimiter(*p)) ++p;
+    return p;
+  }
+
+  bool m_is_delimiter[256];
+  std::vector<unsigned char> m_delimiters;
+#ifdef __SSE2__
+  /// The first 16 delimiters, broadcast to the 16 bytes of a vector.
+  __m128i m_delimiter_vectors[16];
+#endif
+  std::shared_ptr<token_vocabulary_set> m_vocabularies;
+};
+
+/**
+ * Tokenizes, interns and counts in a single pass: the counts of the tokens
+ * of all the strings added, emitted as a {token: count} dictionary in the
+ * order tokens were first seen.
+ */
+class token_counter {
+ public:
+  token_counter(const delimiter_tokenizer& tokenizer, bool to_lower)
+      : m_tokenizer(tokenizer), m_to_lower(to_lower),
+        m_vocabulary(tokenizer.vocabulary()) {
+    m_vocabulary.trim();
+  }
+
+  /**
+   * Counts the tokens of str.
+   */
+  void add(const flex_string& str) {
+    m_tokenizer.for_each_token(str.data(), str.size(),
+                               [&](const char* token, size_t len) {
+      size_t id = m_vocabulary.intern(token, len, m_to_lower);
+      auto it = m_positions.find(id);
+      if (it == m_positions.end()) {
+        m_positions.emplace(id, m_counts.size());
+        m_counts.emplace_back(id, 1);
+      } else {
+        ++m_counts[it->second].second;
+      }
+    });
+  }
+
+  flex_dict to_dict() const {
+    flex_dict ret;
+    ret.reserve(m_counts.size());
+    for (const auto& c : m_counts) {
+      ret.push_back({m_vocabulary.token(c.first), flexible_type(c.second)});
+    }
+    return ret;
+  }
+
+ private:
+  const delimiter_tokenizer& m_tokenizer;
+  bool m_to_lower;
+  token_vocabulary& m_vocabulary;
+  std::unordered_map<size_t, size_t> m_positions;
+  std::vector<std::pair<size_t, size_t>> m_counts;
+};
+
+/**
+ * The tokens of str, as interned strings.
+ */
+inline flex_list tokenize_to_list(const delimiter_tokenizer& tokenizer,
+                                  const flex_string& str, bool to_lower) {
+  token_vocabulary& vocabulary = tokenizer.vocabulary();
+  vocabulary.trim();
+  flex_list ret;
+  tokenizer.for_each_token(str.data(), str.size(),
+                           [&](const char* token, size_t len) {
+    ret.push_back(vocabulary.token(vocabulary.intern(token, len, to_lower)));
+  });
+  return ret;
+}
+
+} // namespace turi
+
+#endif
@@ -398,6 +398,14 @@ void gl_sframe::materialize() {
   get_proxy()->materialize();
 }
 
+bool gl_sframe::is_fragmented() const {
+  return get_proxy()->is_fragmented();
+}
+
+void gl_sframe::compact() {
+  get_proxy()->compact();
+}
+
 void gl_sframe::save(const std::string& _path, const std::string& _format) const {
   std::string path = _path;
   std::string format = _format;
@@ -881,6 +881,23 @@ class gl_sframe {
    */
   void materialize();
 
+  /**
+   * Returns whether or not the SFrame is stored in many more segments, or
+   * many more small blocks, than usual, as left behind by many appends.
+   * Lazily evaluated SFrames are not fragmented.
+   *
+   * \see compact
+   */
+  bool is_fragmented() const;
+
+  /**
+   * Materializes the SFrame, and rewrites it in fewer segments and larger
+   * blocks if it is fragmented. Reading a compacted SFrame is faster.
+   *
+   * \see is_fragmented
+   */
+  void compact();
+
   /**
    * 
    * Saves the SFrame to file.
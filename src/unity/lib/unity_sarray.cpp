@@ -11,6 +11,7 @@
 #include <unity/lib/unity_sarray.hpp>
 #include <unity/lib/unity_sframe.hpp>
 #include <unity/lib/flex_dict_view.hpp>
+#include <unity/lib/delimiter_tokenizer.hpp>
 #include <unity/lib/unity_global.hpp>
 #include <unity/lib/unity_global_singleton.hpp>
 #include <unity/lib/variant.hpp>
@@ -28,6 +29,7 @@
 #include <sframe/parallel_csv_parser.hpp>
 #include <flexible_type/flexible_type_spirit_parser.hpp>
 #include <sframe/sframe_constants.hpp>
+#include <sframe/sarray_dict_projection.hpp>
 #include <serialization/oarchive.hpp>
 #include <serialization/iarchive.hpp>
 #include <unity/lib/auto_close_sarray.hpp>
@@ -1506,10 +1508,30 @@ std::shared_ptr<unity_sarray_base> unity_sarray::scalar_operator(flexible_type o
           return right_operator ? binaryfn(other, f) : binaryfn(f, other);
         };
 
-    return transform_lambda(transformfn,
-                            output_type,
-                            false/*skip undefined*/,
-                            0 /*random seed*/);
+    auto ret = transform_lambda(transformfn,
+                                output_type,
+                                false/*skip undefined*/,
+                                0 /*random seed*/);
+
+    // Record the keys of sa == key and sa.is_in(keys), so the query planner
+    // can answer a filter on the result with a key index of the column.
+    if (op == "==" ||
+        (op == "in" && right_operator &&
+         (other.get_type() == flex_type_enum::LIST ||
+          other.get_type() == flex_type_enum::VECTOR))) {
+      flex_list keys;
+      if (op == "==") {
+        keys.push_back(other);
+      } else if (other.get_type() == flex_type_enum::LIST) {
+        keys = other.get<flex_list>();
+      } else {
+        const flex_vec& vec = other.get<flex_vec>();
+        keys.assign(vec.begin(), vec.end());
+      }
+      std::static_pointer_cast<unity_sarray>(ret)->get_planner_node()
+          ->operator_parameters["key_lookup_values"] = keys;
+    }
+    return ret;
   } else {
     auto transformfn = [=](const flexible_type& f)->flexible_type {
           if (f.get_type() == flex_type_enum::UNDEFINED) {
@@ -1745,67 +1767,13 @@ unity_sarray::count_bag_of_words(std::map<std::string, flexible_type> options) {
     delimiter_list = options["delimiters"];
   }
 
-  std::set<char> delimiters;
-  for (auto it = delimiter_list.begin(); it != delimiter_list.end(); ++it) {
-    // iterate through flexible_types storing the delimiters
-    // cast each to a string and take first char in string
-    // insert into std::set for quicker look-ups than turi::flex_list
-    delimiters.insert(it->to<std::string>().at(0));
-  }
+  delimiter_tokenizer tokenizer(delimiter_list);
 
-  auto is_delimiter = [delimiters](const char c)->bool {
-    return delimiters.find(c) != delimiters.end();
-  };
-
-  auto transformfn = [to_lower, is_delimiter](const flexible_type& f)->flexible_type {
-    flex_dict ret;
-    const std::string& str = f.get<flex_string>();
-
-    // Tokenizing the string by space, and add to mape
-    // Here we optimize for speed to reduce the string malloc
-    size_t word_begin = 0;
-    // skip leading delimiters
-    while (word_begin < str.size() && (is_delimiter(str[word_begin])))
-      ++word_begin;
-
-    std::string word;
-    flexible_type word_flex;
-
-    // count bag of words
-    std::unordered_map<flexible_type, size_t> ret_count;
-
-    for (size_t i = word_begin; i < str.size(); ++i) {
-      if (is_delimiter(str[i])) {
-        // find the end of thw word, make a substring, and transform to lower case
-        word = std::string(str, word_begin, i - word_begin);
-        if  (to_lower)
-          std::transform(word.begin(), word.end(), word.begin(), ::tolower);
-        word_flex = std::move(word);
-
-        // add the word to map
-        ret_count[word_flex]++;
-
-        // keep skipping delimiters, and reset word_begin
-        while (i < str.size() && (is_delimiter(str[i])))
-          ++i;
-        word_begin = i;
-      }
-    }
-
-    // add the last word
-    if (word_begin < str.size()) {
-      word = std::string(str, word_begin, str.size() - word_begin);
-      if  (to_lower)
-        std::transform(word.begin(), word.end(), word.begin(), ::tolower);
-      word_flex = std::move(word);
-      ret_count[word_flex]++;
-    }
-
-    // convert to dictionary
-    for(auto& val : ret_count) {
-      ret.push_back({val.first, flexible_type(val.second)});
-    }
-    return ret;
+  auto transformfn = [to_lower, tokenizer](const flexible_type& f)->flexible_type {
+    // count bag of words in a single pass over the string
+    token_counter counter(tokenizer, to_lower);
+    counter.add(f.get<flex_string>());
+    return counter.to_dict();
   };
 
   return transform_lambda(transformfn, flex_type_enum::DICT, true, 0);
@@ -2150,6 +2118,16 @@ std::shared_ptr<unity_sarray_base> unity_sarray::dict_keys() {
     log_and_throw("Only dictionary type is supported for trim by keys.");
   }
 
+  // A materialized array only needs its keys read
+  if (is_materialized()) {
+    auto column = get_underlying_sarray();
+    if (sarray_dict_projection_supported(*column)) {
+      std::shared_ptr<unity_sarray> ret(new unity_sarray());
+      ret->construct_from_sarray(sarray_dict_keys(*column));
+      return ret;
+    }
+  }
+
   auto transformfn = [](const flexible_type& f)->flexible_type {
     if (f.get_type() == flex_type_enum::UNDEFINED) return f;
     return flex_dict_view(f).keys();
@@ -2328,9 +2306,26 @@ std::shared_ptr<unity_sframe_base >unity_sarray::unpack_dict(
     return true;
   };
 
-  key_valuetype_map =
-    query_eval::reduce<std::map<flexible_type, flex_type_enum>>
-    (m_planner_node, reductionfn, combinefn, key_valuetype_map);
+  // A materialized array only needs its keys and the value headers read
+  std::shared_ptr<sarray<flexible_type>> column;
+  if (is_materialized()) column = get_underlying_sarray();
+  if (column && sarray_dict_projection_supported(*column)) {
+    for (const auto& key_types: sarray_dict_value_types(*column)) {
+      auto position = key_valuetype_map.find(key_types.first);
+      if (position == key_valuetype_map.end()) {
+        if (has_key_limits) continue;
+        position = key_valuetype_map.emplace(key_types.first,
+                                             flex_type_enum::UNDEFINED).first;
+      }
+      for (flex_type_enum t: key_types.second) {
+        position->second = type_combine_fn(t, position->second);
+      }
+    }
+  } else {
+    key_valuetype_map =
+      query_eval::reduce<std::map<flexible_type, flex_type_enum>>
+      (m_planner_node, reductionfn, combinefn, key_valuetype_map);
+  }
 
   if (key_valuetype_map.size() == 0) {
     throw "Nothing to unpack, SArray is empty";
@@ -2505,6 +2500,19 @@ std::shared_ptr<unity_sframe_base> unity_sarray::unpack(
     }
   }
   auto coltype = dtype();
+
+  // A materialized dictionary array only needs the values of the keys read
+  if (coltype == flex_type_enum::DICT && is_materialized()) {
+    auto column = get_underlying_sarray();
+    if (sarray_dict_projection_supported(*column)) {
+      std::shared_ptr<unity_sframe> ret(new unity_sframe());
+      ret->construct_from_sframe(sarray_dict_unpack(*column, unpacked_keys,
+                                                    column_names, column_types,
+                                                    na_value));
+      return ret;
+    }
+  }
+
   auto transformfn = [coltype, unpacked_keys, na_value](const sframe_rows::row& row,
                                                         sframe_rows::row& ret) {
     const auto& val = row[0];
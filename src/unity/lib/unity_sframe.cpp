@@ -21,6 +21,8 @@
 #include <sframe/groupby_aggregate_operators.hpp>
 #include <sframe/csv_line_tokenizer.hpp>
 #include <sframe/csv_writer.hpp>
+#include <sframe/sframe_arrow_io.hpp>
+#include <sframe/sframe_key_index.hpp>
 #include <flexible_type/flexible_type_spirit_parser.hpp>
 #include <sframe/join.hpp>
 #include <unity/lib/auto_close_sarray.hpp>
@@ -91,6 +93,12 @@ void unity_sframe::construct_from_sframe(const sframe& sf) {
   this->set_sframe(std::make_shared<sframe>(sf));
 }
 
+void unity_sframe::construct_from_arrow(std::string url) {
+  logstream(LOG_INFO) << "Construct sframe from Arrow file: " << sanitize_url(url) << std::endl;
+  clear();
+  this->set_sframe(std::make_shared<sframe>(sframe_load_from_arrow(url)));
+}
+
 void unity_sframe::construct_from_sframe_index(std::string location) {
   logstream(LOG_INFO) << "Construct sframe from location: " << sanitize_url(location) << std::endl;
   clear();
@@ -789,6 +797,13 @@ std::shared_ptr<unity_sframe_base> unity_sframe::logical_filter(
               return (flex_int)(!f.is_zero());
             }, flex_type_enum::INTEGER, true, 0));
 
+  // The binarized mask selects the same rows, so the query planner may
+  // still answer the filter with a key index.
+  auto filter_node = filter_array->get_planner_node();
+  if (filter_node->operator_parameters.count("key_lookup_values")) {
+    other_array_binarized->get_planner_node()->operator_parameters["key_lookup_values"] =
+        filter_node->operator_parameters.at("key_lookup_values");
+  }
 
   auto equal_length = query_eval::planner().test_equal_length(this->get_planner_node(),
                                                               other_array_binarized->get_planner_node());
@@ -900,6 +915,27 @@ std::vector< std::vector<flexible_type> > unity_sframe::iterator_get_next(size_t
   return ret;
 }
 
+void unity_sframe::save_as_arrow(const std::string& url) {
+  log_func_entry();
+  logstream(LOG_INFO) << "Args: " << sanitize_url(url) << std::endl;
+  sframe_save_as_arrow(*get_underlying_sframe(), url);
+}
+
+void unity_sframe::build_key_index(const std::string& column_name) {
+  log_func_entry();
+  auto sf = get_underlying_sframe();
+  this->set_sframe(std::make_shared<sframe>(sframe_add_key_index(*sf, {column_name})));
+}
+
+std::shared_ptr<unity_sframe_base> unity_sframe::lookup_by_key(
+    const std::string& column_name, const std::vector<flexible_type>& keys) {
+  log_func_entry();
+  // The query planner answers this filter with the key index, if any.
+  auto mask = select_column(column_name)->right_scalar_operator(
+      flex_list(keys.begin(), keys.end()), "in");
+  return logical_filter(mask);
+}
+
 void unity_sframe::save_as_csv(const std::string& url,
                                std::map<std::string, flexible_type> writing_config) {
   log_func_entry();
@@ -1042,6 +1078,19 @@ bool unity_sframe::is_materialized() {
   return false;
 }
 
+bool unity_sframe::is_fragmented() {
+  // only a materialized sframe has segments to look at
+  if (!is_materialized()) return false;
+  return sframe_is_fragmented(*get_underlying_sframe());
+}
+
+void unity_sframe::compact() {
+  auto sf = get_underlying_sframe();
+  if (sframe_is_fragmented(*sf)) {
+    set_sframe(std::make_shared<sframe>(sframe_compact(*sf)));
+  }
+}
+
 bool unity_sframe::has_size() {
   return infer_planner_node_length(m_planner_node) != -1;
 }
@@ -83,6 +83,13 @@ class unity_sframe : public unity_sframe_base {
    */
   void construct_from_sframe_index(std::string index_file);
 
+  /**
+   * Constructs an SFrame from an Apache Arrow IPC file (".arrow" / Feather
+   * V2). If the current object is already storing an frame, it is cleared
+   * (\ref clear()). See \ref sframe_load_from_arrow for the type mapping.
+   */
+  void construct_from_arrow(std::string url);
+
   /**
    * Constructs an SFrame from one or more csv files.
    * To keep the interface stable, the CSV parsing configuration read from a
@@ -383,6 +390,29 @@ class unity_sframe : public unity_sframe_base {
   void save_as_csv(const std::string& url,
                    std::map<std::string, flexible_type> writing_config);
 
+  /**
+   * Saves the SFrame as an Apache Arrow IPC file (".arrow" / Feather V2).
+   * See \ref sframe_save_as_arrow for the type mapping.
+   */
+  void save_as_arrow(const std::string& url);
+
+  /**
+   * Builds a key index on a column of a saved SFrame, so that filters
+   * comparing the column to constants (sa == key, sa.is_in(keys)) and
+   * \ref lookup_by_key read only the matching rows. The saved frame is not
+   * modified: this SFrame is switched to a new frame index file which
+   * records the index. See \ref sframe_add_key_index.
+   */
+  void build_key_index(const std::string& column_name);
+
+  /**
+   * Returns the rows whose column column_name is equal to one of keys.
+   * Uses the key index of the column if there is one, and scans the
+   * column otherwise.
+   */
+  std::shared_ptr<unity_sframe_base> lookup_by_key(
+      const std::string& column_name, const std::vector<flexible_type>& keys);
+
   /**
    * Randomly split the sframe into two parts, with ratio = percent, and  seed = random_seed.
    *
@@ -409,6 +439,20 @@ class unity_sframe : public unity_sframe_base {
    **/
   bool is_materialized();
 
+  /**
+   * Returns whether or not this sframe is materialized into many more
+   * segments, or many more small blocks, than usual, as left behind by
+   * many appends (see \ref sframe_is_fragmented). Never materializes.
+   */
+  bool is_fragmented();
+
+  /**
+   * Materializes the sframe, and rewrites it to temporary storage in fewer
+   * segments and larger blocks if it is fragmented (see \ref sframe_compact).
+   * This will NOT create a new unity_sframe.
+   */
+  void compact();
+
   /**
    * Return the query plan as a string representation of a dot graph.
    */
@@ -3,6 +3,7 @@
  * Use of this source code is governed by a BSD-3-clause license that can
  * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
  */
+#include <cmath>
 #include <future>
 #include <thread>
 #include <unordered_set>
@@ -10,6 +11,7 @@
 #include <unity/lib/unity_sketch.hpp>
 #include <unity/lib/unity_sarray.hpp>
 #include <unity/lib/flex_dict_view.hpp>
+#include <sframe/column_sketch.hpp>
 #include <sketches/hyperloglog.hpp>
 #include <sketches/countsketch.hpp>
 #include <sketches/quantile_sketch.hpp>
@@ -38,6 +40,23 @@ void unity_sketch::construct_from_sarray(
     return;
   }
 
+  // a saved array may carry the sketch of its values: use it rather than
+  // scanning the array
+  if (key_set.empty() && !m_is_list) {
+    auto persisted = sarray_column_sketch(*array);
+    if (persisted && persisted->size() == m_size) {
+      load_persisted_sketch(*persisted);
+      m_persisted_reader = reader;
+      return;
+    }
+  }
+
+  scan(reader, key_set, background);
+}
+
+void unity_sketch::scan(std::shared_ptr<sarray<flexible_type>::reader_type> reader,
+                        const std::unordered_set<flexible_type>& key_set,
+                        bool background) {
   // build up the thread local datastructures
   m_commit_timer.start();
   m_background_future =
@@ -72,6 +91,39 @@ void unity_sketch::construct_from_sarray(
   }
 }
 
+void unity_sketch::load_persisted_sketch(const column_sketch& persisted) {
+  m_undefined_count = persisted.num_undefined();
+  if (m_is_numeric && persisted.num_numeric() > 0) {
+    m_numeric_sketch.quantiles.reset(
+        new sketches::streaming_quantile_sketch<double>(persisted.quantiles()));
+    m_numeric_sketch.min = persisted.min().to<flex_float>();
+    m_numeric_sketch.max = persisted.max().to<flex_float>();
+    m_numeric_sketch.sum = persisted.sum();
+    m_numeric_sketch.mean = persisted.mean();
+    m_numeric_sketch.m2 = persisted.m2();
+    m_numeric_sketch.num_items = persisted.num_numeric();
+  } else if (m_is_numeric) {
+    m_numeric_sketch.finalize();
+  }
+  m_discrete_sketch.unique.reset(new sketches::hyperloglog(persisted.unique_sketch()));
+  m_persisted_frequent_items = persisted.frequent_items();
+  m_persisted_frequent_items_cutoff = persisted.frequent_items_cutoff();
+
+  m_num_elements_processed = m_size;
+  m_rows_processed_by_threads.value = m_size;
+  m_thrlocal.clear();
+}
+
+void unity_sketch::scan_persisted_array() {
+  // The count sketch is not persisted: compute all the sketches.
+  auto reader = m_persisted_reader;
+  m_persisted_reader.reset();
+  m_persisted_frequent_items.clear();
+  init(NULL, m_stored_type, {}, reader);
+  m_rows_processed_by_threads.value = 0;
+  scan(reader, {}, false);
+}
+
 unity_sketch::~unity_sketch() {
   if (m_background_future.valid()) {
     m_cancel = true;
@@ -387,6 +439,22 @@ double unity_sketch::frequency_count(flexible_type val) {
     log_and_throw("Invalid type");
   }
 
+  if (m_persisted_reader) {
+    flexible_type tempval(tmpval_type);
+    tempval.soft_assign(val);
+    for (const auto& item: m_persisted_frequent_items) {
+      if (item.first == tempval) return item.second;
+    }
+    // missing values and NaN are never listed
+    bool listable = tempval.get_type() != flex_type_enum::UNDEFINED &&
+        !(tempval.get_type() == flex_type_enum::FLOAT &&
+          std::isnan(tempval.get<flex_float>()));
+    if (listable && m_persisted_frequent_items_cutoff == 0) return 0.0;
+    // the value may have been left out of the persisted frequent items:
+    // count it with the count sketch
+    scan_persisted_array();
+  }
+
   commit_global_if_out_of_date();
   std::unique_lock<turi::mutex> global_lock(lock);
   if (m_discrete_sketch.count) {
@@ -404,7 +472,9 @@ std::vector<std::pair<flexible_type, size_t> > unity_sketch::frequent_items() {
   commit_global_if_out_of_date();
 
   std::unique_lock<turi::mutex> global_lock(lock);
-  if (m_discrete_sketch.frequent) {
+  if (m_persisted_reader) {
+    return m_persisted_frequent_items;
+  } else if (m_discrete_sketch.frequent) {
     auto items = m_discrete_sketch.frequent->frequent_items();
     std::vector<std::pair<flexible_type, size_t> > ret;
     for (auto& item: items) {
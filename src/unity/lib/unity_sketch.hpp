@@ -21,6 +21,7 @@ namespace turi {
 // forward declarations
 class unity_sarray;
 class unity_sketch;
+class column_sketch;
 
 namespace sketches {
 
@@ -402,6 +403,13 @@ class unity_sketch: public unity_sketch_base {
   // for vector/dict, allow user to specify a subset keys/index to grab subsketch
   std::map<flexible_type, std::shared_ptr<unity_sketch>> m_element_sub_sketch;
 
+  // if the sketches were loaded from the sketch persisted with the array,
+  // a reader of the array and the persisted frequent items, with the bound
+  // on the count of the values they leave out (0 if they are complete).
+  std::shared_ptr<sarray<flexible_type>::reader_type> m_persisted_reader;
+  std::vector<std::pair<flexible_type, size_t>> m_persisted_frequent_items;
+  size_t m_persisted_frequent_items_cutoff = 0;
+
   /*
    * Resets the global sketches and statistics. This function does not
    * acquire locks. The caller must acquire the global lock if necessary.
@@ -426,6 +434,26 @@ class unity_sketch: public unity_sketch_base {
     DASSERT_TRUE(m_is_child_sketch);
   }
 
+  /**
+   * Starts accumulating the sketches of the values read by reader, in the
+   * background if background is true.
+   */
+  void scan(std::shared_ptr<sarray<flexible_type>::reader_type> reader,
+            const std::unordered_set<flexible_type>& key_set,
+            bool background);
+
+  /**
+   * Fills in the statistics and sketches from the sketch persisted with
+   * the array. The count sketch is not persisted: see scan_persisted_array.
+   */
+  void load_persisted_sketch(const column_sketch& persisted);
+
+  /**
+   * Replaces the sketches loaded by load_persisted_sketch by sketches
+   * computed by scanning the array.
+   */
+  void scan_persisted_array();
+
   inline void init(
     unity_sketch* parent,
     flex_type_enum type,
@@ -10,6 +10,7 @@
 
 #include <string>
 #include <cmath>
+#include <algorithm>
 
 namespace turi {
 namespace visualization {
@@ -177,7 +178,14 @@ void histogram_result::add_element_simple(const flexible_type& value) {
    * add element to summary stats
    */
   m_count.add_element_simple(value);
-  m_count_distinct.add_element_simple(value);
+  m_count_distinct.add(value);
+  if (!m_many_distinct_values) {
+    m_distinct_values.insert(value);
+    if (m_distinct_values.size() > MAX_EXACT_NUM_UNIQUE) {
+      m_many_distinct_values = true;
+      std::unordered_set<flexible_type>().swap(m_distinct_values);
+    }
+  }
   m_non_null_count.add_element_simple(value);
   m_average.add_element_simple(value);
   m_min.add_element_simple(value);
@@ -242,6 +250,26 @@ void histogram::init(const gl_sarray& source) {
   }
 }
 
+void histogram_result::combine_num_unique(const histogram_result& other) {
+  m_count_distinct.combine(other.m_count_distinct);
+  if (!m_many_distinct_values && !other.m_many_distinct_values) {
+    m_distinct_values.insert(other.m_distinct_values.begin(),
+                             other.m_distinct_values.end());
+  }
+  if (m_many_distinct_values || other.m_many_distinct_values ||
+      m_distinct_values.size() > MAX_EXACT_NUM_UNIQUE) {
+    m_many_distinct_values = true;
+    std::unordered_set<flexible_type>().swap(m_distinct_values);
+  }
+}
+
+size_t histogram_result::num_unique() const {
+  if (!m_many_distinct_values) return m_distinct_values.size();
+  // the estimate is never below the exact counts it replaces
+  return std::max<size_t>(MAX_EXACT_NUM_UNIQUE + 1,
+                          std::llround(m_count_distinct.estimate()));
+}
+
 std::vector<histogram_result> histogram::split_input(size_t num_threads) {
   flexible_type current_min = m_transformer->min;
   flexible_type current_max = m_transformer->max;
@@ -258,7 +286,7 @@ void histogram::merge_results(std::vector<histogram_result>& thread_results) {
   for (auto& thread_result : thread_results) {
     // combine summary stats
     m_transformer->m_count.combine(thread_result.m_count);
-    m_transformer->m_count_distinct.combine(thread_result.m_count_distinct);
+    m_transformer->combine_num_unique(thread_result);
     m_transformer->m_non_null_count.combine(thread_result.m_non_null_count);
     m_transformer->m_average.combine(thread_result.m_average);
     m_transformer->m_min.combine(thread_result.m_min);
@@ -320,7 +348,7 @@ std::string histogram_result::vega_summary_data() const {
   std::string typeName = flex_type_enum_to_name(m_type);
 
   ss << "\"type\": \"" << typeName << "\",";
-  ss << "\"num_unique\": " << m_count_distinct.emit() << ",";
+  ss << "\"num_unique\": " << num_unique() << ",";
   ss << "\"num_missing\": " << num_missing << ",";
   ss << "\"mean\": " << escape_float(m_average.emit()) << ",";
   ss << "\"min\": " << escape_float(m_min.emit()) << ",";
@@ -7,6 +7,8 @@
 #define __TC_HISTOGRAM
 
 #include <sframe/groupby_aggregate_operators.hpp>
+#include <sketches/hyperloglog.hpp>
+#include <unordered_set>
 #include <unity/lib/visualization/histogram.hpp>
 #include <unity/lib/visualization/plot.hpp>
 #include <unity/lib/visualization/vega_spec.hpp>
@@ -62,6 +64,9 @@ struct histogram_result : public sframe_transformation_output {
     histogram_result();
     flex_type_enum m_type;
     constexpr static size_t MAX_BINS = 1000;
+    // num_unique is exact up to this many distinct values (well above the
+    // 200 items a plot shows), and estimated beyond
+    constexpr static size_t MAX_EXACT_NUM_UNIQUE = 1000;
     std::array<flex_int, MAX_BINS> bins;
     flexible_type min;
     flexible_type max;
@@ -74,12 +79,19 @@ struct histogram_result : public sframe_transformation_output {
     flexible_type get_min_value() const;
     flexible_type get_max_value() const;
     void add_element_simple(const flexible_type& value); // updates the result w/ value
+    void combine_num_unique(const histogram_result& other);
+    size_t num_unique() const; // number of distinct values seen so far
     virtual std::string vega_column_data(bool) const override;
     virtual std::string vega_summary_data() const override;
 
     // also store and compute basic summary stats
     groupby_operators::count m_count; // num rows
-    groupby_operators::count_distinct m_count_distinct; // num unique
+    // num unique: the distinct values while there are at most
+    // MAX_EXACT_NUM_UNIQUE of them, and a sketch of constant size, which
+    // merges cheaply, for the estimate beyond
+    std::unordered_set<flexible_type> m_distinct_values;
+    bool m_many_distinct_values = false;
+    ::turi::sketches::hyperloglog m_count_distinct;
     groupby_operators::non_null_count m_non_null_count; // (inverse) num missing
     groupby_operators::average m_average; // mean
     groupby_operators::min m_min; // min
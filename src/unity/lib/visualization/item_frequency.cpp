@@ -6,6 +6,7 @@
 #include "item_frequency.hpp"
 #include "vega_spec.hpp"
 #include <string>
+#include <algorithm>
 
 using namespace turi::visualization;
 
@@ -27,7 +28,6 @@ void item_frequency_result::add_element_simple(const flexible_type& flex) {
    * add element to summary stats
    */
   m_count.add_element_simple(flex);
-  m_count_distinct.add_element_simple(flex);
   m_non_null_count.add_element_simple(flex);
 }
 
@@ -35,12 +35,15 @@ void item_frequency_result::combine(const group_aggregate_value& other) {
   groupby_operators::frequency_count::combine(other);
 
   /* combine summary stats */
-  auto item_frequency_other = dynamic_cast<const item_frequency_result&>(other);
+  const auto& item_frequency_other = dynamic_cast<const item_frequency_result&>(other);
   m_count.combine(item_frequency_other.m_count);
-  m_count_distinct.combine(item_frequency_other.m_count_distinct);
   m_non_null_count.combine(item_frequency_other.m_non_null_count);
 }
 
+size_t item_frequency_result::num_unique() const {
+  return m_values.size();
+}
+
 std::string item_frequency_result::vega_summary_data() const {
   std::stringstream ss;
 
@@ -48,7 +51,7 @@ std::string item_frequency_result::vega_summary_data() const {
   std::string data = vega_column_data(true);
 
   ss << "\"type\": \"str\",";
-  ss << "\"num_unique\": " << m_count_distinct.emit() << ",";
+  ss << "\"num_unique\": " << num_unique() << ",";
   ss << "\"num_missing\": " << num_missing << ",";
   ss << "\"categorical\": [" << data << "],";
   ss << "\"numeric\": []";
@@ -61,7 +64,14 @@ std::string item_frequency_result::vega_column_data(bool sframe) const {
   std::stringstream ss;
   size_t x = 0;
 
-  auto items_list = emit().get<flex_dict>();
+  // Only the most frequent items are shown, so select them in place rather
+  // than copying and sorting every item seen so far on each update.
+  typedef std::pair<const flexible_type, size_t> item_type;
+  std::vector<const item_type*> items_list;
+  items_list.reserve(m_values.size());
+  for (const auto& item : m_values) {
+    items_list.push_back(&item);
+  }
   size_t size_list;
 
   if(sframe){
@@ -70,30 +80,27 @@ std::string item_frequency_result::vega_column_data(bool sframe) const {
     size_list = std::min(200UL, items_list.size());
   }
 
-  std::sort(items_list.begin(), items_list.end(), [](const std::pair<turi::flexible_type,flexible_type> &left, const std::pair<turi::flexible_type,flexible_type> &right) {
-    DASSERT_EQ(left.second.get_type(), flex_type_enum::INTEGER);
-    DASSERT_EQ(right.second.get_type(), flex_type_enum::INTEGER);
-
-    if (left.second == right.second) {
+  std::partial_sort(items_list.begin(), items_list.begin() + size_list, items_list.end(), [](const item_type* left, const item_type* right) {
+    if (left->second == right->second) {
       // ignore undefined (always sort lower -- it'll get ignored later)
-      if (left.first.get_type() == flex_type_enum::UNDEFINED ||
-          right.first.get_type() == flex_type_enum::UNDEFINED) {
+      if (left->first.get_type() == flex_type_enum::UNDEFINED ||
+          right->first.get_type() == flex_type_enum::UNDEFINED) {
         return false;
       }
 
-      DASSERT_EQ(left.first.get_type(), flex_type_enum::STRING);
-      DASSERT_EQ(right.first.get_type(), flex_type_enum::STRING);
+      DASSERT_EQ(left->first.get_type(), flex_type_enum::STRING);
+      DASSERT_EQ(right->first.get_type(), flex_type_enum::STRING);
 
       // if count is equal, sort ascending by label
-      return right.first > left.first;
+      return right->first > left->first;
     }
     // sort descending by count
-    return left.second > right.second;
+    return left->second > right->second;
   });
 
   for(size_t i=0; i<size_list; i++) {
 
-    const auto& pair = items_list[i];
+    const auto& pair = *items_list[i];
     const auto& flex_value = pair.first;
     if (flex_value.get_type() == flex_type_enum::UNDEFINED) {
       // skip missing values for now
@@ -107,7 +114,7 @@ std::string item_frequency_result::vega_column_data(bool sframe) const {
     DASSERT_TRUE(flex_value.get_type() == flex_type_enum::STRING);
     const auto& value = flex_value.get<flex_string>();
 
-    size_t count = pair.second.get<flex_int>();
+    size_t count = pair.second;
 
     ss << "{\"label\": ";
 
@@ -152,9 +159,16 @@ namespace turi {
         item_frequency item_freq;
         item_freq.init(*self);
 
-        auto transformer = std::dynamic_pointer_cast<item_frequency_result>(item_freq.get());
-        auto result = transformer->emit().get<flex_dict>();
-        size_t length_list = std::min(200UL, result.size());
+        // The spec is sized by the number of items found in the first
+        // batches; since those start small, keep going until there are
+        // enough items, or as many rows as one full batch were seen.
+        std::shared_ptr<item_frequency_result> transformer;
+        do {
+          transformer = std::dynamic_pointer_cast<item_frequency_result>(item_freq.get());
+        } while (!item_freq.eof() &&
+                 transformer->num_unique() < 200 &&
+                 static_cast<size_t>(item_freq.get_rows_processed()) < item_freq.get_batch_size());
+        size_t length_list = std::min(200UL, transformer->num_unique());
         
         if (title.empty()) {
           title = std::string("Distribution of Values [");
@@ -24,10 +24,10 @@ class item_frequency_result: public sframe_transformation_output,
     virtual void combine(const group_aggregate_value& other) override;
     virtual std::string vega_column_data(bool sframe) const override;
     virtual std::string vega_summary_data() const override;
+    size_t num_unique() const; // number of distinct items seen so far
 
     // also store and compute basic summary stats
     groupby_operators::count m_count; // num rows
-    groupby_operators::count_distinct m_count_distinct; // num unique
     groupby_operators::non_null_count m_non_null_count; // (inverse) num missing
 };
 
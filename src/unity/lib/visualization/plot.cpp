@@ -21,17 +21,27 @@ namespace turi{
         process_wrapper ew(self->m_path_to_client);
         ew << self->m_vega_spec;
 
+        std::string last_data;
         while(ew.good()) {
-          vega_data vd;
+          std::string data = self->m_transformer->get()->vega_column_data();
+          bool eof = self->m_transformer->eof();
+
+          // only send updates that change what is shown (the final one is
+          // always sent, to complete the progress)
+          if (data == last_data && !eof) {
+            continue;
+          }
 
-          vd << self->m_transformer->get()->vega_column_data();
+          vega_data vd;
+          vd << data;
 
           double num_rows_processed =  static_cast<double>(self->m_transformer->get_rows_processed());
           double percent_complete = num_rows_processed/self->m_size_array;
 
           ew << vd.get_data_spec(percent_complete);
+          last_data = std::move(data);
 
-          if (self->m_transformer->eof()) {
+          if (eof) {
              break;
           }
         }
@@ -8,6 +8,7 @@
 
 #include <flexible_type/flexible_type.hpp>
 #include <parallel/lambda_omp.hpp>
+#include <unity/lib/visualization/visualization_constants.hpp>
 
 namespace turi {
 namespace visualization {
@@ -48,6 +49,7 @@ class transformation : public transformation_base {
     InputIterable m_source;
     std::shared_ptr<Output> m_transformer;
     size_t m_currentIdx = 0;
+    size_t m_currentBatchSize = 0;
     bool m_initialized = false;
 
   private:
@@ -79,6 +81,8 @@ class transformation : public transformation_base {
       m_source = source;
       m_transformer = std::make_shared<Output>();
       m_currentIdx = 0;
+      m_currentBatchSize = std::min(
+        std::max<size_t>(VISUALIZATION_INITIAL_BATCH_SIZE, 1), BATCH_SIZE);
       m_initialized = true;
     }
     virtual bool eof() const override {
@@ -101,7 +105,7 @@ class transformation : public transformation_base {
 
       const size_t num_threads_reported = thread_pool::get_instance().size();
       const size_t start = m_currentIdx;
-      const size_t input_size = std::min(BATCH_SIZE, m_source.size() - m_currentIdx);
+      const size_t input_size = std::min(m_currentBatchSize, m_source.size() - m_currentIdx);
       const size_t end = start + input_size;
       auto transformers = this->split_input(num_threads_reported);
       const auto& source = this->m_source;
@@ -131,9 +135,18 @@ class transformation : public transformation_base {
       this->merge_results(transformers);
       m_currentIdx = end;
 
+      // Start with small batches so the first result shows up quickly, then
+      // grow them so the per-batch overhead (splitting, merging and
+      // rendering) stays small relative to the rows processed.
+      m_currentBatchSize = std::min(
+        m_currentBatchSize * std::max<size_t>(VISUALIZATION_BATCH_GROWTH_FACTOR, 1),
+        BATCH_SIZE);
+
       return m_transformer;
     }
 
+    /* The maximum batch size. The first batches are smaller, see
+       VISUALIZATION_INITIAL_BATCH_SIZE. */
     virtual size_t get_batch_size() const override {
       return BATCH_SIZE;
     }
@@ -0,0 +1,25 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#include <unity/lib/visualization/visualization_constants.hpp>
+#include <globals/globals.hpp>
+#include <export.hpp>
+
+namespace turi {
+namespace visualization {
+
+EXPORT size_t VISUALIZATION_INITIAL_BATCH_SIZE = 10000;
+EXPORT size_t VISUALIZATION_BATCH_GROWTH_FACTOR = 4;
+
+REGISTER_GLOBAL_WITH_CHECKS(int64_t,
+                            VISUALIZATION_INITIAL_BATCH_SIZE,
+                            true,
+                            +[](int64_t val){ return val > 0; });
+REGISTER_GLOBAL_WITH_CHECKS(int64_t,
+                            VISUALIZATION_BATCH_GROWTH_FACTOR,
+                            true,
+                            +[](int64_t val){ return val >= 1; });
+
+}}
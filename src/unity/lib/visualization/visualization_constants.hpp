@@ -0,0 +1,30 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#ifndef _TC_VISUALIZATION_CONSTANTS
+#define _TC_VISUALIZATION_CONSTANTS
+
+#include <cstddef>
+
+namespace turi {
+namespace visualization {
+
+/**
+ * The number of rows processed by the first batch of a streaming
+ * visualization, so that a first result is shown quickly even for very
+ * large inputs.
+ */
+extern size_t VISUALIZATION_INITIAL_BATCH_SIZE;
+
+/**
+ * Every following batch of a streaming visualization processes this many
+ * times as many rows as the previous one, up to the maximum batch size of
+ * the transformation.
+ */
+extern size_t VISUALIZATION_BATCH_GROWTH_FACTOR;
+
+}}
+
+#endif // _TC_VISUALIZATION_CONSTANTS
@@ -56,6 +56,8 @@ cdef extern from "<unity/lib/unity_sframe.hpp>" namespace "turi":
         unity_sframe_base_ptr append(unity_sframe_base_ptr) except +
         void materialize() except +
         bint is_materialized() except +
+        bint is_fragmented() except +
+        void compact() except +
         bint has_size() except +
         string query_plan_string() except +
         unity_sframe_base_ptr join(unity_sframe_base_ptr, const string, map[string, string]) except +
@@ -137,6 +139,10 @@ cdef class UnitySFrameProxy:
 
     cpdef is_materialized(self)
 
+    cpdef is_fragmented(self)
+
+    cpdef compact(self)
+
     cpdef has_size(self)
 
     cpdef query_plan_string(self)
@@ -282,6 +282,12 @@ cdef class UnitySFrameProxy:
     cpdef is_materialized(self):
         return self.thisptr.is_materialized()
 
+    cpdef is_fragmented(self):
+        return self.thisptr.is_fragmented()
+
+    cpdef compact(self):
+        self.thisptr.compact()
+
     cpdef has_size(self):
         return self.thisptr.has_size()
 
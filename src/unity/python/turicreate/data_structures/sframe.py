@@ -3643,6 +3643,41 @@ class SFrame(object):
         """
         return self.__proxy__.is_materialized()
 
+    def is_fragmented(self):
+        """
+        Returns whether or not the SFrame is stored in many more segments, or
+        many more small blocks, than usual, as left behind by many appends.
+        A lazily evaluated SFrame is not fragmented.
+
+        See Also
+        --------
+        compact
+        """
+        with cython_context():
+            return self.__proxy__.is_fragmented()
+
+    def compact(self):
+        """
+        Materializes the SFrame, and rewrites it in fewer segments and larger
+        blocks if it is fragmented. This speeds up reading an SFrame built
+        by many appends. The SFrame is modified in place.
+
+        See Also
+        --------
+        is_fragmented
+
+        Examples
+        --------
+        >>> sf = turicreate.SFrame({'a': [1]})
+        >>> for i in range(1000):
+        ...     sf = sf.append(turicreate.SFrame({'a': [i]}))
+        >>> sf.compact()
+        >>> sf.is_fragmented()
+        False
+        """
+        with cython_context():
+            self.__proxy__.compact()
+
     def __has_size__(self):
         """
         Returns whether or not the size of the SFrame is known.
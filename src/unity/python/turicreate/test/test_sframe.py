@@ -3389,6 +3389,15 @@ class SFrameTest(unittest.TestCase):
         sf.materialize()
         self.assertTrue(sf.is_materialized())
 
+    def test_compact(self):
+        sf = SFrame({'a': [0]})
+        for i in range(1, 200):
+            sf = sf.append(SFrame({'a': [i]}))
+        sf.compact()
+        self.assertTrue(sf.is_materialized())
+        self.assertFalse(sf.is_fragmented())
+        self.assertEqual(list(sf['a']), list(range(200)))
+
     def test_materialization_slicing(self):
         # Has been known to fail.
         g=SFrame({'a':range(100)})[:10]
@@ -16,6 +16,13 @@ static const size_t USER_COLUMN_INDEX = 0;
  */
 static const size_t ITEM_COLUMN_INDEX = 1;
 
+/**
+ * The maximum number of bytes the binned roc_curve / auc accumulators
+ * (per class, per thread) may take before the factory switches to the
+ * exact, sort based evaluators.
+ */
+extern size_t EVALUATION_BINNED_ROC_MEMORY_LIMIT;
+
 } // namespace evaluation
 } // namespace turi
 #endif
@@ -8,7 +8,13 @@
 // Types
 #include <unity/lib/unity_sframe.hpp>
 #include <unity/lib/variant.hpp>
+#include <unity/toolkits/evaluation/evaluation_constants.hpp>
+#include <sframe_query_engine/algorithm/sort.hpp>
+#include <sframe_query_engine/operators/sframe_source.hpp>
 #include <unordered_map>
+#include <functional>
+#include <limits>
+#include <cmath>
 
 const double EVAL_ZERO = 1.0e-9;
 
@@ -1450,6 +1456,9 @@ class flexible_accuracy : public precision_recall_base {
  * - multiclass mode: In this mode, the inputs are (target_class, prob_vec)
  *   where prob_vec are the vector of probabilities. In this case, the 
  *   target_class must be integer 
+ *
+ * The accumulators take NUM_BINS counters per class per thread. For problems
+ * with many classes, see \ref exact_roc_curve.
  */
 class roc_curve: public supervised_evaluation_interface {
 
@@ -1948,6 +1957,455 @@ class auc: public roc_curve {
   }
 };
 
+/**
+ * Computes the exact ROC curve.
+ *
+ * Unlike \ref roc_curve, no binning is performed. Each (class, score, label)
+ * triple is appended to an SFrame (one segment per thread) as it is
+ * registered. When the metric is requested, the SFrame is sorted once by
+ * (class, score) using the external sort of the query engine, and the curve
+ * for every class is computed in a single sequential pass over the sorted
+ * rows.
+ *
+ * The memory used is proportional to the data (and spills to disk through the
+ * SFrame writers), and not to the number of bins x classes x threads. One
+ * point is emitted per distinct score, so the curve (and the AUC computed
+ * from it) is exact.
+ *
+ * The input modes are the same as those of \ref roc_curve.
+ */
+class exact_roc_curve: public supervised_evaluation_interface {
+
+  private:
+
+  // Accumulators
+  sframe scores;
+  std::vector<sframe::iterator> scores_out;
+  std::vector<std::vector<size_t>> num_examples;
+
+  protected:
+
+  // Options
+  average_type_enum average = average_type_enum::NONE;
+  bool binary = false;
+  size_t n_threads = 0;
+  size_t num_classes = 0;
+
+  // Input map.
+  std::unordered_map<flexible_type, size_t> index_map;
+
+  // Total counts
+  std::vector<size_t> total_examples;
+  size_t all_examples = 0;
+
+  public:
+
+  /**
+   * Constructor.
+   *
+   * \param[in] index_map Dictionary from flexible_type -> size_t for classes.
+   * \param[in] average   Averaging mode
+   * \param[in] binary    Is the input mode expected to be binary?
+   */
+  exact_roc_curve(
+      std::unordered_map<flexible_type, size_t> index_map =
+                  std::unordered_map<flexible_type, size_t>(),
+      flexible_type average = FLEX_UNDEFINED,
+      bool binary = true,
+      size_t num_classes = size_t(-1)) {
+    this->average = average_type_enum_from_name(average);
+    this->binary = binary;
+    this->index_map = index_map;
+    if (num_classes == size_t(-1)) {
+      this->num_classes = index_map.size();
+    } else {
+      this->num_classes = num_classes;
+    }
+  }
+
+  /**
+   * Name of the evaluator.
+   */
+  std::string name() const {
+    return (std::string)("roc_curve");
+  }
+
+  /**
+   * Returns true of this evaluator works on probabilities/scores (vs)
+   * classes.
+   */
+  bool is_prob_evaluator() const {
+    return true;
+  }
+
+  /**
+   * Returns true of this evaluator can be displayed as a single float value.
+   */
+  virtual bool is_table_printer_compatible() const {
+    return false;
+  }
+
+  /**
+   * Init the state with a variant type.
+   */
+  void init(size_t _n_threads = 1) {
+    DASSERT_TRUE(num_classes > 0);
+    DASSERT_LE(binary, num_classes == 2);
+
+    // Init the options.
+    n_threads = _n_threads;
+
+    // Initialize the accumulators. Any previously registered example
+    // is discarded.
+    scores_out.clear();
+    scores = sframe();
+    scores.open_for_write({"class", "score", "label"},
+                          {flex_type_enum::INTEGER,
+                           flex_type_enum::FLOAT,
+                           flex_type_enum::INTEGER},
+                          "", n_threads);
+    for (size_t i = 0; i < n_threads; i++) {
+      scores_out.push_back(scores.get_output_iterator(i));
+    }
+    num_examples.assign(n_threads, std::vector<size_t>(num_classes, 0));
+
+    // Initialize the aggregators.
+    total_examples.assign(num_classes, 0);
+    all_examples = 0;
+  };
+
+  /**
+   * Register a (target, prediction) pair
+   *
+   * \param[in] target     Target of a simple example.
+   * \param[in] prediction Prediction of a single example.
+   * \param[in] thread_id  Thread id
+   *
+   */
+  void register_example(const flexible_type& target,
+                        const flexible_type& prediction,
+                        size_t thread_id = 0){
+    DASSERT_LT(thread_id, n_threads);
+    DASSERT_LT(thread_id, scores_out.size());
+    check_undefined(prediction);
+    DASSERT_EQ(binary, (prediction.get_type() == flex_type_enum::FLOAT) ||
+                       (prediction.get_type() == flex_type_enum::INTEGER));
+    DASSERT_EQ(!binary, prediction.get_type() == flex_type_enum::VECTOR);
+
+    // The index for this target. Skip the example if it doesn't exist!
+    size_t idx = 0;
+    auto it = index_map.find(target);
+    if (it == index_map.end()) {
+      return;
+    } else {
+      idx = size_t(it->second);
+    }
+    DASSERT_LT(idx, index_map.size());
+
+    auto& out = scores_out[thread_id];
+    std::vector<flexible_type> row(3);
+
+    // Binary mode: only the curve of the positive class is reported.
+    if (binary) {
+      DASSERT_EQ(num_classes, 2);
+      double pred = prediction.to<double>();
+      check_probability_range(pred);
+
+      row[0] = 1;
+      row[1] = pred;
+      row[2] = (idx == 1);
+      *out = row;
+      ++out;
+      num_examples[thread_id][idx]++;
+
+    // Multi-class mode.
+    } else {
+
+      // Error out!
+      if(prediction.size() != num_classes) {
+        std::stringstream ss;
+        ss << "Size of prediction probability vector"
+           << "(" << prediction.size() << ") != number of classes"
+           << "(" << num_classes << ")." << std::endl;
+        log_and_throw(ss.str());
+      }
+
+      // Data point in the test set but not in the training set. Skip.
+      if (idx >= prediction.size()) {
+        return;
+      }
+
+      for (size_t i = 0; i < prediction.size(); i++) {
+        check_probability_range(prediction[i]);
+        row[0] = i;
+        row[1] = prediction[i];
+        row[2] = (i == idx);
+        *out = row;
+        ++out;
+      }
+      num_examples[thread_id][idx]++;
+    }
+  }
+
+  /**
+   * Gather the per-class example counts.
+   */
+  void gather_global_metrics() {
+    total_examples.assign(num_classes, 0);
+    all_examples = 0;
+    for (size_t i = 0; i < n_threads; ++i) {
+      for (size_t c = 0; c < num_classes; c++) {
+        total_examples[c] += num_examples[i][c];
+        all_examples += num_examples[i][c];
+      }
+    }
+  }
+
+  /**
+   * Sort the registered scores by (class, score) and make a single pass
+   * over them. For every class, point_fn(c, threshold, tp, fp) is called
+   * once for every distinct score in increasing order, where tp and fp are
+   * the number of positive and negative examples with a score >= threshold.
+   * A final point with tp = fp = 0 is emitted at a threshold above the
+   * largest score.
+   */
+  void scan_sorted_scores(
+      const std::function<void(size_t, double, size_t, size_t)>& point_fn) {
+    if (scores.is_opened_for_write()) {
+      scores.close();
+    }
+    if (scores.size() == 0) return;
+
+    std::shared_ptr<sframe> sorted = query_eval::sort(
+        query_eval::op_sframe_source::make_planner_node(scores),
+        scores.column_names(), {0, 1}, {true, true});
+
+    auto reader = sorted->get_reader();
+    std::vector<std::vector<flexible_type>> rows;
+
+    size_t cur_class = size_t(-1);
+    double cur_score = 0;
+    size_t pos_below = 0, neg_below = 0;
+
+    auto finish_class = [&]() {
+      if (cur_class == size_t(-1)) return;
+      double threshold = (cur_score < 1.0) ? 1.0 :
+          std::nextafter(cur_score, std::numeric_limits<double>::infinity());
+      point_fn(cur_class, threshold, 0, 0);
+    };
+
+    const size_t block_size = 5000;
+    for (size_t row_start = 0; row_start < sorted->size();
+         row_start += block_size) {
+      reader->read_rows(row_start, row_start + block_size, rows);
+      for (const auto& row : rows) {
+        size_t c = row[0].get<flex_int>();
+        double score = row[1].get<flex_float>();
+        bool positive = row[2].get<flex_int>() != 0;
+        DASSERT_LT(c, num_classes);
+
+        if (c != cur_class) {
+          finish_class();
+          cur_class = c;
+          pos_below = neg_below = 0;
+          point_fn(c, score, total_examples[c],
+                   all_examples - total_examples[c]);
+        } else if (score != cur_score) {
+          point_fn(c, score, total_examples[c] - pos_below,
+                   all_examples - total_examples[c] - neg_below);
+        }
+        cur_score = score;
+        if (positive) {
+          ++pos_below;
+        } else {
+          ++neg_below;
+        }
+      }
+    }
+    finish_class();
+  }
+
+  /**
+   * Return the final metric.
+   */
+  virtual variant_type get_metric() {
+
+    this->gather_global_metrics();
+
+    std::map<size_t, flexible_type> inv_map;
+    for (const auto& kvp: index_map) {
+      inv_map[kvp.second] = kvp.first;
+    }
+
+    // Columns in the SFrame.
+    sframe ret;
+    std::vector<std::string> col_names {"threshold", "fpr", "tpr", "p", "n"};
+    std::vector<flex_type_enum> col_types {flex_type_enum::FLOAT,
+                                           flex_type_enum::FLOAT,
+                                           flex_type_enum::FLOAT,
+                                           flex_type_enum::INTEGER,
+                                           flex_type_enum::INTEGER};
+
+    // Not binary, add class to it!
+    if (num_classes != 2) {
+      DASSERT_TRUE(average == average_type_enum::NONE ||
+                   average == average_type_enum::DEFAULT);
+      DASSERT_TRUE(inv_map.size() > 0);
+      col_names.push_back("class");
+      col_types.push_back(inv_map.begin()->second.get_type());
+    }
+
+    ret.open_for_write(col_names, col_types, "", 1);
+    auto it_out = ret.get_output_iterator(0);
+    std::vector<flexible_type> out_v;
+
+    size_t _num_classes = num_classes;
+    const std::vector<size_t>& _total_examples = total_examples;
+    size_t _all_examples = all_examples;
+    scan_sorted_scores([&](size_t c, double threshold, size_t tp, size_t fp) {
+      // In binary mode, only the positive class is registered.
+      size_t p = _total_examples[c];
+      size_t n = _all_examples - p;
+      out_v = {threshold, (1.0 * fp) / n, (1.0 * tp) / p, p, n};
+      if (_num_classes != 2) {
+        out_v.push_back(inv_map.at(c));
+      }
+      *it_out = out_v;
+      ++it_out;
+    });
+    ret.close();
+
+    // Convert to variant type.
+    std::shared_ptr<unity_sframe> tmp = std::make_shared<unity_sframe>();
+    tmp->construct_from_sframe(ret);
+    return to_variant<std::shared_ptr<unity_sframe>>(tmp);
+  }
+};
+
+
+/*
+ * Compute the exact Area Under the Curve (AUC) using the trapezoidal rule
+ * over the points of \ref exact_roc_curve.
+ */
+class exact_auc: public exact_roc_curve {
+
+  public:
+
+  /**
+   * Constructor.
+   *
+   * \param[in] index_map Dictionary from flexible_type -> size_t for classes.
+   * \param[in] average   Averaging mode
+   * \param[in] binary    Is the input mode expected to be binary?
+   */
+  exact_auc(
+      std::unordered_map<flexible_type, size_t> index_map =
+                  std::unordered_map<flexible_type, size_t>(),
+      flexible_type average = "micro",
+      bool binary = true,
+      size_t num_classes = size_t(-1)) {
+    this->average = average_type_enum_from_name(average);
+    this->binary = binary;
+    this->index_map = index_map;
+    if (num_classes == size_t(-1)) {
+      this->num_classes = index_map.size();
+    } else {
+      this->num_classes = num_classes;
+    }
+  }
+
+  /*
+   * Name of the evaluator.
+   */
+  std::string name() const {
+    return (std::string)("auc");
+  }
+
+  /**
+   * Returns true of this evaluator can be displayed as a single float value.
+   */
+  virtual bool is_table_printer_compatible() const {
+    return average != average_type_enum::NONE;
+  }
+
+  /**
+   * Return the final metric.
+   */
+  variant_type get_metric() {
+
+    this->gather_global_metrics();
+
+    // Integrate every class curve as the points stream by. Thresholds
+    // increase, so the fpr decreases from one point to the next.
+    std::vector<double> auc_score(num_classes, 0);
+    std::vector<double> last_fpr(num_classes, 0);
+    std::vector<double> last_tpr(num_classes, 0);
+    std::vector<bool> started(num_classes, false);
+
+    const std::vector<size_t>& _total_examples = total_examples;
+    size_t _all_examples = all_examples;
+    scan_sorted_scores([&](size_t c, double, size_t tp, size_t fp) {
+      double fpr = (1.0 * fp) / (_all_examples - _total_examples[c]);
+      double tpr = (1.0 * tp) / _total_examples[c];
+      if (started[c]) {
+        auc_score[c] += 0.5 * (last_tpr[c] + tpr) * (last_fpr[c] - fpr);
+      }
+      started[c] = true;
+      last_fpr[c] = fpr;
+      last_tpr[c] = tpr;
+    });
+
+    // Compute the integral with respect to ROC-1
+    if (num_classes == 2) {
+      return to_variant(auc_score[1]);
+    }
+
+    switch(average) {
+
+      // Score for each class.
+      case average_type_enum::NONE:
+      {
+
+        // Create an inverse map.
+        std::map<size_t, flexible_type> inv_map;
+        for (const auto& kvp: index_map) {
+          inv_map[kvp.second] = kvp.first;
+        }
+
+        std::unordered_map<flexible_type, double> ret;
+        for (size_t c = 0; c < num_classes; c++) {
+          ret[inv_map[c]] = auc_score[c];
+        }
+        return to_variant(ret);
+      }
+
+      case average_type_enum::DEFAULT:
+      case average_type_enum::MACRO:
+      {
+        double ret = 0;
+        for (size_t c = 0; c < num_classes; c++) {
+          ret += auc_score[c];
+        }
+        return to_variant(ret / num_classes);
+      }
+
+      default:
+        DASSERT_TRUE(false);
+    }
+    DASSERT_TRUE(false);
+  }
+};
+
+/**
+ * Returns true if the binned \ref roc_curve accumulators for this problem
+ * would exceed EVALUATION_BINNED_ROC_MEMORY_LIMIT, in which case the exact
+ * (sort based) evaluators are used instead.
+ */
+inline bool use_exact_roc_evaluator(size_t num_classes, size_t n_threads) {
+  double binned_bytes = 2.0 * sizeof(size_t) * 1e5 * num_classes * n_threads;
+  return binned_bytes > (double)EVALUATION_BINNED_ROC_MEMORY_LIMIT;
+}
+
 /*
  * Factory method to get the set of evaluation metrics.
  * \param[in] metric Name of the metric
@@ -2026,8 +2484,15 @@ inline std::shared_ptr<supervised_evaluation_interface> get_evaluator_metric(
     if (kwargs.count("num_classes") > 0) {
       num_classes = variant_get_value<size_t>(kwargs.at("num_classes"));
     }
-    evaluator = std::make_shared<roc_curve>(
-                    roc_curve(index_map, average, binary, num_classes));
+    if (use_exact_roc_evaluator(
+          num_classes == size_t(-1) ? index_map.size() : num_classes,
+          turi::thread::cpu_count())) {
+      evaluator = std::make_shared<exact_roc_curve>(
+                      exact_roc_curve(index_map, average, binary, num_classes));
+    } else {
+      evaluator = std::make_shared<roc_curve>(
+                      roc_curve(index_map, average, binary, num_classes));
+    }
 
   } else if(metric == "auc"){
     DASSERT_TRUE(kwargs.count("average") > 0);
@@ -2041,8 +2506,35 @@ inline std::shared_ptr<supervised_evaluation_interface> get_evaluator_metric(
     if (kwargs.count("num_classes") > 0) {
       num_classes = variant_get_value<size_t>(kwargs.at("num_classes"));
     }
-    evaluator = std::make_shared<auc>(auc(index_map, average, binary, num_classes));
+    if (use_exact_roc_evaluator(
+          num_classes == size_t(-1) ? index_map.size() : num_classes,
+          turi::thread::cpu_count())) {
+      evaluator = std::make_shared<exact_auc>(
+                      exact_auc(index_map, average, binary, num_classes));
+    } else {
+      evaluator = std::make_shared<auc>(auc(index_map, average, binary, num_classes));
+    }
   
+  } else if((metric == "exact_roc_curve") || (metric == "exact_auc")){
+    DASSERT_TRUE(kwargs.count("average") > 0);
+    DASSERT_TRUE(kwargs.count("binary") > 0);
+    DASSERT_TRUE(kwargs.count("index_map") > 0);
+    auto average = variant_get_value<flexible_type>(kwargs.at("average"));
+    auto binary = variant_get_value<bool>(kwargs.at("binary"));
+    auto index_map = variant_get_value<
+       std::unordered_map<flexible_type, size_t>>(kwargs.at("index_map"));
+    size_t num_classes = size_t(-1);
+    if (kwargs.count("num_classes") > 0) {
+      num_classes = variant_get_value<size_t>(kwargs.at("num_classes"));
+    }
+    if (metric == "exact_roc_curve") {
+      evaluator = std::make_shared<exact_roc_curve>(
+                      exact_roc_curve(index_map, average, binary, num_classes));
+    } else {
+      evaluator = std::make_shared<exact_auc>(
+                      exact_auc(index_map, average, binary, num_classes));
+    }
+
   } else if(metric == "flexible_accuracy"){
     DASSERT_TRUE(kwargs.count("average") > 0);
     auto average = variant_get_value<flexible_type>(kwargs.at("average"));
@@ -18,6 +18,8 @@
 #include <unity/toolkits/evaluation/evaluation_constants.hpp>
 #include <unity/toolkits/evaluation/metrics.hpp>
 
+#include <globals/globals.hpp>
+
 #include <map>
 #include <algorithm>
 
@@ -25,6 +27,10 @@
 namespace turi {
 namespace evaluation {
 
+size_t EVALUATION_BINNED_ROC_MEMORY_LIMIT = 1024LL * 1024 * 1024;
+
+REGISTER_GLOBAL(int64_t, EVALUATION_BINNED_ROC_MEMORY_LIMIT, true);
+
 /*
  * Utility function to get the index map for an SArray. 
  * \param[in] targets      SArray of ground-truth
@@ -86,6 +92,7 @@ variant_type _supervised_streaming_evaluator(
     opts[kvp.first] = to_variant(kvp.second);
   } 
   if ((metric == "auc") || (metric == "roc_curve") || 
+      (metric == "exact_auc") || (metric == "exact_roc_curve") ||
       (metric == "binary_logloss") || (metric == "multiclass_logloss")) {
     opts["index_map"] =  to_variant(
         get_index_map(unity_targets, unity_predictions));
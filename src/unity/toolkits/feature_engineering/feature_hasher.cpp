@@ -16,31 +16,117 @@ namespace feature_engineering {
 
 
 /**
- * Hashes key and inserts value. In case of collisions, there is a secondary
- * hash which determines if values should be added or subtracted. This builds
- * an unbiased approximation to the value
+ * Accumulates the hashed features of a row.
+ *
+ * The (index, value) pairs are appended to a flat buffer which a thread
+ * reuses across rows, and merged by a stable sort on the index when the row
+ * is done, so no tree node is allocated per feature.
  */
-void insert_into_map(uint128_t combined_key_name, size_t num_bits,
-      const flexible_type& value, std::map<size_t, flexible_type>& hashed_map){
+class hashed_feature_accumulator {
+ public:
+  void clear() { entries.clear(); }
+
+  /**
+   * Hashes key and inserts value. In case of collisions, there is a secondary
+   * hash which determines if values should be added or subtracted. This builds
+   * an unbiased approximation to the value
+   */
+  void insert(uint128_t combined_key_name, size_t num_bits,
+              const flexible_type& value) {
+    // Random large prime number
+    uint128_t combine_seed = 32416190071LL;
+
+    // Decides whether collision values are added or subtracted
+    bool sign = (hash128_combine(combined_key_name, combine_seed) % 2);
+    uint128_t final_key = combined_key_name & ( (1 << num_bits) - 1);
+
+    entry e;
+    e.index = (size_t)final_key;
+    e.value = sign ? -(flex_float) value : (flex_float) value;
+    e.is_float = (value.get_type() == flex_type_enum::FLOAT);
+    entries.push_back(e);
+  }
 
-  // Random large prime number
-  uint128_t combine_seed = 32416190071LL;
-  flex_type_enum value_type = value.get_type();
+  /**
+   * Returns the accumulated features as a dictionary sorted by index, and
+   * clears the accumulator.
+   */
+  flex_dict finalize() {
+    std::stable_sort(entries.begin(), entries.end(),
+                     [](const entry& a, const entry& b) { return a.index < b.index; });
+
+    flex_dict ret;
+    for (size_t i = 0; i < entries.size();) {
+      size_t index = entries[i].index;
+
+      // Sums are integers until a float value is added, as with
+      // flexible_type arithmetic.
+      bool is_float = false;
+      flex_int int_sum = 0;
+      flex_float float_sum = 0;
+      for (; i < entries.size() && entries[i].index == index; ++i) {
+        if (entries[i].is_float && !is_float) {
+          is_float = true;
+          float_sum = int_sum;
+        }
+        if (is_float) {
+          float_sum += entries[i].value;
+        } else {
+          int_sum += entries[i].value;
+        }
+      }
+      ret.push_back({flexible_type(index),
+                     is_float ? flexible_type(float_sum) : flexible_type(int_sum)});
+    }
+    entries.clear();
+    return ret;
+  }
 
-  // Decides whether collision values are added or subtracted
-  bool sign = (hash128_combine(combined_key_name, combine_seed) % 2);
-  uint128_t final_key = combined_key_name & ( (1 << num_bits) - 1);
+ private:
+  struct entry {
+    size_t index;
+    double value;
+    bool is_float;
+  };
+  std::vector<entry> entries;
+};
 
-  // For floats, flex_type will cast to the left value, so we have to
-  // cast to a float before we do any adding.
-  if (value_type == flex_type_enum::FLOAT){
-    hashed_map[final_key] = (flex_float) hashed_map[final_key];
-  }
-  // Add or subtract hashes.
-  if (sign){
-     hashed_map[final_key] -= (flex_float) value;
-  } else {
-     hashed_map[final_key] += (flex_float) value;
+/**
+ * Calls fn(key, value) for every (key, value) pair of the dictionary view of
+ * a feature column value (see transform_utils::flexible_type_to_flex_dict),
+ * without building the dictionary.
+ */
+template <typename Fn>
+static void for_each_feature(const flexible_type& in, Fn&& fn) {
+  switch (in.get_type()) {
+    case flex_type_enum::DICT: {
+      for (const auto& kv : in.get<flex_dict>()) fn(kv.first, kv.second);
+      break;
+    }
+    case flex_type_enum::UNDEFINED: {
+      fn(flexible_type(0), in);
+      break;
+    }
+    case flex_type_enum::STRING: {
+      fn(in, flexible_type(1));
+      break;
+    }
+    case flex_type_enum::LIST: {
+      const flex_list& list = in.get<flex_list>();
+      for (size_t i = 0; i < list.size(); i++) fn(flexible_type(i), list[i]);
+      break;
+    }
+    case flex_type_enum::VECTOR: {
+      const flex_vec& vec = in.get<flex_vec>();
+      for (size_t i = 0; i < vec.size(); i++) fn(flexible_type(i), flexible_type(vec[i]));
+      break;
+    }
+    default: {
+      if (transform_utils::is_numeric_type(in.get_type())) {
+        fn(flexible_type(0), in);
+      }
+      break;
+    }
   }
 }
 
@@ -51,31 +137,28 @@ void insert_into_map(uint128_t combined_key_name, size_t num_bits,
 flex_dict hash_apply(const sframe_rows::row& row,
                     const std::vector<uint128_t> hashed_names, size_t num_bits){
 
-  std::map<size_t,flexible_type> hashed_map;
-  flex_dict ret;
+  static thread_local hashed_feature_accumulator accumulator;
+  accumulator.clear();
   for (size_t i = 0; i < row.size(); ++i){
-    flex_dict dict_to_hash = transform_utils::flexible_type_to_flex_dict(row[i]);
-    for (auto& k : dict_to_hash){
+    for_each_feature(row[i], [&](const flexible_type& key, const flexible_type& value) {
       // Combine the hash value.
-      hash_value hashed_key(k.first);
+      hash_value hashed_key(key);
       uint128_t combined_key_name = hash128_combine(
                                     hashed_key.hash(), hashed_names[i]);
       // Hash numerics.
-      if (transform_utils::is_numeric_type(k.second.get_type())){
-        hash_value hashed_key(k.first);
-        insert_into_map(combined_key_name, num_bits, k.second, hashed_map);
+      if (transform_utils::is_numeric_type(value.get_type())){
+        accumulator.insert(combined_key_name, num_bits, value);
 
       // Add categorical hashes for non-numerics.
       } else {
-        hash_value hashed_value(k.second);
+        hash_value hashed_value(value);
         uint128_t super_key = hash128_combine(
                      combined_key_name, hashed_value.hash());
-        insert_into_map(super_key, num_bits, 1, hashed_map);
+        accumulator.insert(super_key, num_bits, 1);
       }
-    }
+    });
   }
-  std::copy(hashed_map.begin(), hashed_map.end(), inserter(ret , ret.begin()));
-  return ret;
+  return accumulator.finalize();
 }
 
 /**
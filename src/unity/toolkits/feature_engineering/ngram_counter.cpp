@@ -5,6 +5,7 @@
  */
 #include <unity/lib/toolkit_class_macros.hpp>
 #include <unity/lib/variant_deep_serialize.hpp>
+#include <unity/lib/delimiter_tokenizer.hpp>
 #include <unity/toolkits/feature_engineering/ngram_counter.hpp>
 #include <logger/assertions.hpp>
 
@@ -58,6 +59,7 @@ void update_ngram_dictionary(std::unordered_map<flex_string, flexible_type>& ngr
  * \param[in] input           A flexible_type input of type str, dict, or list
  * \param[in] n               An integer specifying the size of the ngram
  * \param[in] string_filter   A list of regex-condition pairs for tokenizing the string
+ * \param[in] tokenizer       If not null, tokenizes the string instead of string_filter
  * \param[in] to_lower        A boolean indicating whether or not to convert strings to lower case
  *
  * \returns  output bag-of-ngrams sparse dictionary flexible_type.
@@ -66,6 +68,7 @@ void update_ngram_dictionary(std::unordered_map<flex_string, flexible_type>& ngr
 flexible_type word_ngram_counter_apply(const flexible_type& input,
                                        const size_t n,
                                        const transform_utils::string_filter_list& string_filters,
+                                       const delimiter_tokenizer* tokenizer,
                                        const bool to_lower) {
   flex_type_enum run_mode = input.get_type();
   DASSERT_TRUE(run_mode == flex_type_enum::STRING
@@ -85,7 +88,7 @@ flexible_type word_ngram_counter_apply(const flexible_type& input,
     }
 
     case flex_type_enum::STRING: {
-      flex_list tokens_list = transform_utils::tokenize_string(input, string_filters, to_lower);
+      flex_list tokens_list = transform_utils::tokenize_string(input.get<flex_string>(), tokenizer, string_filters, to_lower);
 
       update_ngram_dictionary(ret_count, tokens_list, n, 1);
 
@@ -104,7 +107,7 @@ flexible_type word_ngram_counter_apply(const flexible_type& input,
             && kvp.second.get_type() != flex_type_enum::FLOAT)
           log_and_throw("Invalid type. Dictionary input to NGramCounter must have integer or float values.");
 
-        flex_list tokens_list = transform_utils::tokenize_string(kvp.first.get<flex_string>(), string_filters, to_lower);
+        flex_list tokens_list = transform_utils::tokenize_string(kvp.first.get<flex_string>(), tokenizer, string_filters, to_lower);
 
         update_ngram_dictionary(ret_count, tokens_list, n, kvp.second);
       }
@@ -121,7 +124,7 @@ flexible_type word_ngram_counter_apply(const flexible_type& input,
         if (elem.get_type() != flex_type_enum::STRING)
           log_and_throw("Invalid type. List input to NGramCounter must contain only strings.");          
 
-        flex_list tokens_list = transform_utils::tokenize_string(elem.get<flex_string>(), string_filters, to_lower);
+        flex_list tokens_list = transform_utils::tokenize_string(elem.get<flex_string>(), tokenizer, string_filters, to_lower);
 
         update_ngram_dictionary(ret_count, tokens_list, n, 1);
       }
@@ -412,6 +415,7 @@ void ngram_counter::set_string_filters(){
 
   if (delimiters.get_type() == flex_type_enum::UNDEFINED) {  // Use Penn treebank-style tokenization
     string_filters = transform_utils::ptb_filters;
+    custom_tokenizer.reset();
     return;
   }
   
@@ -422,20 +426,14 @@ void ngram_counter::set_string_filters(){
 
   // Tokenize using custom delimiters list
   flex_list delimiter_list = delimiters.get<flex_list>();
-  std::string all_delims = "";
   for (auto elem = delimiter_list.begin(); elem != delimiter_list.end(); ++elem) {
     if (elem->get_type() != flex_type_enum::STRING)
       log_and_throw("Invalid type. NGramCounter delimiters must be strings.");
-    
-    all_delims += elem->get<flex_string>().substr(0,1);
   }
 
-  string_filters = transform_utils::string_filter_list({
-    std::make_pair(
-      boost::regex(std::string("([^" + all_delims + "]+)")),   // a token is any word that does not containing a delimiter
-      [](const std::string& current){return true;}
-      )
-  });
+  // A token is any word that does not contain a delimiter.
+  string_filters.clear();
+  custom_tokenizer.reset(new delimiter_tokenizer(delimiter_list));
 }
 
 /**
@@ -552,14 +550,15 @@ gl_sframe ngram_counter::transform(gl_sframe data){
 
     std::function<flexible_type(const flexible_type&)> transformfn;
     transform_utils::string_filter_list m_string_filters = string_filters;
+    std::shared_ptr<delimiter_tokenizer> m_tokenizer = custom_tokenizer;
     bool m_to_lower = to_lower;
     bool m_ignore_punct = ignore_punct;
     bool m_ignore_space = ignore_space;
     size_t m_n = n;
 
     if (ngram_type == "word") {
-      transformfn = [m_n, m_string_filters, m_to_lower](const flexible_type& x){
-        return word_ngram_counter_apply(x, m_n, m_string_filters, m_to_lower);
+      transformfn = [m_n, m_string_filters, m_tokenizer, m_to_lower](const flexible_type& x){
+        return word_ngram_counter_apply(x, m_n, m_string_filters, m_tokenizer.get(), m_to_lower);
       };
     }
     else {
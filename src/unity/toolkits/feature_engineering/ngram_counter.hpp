@@ -31,6 +31,7 @@ class EXPORT ngram_counter: public transformer_base {
 
   private:
   transform_utils::string_filter_list string_filters;
+  std::shared_ptr<delimiter_tokenizer> custom_tokenizer;  // Set if delimiters are given.
 
   void set_string_filters();
   
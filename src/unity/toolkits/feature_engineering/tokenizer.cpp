@@ -4,6 +4,7 @@
  * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
  */
 #include <unity/lib/variant_deep_serialize.hpp>
+#include <unity/lib/delimiter_tokenizer.hpp>
 #include <unity/lib/toolkit_class_macros.hpp>
 #include <unity/toolkits/feature_engineering/tokenizer.hpp>
 #include <unity/toolkits/feature_engineering/transform_utils.hpp>
@@ -137,26 +138,21 @@ void tokenizer::set_string_filters(){
   switch (delimiters.get_type()) {
     case flex_type_enum::UNDEFINED: {  // Use Penn treebank-style tokenization
       string_filters = transform_utils::ptb_filters;
+      custom_tokenizer.reset();
       break;
     }
     
     case flex_type_enum::LIST: {
       // Tokenize using custom delimiters list
       flex_list delimiter_list = delimiters.get<flex_list>();
-      std::string all_delims = "";
       for (auto elem = delimiter_list.begin(); elem != delimiter_list.end(); ++elem) {
         if (elem->get_type() != flex_type_enum::STRING)
           log_and_throw("Invalid type. Tokenizer delimiters must be strings.");
-        
-        all_delims += elem->get<flex_string>().substr(0,1);
       }
 
-      string_filters = transform_utils::string_filter_list({
-        std::make_pair(
-          boost::regex(std::string("([^" + all_delims + "]+)")),   // a token is any word that does not containing a delimiter
-          [](const std::string& current){return true;}
-          )
-      });
+      // A token is any word that does not contain a delimiter.
+      string_filters.clear();
+      custom_tokenizer.reset(new delimiter_tokenizer(delimiter_list));
       break;
     }
 
@@ -241,9 +237,11 @@ gl_sframe tokenizer::transform(gl_sframe data){
     flex_string output_column_name = output_column_prefix + f;
 
     transform_utils::string_filter_list m_string_filters = string_filters;
+    std::shared_ptr<delimiter_tokenizer> m_tokenizer = custom_tokenizer;
     bool m_to_lower = to_lower;
-    auto transformfn = [m_string_filters, m_to_lower](const flexible_type& x){
-      return transform_utils::tokenize_string(x, m_string_filters, m_to_lower);
+    auto transformfn = [m_string_filters, m_tokenizer, m_to_lower](const flexible_type& x){
+      return transform_utils::tokenize_string(
+          x.get<flex_string>(), m_tokenizer.get(), m_string_filters, m_to_lower);
     };
 
     // Error checking mode.
@@ -27,6 +27,7 @@ class EXPORT tokenizer: public transformer_base {
 
   private:
   transform_utils::string_filter_list string_filters;
+  std::shared_ptr<delimiter_tokenizer> custom_tokenizer;  // Set if delimiters are given.
 
   void set_string_filters();
 
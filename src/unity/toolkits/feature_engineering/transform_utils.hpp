@@ -14,6 +14,7 @@
 
 #include <unity/lib/gl_sframe.hpp>
 #include <unity/lib/gl_sarray.hpp>
+#include <unity/lib/delimiter_tokenizer.hpp>
 
 #include <unity/toolkits/feature_engineering/topk_indexer.hpp>
 #include <unity/toolkits/feature_engineering/statistics_tracker.hpp>
@@ -813,6 +814,21 @@ inline flex_list tokenize_string(const std::string& to_tokenize,
   return previous;
 }
 
+/**
+ * Tokenizes the input string with the delimiter tokenizer if one is given
+ * (a transformer with a custom delimiter list), and with the filter list
+ * otherwise.
+ */
+inline flex_list tokenize_string(const std::string& to_tokenize,
+                                 const delimiter_tokenizer* tokenizer,
+                                 const string_filter_list& filter_list,
+                                 const bool to_lower) {
+  if (tokenizer != nullptr) {
+    return tokenize_to_list(*tokenizer, to_tokenize, to_lower);
+  }
+  return tokenize_string(to_tokenize, filter_list, to_lower);
+}
+
 
 }// transform_utils
 }//turicreate
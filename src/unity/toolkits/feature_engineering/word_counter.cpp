@@ -5,6 +5,7 @@
  */
 #include <unity/lib/toolkit_class_macros.hpp>
 #include <unity/lib/variant_deep_serialize.hpp>
+#include <unity/lib/delimiter_tokenizer.hpp>
 #include <unity/toolkits/feature_engineering/word_counter.hpp>
 #include <logger/assertions.hpp>
 
@@ -14,72 +15,6 @@ namespace turi {
 namespace sdk_model {
 namespace feature_engineering {
 
-/**
- * Ported from original count_words implementation.
- */
-void word_count_delimiters_update(flexible_type f, flex_list delimiter_list, bool to_lower,
-                                           std::unordered_map<flexible_type, size_t>& ret_count) {
-
-
-  std::set<char> delimiters;
-  for (auto it = delimiter_list.begin(); it != delimiter_list.end(); ++it) {
-    // iterate through flexible_types storing the delimiters
-    // cast each to a string and take first char in string
-    // insert into std::set for quicker look-ups than turi::flex_list
-    delimiters.insert(it->to<std::string>().at(0));
-  }
-
-  auto is_delimiter = [delimiters](const char c)->bool {
-    return delimiters.find(c) != delimiters.end();
-  };
-
-  flex_dict ret;
-  const std::string& str = f.get<flex_string>();
-
-  // Tokenizing the string by space, and add to mape
-  // Here we optimize for speed to reduce the string malloc
-  size_t word_begin = 0;
-  // skip leading delimiters
-  while (word_begin < str.size() && (is_delimiter(str[word_begin])))
-    ++word_begin;
-
-  std::string word;
-  flexible_type word_flex;
-
-  for (size_t i = word_begin; i < str.size(); ++i) {
-    if (is_delimiter(str[i])) {
-      // find the end of thw word, make a substring, and transform to lower case
-      word = std::string(str, word_begin, i - word_begin);
-      if  (to_lower)
-        std::transform(word.begin(), word.end(), word.begin(), ::tolower);
-      word_flex = std::move(word);
-
-      // add the word to map
-      ret_count[word_flex]++;
-
-      // keep skipping delimiters, and reset word_begin
-      while (i < str.size() && (is_delimiter(str[i])))
-        ++i;
-      word_begin = i;
-    }
-  }
-
-  // add the last word
-  if (word_begin < str.size()) {
-    word = std::string(str, word_begin, str.size() - word_begin);
-    if  (to_lower)
-      std::transform(word.begin(), word.end(), word.begin(), ::tolower);
-    word_flex = std::move(word);
-    ret_count[word_flex]++;
-  }
-
-  // convert to dictionary
-  for(auto& val : ret_count) {
-    ret.push_back({val.first, flexible_type(val.second)});
-  }
-}
-
-
 /**
  * For a given flexible_type input, create a bag-of-words representation.
  * Handle undefined, strings, lists, and dict.
@@ -92,7 +27,7 @@ void word_count_delimiters_update(flexible_type f, flex_list delimiter_list, boo
  * Returns a dict of {token: count[token]}.
  */
 flexible_type word_counter_apply_with_manual(const flexible_type& input,
-                                             flex_list delimiter_list,
+                                             const delimiter_tokenizer& tokenizer,
                                              bool to_lower) {
   flex_type_enum run_mode = input.get_type();
   DASSERT_TRUE(run_mode == flex_type_enum::STRING
@@ -101,18 +36,16 @@ flexible_type word_counter_apply_with_manual(const flexible_type& input,
                || run_mode == flex_type_enum::UNDEFINED);
 
   // Tokenize all string inputs according to delimiters and to_lower options,
-  // then accumulate counts and return as dictionary
-  flexible_type output;
-  std::unordered_map<flexible_type, size_t> ret_count;
+  // accumulating counts in the same pass, and return as dictionary
+  token_counter counter(tokenizer, to_lower);
   switch(run_mode) {
     case flex_type_enum::UNDEFINED: {
       // No transform required
-      output = input;
       break;
     }
 
     case flex_type_enum::STRING: {
-      word_count_delimiters_update(input, delimiter_list, to_lower, ret_count);
+      counter.add(input.get<flex_string>());
       break;
     }
 
@@ -125,7 +58,7 @@ flexible_type word_counter_apply_with_manual(const flexible_type& input,
         if (kvp.second.get_type() != flex_type_enum::INTEGER
             && kvp.second.get_type() != flex_type_enum::FLOAT)
           log_and_throw("Invalid type. Dictionary input to WordCounter must have integer or float values.");
-        word_count_delimiters_update(kvp.first.get<flex_string>(), delimiter_list, to_lower, ret_count);
+        counter.add(kvp.first.get<flex_string>());
       }
       break;
     }
@@ -137,7 +70,7 @@ flexible_type word_counter_apply_with_manual(const flexible_type& input,
         if (elem.get_type() != flex_type_enum::STRING)
           log_and_throw("Invalid type. List input to WordCounter must contain only strings.");
 
-        word_count_delimiters_update(elem.get<flex_string>(), delimiter_list, to_lower, ret_count);
+        counter.add(elem.get<flex_string>());
       }
       break;
     }
@@ -148,7 +81,7 @@ flexible_type word_counter_apply_with_manual(const flexible_type& input,
       break;
   } // switch(run_mode)
 
-  return flex_dict(ret_count.begin(), ret_count.end());
+  return counter.to_dict();
 }
 
 
@@ -397,25 +330,25 @@ gl_sframe word_counter::transform(gl_sframe data){
 
   // Decide whether or not to use regex
   const bool use_ptb_tokenizer = (delimiters.get_type() == flex_type_enum::UNDEFINED);
-  flex_list delimiter_list;
+  delimiter_tokenizer tokenizer;
 
   if (!use_ptb_tokenizer) {
     if (delimiters.get_type() != flex_type_enum::LIST) {
       log_and_throw("Invalid type. "
                     "WordCounter delimiter must be a list of single-character strings.");
     }
-    delimiter_list = delimiters.get<flex_list>();
+    tokenizer = delimiter_tokenizer(delimiters.get<flex_list>());
   }
 
   // Make a single lambda to use in the apply below.
   bool m_to_lower = to_lower;
   std::function<flexible_type(const flexible_type&)> transform_regex =
-      [m_to_lower, delimiter_list](const flexible_type& x){
+      [m_to_lower](const flexible_type& x){
     return word_counter_apply_with_regex(x, m_to_lower);
   };
   std::function<flexible_type(const flexible_type&)> transform_manual =
-      [m_to_lower, delimiter_list](const flexible_type& x){
-    return word_counter_apply_with_manual(x, delimiter_list, m_to_lower);
+      [m_to_lower, tokenizer](const flexible_type& x){
+    return word_counter_apply_with_manual(x, tokenizer, m_to_lower);
   };
   std::function<flexible_type(const flexible_type&)> transform_fn;
   transform_fn = use_ptb_tokenizer ? transform_regex : transform_manual;
@@ -42,67 +42,6 @@ gl_sframe generate_vocab(std::map<std::string, std::shared_ptr<topk_indexer>> in
 }
 
 
-/**
- * Ported from original count_words implementation.
- */
-flex_list word_count_delimiters(flexible_type f, const flex_list& delimiter_list, bool to_lower) {
-
-
-  std::set<char> delimiters;
-  for (auto it = delimiter_list.begin(); it != delimiter_list.end(); ++it) {
-    // iterate through flexible_types storing the delimiters
-    // cast each to a string and take first char in string
-    // insert into std::set for quicker look-ups than turi::flex_list
-    delimiters.insert(it->to<std::string>().at(0));
-  }
-
-  auto is_delimiter = [delimiters](const char c)->bool {
-    return delimiters.find(c) != delimiters.end();
-  };
-
-  flex_list ret;
-  const std::string& str = f.get<flex_string>();
-
-  // Tokenizing the string by space, and add to mape
-  // Here we optimize for speed to reduce the string malloc
-  size_t word_begin = 0;
-  // skip leading delimiters
-  while (word_begin < str.size() && (is_delimiter(str[word_begin])))
-    ++word_begin;
-
-  std::string word;
-  flexible_type word_flex;
-
-  for (size_t i = word_begin; i < str.size(); ++i) {
-    if (is_delimiter(str[i])) {
-      // find the end of the word, make a substring, and transform to lower case
-      word = std::string(str, word_begin, i - word_begin);
-      if  (to_lower)
-        std::transform(word.begin(), word.end(), word.begin(), ::tolower);
-      word_flex = std::move(word);
-
-      // add the word to list
-      ret.push_back(word_flex);
-
-      // keep skipping delimiters, and reset word_begin
-      while (i < str.size() && (is_delimiter(str[i])))
-        ++i;
-      word_begin = i;
-    }
-  }
-
-  // add the last word
-  if (word_begin < str.size()) {
-    word = std::string(str, word_begin, str.size() - word_begin);
-    if  (to_lower)
-      std::transform(word.begin(), word.end(), word.begin(), ::tolower);
-    word_flex = std::move(word);
-    ret.push_back(word_flex);
-  }
-  return ret;
-}
-
-
 /**
  * Constructs a top-k indexer.
  *
@@ -122,14 +61,14 @@ void word_trimmer_topk_index_mapping(const gl_sarray& src,
   const transform_utils::string_filter_list& string_filters = transform_utils::ptb_filters;
 
   const bool use_ptb_tokenizer = (delimiters.get_type() == flex_type_enum::UNDEFINED);
-  flex_list delimiter_list;
+  delimiter_tokenizer tokenizer;
 
   if (!use_ptb_tokenizer) {
     if (delimiters.get_type() != flex_type_enum::LIST) {
       log_and_throw("Invalid type. "
                     "RareWordTrimmer delimiter must be a list of single-character strings.");
     }
-    delimiter_list = delimiters.get<flex_list>();
+    tokenizer = delimiter_tokenizer(delimiters.get<flex_list>());
   }
 
 
@@ -155,7 +94,7 @@ void word_trimmer_topk_index_mapping(const gl_sarray& src,
           if (use_ptb_tokenizer){
             tokens_list = transform_utils::tokenize_string(v, string_filters, to_lower);
           } else {
-            tokens_list = word_count_delimiters(v, delimiter_list, to_lower);
+            tokens_list = tokenize_to_list(tokenizer, v.get<flex_string>(), to_lower);
           }
           for (const auto& token : tokens_list){
             indexer->insert_or_update(token, thread_idx);
@@ -244,14 +183,14 @@ flexible_type word_trimmer_apply(const flexible_type& input,
   const transform_utils::string_filter_list& string_filters = transform_utils::ptb_filters;
 
   const bool use_ptb_tokenizer = (delimiters.get_type() == flex_type_enum::UNDEFINED);
-  flex_list delimiter_list;
+  delimiter_tokenizer tokenizer;
 
   if (!use_ptb_tokenizer) {
     if (delimiters.get_type() != flex_type_enum::LIST) {
       log_and_throw("Invalid type. "
                     "RareWordTrimmer delimiter must be a list of single-character strings.");
     }
-    delimiter_list = delimiters.get<flex_list>();
+    tokenizer = delimiter_tokenizer(delimiters.get<flex_list>());
   }
 
 
@@ -263,7 +202,7 @@ flexible_type word_trimmer_apply(const flexible_type& input,
       if (use_ptb_tokenizer){
         tokens_list = transform_utils::tokenize_string(input.get<flex_string>(), string_filters, to_lower);
       } else {
-        tokens_list = word_count_delimiters(input.get<flex_string>(), delimiter_list, to_lower);
+        tokens_list = tokenize_to_list(tokenizer, input.get<flex_string>(), to_lower);
       }
 
       for (const auto& token : tokens_list){
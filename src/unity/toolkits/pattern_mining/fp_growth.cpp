@@ -3,7 +3,10 @@
  * Use of this source code is governed by a BSD-3-clause license that can
  * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
  */
+#include <atomic>
 #include <timer/timer.hpp>
+#include <parallel/pthread_tools.hpp>
+#include <parallel/lambda_omp.hpp>
 #include <unity/lib/gl_sframe.hpp>
 #include <unity/lib/gl_sarray.hpp>
 #include <unity/lib/variant_deep_serialize.hpp>
@@ -494,6 +497,14 @@ fp_top_k_results_tree top_k_algorithm(const gl_sarray& database, \
 
 /**
  * Helper function for top_k_algorithm. Reduces the fp_tree by mining top-down.
+ *
+ * The conditional trees of the frequent singletons are independent, so they
+ * are mined in parallel: every thread takes the next singleton (in decreasing
+ * order of support) and mines its conditional tree into a results tree of its
+ * own. The minimum support raised by any thread is shared with the others.
+ * The results trees are merged once all singletons are mined.
+ *
+ * my_tree is not modified, so that the threads can read it concurrently.
  */
 void global_top_down_growth(fp_top_k_tree& my_tree,  \
     fp_top_k_results_tree& closed_itemset_tree, size_t& min_support){
@@ -509,61 +520,95 @@ void global_top_down_growth(fp_top_k_tree& my_tree,  \
                        {"Elapsed Time", 16}});
   table.print_header();
 
-  // For each frequent singleton (in increasing order)
-  auto& headings = my_tree.header.headings;
-  size_t counter = 0;
-  for(auto it = headings.begin(); it != headings.end(); it++){
+  // One results tree per thread
+  const std::vector<size_t> ids = my_tree.header.get_ids();
+  size_t num_threads = thread_pool::get_instance().size();
+  std::vector<fp_top_k_results_tree> local_trees;
+  for(size_t i = 0; i < num_threads; i++){
+    local_trees.push_back(fp_top_k_results_tree(ids, \
+          closed_itemset_tree.top_k, closed_itemset_tree.min_length));
+  }
 
-    auto& heading = *it;
-    size_t& id = heading.id;
-    size_t& support = heading.support;
-    size_t num_patterns = closed_itemset_tree.min_support_heap.size();
-    table.print_row(counter, num_patterns, support, min_support, progress_time());
-    counter++;
+  const auto& headings = my_tree.header.headings;
+  std::atomic<size_t> next_heading(0);
+  std::atomic<size_t> shared_min_support(min_support);
+  std::atomic<size_t> num_patterns(0);
+  mutex table_lock;
+
+  // Raise the shared min_support to at least bound
+  auto raise_min_support = [&](size_t bound){
+    size_t current = shared_min_support.load();
+    while(current < bound && \
+        !shared_min_support.compare_exchange_weak(current, bound)) { }
+  };
 
-    // Check if support in transaction of min_length is large enough
-    // size_t support_at_depth = my_tree.get_support(heading, my_tree.get_min_depth());
-    size_t& support_at_depth = support; // Fix for predict
-    if(support_at_depth >= min_support){
+  in_parallel([&](size_t thread_id, size_t num_threads) {
+    fp_top_k_results_tree& local_tree = local_trees[thread_id];
+
+    // For each frequent singleton (in decreasing support order)
+    for(size_t i = next_heading++; i < headings.size(); i = next_heading++){
+      const fp_tree_heading& heading = headings[i];
+      const size_t& id = heading.id;
+      const size_t& support = heading.support;
+      size_t local_min_support = shared_min_support.load();
+      {
+        std::lock_guard<mutex> guard(table_lock);
+        table.print_row(i, num_patterns.load(), support, local_min_support, \
+            progress_time());
+      }
+
+      // Check if support in transaction of min_length is large enough
+      // size_t support_at_depth = my_tree.get_support(heading, my_tree.get_min_depth());
+      const size_t& support_at_depth = support; // Fix for predict
+      if(support_at_depth < local_min_support){
+        continue;
+      }
       std::vector<size_t> new_prefix = my_tree.root_prefix;
       new_prefix.push_back(id);
 
       // Check if new_prefix could be a closed itemset
-      if(!closed_itemset_tree.is_itemset_redundant(new_prefix,support)){
+      if(!local_tree.is_itemset_redundant(new_prefix, support)){
+        size_t num_local_patterns = local_tree.min_support_heap.size();
+
         // Build conditional database for new prefix
-        fp_top_k_tree new_tree = my_tree.build_cond_tree(heading, min_support);
+        fp_top_k_tree new_tree = my_tree.build_cond_tree(heading, \
+            local_min_support);
 
         // Try to raise min_support
         size_t closed_node_bound = new_tree.get_min_support_bound();
-        min_support = std::max(min_support, closed_node_bound);
+        local_min_support = std::max(local_min_support, closed_node_bound);
 
         // (Future Optimization) Implement Anchor Bound
         //  size_t anchor_bound = new_tree.get_anchor_min_support_bound();
         //  min_support = std::max(min_support, anchor_bound);
 
         // Prune new_tree
-        new_tree.prune_tree(min_support);
+        new_tree.prune_tree(local_min_support);
 
         // Recurse
-        local_bottom_up_growth(new_tree, closed_itemset_tree, \
-            min_support);
+        local_bottom_up_growth(new_tree, local_tree, local_min_support);
 
         // Save new_prefix if it is a closed itemset
-        if((support >= min_support) &&
-            (!closed_itemset_tree.is_itemset_redundant(new_prefix, support))) {
-          closed_itemset_tree.add_itemset(new_prefix, support);
-
-          // Try to raise min_support
-          size_t current_top_k_bound = closed_itemset_tree.get_min_support_bound();
-          min_support = std::max(min_support, current_top_k_bound);
+        if((support >= local_min_support) &&
+            (!local_tree.is_itemset_redundant(new_prefix, support))) {
+          local_tree.add_itemset(new_prefix, support);
+
+          // Try to raise min_support (the top_k supports of a thread bound
+          // the top_k supports of all threads)
+          size_t current_top_k_bound = local_tree.get_min_support_bound();
+          local_min_support = std::max(local_min_support, current_top_k_bound);
         }
 
-        // Prune original_tree on new min_support
-        my_tree.prune_tree(min_support);
-
+        raise_min_support(local_min_support);
+        num_patterns += local_tree.min_support_heap.size() - num_local_patterns;
       }
     }
-  }
+  });
+
+  // Merge the results of all threads
+  min_support = shared_min_support.load();
+  merge_results_trees(closed_itemset_tree, local_trees, min_support);
+  min_support = std::max(min_support, closed_itemset_tree.get_min_support_bound());
 
   // Final row.
   table.print_row("Final",
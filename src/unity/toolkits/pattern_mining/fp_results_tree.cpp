@@ -587,6 +587,52 @@ gl_sframe fp_top_k_results_tree::get_closed_itemsets( \
   return fp_results_tree::get_top_k_closed_itemsets(top_k, min_length, indexer);
 }
 
+/**
+ * Merge results trees mined independently.
+ */
+void merge_results_trees(fp_top_k_results_tree& closed_itemset_tree, \
+    const std::vector<fp_top_k_results_tree>& local_trees, \
+    const size_t& min_support){
+
+  // Extract the closed itemsets of all trees
+  std::vector<std::pair<std::vector<size_t>, size_t>> itemsets;
+  for(const auto& local_tree: local_trees){
+    std::stack<fp_node*> node_stack;
+    node_stack.push(local_tree.root_node.get());
+    while(!node_stack.empty()){
+      fp_node* current_node = node_stack.top();
+      node_stack.pop();
+      if((current_node->item_id != ROOT_ID) && current_node->is_closed() && \
+          (current_node->item_count >= min_support)){
+        itemsets.emplace_back(current_node->get_path_to_root(), \
+            current_node->item_count);
+      }
+      for(auto& child_node: current_node->children_nodes){
+        node_stack.push(child_node.get());
+      }
+    }
+  }
+
+  // Supersets (with equal support) first
+  std::sort(itemsets.begin(), itemsets.end(), \
+      [](const std::pair<std::vector<size_t>, size_t>& left, \
+         const std::pair<std::vector<size_t>, size_t>& right){
+        if(left.second != right.second){
+          return left.second > right.second;
+        }
+        if(left.first.size() != right.first.size()){
+          return left.first.size() > right.first.size();
+        }
+        return left.first < right.first;
+      });
+
+  for(const auto& itemset: itemsets){
+    if(!closed_itemset_tree.is_itemset_redundant(itemset.first, itemset.second)){
+      closed_itemset_tree.add_itemset(itemset.first, itemset.second);
+    }
+  }
+}
+
 
 
 } // namespace patten_mining
@@ -331,6 +331,25 @@ class fp_top_k_results_tree : public fp_results_tree {
 
 };
 
+/**
+ * Merge top-k results trees mined independently (e.g. by different threads)
+ * into closed_itemset_tree.
+ *
+ *   The closed itemsets of all the trees are added in decreasing order of
+ *   support (longest first among equal supports), skipping redundant ones, so
+ *   an itemset with a superset of equal support in any of the trees is
+ *   dropped, and the result does not depend on how the itemsets were split
+ *   between the trees.
+ *
+ * Args:
+ *   closed_itemset_tree (fp_top_k_results_tree) - tree to merge into
+ *   local_trees (vector of fp_top_k_results_tree) - trees to merge
+ *   min_support (size_t) - itemsets with lower support are skipped
+ */
+void merge_results_trees(fp_top_k_results_tree& closed_itemset_tree, \
+    const std::vector<fp_top_k_results_tree>& local_trees, \
+    const size_t& min_support);
+
 
 
 
@@ -0,0 +1,89 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#include <toolkits/supervised_learning/feature_block_cache.hpp>
+#include <toolkits/supervised_learning/supervised_learning_utils-inl.hpp>
+#include <globals/globals.hpp>
+#include <logger/logger.hpp>
+
+namespace turi {
+namespace supervised {
+
+size_t SUPERVISED_LEARNING_FEATURE_CACHE_BYTES = 1024LL * 1024 * 1024;
+
+REGISTER_GLOBAL(int64_t, SUPERVISED_LEARNING_FEATURE_CACHE_BYTES, true);
+
+size_t SUPERVISED_LEARNING_FEATURE_BLOCK_ROWS = 1024;
+
+REGISTER_GLOBAL_WITH_CHECKS(int64_t,
+                            SUPERVISED_LEARNING_FEATURE_BLOCK_ROWS,
+                            true,
+                            +[](int64_t val){ return val >= 1; });
+
+bool feature_block_cache::try_build(const ml_data& data,
+                                    size_t num_variables,
+                                    const l2_rescaling* scaler) {
+  if (m_built) return true;
+  if (m_over_budget) return false;
+
+  // The features, the target value and the target index of every row.
+  double bytes = double(data.num_rows()) * (num_variables + 2) * sizeof(double);
+  if (bytes > double(SUPERVISED_LEARNING_FEATURE_CACHE_BYTES)) {
+    logstream(LOG_INFO) << "Feature blocks need " << bytes << " bytes, above the "
+                        << "limit of " << SUPERVISED_LEARNING_FEATURE_CACHE_BYTES
+                        << " bytes; not caching them." << std::endl;
+    m_over_budget = true;
+    return false;
+  }
+
+  const size_t block_rows = SUPERVISED_LEARNING_FEATURE_BLOCK_ROWS;
+  std::vector<std::vector<block>> thread_blocks(thread_pool::get_instance().size());
+
+  in_parallel([&](size_t thread_idx, size_t num_threads) {
+    std::vector<block>& blocks = thread_blocks[thread_idx];
+    for(auto it = data.get_iterator(thread_idx, num_threads); !it.done();) {
+      block b;
+      b.x.set_size(block_rows, num_variables);
+      b.target_index.reserve(block_rows);
+      b.target_value.set_size(block_rows);
+
+      size_t row_id = 0;
+      while(row_id < block_rows && !it.done()) {
+        fill_reference_encoding(*it, b.x.row(row_id));
+        b.x(row_id, num_variables - 1) = 1;
+        b.target_index.push_back(it->target_index());
+        b.target_value(row_id) = it->target_value();
+        ++it;
+        ++row_id;
+      }
+
+      // Resize will happen only once (last few rows).
+      b.x.resize(row_id, num_variables);
+      b.target_value.resize(row_id);
+      if(scaler != nullptr) {
+        scaler->transform(b.x);
+      }
+      blocks.push_back(std::move(b));
+    }
+  });
+
+  m_blocks.clear();
+  for(auto& blocks : thread_blocks) {
+    for(auto& b : blocks) {
+      m_blocks.push_back(std::move(b));
+    }
+  }
+  m_built = true;
+  return true;
+}
+
+void feature_block_cache::clear() {
+  m_blocks.clear();
+  m_built = false;
+  m_over_budget = false;
+}
+
+} // supervised
+} // turicreate
@@ -0,0 +1,91 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#ifndef TURI_SUPERVISED_LEARNING_FEATURE_BLOCK_CACHE_H_
+#define TURI_SUPERVISED_LEARNING_FEATURE_BLOCK_CACHE_H_
+
+#include <vector>
+#include <ml_data/ml_data.hpp>
+#include <numerics/armadillo.hpp>
+#include <optimization/optimization_interface.hpp>
+#include <parallel/lambda_omp.hpp>
+#include <toolkits/supervised_learning/standardization-inl.hpp>
+
+namespace turi {
+namespace supervised {
+
+/**
+ * The maximum number of bytes the dense feature blocks of the training data
+ * of a linear model may take. Above that, the gradient and hessian are
+ * computed by iterating over the ml_data on every pass.
+ */
+extern size_t SUPERVISED_LEARNING_FEATURE_CACHE_BYTES;
+
+/**
+ * The number of rows in each cached feature block.
+ */
+extern size_t SUPERVISED_LEARNING_FEATURE_BLOCK_ROWS;
+
+/**
+ * Dense feature blocks of an ml_data, materialized once and reused on every
+ * pass of the solvers.
+ *
+ * Every row is reference encoded, followed by a 1 for the bias term, and
+ * rescaled if a scaler is given, i.e. it is exactly the vector the per-row
+ * code paths of the linear model solver interfaces build. The rows are
+ * grouped in blocks of (at most) SUPERVISED_LEARNING_FEATURE_BLOCK_ROWS rows
+ * so that margins, gradients and hessians can be computed with matrix
+ * products.
+ */
+class feature_block_cache {
+ public:
+
+  struct block {
+    DenseMatrix x;                       /**< rows x num_variables */
+    std::vector<size_t> target_index;    /**< Target index of every row */
+    DenseVector target_value;            /**< Target value of every row */
+  };
+
+  /**
+   * Builds the blocks, unless already built. Returns false, and remembers
+   * it, if the blocks would exceed SUPERVISED_LEARNING_FEATURE_CACHE_BYTES.
+   *
+   * \param[in] data          Data to materialize.
+   * \param[in] num_variables Number of variables of a row (including bias).
+   * \param[in] scaler        Rescaling applied to the rows (may be null).
+   */
+  bool try_build(const ml_data& data, size_t num_variables,
+                 const l2_rescaling* scaler);
+
+  /**
+   * Drops the blocks, e.g. because the feature rescaling changed.
+   */
+  void clear();
+
+  /// Number of cached blocks.
+  size_t num_blocks() const { return m_blocks.size(); }
+
+  /**
+   * Calls fn(thread_idx, block) on every block, in parallel.
+   */
+  template <typename Fn>
+  void parallel_for_each_block(Fn&& fn) const {
+    in_parallel([&](size_t thread_idx, size_t num_threads) {
+      for (size_t i = thread_idx; i < m_blocks.size(); i += num_threads) {
+        fn(thread_idx, m_blocks[i]);
+      }
+    });
+  }
+
+ private:
+  std::vector<block> m_blocks;
+  bool m_built = false;
+  bool m_over_budget = false;
+};
+
+} // supervised
+} // turicreate
+
+#endif
@@ -118,6 +118,8 @@ class EXPORT linear_regression: public supervised_learning_model_base {
   flexible_type predict_single_example(const SparseVector& x, 
           const prediction_type_enum& output_type=prediction_type_enum::NA);
 
+  bool supports_single_example_prediction() const override { return true; }
+
   /**
   * Get coefficients for a trained model.
   */
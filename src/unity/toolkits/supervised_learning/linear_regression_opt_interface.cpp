@@ -77,6 +77,16 @@ void linear_regression_opt_interface::set_threads(size_t _n_threads) {
 void linear_regression_opt_interface::init_feature_rescaling() {
   feature_rescaling = true;
   scaler.reset(new l2_rescaling(smodel.get_ml_metadata(), true));
+  block_cache.clear();
+}
+
+/**
+ * Use the cached feature blocks for this data?
+ */
+bool linear_regression_opt_interface::use_block_cache(const ml_data& _data) {
+  if (!is_dense || &_data != &data) return false;
+  return block_cache.try_build(data, variables,
+                               feature_rescaling ? scaler.get() : nullptr);
 }
 
 /**
@@ -150,8 +160,17 @@ void linear_regression_opt_interface::compute_first_order_statistics(const
   std::vector<DenseVector> G(n_threads, arma::zeros(variables));
   std::vector<double> f(n_threads, 0.0);
 
+  // Dense training data, materialized in blocks on the first pass.
+  if (use_block_cache(data)) {
+    block_cache.parallel_for_each_block([&](size_t thread_idx,
+                                            const feature_block_cache::block& b) {
+      DenseVector r = b.x * point - b.target_value;
+      G[thread_idx] += 2 * b.x.t() * r;
+      f[thread_idx] += dot(r, r);
+    });
+
   // Dense data. 
-  if (this->is_dense) {
+  } else if (this->is_dense) {
       in_parallel([&](size_t thread_idx, size_t num_threads) {
         DenseMatrix x(LINEAR_REGRESSION_BATCH_SIZE, variables);
         DenseVector y(LINEAR_REGRESSION_BATCH_SIZE);
@@ -228,8 +247,18 @@ void linear_regression_opt_interface::compute_second_order_statistics( const
                         arma::zeros(variables));
   std::vector<double> f(n_threads, 0.0);
   
+  // Dense training data, materialized in blocks on the first pass.
+  if (use_block_cache(data)) {
+    block_cache.parallel_for_each_block([&](size_t thread_idx,
+                                            const feature_block_cache::block& b) {
+      DenseVector r = b.x * point - b.target_value;
+      G[thread_idx] += 2 * b.x.t() * r;
+      f[thread_idx] += dot(r, r);
+      H[thread_idx] += 2 * b.x.t() * b.x;
+    });
+
   // Dense data. 
-  if (this->is_dense) {
+  } else if (this->is_dense) {
     in_parallel([&](size_t thread_idx, size_t num_threads) {
       DenseMatrix x(LINEAR_REGRESSION_BATCH_SIZE, variables);
       DenseVector y(LINEAR_REGRESSION_BATCH_SIZE);
@@ -13,6 +13,7 @@
 // Toolkits
 #include <toolkits/supervised_learning/supervised_learning.hpp>
 #include <toolkits/supervised_learning/standardization-inl.hpp>
+#include <toolkits/supervised_learning/feature_block_cache.hpp>
 #include <toolkits/supervised_learning/linear_regression.hpp>
 
 // Optimization Interface
@@ -51,6 +52,7 @@ class linear_regression_opt_interface: public
   std::shared_ptr<l2_rescaling> scaler;        /** <Scale features */
   bool feature_rescaling = false;              /** Feature rescaling */
   bool is_dense = false;                       /** Is the data sparse */
+  feature_block_cache block_cache;             /** Cached training rows */
 
   public:
 
@@ -174,6 +176,8 @@ class linear_regression_opt_interface: public
   void compute_first_order_statistics(const ml_data& data, const DenseVector
       &point, DenseVector& gradient, double & function_value, const size_t
       mbStart = 0, const size_t mbSize = -1);
+
+  bool use_block_cache(const ml_data& data);
 };
 
 
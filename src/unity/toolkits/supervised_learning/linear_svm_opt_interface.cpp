@@ -165,6 +165,7 @@ std::vector<std::string> linear_svm_scaled_logistic_opt_interface::get_status(
 void linear_svm_scaled_logistic_opt_interface::init_feature_rescaling() {
   feature_rescaling = true;
   scaler.reset(new l2_rescaling(data.metadata(), true));
+  block_cache.clear();
 }
 
 /**
@@ -220,8 +221,31 @@ void linear_svm_scaled_logistic_opt_interface::compute_first_order_statistics(co
   std::vector<double> f(n_threads, 0.0);
   std::vector<DenseVector> G(n_threads, arma::zeros(primal_variables));
 
+  // Dense data, materialized in blocks on the first pass.
+  if (this->is_dense && block_cache.try_build(data, primal_variables,
+                            feature_rescaling ? scaler.get() : nullptr)) {
+    block_cache.parallel_for_each_block([&](size_t thread_idx,
+                                            const feature_block_cache::block& b) {
+      DenseVector dots = b.x * point;
+      DenseVector r(b.x.n_rows);
+      double y, row_prob, margin, row_func, w;
+      for(size_t i = 0; i < b.x.n_rows; i++) {
+        size_t class_idx = b.target_index[i];
+        y = class_idx * 2 - 1.0;
+        w = class_weights[class_idx];
+        margin = -gamma * (y * dots(i) - 1);
+
+        row_prob = - sigmoid(margin);
+        row_func = log1pe(margin);
+
+        f[thread_idx] += w * row_func / gamma;
+        r(i) = w * y * row_prob;
+      }
+      G[thread_idx] += b.x.t() * r;
+    });
+
   // Dense data. 
-  if (this->is_dense) {
+  } else if (this->is_dense) {
     in_parallel([&](size_t thread_idx, size_t num_threads) {
       DenseVector x(primal_variables);
       double y, row_prob, margin, row_func;
@@ -11,6 +11,7 @@
 
 // Toolkits
 #include <toolkits/supervised_learning/standardization-inl.hpp>
+#include <toolkits/supervised_learning/feature_block_cache.hpp>
 #include <toolkits/supervised_learning/supervised_learning.hpp>
 #include <toolkits/supervised_learning/linear_svm.hpp>
 
@@ -65,6 +66,7 @@ class linear_svm_scaled_logistic_opt_interface: public
   bool feature_rescaling = false;             /** Feature rescaling */
   double gamma = 30;
   bool is_dense = false;                      /** Is the data dense? */
+  feature_block_cache block_cache;            /** Cached training rows */
 
   public:
 
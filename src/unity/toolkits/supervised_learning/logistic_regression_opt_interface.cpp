@@ -123,6 +123,45 @@ void logistic_regression_opt_interface::set_class_weights(
 void logistic_regression_opt_interface::init_feature_rescaling() {
   feature_rescaling = true;
   scaler.reset(new l2_rescaling(smodel.get_ml_metadata(), true));
+  block_cache.clear();
+}
+
+/**
+ * Use the cached feature blocks for this data?
+ */
+bool logistic_regression_opt_interface::use_block_cache(const ml_data& _data) {
+  if (!is_dense || &_data != &data) return false;
+  return block_cache.try_build(data, variables / (classes-1),
+                               feature_rescaling ? scaler.get() : nullptr);
+}
+
+/**
+ * Fill R with the weighted residuals (the gradient of the loss with respect
+ * to the margins) of a block, and P with the class probabilities, if given.
+ * Returns the weighted loss of the block.
+ */
+double logistic_regression_opt_interface::compute_block_residuals(
+    const feature_block_cache::block& b, const DenseMatrix& margin,
+    DenseMatrix& R, DenseMatrix* P) {
+  double f = 0;
+  for(size_t i = 0; i < b.x.n_rows; i++){
+    size_t class_idx = b.target_index[i];
+    double w = class_weights[class_idx];
+    double kernel_sum = 0;
+    for(size_t c = 0; c < classes - 1; c++){
+      R(i, c) = std::exp(margin(i, c));
+      kernel_sum += R(i, c);
+    }
+    double margin_dot_class = (class_idx > 0) ? margin(i, class_idx - 1) : 0;
+    f += w * (log1p(kernel_sum) - margin_dot_class);
+    for(size_t c = 0; c < classes - 1; c++){
+      R(i, c) /= (1 + kernel_sum);
+      if (P != nullptr) (*P)(i, c) = R(i, c);
+      R(i, c) *= w;
+    }
+    if (class_idx > 0) R(i, class_idx - 1) -= w;
+  }
+  return f;
 }
 
 /**
@@ -243,8 +282,20 @@ void logistic_regression_opt_interface::compute_first_order_statistics(
 
   logstream(LOG_INFO) << "Starting first order stats computation" << std::endl; 
 
+  // Dense training data, materialized in blocks on the first pass.
+  if (use_block_cache(data)) {
+    DenseMatrix pointMat(point);
+    pointMat.reshape(variables_per_class, classes-1);
+    block_cache.parallel_for_each_block([&](size_t thread_idx,
+                                            const feature_block_cache::block& b) {
+      DenseMatrix margin = b.x * pointMat;
+      DenseMatrix R(b.x.n_rows, classes - 1);
+      f[thread_idx] += compute_block_residuals(b, margin, R, nullptr);
+      G[thread_idx] += arma::vectorise(b.x.t() * R);
+    });
+
   // Dense data. 
-  if (this->is_dense) {
+  } else if (this->is_dense) {
     in_parallel([&](size_t thread_idx, size_t num_threads) {
       DenseVector x(variables_per_class);
       double row_func = 0, margin_dot_class = 0;
@@ -344,8 +395,42 @@ void logistic_regression_opt_interface::compute_second_order_statistics(
   std::vector<double> f(n_threads, 0.0);
   size_t variables_per_class = variables / (classes-1);
 
+  // Dense training data, materialized in blocks on the first pass.
+  if (use_block_cache(data)) {
+    DenseMatrix pointMat(point);
+    pointMat.reshape(variables_per_class, classes-1);
+    block_cache.parallel_for_each_block([&](size_t thread_idx,
+                                            const feature_block_cache::block& b) {
+      DenseMatrix margin = b.x * pointMat;
+      DenseMatrix R(b.x.n_rows, classes - 1);
+      DenseMatrix P(b.x.n_rows, classes - 1);
+      f[thread_idx] += compute_block_residuals(b, margin, R, &P);
+      G[thread_idx] += arma::vectorise(b.x.t() * R);
+
+      // The (a,b) block of the hessian is X' * diag(w .* A(a,b)) * X, where
+      // A = diag(p) - p * p' for every row.
+      DenseVector w(b.x.n_rows);
+      for(size_t i = 0; i < b.x.n_rows; i++){
+        w(i) = class_weights[b.target_index[i]];
+      }
+      size_t m = variables_per_class;
+      for(size_t a = 0; a < classes - 1; a++){
+        for(size_t c = a; c < classes - 1; c++){
+          DenseVector d = -w % P.col(a) % P.col(c);
+          if (a == c) d += w % P.col(a);
+          DenseMatrix H_ac = b.x.t() * (b.x.each_col() % d);
+          H[thread_idx].submat(a * m, c * m, (a + 1) * m - 1, (c + 1) * m - 1)
+              += H_ac;
+          if (a != c) {
+            H[thread_idx].submat(c * m, a * m, (c + 1) * m - 1, (a + 1) * m - 1)
+                += H_ac;
+          }
+        }
+      }
+    });
+
   // Dense data
-  if (this->is_dense) {
+  } else if (this->is_dense) {
 
     in_parallel([&](size_t thread_idx, size_t num_threads) {
       DenseVector x(variables_per_class);
@@ -11,6 +11,7 @@
 
 // Toolkits
 #include <toolkits/supervised_learning/standardization-inl.hpp>
+#include <toolkits/supervised_learning/feature_block_cache.hpp>
 #include <toolkits/supervised_learning/supervised_learning.hpp>
 #include <toolkits/supervised_learning/logistic_regression.hpp>
 
@@ -61,6 +62,7 @@ class logistic_regression_opt_interface: public
   std::shared_ptr<l2_rescaling> scaler;        /** <Scale features */
   bool feature_rescaling = false;              /** Feature rescaling */
   bool is_dense = false;                       /** Is the data dense? */
+  feature_block_cache block_cache;             /** Cached training rows */
 
   public:
 
@@ -202,6 +204,11 @@ class logistic_regression_opt_interface: public
   void compute_first_order_statistics(const ml_data& data, const DenseVector
       &point, DenseVector& gradient, double & function_value, const size_t
       mbStart = 0, const size_t mbSize = -1);
+
+  bool use_block_cache(const ml_data& data);
+
+  double compute_block_residuals(const feature_block_cache::block& b,
+      const DenseMatrix& margin, DenseMatrix& R, DenseMatrix* P);
 };
 
 
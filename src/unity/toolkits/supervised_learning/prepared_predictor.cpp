@@ -0,0 +1,182 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#include <toolkits/supervised_learning/prepared_predictor.hpp>
+#include <toolkits/supervised_learning/supervised_learning_utils-inl.hpp>
+#include <logger/logger.hpp>
+
+namespace turi {
+namespace supervised {
+
+prepared_predictor::prepared_predictor(
+    std::shared_ptr<supervised_learning_model_base> model,
+    const std::string& missing_value_action,
+    const std::string& output_type)
+    : m_model(model),
+      m_missing_value_action(missing_value_action),
+      m_output_type(output_type) {
+
+  if (m_model == nullptr || m_model->ml_mdata == nullptr) {
+    log_and_throw("The model must be trained before making predictions.");
+  }
+  m_metadata = m_model->ml_mdata;
+
+  m_na_enum = m_model->get_missing_value_enum_from_string(missing_value_action);
+  m_pred_type_enum = prediction_type_enum_from_name(output_type);
+  if (output_type == "class") {
+    m_prediction_type = m_metadata->target_column_type();
+  } else if (output_type == "probability_vector") {
+    m_prediction_type = flex_type_enum::VECTOR;
+  } else {
+    m_prediction_type = flex_type_enum::FLOAT;
+  }
+
+  // Same sizes as fast_predict.
+  std::map<std::string, variant_type> state = m_model->get_state();
+  if (state.count("num_coefficients") > 0) {
+    m_variables = variant_get_value<size_t>(state.at("num_coefficients"));
+  }
+  if (state.count("num_classes") > 0) {
+    size_t classes = variant_get_value<size_t>(state.at("num_classes"));
+    DASSERT_TRUE(classes > 1);
+    m_variables = m_variables / (classes - 1);
+  }
+
+  m_single_example = m_model->supports_single_example_prediction();
+  m_is_dense = m_model->is_dense();
+
+  m_feature_names = m_metadata->column_names();
+  for (size_t i = 0; i < m_feature_names.size(); ++i) {
+    m_column_index[m_feature_names[i]] = i;
+  }
+}
+
+std::unique_ptr<prepared_predictor::scratch>
+prepared_predictor::acquire_scratch() const {
+  {
+    std::lock_guard<turi::mutex> guard(m_scratch_lock);
+    if (!m_free_scratch.empty()) {
+      std::unique_ptr<scratch> s = std::move(m_free_scratch.back());
+      m_free_scratch.pop_back();
+      return s;
+    }
+  }
+  std::unique_ptr<scratch> s(new scratch);
+  s->data_block = std::make_shared<ml_data_internal::ml_data_block>();
+  s->x = DenseVector(m_variables);
+  s->x_sp = SparseVector(m_variables);
+  return s;
+}
+
+void prepared_predictor::release_scratch(std::unique_ptr<scratch> s) const {
+  std::lock_guard<turi::mutex> guard(m_scratch_lock);
+  m_free_scratch.push_back(std::move(s));
+}
+
+void prepared_predictor::fill_column_buffer(
+    const std::vector<flexible_type>& rows, scratch& s) const {
+
+  size_t num_columns = m_feature_names.size();
+  s.column_buffer.resize(num_columns);
+  for (auto& column : s.column_buffer) {
+    column.assign(rows.size(), FLEX_UNDEFINED);
+  }
+
+  for (size_t r = 0; r < rows.size(); ++r) {
+    const flexible_type& row = rows[r];
+    switch (row.get_type()) {
+      case flex_type_enum::DICT: {
+        for (const auto& kv : row.get<flex_dict>()) {
+          if (kv.first.get_type() != flex_type_enum::STRING) {
+            log_and_throw("TypeError: Expecting column names as keys of "
+                          "each example.");
+          }
+          auto it = m_column_index.find(kv.first.get<flex_string>());
+          if (it != m_column_index.end()) {
+            s.column_buffer[it->second][r] = kv.second;
+          }
+        }
+        break;
+      }
+      case flex_type_enum::LIST: {
+        const flex_list& values = row.get<flex_list>();
+        if (values.size() != num_columns) {
+          log_and_throw("Expecting " + std::to_string(num_columns)
+                        + " feature values for each example, got "
+                        + std::to_string(values.size()) + ".");
+        }
+        for (size_t c = 0; c < num_columns; ++c) {
+          s.column_buffer[c][r] = values[c];
+        }
+        break;
+      }
+      case flex_type_enum::VECTOR: {
+        const flex_vec& values = row.get<flex_vec>();
+        if (values.size() != num_columns) {
+          log_and_throw("Expecting " + std::to_string(num_columns)
+                        + " feature values for each example, got "
+                        + std::to_string(values.size()) + ".");
+        }
+        for (size_t c = 0; c < num_columns; ++c) {
+          s.column_buffer[c][r] = values[c];
+        }
+        break;
+      }
+      default:
+        log_and_throw("TypeError: Expecting a dictionary, a list or an array "
+                      "as input type for each example.");
+    }
+  }
+}
+
+void prepared_predictor::predict(const std::vector<flexible_type>& rows,
+                                 std::vector<flexible_type>& out) const {
+  out.resize(rows.size());
+  if (rows.empty()) return;
+
+  if (!m_single_example) {
+    gl_sarray preds = m_model->fast_predict(rows, m_missing_value_action,
+                                            m_output_type);
+    size_t i = 0;
+    for (const auto& v : preds.range_iterator()) {
+      out[i++] = v;
+    }
+    return;
+  }
+
+  std::unique_ptr<scratch> s = acquire_scratch();
+  try {
+    fill_column_buffer(rows, *s);
+    ml_data_row_reference::from_column_buffer(
+        m_metadata, s->column_buffer, false, s->data_block, s->row_refs,
+        m_na_enum);
+
+    for (size_t i = 0; i < rows.size(); ++i) {
+      if (m_is_dense) {
+        fill_reference_encoding(s->row_refs[i], s->x);
+        s->x(m_variables - 1) = 1;
+        out[i] = m_model->predict_single_example(s->x, m_pred_type_enum);
+      } else {
+        fill_reference_encoding(s->row_refs[i], s->x_sp);
+        s->x_sp.insert(m_variables - 1, 1);
+        out[i] = m_model->predict_single_example(s->x_sp, m_pred_type_enum);
+      }
+    }
+  } catch (...) {
+    release_scratch(std::move(s));
+    throw;
+  }
+  release_scratch(std::move(s));
+}
+
+std::vector<flexible_type> prepared_predictor::predict(
+    const std::vector<flexible_type>& rows) const {
+  std::vector<flexible_type> out;
+  predict(rows, out);
+  return out;
+}
+
+} // supervised
+} // turicreate
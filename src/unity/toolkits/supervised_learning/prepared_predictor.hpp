@@ -0,0 +1,131 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#ifndef TURI_SUPERVISED_LEARNING_PREPARED_PREDICTOR_H_
+#define TURI_SUPERVISED_LEARNING_PREPARED_PREDICTOR_H_
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <flexible_type/flexible_type.hpp>
+#include <ml_data/ml_data.hpp>
+#include <parallel/mutex.hpp>
+#include <toolkits/supervised_learning/supervised_learning.hpp>
+
+namespace turi {
+namespace supervised {
+
+/**
+ * A predictor for low latency predictions on small batches of rows held in
+ * memory, for instance to serve a model in process.
+ *
+ * Everything which only depends on the model is looked up once, when the
+ * predictor is built: the column name to column index map, the number of
+ * coefficients, and the prediction and missing value enums. Each batch is
+ * then translated in one pass (see
+ * \ref ml_data_row_reference::from_column_buffer) into buffers which are
+ * reused from call to call, and predicted row by row with
+ * predict_single_example. No SFrame or SArray is created.
+ *
+ * Rows can be given as
+ *  - a flex_dict of {column name, value}. Columns which are not features of
+ *    the model, including the target, are ignored; missing features are
+ *    missing values;
+ *  - a flex_list or a flex_vec of the values of the features, in the order
+ *    of \ref feature_names.
+ *
+ * The predictor is thread safe: concurrent calls each use their own
+ * buffers. The model must not be modified while the predictor is in use.
+ *
+ * Models which do not support predict_single_example (see
+ * supervised_learning_model_base::supports_single_example_prediction), such
+ * as the tree models, fall back on the model's fast_predict, and only accept
+ * flex_dict rows.
+ *
+ * Example:
+ * \code
+ *   prepared_predictor predictor(model, "impute", "probability");
+ *   std::vector<flexible_type> preds;
+ *   predictor.predict({flex_dict{{"x", 1.0}, {"c", "a"}}}, preds);
+ * \endcode
+ */
+class prepared_predictor {
+ public:
+  /**
+   * Prepares predictions with a trained model.
+   *
+   * \param[in] model                 Trained model.
+   * \param[in] missing_value_action  Missing value action string, as for
+   *                                  fast_predict.
+   * \param[in] output_type           Output type, as for fast_predict.
+   */
+  prepared_predictor(std::shared_ptr<supervised_learning_model_base> model,
+                     const std::string& missing_value_action = "error",
+                     const std::string& output_type = "");
+
+  /// The features, in the order expected by positional rows.
+  const std::vector<std::string>& feature_names() const {
+    return m_feature_names;
+  }
+
+  /// The type of the predictions.
+  flex_type_enum prediction_type() const { return m_prediction_type; }
+
+  /**
+   * Predicts a batch of rows, writing one prediction per row to out.
+   * Thread safe.
+   */
+  void predict(const std::vector<flexible_type>& rows,
+               std::vector<flexible_type>& out) const;
+
+  /// Predicts a batch of rows. Thread safe.
+  std::vector<flexible_type> predict(const std::vector<flexible_type>& rows) const;
+
+ private:
+  /// The buffers of a call, reused by the following calls.
+  struct scratch {
+    std::vector<std::vector<flexible_type> > column_buffer;
+    std::shared_ptr<ml_data_internal::ml_data_block> data_block;
+    std::vector<ml_data_row_reference> row_refs;
+    DenseVector x;
+    SparseVector x_sp;
+  };
+
+  std::shared_ptr<supervised_learning_model_base> m_model;
+  std::shared_ptr<ml_metadata> m_metadata;
+  std::string m_missing_value_action;
+  std::string m_output_type;
+  ml_missing_value_action m_na_enum;
+  prediction_type_enum m_pred_type_enum;
+  flex_type_enum m_prediction_type;
+  bool m_single_example = false;
+  bool m_is_dense = true;
+  /// The size of the feature vectors, bias term included.
+  size_t m_variables = 0;
+  std::vector<std::string> m_feature_names;
+  std::unordered_map<std::string, size_t> m_column_index;
+
+  mutable turi::mutex m_scratch_lock;
+  mutable std::vector<std::unique_ptr<scratch> > m_free_scratch;
+
+  /// Takes the buffers of a call, allocating them if none are free.
+  std::unique_ptr<scratch> acquire_scratch() const;
+
+  /// Returns the buffers of a call for reuse.
+  void release_scratch(std::unique_ptr<scratch> s) const;
+
+  /**
+   * Fills the column buffer of s with the values of the rows, one column per
+   * feature.
+   */
+  void fill_column_buffer(const std::vector<flexible_type>& rows,
+                          scratch& s) const;
+};
+
+} // supervised
+} // turicreate
+
+#endif
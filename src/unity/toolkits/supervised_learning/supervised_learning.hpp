@@ -40,6 +40,7 @@ namespace turi {
 namespace supervised {
 
 class supervised_learning_model_base;
+class prepared_predictor;
 typedef arma::vec  DenseVector;
 typedef sparse_vector<double>  SparseVector;
 
@@ -288,6 +289,15 @@ class EXPORT supervised_learning_model_base : public ml_model_base {
           const prediction_type_enum& output_type=prediction_type_enum::NA) {
     return 0.0;
   }
+
+  /**
+   * Returns true if the model implements predict_single_example on
+   * reference encoded features, so that predictions can be made row by row
+   * without going through an SFrame (see \ref prepared_predictor).
+   */
+  virtual bool supports_single_example_prediction() const {
+    return false;
+  }
   
   /**
    * Evaluate the model.
@@ -802,6 +812,8 @@ class EXPORT supervised_learning_model_base : public ml_model_base {
 
 
   protected:
+   friend class prepared_predictor;
+
    ml_missing_value_action get_missing_value_enum_from_string(
        const std::string& missing_value_str) const;
 };
@@ -0,0 +1,228 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#ifndef TURI_TEST_BENCHMARK_UTIL_HPP
+#define TURI_TEST_BENCHMARK_UTIL_HPP
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#ifdef __APPLE__
+#include <mach/mach.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace turi {
+namespace benchmark {
+
+/**
+ * Command line options shared by all the benchmark executables:
+ *
+ * - --rows=N        Size of the generated data (default 1000000).
+ * - --iterations=N  Timed runs of every benchmark (default 5).
+ * - --seed=N        Seed of the generated data (default 0).
+ * - --filter=S      Only run the benchmarks whose name contains S.
+ */
+struct benchmark_options {
+  size_t num_rows = 1000000;
+  size_t iterations = 5;
+  size_t seed = 0;
+  std::string filter;
+
+  benchmark_options(int argc, char** argv) {
+    for (int i = 1; i < argc; ++i) {
+      std::string arg = argv[i];
+      auto value = [&](const std::string& flag) -> const char* {
+        return arg.compare(0, flag.size(), flag) == 0 ? argv[i] + flag.size() : nullptr;
+      };
+      if (const char* v = value("--rows=")) {
+        num_rows = std::strtoull(v, nullptr, 10);
+      } else if (const char* v = value("--iterations=")) {
+        iterations = std::max<size_t>(1, std::strtoull(v, nullptr, 10));
+      } else if (const char* v = value("--seed=")) {
+        seed = std::strtoull(v, nullptr, 10);
+      } else if (const char* v = value("--filter=")) {
+        filter = v;
+      } else {
+        std::cerr << "usage: " << argv[0]
+                  << " [--rows=N] [--iterations=N] [--seed=N] [--filter=S]\n";
+        std::exit(1);
+      }
+    }
+  }
+};
+
+/**
+ * The current resident set size of the process, in bytes. 0 if unknown.
+ */
+inline size_t current_rss_bytes() {
+#ifdef __APPLE__
+  mach_task_basic_info info;
+  mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+  if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO,
+                (task_info_t)&info, &count) != KERN_SUCCESS) {
+    return 0;
+  }
+  return info.resident_size;
+#else
+  std::ifstream statm("/proc/self/statm");
+  size_t total_pages = 0, resident_pages = 0;
+  if (!(statm >> total_pages >> resident_pages)) return 0;
+  return resident_pages * size_t(sysconf(_SC_PAGESIZE));
+#endif
+}
+
+/**
+ * Samples the resident set size of the process from a background thread,
+ * from construction until \ref stop, keeping the largest value seen.
+ *
+ * Unlike getrusage's ru_maxrss, which is the high-water mark of the whole
+ * process (so every benchmark after the first would report the largest
+ * earlier peak), this measures the peak of one benchmark. Spikes shorter
+ * than the sampling interval may be missed.
+ */
+class rss_sampler {
+ public:
+  static constexpr size_t INTERVAL_MS = 5;
+
+  rss_sampler() : m_start(current_rss_bytes()), m_peak(m_start) {
+    m_thread = std::thread([this]() {
+      std::unique_lock<std::mutex> lock(m_lock);
+      while (!m_stopped) {
+        m_peak = std::max(m_peak, current_rss_bytes());
+        m_cond.wait_for(lock, std::chrono::milliseconds(INTERVAL_MS));
+      }
+    });
+  }
+
+  rss_sampler(const rss_sampler&) = delete;
+  rss_sampler& operator=(const rss_sampler&) = delete;
+
+  ~rss_sampler() { stop(); }
+
+  /// Takes a last sample and stops sampling.
+  void stop() {
+    {
+      std::lock_guard<std::mutex> guard(m_lock);
+      if (m_stopped) return;
+      m_peak = std::max(m_peak, current_rss_bytes());
+      m_stopped = true;
+    }
+    m_cond.notify_one();
+    m_thread.join();
+  }
+
+  /// The resident set size when sampling started.
+  size_t start_bytes() const { return m_start; }
+
+  /// The largest resident set size sampled.
+  size_t peak_bytes() const {
+    std::lock_guard<std::mutex> guard(m_lock);
+    return m_peak;
+  }
+
+ private:
+  size_t m_start;
+  size_t m_peak;
+  bool m_stopped = false;
+  mutable std::mutex m_lock;
+  std::condition_variable m_cond;
+  std::thread m_thread;
+};
+
+/**
+ * Runs benchmarks and writes one JSON object per benchmark to stdout:
+ *
+ * \code
+ * {"benchmark": "sort", "rows": 1000000, "seed": 0, "iterations": 5,
+ *  "items": 1000000, "throughput_items_per_s": 2.1e+06,
+ *  "latency_ms": {"min": 450.2, "p50": 470.1, "p90": 481.9, "p99": 481.9,
+ *                 "max": 481.9},
+ *  "peak_rss_bytes": 812343296, "rss_growth_bytes": 402653184,
+ *  "rss_sample_interval_ms": 5}
+ * \endcode
+ *
+ * Throughput is computed from the median latency. peak_rss_bytes is the
+ * largest resident set size sampled (see \ref rss_sampler) while this
+ * benchmark ran, warm up included, and rss_growth_bytes how much it exceeds
+ * the resident set size before the benchmark; both are sampled every
+ * rss_sample_interval_ms, so shorter spikes may be missed. Progress and logging go to
+ * stderr, so that the output can be piped to a file and compared between
+ * builds.
+ */
+class benchmark_runner {
+ public:
+  explicit benchmark_runner(const benchmark_options& options)
+      : m_options(options) { }
+
+  const benchmark_options& options() const { return m_options; }
+
+  /**
+   * Times options().iterations calls of fn(), after one untimed warm up
+   * call. items is the number of items (rows, values, edges...) one call of
+   * fn processes.
+   */
+  template <typename Fn>
+  void run(const std::string& name, size_t items, Fn&& fn) {
+    if (!m_options.filter.empty() &&
+        name.find(m_options.filter) == std::string::npos) {
+      return;
+    }
+    std::cerr << "Running " << name << std::endl;
+    rss_sampler rss;
+    fn();
+    std::vector<double> latencies_ms;
+    for (size_t i = 0; i < m_options.iterations; ++i) {
+      auto start = std::chrono::steady_clock::now();
+      fn();
+      auto end = std::chrono::steady_clock::now();
+      latencies_ms.push_back(
+          std::chrono::duration<double, std::milli>(end - start).count());
+    }
+    rss.stop();
+    std::sort(latencies_ms.begin(), latencies_ms.end());
+    double p50 = percentile(latencies_ms, 0.5);
+    std::cout << "{\"benchmark\": \"" << name << "\""
+              << ", \"rows\": " << m_options.num_rows
+              << ", \"seed\": " << m_options.seed
+              << ", \"iterations\": " << m_options.iterations
+              << ", \"items\": " << items
+              << ", \"throughput_items_per_s\": "
+              << (p50 > 0 ? items / (p50 / 1000) : 0)
+              << ", \"latency_ms\": {\"min\": " << latencies_ms.front()
+              << ", \"p50\": " << p50
+              << ", \"p90\": " << percentile(latencies_ms, 0.9)
+              << ", \"p99\": " << percentile(latencies_ms, 0.99)
+              << ", \"max\": " << latencies_ms.back() << "}"
+              << ", \"peak_rss_bytes\": " << rss.peak_bytes()
+              << ", \"rss_growth_bytes\": "
+              << rss.peak_bytes() - std::min(rss.peak_bytes(), rss.start_bytes())
+              << ", \"rss_sample_interval_ms\": " << rss_sampler::INTERVAL_MS
+              << "}"
+              << std::endl;
+  }
+
+ private:
+  /// Nearest rank percentile of sorted values.
+  static double percentile(const std::vector<double>& sorted, double p) {
+    size_t rank = size_t(std::ceil(p * sorted.size()));
+    return sorted[std::min(sorted.size(), std::max<size_t>(rank, 1)) - 1];
+  }
+
+  benchmark_options m_options;
+};
+
+} // benchmark
+} // turi
+#endif
@@ -0,0 +1,65 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#include <unity/lib/gl_sframe.hpp>
+#include <unity/lib/gl_sarray.hpp>
+#include <unity/toolkits/util/random_sframe_generation.hpp>
+#include "benchmark_util.hpp"
+
+using namespace turi;
+
+/*
+ * Benchmarks of the query engine: filter and transform pipelines, groupby,
+ * join and sort, on a generated frame with the columns
+ * X1-n, X2-n (float), X3-z, X4-z (integer), X5-c (categorical string) and
+ * X6-s (string).
+ */
+
+int main(int argc, char** argv) {
+  benchmark::benchmark_options options(argc, argv);
+  benchmark::benchmark_runner runner(options);
+
+  gl_sframe data = _generate_random_sframe(options.num_rows, "nnzzcs",
+                                           options.seed, false, 0);
+  data.materialize();
+  const size_t num_rows = data.size();
+
+  runner.run("filter", num_rows, [&]() {
+    gl_sframe result = data[data["X1-n"] > 0.5];
+    result.materialize();
+  });
+
+  runner.run("filter_transform", num_rows, [&]() {
+    gl_sframe result = data[data["X1-n"] > 0.5];
+    result.replace_add_column(result["X1-n"] * 2.0 + result["X2-n"], "linear");
+    result.replace_add_column(
+        result.apply([](const sframe_rows::row& row) -> flexible_type {
+            return row[2].get<flex_int>() + flex_int(row[5].get<flex_string>().size());
+          }, flex_type_enum::INTEGER),
+        "lambda");
+    result.materialize();
+  });
+
+  runner.run("groupby", num_rows, [&]() {
+    gl_sframe result = data.groupby({"X5-c"},
+                                    {{"count", aggregate::COUNT()},
+                                     {"sum", aggregate::SUM("X3-z")},
+                                     {"mean", aggregate::MEAN("X1-n")}});
+    result.materialize();
+  });
+
+  gl_sframe categories = data.groupby({"X5-c"},
+                                      {{"mean", aggregate::MEAN("X1-n")}});
+  categories.materialize();
+  runner.run("join", num_rows, [&]() {
+    gl_sframe result = data.join(categories, {"X5-c"}, "inner");
+    result.materialize();
+  });
+
+  runner.run("sort", num_rows, [&]() {
+    gl_sframe result = data.sort({"X3-z", "X1-n"});
+    result.materialize();
+  });
+}
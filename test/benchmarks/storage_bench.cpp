@@ -0,0 +1,131 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#include <random>
+#include <vector>
+#include <sframe/sframe.hpp>
+#include <sframe/sarray.hpp>
+#include <sframe/integer_pack.hpp>
+#include <sframe/sarray_v2_block_manager.hpp>
+#include <sframe/sframe_constants.hpp>
+#include <sframe/csv_line_tokenizer.hpp>
+#include <serialization/serialization_includes.hpp>
+#include <fileio/temp_files.hpp>
+#include <unity/toolkits/util/random_sframe_generation.hpp>
+#include "benchmark_util.hpp"
+
+using namespace turi;
+
+/*
+ * Benchmarks of the storage layer: integer packing, reading and writing v2
+ * blocks, and CSV ingest.
+ */
+
+void bench_integer_pack(benchmark::benchmark_runner& runner) {
+  // Sorted-ish values with small deltas, as in an integer id column.
+  const size_t num_values = runner.options().num_rows / 128 * 128;
+  std::mt19937_64 rng(runner.options().seed);
+  std::vector<uint64_t> values(num_values);
+  uint64_t cur = 0;
+  for (auto& v : values) {
+    cur += rng() % 1024;
+    v = cur;
+  }
+
+  oarchive oarc;
+  auto encode = [&]() {
+    oarc.off = 0;
+    for (size_t i = 0; i < num_values; i += 128) {
+      integer_pack::frame_of_reference_encode_128(values.data() + i, 128, oarc);
+    }
+  };
+  runner.run("integer_pack_encode", num_values, encode);
+
+  std::vector<uint64_t> decoded(num_values);
+  runner.run("integer_pack_decode", num_values, [&]() {
+    iarchive iarc(oarc.buf, oarc.off);
+    for (size_t i = 0; i < num_values; i += 128) {
+      integer_pack::frame_of_reference_decode_128(iarc, 128, decoded.data() + i);
+    }
+  });
+  ASSERT_TRUE(decoded == values);
+  free(oarc.buf);
+}
+
+void bench_v2_blocks(benchmark::benchmark_runner& runner,
+                     const sframe& data) {
+  const size_t num_rows = data.num_rows();
+
+  // Write every column of the frame to new v2 files.
+  sframe written;
+  runner.run("v2_block_write", num_rows * data.num_columns(), [&]() {
+    written = sframe();
+    written.open_for_write(data.column_names(), data.column_types(), "", 1);
+    auto out = written.get_output_iterator(0);
+    auto reader = data.get_reader(1);
+    std::vector<std::vector<flexible_type>> rows;
+    for (size_t start = 0; start < num_rows; start += DEFAULT_SARRAY_READER_BUFFER_SIZE) {
+      reader->read_rows(start, std::min(num_rows, start + DEFAULT_SARRAY_READER_BUFFER_SIZE), rows);
+      for (const auto& row : rows) {
+        *out = row;
+        ++out;
+      }
+    }
+    written.close();
+  });
+
+  // Read and decode every block of every column through the block manager.
+  auto& manager = v2_block_impl::block_manager::get_instance();
+  runner.run("v2_block_read", num_rows * written.num_columns(), [&]() {
+    std::vector<flexible_type> values;
+    for (size_t c = 0; c < written.num_columns(); ++c) {
+      auto index_info = written.select_column(c)->get_index_info();
+      for (const auto& segment_file : index_info.segment_files) {
+        auto column = manager.open_column(segment_file);
+        size_t nblocks = manager.num_blocks_in_column(column);
+        for (size_t b = 0; b < nblocks; ++b) {
+          v2_block_impl::block_address addr{std::get<0>(column),
+                                            std::get<1>(column), b};
+          ASSERT_TRUE(manager.read_typed_block(addr, values));
+        }
+        manager.close_column(column);
+      }
+    }
+  });
+}
+
+void bench_csv_ingest(benchmark::benchmark_runner& runner,
+                      const gl_sframe& data) {
+  std::string csv_file = get_temp_name() + ".csv";
+  data.save(csv_file, "csv");
+
+  csv_line_tokenizer tokenizer;
+  tokenizer.delimiter = ',';
+  tokenizer.init();
+  runner.run("csv_ingest", data.size(), [&]() {
+    sframe frame;
+    frame.init_from_csvs(csv_file,
+                         tokenizer,
+                         true,   // header
+                         false,  // do not continue on failure
+                         false,  // do not store errors
+                         std::map<std::string, flex_type_enum>());
+    ASSERT_EQ(frame.num_rows(), data.size());
+  });
+}
+
+int main(int argc, char** argv) {
+  benchmark::benchmark_options options(argc, argv);
+  benchmark::benchmark_runner runner(options);
+
+  // numeric, integer, categorical and string columns
+  gl_sframe data = _generate_random_sframe(options.num_rows, "nnzzcs",
+                                           options.seed, false, 0);
+  data.materialize();
+
+  bench_integer_pack(runner);
+  bench_v2_blocks(runner, data.materialize_to_sframe());
+  bench_csv_ingest(runner, data);
+}
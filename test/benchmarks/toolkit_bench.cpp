@@ -0,0 +1,134 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#include <atomic>
+#include <random>
+#include <ml_data/ml_data.hpp>
+#include <parallel/atomic.hpp>
+#include <parallel/lambda_omp.hpp>
+#include <sgraph/sgraph.hpp>
+#include <sgraph/sgraph_fast_triple_apply.hpp>
+#include <unity/lib/gl_sframe.hpp>
+#include <unity/toolkits/util/random_sframe_generation.hpp>
+#include <toolkits/supervised_learning/logistic_regression.hpp>
+#include <toolkits/supervised_learning/boosted_trees.hpp>
+#include "benchmark_util.hpp"
+
+using namespace turi;
+
+/*
+ * Benchmarks of the toolkit hot paths: ml_data fill and iteration, training
+ * logistic regression (LBFGS) and boosted trees, and PageRank on
+ * fast_triple_apply.
+ */
+
+static const size_t NUM_TRAINING_ITERATIONS = 10;
+static const size_t NUM_PAGERANK_ITERATIONS = 5;
+
+void bench_ml_data(benchmark::benchmark_runner& runner, const sframe& data) {
+  ml_data filled;
+  runner.run("ml_data_fill", data.num_rows(), [&]() {
+    filled = ml_data();
+    filled.fill(data, "target");
+  });
+
+  runner.run("ml_data_iterate", data.num_rows(), [&]() {
+    std::vector<double> sums(thread::cpu_count(), 0);
+    in_parallel([&](size_t thread_idx, size_t num_threads) {
+      std::vector<ml_data_entry> x;
+      for (auto it = filled.get_iterator(thread_idx, num_threads); !it.done(); ++it) {
+        it->fill(x);
+        for (const auto& e : x) sums[thread_idx] += e.value;
+      }
+    });
+  });
+}
+
+void bench_supervised(benchmark::benchmark_runner& runner,
+                      const gl_sframe& data) {
+  std::vector<std::string> features;
+  for (const auto& name : data.column_names()) {
+    if (name != "target") features.push_back(name);
+  }
+  sframe X = data.select_columns(features).materialize_to_sframe();
+  sframe y = data.select_columns({"target"}).materialize_to_sframe();
+
+  runner.run("logistic_regression_lbfgs", X.num_rows(), [&]() {
+    std::shared_ptr<supervised::logistic_regression> model;
+    model.reset(new supervised::logistic_regression);
+    model->init(X, y);
+    model->init_options({{"solver", "lbfgs"},
+                         {"max_iterations", NUM_TRAINING_ITERATIONS}});
+    model->train();
+  });
+
+  runner.run("boosted_trees_classifier", X.num_rows(), [&]() {
+    std::shared_ptr<supervised::xgboost::boosted_trees_classifier> model;
+    model.reset(new supervised::xgboost::boosted_trees_classifier);
+    model->init(X, y);
+    model->init_options({{"max_iterations", NUM_TRAINING_ITERATIONS}});
+    model->train();
+  });
+}
+
+/*
+ * The PageRank iteration of graph_analytics/pagerank_sgraph.cpp, on a
+ * random graph with num_rows edges and num_rows / 10 vertices.
+ */
+void bench_pagerank(benchmark::benchmark_runner& runner) {
+  const size_t num_edges = runner.options().num_rows;
+  const size_t num_vertices = std::max<size_t>(1, num_edges / 10);
+  std::mt19937_64 rng(runner.options().seed);
+  std::vector<flexible_type> src(num_edges), dst(num_edges);
+  for (size_t i = 0; i < num_edges; ++i) {
+    src[i] = flex_int(rng() % num_vertices);
+    dst[i] = flex_int(rng() % num_vertices);
+  }
+  gl_sframe edges({{"src", src}, {"dst", dst}});
+  sgraph g;
+  g.add_edges(edges.materialize_to_sframe(), "src", "dst");
+
+  auto degree_counts = sgraph_compute::create_vertex_data<std::atomic<size_t>>(g);
+  sgraph_compute::fast_triple_apply(g,
+                                    [&](sgraph_compute::fast_edge_scope& scope) {
+                                      auto src_addr = scope.source_vertex_address();
+                                      degree_counts[src_addr.partition_id][src_addr.local_id]++;
+                                    }, {}, {});
+
+  const double reset_probability = 0.15;
+  runner.run("pagerank_fast_triple_apply", num_edges * NUM_PAGERANK_ITERATIONS, [&]() {
+    auto cur_pagerank = sgraph_compute::create_vertex_data_from_const<turi::atomic<double>>(g, 1.0);
+    auto prev_pagerank = sgraph_compute::create_vertex_data_from_const<turi::atomic<double>>(g, 1.0);
+    for (size_t iter = 0; iter < NUM_PAGERANK_ITERATIONS; ++iter) {
+      std::swap(cur_pagerank, prev_pagerank);
+      for (auto& partition : cur_pagerank) {
+        for (auto& value : partition) value.value = reset_probability;
+      }
+      sgraph_compute::fast_triple_apply(g,
+          [&](sgraph_compute::fast_edge_scope& scope) {
+            auto source_addr = scope.source_vertex_address();
+            auto target_addr = scope.target_vertex_address();
+            double source_data = prev_pagerank[source_addr.partition_id][source_addr.local_id];
+            size_t source_degree = degree_counts[source_addr.partition_id][source_addr.local_id];
+            cur_pagerank[target_addr.partition_id][target_addr.local_id].inc(
+                (1 - reset_probability) * source_data / source_degree);
+          }, {}, {});
+    }
+  });
+}
+
+int main(int argc, char** argv) {
+  benchmark::benchmark_options options(argc, argv);
+  benchmark::benchmark_runner runner(options);
+
+  // numeric, integer and categorical features, and a binary target
+  gl_sframe data = _generate_random_classification_sframe(
+      options.num_rows, "nnnnzzc", options.seed, 2, 0, 0);
+  data.materialize();
+
+  bench_ml_data(runner, data.materialize_to_sframe());
+  bench_supervised(runner, data);
+  bench_pagerank(runner);
+}
@@ -0,0 +1,56 @@
+#define BOOST_TEST_MODULE
+#include <boost/test/unit_test.hpp>
+#include <util/test_macros.hpp>
+#include <cppipc/cppipc.hpp>
+#include <fileio/temp_files.hpp>
+#include "test_object_base.hpp"
+
+struct call_batch_test {
+ public:
+  void test_call_batch() {
+    std::string server_ipc_file = std::string("ipc://" + turi::get_temp_name());
+    cppipc::comm_server server({}, "", server_ipc_file);
+    server.register_type<test_object_base>([](){ return new test_object_impl;});
+    server.start();
+
+    cppipc::comm_client client({}, server_ipc_file);
+    client.start();
+    {
+      test_object_proxy a(client);
+      test_object_proxy b(client);
+      cppipc::call_batch batch(client);
+
+      std::vector<std::future<int>> sums;
+      for (int i = 0; i < 50; ++i) {
+        sums.push_back(a.proxy.call_async(batch, &test_object_base::add, i, 1));
+      }
+      auto set = b.proxy.call_async(batch, &test_object_base::set_value, 7);
+      auto value = b.proxy.call_async(batch, &test_object_base::get_value);
+      auto error = a.proxy.call_async(batch, &test_object_base::an_exception);
+      auto ping = a.proxy.call_async(batch, &test_object_base::ping, std::string("hello"));
+      TS_ASSERT_EQUALS(batch.size(), 54);
+
+      batch.flush();
+      TS_ASSERT_EQUALS(batch.size(), 0);
+      for (int i = 0; i < 50; ++i) {
+        TS_ASSERT_EQUALS(sums[i].get(), i + 1);
+      }
+      set.get();
+      // calls are executed in order
+      TS_ASSERT_EQUALS(value.get(), 7);
+      // a failing call does not stop the calls after it
+      TS_ASSERT_THROWS_ANYTHING(error.get());
+      TS_ASSERT_EQUALS(ping.get(), "hello");
+
+      // nothing to issue
+      batch.flush();
+    }
+    client.stop();
+  }
+};
+
+BOOST_FIXTURE_TEST_SUITE(_call_batch_test, call_batch_test)
+BOOST_AUTO_TEST_CASE(test_call_batch) {
+  call_batch_test::test_call_batch();
+}
+BOOST_AUTO_TEST_SUITE_END()
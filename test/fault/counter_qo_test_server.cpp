@@ -0,0 +1,62 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#include <iostream>
+#include <fault/query_object_server_process.hpp>
+
+using namespace libfault;
+
+/*
+ * A query object holding a counter. An update adds the 8 byte integer of
+ * the message to the counter, and a query returns the counter.
+ * Unlike the echo server, nothing is printed, so that it can be used to
+ * measure update throughput (see qo_update_throughput_test).
+ */
+class counter_server: public query_object {
+ private:
+   uint64_t counter;
+ public:
+   counter_server() {
+     counter = 0;
+   }
+  void query(char* msg, size_t msglen,
+             char** outreply, size_t *outreplylen) {
+    (*outreply) = (char*)malloc(sizeof(uint64_t));
+    (*outreplylen) = sizeof(uint64_t);
+    (*(uint64_t*)(*outreply)) = counter;
+  }
+
+  bool update(char* msg, size_t msglen,
+              char** outreply, size_t *outreplylen) {
+    assert(msglen == sizeof(uint64_t));
+    counter += (*(uint64_t*)msg);
+    (*outreply) = (char*)malloc(sizeof(uint64_t));
+    (*outreplylen) = sizeof(uint64_t);
+    (*(uint64_t*)(*outreply)) = counter;
+    return true;
+  }
+
+  void serialize(char** outbuf, size_t *outbuflen) {
+    (*outbuf) = (char*)malloc(sizeof(uint64_t));
+    (*(uint64_t*)(*outbuf)) = counter;
+    (*outbuflen ) = sizeof(uint64_t);
+  }
+  void deserialize(const char* buf, size_t buflen) {
+    assert(buflen == sizeof(uint64_t));
+    counter = (*(uint64_t*)(buf));
+  }
+
+  static query_object* factory(std::string objectkey,
+                               std::vector<std::string> zk_hosts,
+                               std::string zk_prefix,
+                               uint64_t create_flags) {
+    return new counter_server;
+  }
+};
+
+
+int main(int argc, char** argv) {
+  query_main(argc, argv, counter_server::factory);
+}
@@ -0,0 +1,76 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#include <iostream>
+#include <deque>
+#include <cstdlib>
+#include <cstring>
+#include <zmq_utils.h>
+#include <fault/query_object_client.hpp>
+
+using namespace libfault;
+
+/*
+ * Measures the update throughput of a counter_qo_test_server object, keeping
+ * [concurrency] updates in flight. Every update adds 1 to the counter, so
+ * after the run, the counter must have grown by [nupdates].
+ *
+ * Starting several of these processes against the same object, with
+ * increasing concurrency, shows the throughput gained by group commit in
+ * the master (see QO_SERVER_GROUP_COMMIT_MAX_LATENCY_US and
+ * QO_SERVER_NUM_REPLY_THREADS).
+ */
+int main(int argc, char** argv) {
+  if (argc != 6) {
+    std::cout << "Usage: qo_update_throughput_test [zkhost] [prefix] [objectkey] "
+              << "[concurrency] [nupdates]\n";
+    return 0;
+  }
+  std::string zkhost = argv[1];
+  std::string prefix = argv[2];
+  std::string objectkey = argv[3];
+  size_t concurrency = atoi(argv[4]);
+  size_t nupdates = atoi(argv[5]);
+  std::vector<std::string> zkhosts; zkhosts.push_back(zkhost);
+
+  void* zmq_ctx = zmq_ctx_new();
+  query_object_client client(zmq_ctx, zkhosts, prefix);
+  void* handle = client.get_object_handle(objectkey);
+  if (handle == NULL) {
+    std::cout << "Unable to connect to " << objectkey << "\n";
+    return 1;
+  }
+
+  size_t failed = 0;
+  std::deque<query_object_client::query_result> in_flight;
+  void* t = zmq_stopwatch_start();
+  for (size_t i = 0;i < nupdates; ++i) {
+    if (in_flight.size() >= concurrency) {
+      if (in_flight.front().get_status() != 0) ++failed;
+      in_flight.pop_front();
+    }
+    // the client takes over the pointer
+    char* msg = (char*)malloc(sizeof(uint64_t));
+    (*(uint64_t*)msg) = 1;
+    in_flight.push_back(client.update(handle, msg, sizeof(uint64_t)));
+  }
+  while (!in_flight.empty()) {
+    if (in_flight.front().get_status() != 0) ++failed;
+    in_flight.pop_front();
+  }
+  unsigned long elapsed = zmq_stopwatch_stop(t);
+
+  query_object_client::query_result res = client.query(handle, NULL, 0);
+  uint64_t counter = 0;
+  if (res.get_status() == 0 && res.get_reply().length() == sizeof(uint64_t)) {
+    memcpy(&counter, res.get_reply().c_str(), sizeof(uint64_t));
+  }
+
+  std::cout << nupdates << " updates, " << concurrency << " in flight: "
+            << double(elapsed) / 1000000 << " s, "
+            << double(nupdates) * 1000000 / double(elapsed) << " updates/s\n";
+  std::cout << "Failed: " << failed << ". Counter: " << counter << "\n";
+  return failed == 0 ? 0 : 1;
+}
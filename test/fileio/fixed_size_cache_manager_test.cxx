@@ -60,6 +60,7 @@ struct fixed_size_cache_manager_test {
     }
     // Throws exception when trying to get an invalid cache_id.
     TS_ASSERT_THROWS_ANYTHING(fixed_size_cache_manager::get_instance().get_cache(make_cache_id(11)));
+    TS_ASSERT_THROWS_ANYTHING(fixed_size_cache_manager::get_instance().is_in_memory(make_cache_id(11)));
 
     // Check the block data.
     for (size_t i = 0; i < 10; ++i) {
@@ -75,7 +76,9 @@ struct fixed_size_cache_manager_test {
     for (size_t i = 0; i < 10; ++i) {
       auto blk = fixed_size_cache_manager::get_instance().get_cache(make_cache_id(i));
       blk->write_bytes_to_memory_cache(reinterpret_cast<char*>(&i), sizeof(size_t));
+      TS_ASSERT(fixed_size_cache_manager::get_instance().is_in_memory(make_cache_id(i)));
       blk->write_to_file();
+      TS_ASSERT(!fixed_size_cache_manager::get_instance().is_in_memory(make_cache_id(i)));
     }
 
     for (size_t i = 0; i < 10; ++i) {
@@ -109,11 +112,27 @@ struct fixed_size_cache_manager_test {
 
 struct cache_eviction_test {
  public:
+  cache_eviction_test()
+      : m_max_capacity(FILEIO_MAXIMUM_CACHE_CAPACITY),
+        m_max_capacity_per_file(FILEIO_MAXIMUM_CACHE_CAPACITY_PER_FILE),
+        m_spill_high_watermark(FILEIO_CACHE_SPILL_HIGH_WATERMARK),
+        m_spill_low_watermark(FILEIO_CACHE_SPILL_LOW_WATERMARK) { }
+
+  ~cache_eviction_test() {
+    fixed_size_cache_manager::get_instance().clear();
+    FILEIO_MAXIMUM_CACHE_CAPACITY = m_max_capacity;
+    FILEIO_MAXIMUM_CACHE_CAPACITY_PER_FILE = m_max_capacity_per_file;
+    FILEIO_CACHE_SPILL_HIGH_WATERMARK = m_spill_high_watermark;
+    FILEIO_CACHE_SPILL_LOW_WATERMARK = m_spill_low_watermark;
+  }
+
   void test_cache_eviction_mechanism() {
     // set cache cap to 64K
     auto& cache_instance = fixed_size_cache_manager::get_instance();
     turi::fileio::FILEIO_MAXIMUM_CACHE_CAPACITY = 64*1024;
     turi::fileio::FILEIO_MAXIMUM_CACHE_CAPACITY_PER_FILE = 32*1024;
+    // only evict synchronously, when the cache is full
+    turi::fileio::FILEIO_CACHE_SPILL_HIGH_WATERMARK = 100;
     // now create a sequence of files ranging from 1K,2K,4K... 64K,128K,256K
     std::map<size_t, std::string> size_to_file;
     size_t fsize = 1024;
@@ -129,15 +148,15 @@ struct cache_eviction_test {
     // then when I write 128K, there is enough capacity to hold 1K -- 16K and to allocate 
     //        a new 32K block. So nothing else is evicted
     // similarly for 256K
-    TS_ASSERT_EQUALS(cache_instance.get_cache(size_to_file[1*1024])->is_pointer(), true);
-    TS_ASSERT_EQUALS(cache_instance.get_cache(size_to_file[2*1024])->is_pointer(), true);
-    TS_ASSERT_EQUALS(cache_instance.get_cache(size_to_file[4*1024])->is_pointer(), true);
-    TS_ASSERT_EQUALS(cache_instance.get_cache(size_to_file[8*1024])->is_pointer(), true);
-    TS_ASSERT_EQUALS(cache_instance.get_cache(size_to_file[16*1024])->is_pointer(), true);
-    TS_ASSERT_EQUALS(cache_instance.get_cache(size_to_file[32*1024])->is_pointer(), true);
-    TS_ASSERT_EQUALS(cache_instance.get_cache(size_to_file[64*1024])->is_pointer(), false);
-    TS_ASSERT_EQUALS(cache_instance.get_cache(size_to_file[128*1024])->is_pointer(), false);
-    TS_ASSERT_EQUALS(cache_instance.get_cache(size_to_file[256*1024])->is_pointer(), false);
+    TS_ASSERT_EQUALS(cache_instance.is_in_memory(size_to_file[1*1024]), true);
+    TS_ASSERT_EQUALS(cache_instance.is_in_memory(size_to_file[2*1024]), true);
+    TS_ASSERT_EQUALS(cache_instance.is_in_memory(size_to_file[4*1024]), true);
+    TS_ASSERT_EQUALS(cache_instance.is_in_memory(size_to_file[8*1024]), true);
+    TS_ASSERT_EQUALS(cache_instance.is_in_memory(size_to_file[16*1024]), true);
+    TS_ASSERT_EQUALS(cache_instance.is_in_memory(size_to_file[32*1024]), true);
+    TS_ASSERT_EQUALS(cache_instance.is_in_memory(size_to_file[64*1024]), false);
+    TS_ASSERT_EQUALS(cache_instance.is_in_memory(size_to_file[128*1024]), false);
+    TS_ASSERT_EQUALS(cache_instance.is_in_memory(size_to_file[256*1024]), false);
     // now to verify that things don't get evicted while it is still in size.
     // we are going to open the last one which is in memory (16K)
     // and set the cache block size to be large enough so that it will try to evict
@@ -148,12 +167,49 @@ struct cache_eviction_test {
     // a reference to it, it should not evict it, but should evict 2K
     std::string fname = cache_instance.get_temp_cache_id();
     turi::general_ofstream fout(fname);
-    TS_ASSERT_EQUALS(cache_instance.get_cache(size_to_file[16*1024])->is_pointer(), true);
-    TS_ASSERT_EQUALS(cache_instance.get_cache(size_to_file[8*1024])->is_pointer(), true);
-    TS_ASSERT_EQUALS(cache_instance.get_cache(size_to_file[4*1024])->is_pointer(), true);
-    TS_ASSERT_EQUALS(cache_instance.get_cache(size_to_file[2*1024])->is_pointer(), true);
-    TS_ASSERT_EQUALS(cache_instance.get_cache(size_to_file[1*1024])->is_pointer(), true);
+    TS_ASSERT_EQUALS(cache_instance.is_in_memory(size_to_file[16*1024]), true);
+    TS_ASSERT_EQUALS(cache_instance.is_in_memory(size_to_file[8*1024]), true);
+    TS_ASSERT_EQUALS(cache_instance.is_in_memory(size_to_file[4*1024]), true);
+    TS_ASSERT_EQUALS(cache_instance.is_in_memory(size_to_file[2*1024]), true);
+    TS_ASSERT_EQUALS(cache_instance.is_in_memory(size_to_file[1*1024]), true);
   }
+
+  void test_background_spill() {
+    auto& cache_instance = fixed_size_cache_manager::get_instance();
+    cache_instance.clear();
+    turi::fileio::FILEIO_MAXIMUM_CACHE_CAPACITY = 64*1024;
+    turi::fileio::FILEIO_MAXIMUM_CACHE_CAPACITY_PER_FILE = 32*1024;
+    turi::fileio::FILEIO_CACHE_SPILL_HIGH_WATERMARK = 50;
+    turi::fileio::FILEIO_CACHE_SPILL_LOW_WATERMARK = 25;
+    // write 6 files of 8K. Once more than 32K is used, the oldest idle
+    // files are spilled in the background until at most 16K is used.
+    std::vector<std::string> files;
+    for (size_t i = 0; i < 6; ++i) {
+      std::string fname = cache_instance.get_temp_cache_id();
+      turi::general_ofstream fout(fname);
+      fout << std::string(8*1024, 'a' + i);
+      fout.close();
+      files.push_back(fname);
+    }
+    cache_instance.wait_for_spill();
+    TS_ASSERT_LESS_THAN_EQUALS(cache_instance.get_cache_utilization(), 32*1024);
+    // least recently used first
+    TS_ASSERT_EQUALS(cache_instance.is_in_memory(files[0]), false);
+    TS_ASSERT_EQUALS(cache_instance.is_in_memory(files[5]), true);
+    // the contents are preserved wherever they are
+    for (size_t i = 0; i < files.size(); ++i) {
+      turi::general_ifstream fin(files[i]);
+      std::string contents((std::istreambuf_iterator<char>(fin)),
+                           std::istreambuf_iterator<char>());
+      TS_ASSERT(contents == std::string(8*1024, 'a' + i));
+    }
+  }
+
+ private:
+  size_t m_max_capacity;
+  size_t m_max_capacity_per_file;
+  size_t m_spill_high_watermark;
+  size_t m_spill_low_watermark;
 };
 
 BOOST_FIXTURE_TEST_SUITE(_fixed_size_cache_manager_test, fixed_size_cache_manager_test)
@@ -174,4 +230,7 @@ BOOST_FIXTURE_TEST_SUITE(_cache_eviction_test, cache_eviction_test)
 BOOST_AUTO_TEST_CASE(test_cache_eviction_mechanism) {
   cache_eviction_test::test_cache_eviction_mechanism();
 }
+BOOST_AUTO_TEST_CASE(test_background_spill) {
+  cache_eviction_test::test_background_spill();
+}
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,101 @@
+#define BOOST_TEST_MODULE
+#include <boost/test/unit_test.hpp>
+#include <util/test_macros.hpp>
+#include <sstream>
+#include <fileio/memory_budget.hpp>
+#include <fileio/fileio_constants.hpp>
+
+using namespace turi::fileio;
+
+struct memory_budget_test {
+ public:
+  memory_budget_test() {
+    old_budget = FILEIO_MEMORY_BUDGET;
+    FILEIO_MEMORY_BUDGET = 1000;
+  }
+
+  ~memory_budget_test() {
+    FILEIO_MEMORY_BUDGET = old_budget;
+  }
+
+  memory_budget::consumer_report report_of(const std::string& consumer) {
+    for (const auto& c : memory_budget::get_instance().report()) {
+      if (c.consumer == consumer) return c;
+    }
+    return memory_budget::consumer_report();
+  }
+
+  void test_reserve() {
+    auto& budget = memory_budget::get_instance();
+    size_t used = budget.used();
+    {
+      auto r1 = budget.reserve("test_sort", 600, 100);
+      TS_ASSERT_EQUALS(r1.size(), 600);
+      // partially granted
+      auto r2 = budget.reserve("test_join", 600, 100);
+      TS_ASSERT_EQUALS(r2.size(), 400 - used);
+      // the minimum is granted even if it overcommits
+      auto r3 = budget.reserve("test_join", 600, 100);
+      TS_ASSERT_EQUALS(r3.size(), 100);
+      TS_ASSERT_EQUALS(report_of("test_join").num_denials, 2);
+      TS_ASSERT(!r1.try_grow(700));
+      r1.shrink(200);
+      TS_ASSERT_EQUALS(r1.size(), 200);
+      // moving transfers the reservation
+      memory_budget::reservation r4 = std::move(r3);
+      TS_ASSERT_EQUALS(r3.size(), 0);
+      TS_ASSERT_EQUALS(r4.size(), 100);
+      TS_ASSERT_EQUALS(report_of("test_join").bytes, 500 - used);
+    }
+    TS_ASSERT_EQUALS(budget.used(), used);
+    TS_ASSERT_EQUALS(report_of("test_sort").peak_bytes, 600);
+  }
+
+  void test_reclaim() {
+    auto& budget = memory_budget::get_instance();
+    size_t used = budget.used();
+    TS_ASSERT(budget.try_acquire("test_cache", 900 - used));
+    size_t reclaimed = 0;
+    size_t id = budget.register_reclaimer("test_cache", [&](size_t bytes) {
+      reclaimed += bytes;
+      budget.release("test_cache", 500);
+    });
+    // the consumer's own requests do not trigger its reclaimer
+    TS_ASSERT(!budget.try_acquire("test_cache", 200));
+    TS_ASSERT_EQUALS(reclaimed, 0);
+    // other consumers' requests do
+    TS_ASSERT(budget.try_acquire("test_groupby", 200));
+    TS_ASSERT_EQUALS(reclaimed, 200);
+    budget.unregister_reclaimer(id);
+    budget.release("test_groupby", 200);
+    budget.release("test_cache", 400 - used);
+    TS_ASSERT_EQUALS(budget.used(), used);
+
+    std::stringstream strm;
+    budget.print_report(strm);
+    TS_ASSERT(strm.str().find("test_cache") != std::string::npos);
+  }
+
+  void test_unlimited() {
+    FILEIO_MEMORY_BUDGET = 0;
+    auto& budget = memory_budget::get_instance();
+    TS_ASSERT_EQUALS(budget.capacity(), (size_t)(-1));
+    auto r = budget.reserve("test_sort", size_t(1) << 40);
+    TS_ASSERT_EQUALS(r.size(), size_t(1) << 40);
+  }
+
+ private:
+  size_t old_budget;
+};
+
+BOOST_FIXTURE_TEST_SUITE(_memory_budget_test, memory_budget_test)
+BOOST_AUTO_TEST_CASE(test_reserve) {
+  memory_budget_test::test_reserve();
+}
+BOOST_AUTO_TEST_CASE(test_reclaim) {
+  memory_budget_test::test_reclaim();
+}
+BOOST_AUTO_TEST_CASE(test_unlimited) {
+  memory_budget_test::test_unlimited();
+}
+BOOST_AUTO_TEST_SUITE_END()
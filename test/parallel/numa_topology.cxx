@@ -0,0 +1,88 @@
+#define BOOST_TEST_MODULE
+#include <boost/test/unit_test.hpp>
+#include <util/test_macros.hpp>
+#include <parallel/numa_topology.hpp>
+#include <parallel/thread_pool.hpp>
+#include <parallel/lambda_omp.hpp>
+#include <parallel/atomic.hpp>
+
+using namespace turi;
+
+struct numa_topology_test {
+ public:
+  void test_parse_cpu_list() {
+    TS_ASSERT(numa_topology::parse_cpu_list("0-3,8,10-11") ==
+              std::vector<size_t>({0, 1, 2, 3, 8, 10, 11}));
+    TS_ASSERT(numa_topology::parse_cpu_list("5\n") == std::vector<size_t>({5}));
+    TS_ASSERT(numa_topology::parse_cpu_list("").empty());
+    TS_ASSERT(numa_topology::parse_cpu_list("x,3-1,2") == std::vector<size_t>({2}));
+  }
+
+  void test_placement() {
+    // two nodes with interleaved CPUs, and a node without CPUs
+    numa_topology topology({{0, 2, 4, 6}, {}, {1, 3, 5, 7}});
+    TS_ASSERT_EQUALS(topology.num_nodes(), 2);
+    TS_ASSERT_EQUALS(topology.node_of_cpu(3), 1);
+    TS_ASSERT_EQUALS(topology.node_of_cpu(4), 0);
+    TS_ASSERT_EQUALS(topology.node_of_cpu(100), 0);
+    TS_ASSERT_EQUALS(topology.num_worker_groups(1), 1);
+    TS_ASSERT_EQUALS(topology.num_worker_groups(8), 2);
+
+    // the workers of a node are contiguous, and the nodes balanced
+    std::vector<size_t> workers_of_node(2, 0);
+    for (size_t i = 0; i < 7; ++i) {
+      size_t node = topology.node_of_worker(i, 7);
+      if (i > 0) TS_ASSERT_LESS_THAN_EQUALS(topology.node_of_worker(i - 1, 7), node);
+      ++workers_of_node[node];
+    }
+    TS_ASSERT_EQUALS(workers_of_node[0] + workers_of_node[1], 7);
+    TS_ASSERT_LESS_THAN_EQUALS(workers_of_node[1], workers_of_node[0] + 1);
+    TS_ASSERT_LESS_THAN_EQUALS(workers_of_node[0], workers_of_node[1] + 1);
+
+    numa_topology single({});
+    TS_ASSERT_EQUALS(single.num_nodes(), 1);
+    TS_ASSERT(single.cpus_of_node(0).empty());
+    TS_ASSERT_EQUALS(single.node_of_worker(5, 8), 0);
+    TS_ASSERT(!single.bind_current_thread(0));
+  }
+
+  void test_thread_pool_groups() {
+    const numa_topology& topology = numa_topology::get_instance();
+    TS_ASSERT_LESS_THAN_EQUALS(1, topology.num_nodes());
+    TS_ASSERT_LESS_THAN(topology.current_node(), topology.num_nodes());
+
+    thread_pool pool(4, true);
+    TS_ASSERT_EQUALS(pool.num_worker_groups(), topology.num_worker_groups(4));
+    for (size_t i = 0; i < 4; ++i) {
+      TS_ASSERT_LESS_THAN(pool.worker_group(i), pool.num_worker_groups());
+    }
+    pool.set_cpu_affinity(false);
+    TS_ASSERT_EQUALS(pool.num_worker_groups(), 1);
+    pool.set_cpu_affinity(true);
+
+    // every task runs, with or without a virtual thread ID
+    atomic<size_t> counter;
+    parallel_task_queue queue(pool);
+    for (size_t i = 0; i < 100; ++i) {
+      queue.launch([&]() { counter.inc(); }, i % 2 ? -1 : i);
+    }
+    queue.join();
+    TS_ASSERT_EQUALS(counter.value, 100);
+
+    pool.resize(2);
+    in_parallel([&](size_t, size_t) { counter.inc(); });
+    TS_ASSERT_EQUALS(counter.value, 100 + thread_pool::get_instance().size());
+  }
+};
+
+BOOST_FIXTURE_TEST_SUITE(_numa_topology_test, numa_topology_test)
+BOOST_AUTO_TEST_CASE(test_parse_cpu_list) {
+  numa_topology_test::test_parse_cpu_list();
+}
+BOOST_AUTO_TEST_CASE(test_placement) {
+  numa_topology_test::test_placement();
+}
+BOOST_AUTO_TEST_CASE(test_thread_pool_groups) {
+  numa_topology_test::test_thread_pool_groups();
+}
+BOOST_AUTO_TEST_SUITE_END()
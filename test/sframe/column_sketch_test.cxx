@@ -0,0 +1,205 @@
+#define BOOST_TEST_MODULE
+#include <boost/test/unit_test.hpp>
+#include <util/test_macros.hpp>
+#include <cmath>
+#include <sframe/sframe.hpp>
+#include <sframe/column_sketch.hpp>
+#include <sframe/sframe_constants.hpp>
+#include <sframe/testing_utils.hpp>
+#include <fileio/temp_files.hpp>
+
+using namespace turi;
+
+struct column_sketch_test {
+ public:
+  /// i % 100 for i in [begin, end), with every 10th value missing.
+  column_sketch make_sketch(size_t begin, size_t end) {
+    column_sketch ret;
+    for (size_t i = begin; i < end; ++i) {
+      if (i % 10 == 0) ret.add(FLEX_UNDEFINED);
+      else ret.add(flex_int(i % 100));
+    }
+    ret.finalize();
+    return ret;
+  }
+
+  void check_whole_sketch(const column_sketch& sketch) {
+    TS_ASSERT_EQUALS(sketch.size(), 10000);
+    TS_ASSERT_EQUALS(sketch.num_undefined(), 1000);
+    TS_ASSERT_EQUALS(sketch.num_numeric(), 9000);
+    TS_ASSERT(sketch.min() == flex_int(1));
+    TS_ASSERT(sketch.max() == flex_int(99));
+    TS_ASSERT_DELTA(sketch.sum(), 450000, 1e-6);
+    TS_ASSERT_DELTA(sketch.mean(), 50, 1e-6);
+    TS_ASSERT_DELTA(sketch.num_unique(), 90, 5);
+    auto quantiles = sketch.quantiles();
+    TS_ASSERT_DELTA(quantiles.query_quantile(0.5), 50, 2);
+    TS_ASSERT_EQUALS(sketch.frequent_items().size(), 90);
+    TS_ASSERT_EQUALS(sketch.frequent_items()[0].second, 100);
+    TS_ASSERT_EQUALS(sketch.frequent_items_cutoff(), 0);
+  }
+
+  void test_add_and_merge() {
+    column_sketch whole = make_sketch(0, 10000);
+    check_whole_sketch(whole);
+
+    column_sketch a = make_sketch(0, 3000);
+    column_sketch b = make_sketch(3000, 3000);
+    column_sketch c = make_sketch(3000, 10000);
+    column_sketch merged = column_sketch::merge({&a, &b, &c});
+    check_whole_sketch(merged);
+    TS_ASSERT_DELTA(merged.m2(), whole.m2(), 1e-6 * whole.m2());
+
+    // strings and NaN
+    column_sketch strings;
+    strings.add("b");
+    strings.add("a");
+    strings.add("b");
+    strings.finalize();
+    TS_ASSERT(strings.min() == "a");
+    TS_ASSERT(strings.max() == "b");
+    TS_ASSERT_EQUALS(strings.num_numeric(), 0);
+    TS_ASSERT(strings.frequent_items()[0].first == "b");
+
+    column_sketch floats;
+    floats.add(NAN);
+    floats.add(1.5);
+    floats.finalize();
+    TS_ASSERT_EQUALS(floats.size(), 2);
+    TS_ASSERT_EQUALS(floats.num_numeric(), 1);
+    TS_ASSERT(floats.min() == 1.5);
+  }
+
+  void test_truncated_frequent_items() {
+    // more distinct values than are kept: 1 is frequent, the rest are not
+    column_sketch a;
+    for (size_t i = 0; i < 500; ++i) a.add(flex_int(1));
+    for (size_t i = 10; i < 3000; ++i) a.add(flex_int(i));
+    a.finalize();
+    TS_ASSERT_LESS_THAN_EQUALS(a.frequent_items().size(),
+                               column_sketch::MAX_FREQUENT_ITEMS);
+    TS_ASSERT_LESS_THAN(0, a.frequent_items_cutoff());
+    TS_ASSERT(a.frequent_items()[0].first == flex_int(1));
+
+    column_sketch b;
+    for (size_t i = 0; i < 10; ++i) b.add(flex_int(1));
+    for (size_t i = 0; i < 20; ++i) b.add(flex_int(2));
+    b.finalize();
+    TS_ASSERT_EQUALS(b.frequent_items_cutoff(), 0);
+
+    // 2 is left out of a, so its summed count could be short: it is not
+    // listed, and the cutoff bounds it instead
+    column_sketch merged = column_sketch::merge({&a, &b});
+    TS_ASSERT(merged.frequent_items()[0].first == flex_int(1));
+    TS_ASSERT_LESS_THAN_EQUALS(510, merged.frequent_items()[0].second);
+    for (const auto& item: merged.frequent_items()) {
+      TS_ASSERT(item.first != flex_int(2));
+    }
+    TS_ASSERT_LESS_THAN_EQUALS(20 + a.frequent_items_cutoff(),
+                               merged.frequent_items_cutoff());
+
+    // complete sketches merge into a complete sketch
+    column_sketch c;
+    c.add(flex_int(2));
+    c.finalize();
+    column_sketch complete = column_sketch::merge({&b, &c});
+    TS_ASSERT_EQUALS(complete.frequent_items_cutoff(), 0);
+    TS_ASSERT(complete.frequent_items()[0].first == flex_int(2));
+    TS_ASSERT_EQUALS(complete.frequent_items()[0].second, 21);
+
+    oarchive oarc;
+    oarc << merged;
+    iarchive iarc(oarc.buf, oarc.off);
+    column_sketch loaded;
+    iarc >> loaded;
+    free(oarc.buf);
+    TS_ASSERT_EQUALS(loaded.frequent_items_cutoff(), merged.frequent_items_cutoff());
+  }
+
+  void test_serialization() {
+    column_sketch sketch = make_sketch(0, 10000);
+    oarchive oarc;
+    oarc << sketch;
+    iarchive iarc(oarc.buf, oarc.off);
+    column_sketch loaded;
+    iarc >> loaded;
+    free(oarc.buf);
+    check_whole_sketch(loaded);
+  }
+
+  void test_saved_sketches() {
+    std::vector<std::vector<flexible_type>> data;
+    for (size_t i = 0; i < 10000; ++i) {
+      data.push_back({i % 10 == 0 ? FLEX_UNDEFINED : flexible_type(flex_int(i % 100)),
+                      "s" + std::to_string(i % 7),
+                      flex_list{flex_int(i)}});
+    }
+    sframe sf = make_testing_sframe({"int", "str", "list"},
+                                    {flex_type_enum::INTEGER,
+                                     flex_type_enum::STRING,
+                                     flex_type_enum::LIST},
+                                    data);
+    // only saved arrays carry sketches
+    TS_ASSERT(sarray_column_sketch(*sf.select_column(0)) == nullptr);
+
+    std::string index_file = get_temp_name() + ".frame_idx";
+    sf.save(index_file);
+    sframe saved(index_file);
+
+    auto int_sketch = sarray_column_sketch(*saved.select_column(0));
+    TS_ASSERT(int_sketch != nullptr);
+    check_whole_sketch(*int_sketch);
+    auto str_sketch = sarray_column_sketch(*saved.select_column(1));
+    TS_ASSERT(str_sketch != nullptr);
+    TS_ASSERT_DELTA(str_sketch->num_unique(), 7, 0.5);
+    TS_ASSERT(sarray_column_sketch(*saved.select_column(2)) == nullptr);
+
+    // missing values count as one distinct value
+    double num_distinct = 0;
+    TS_ASSERT(estimate_num_distinct(saved, {0}, num_distinct));
+    TS_ASSERT_DELTA(num_distinct, 91, 5);
+    TS_ASSERT(estimate_num_distinct(saved, {0, 1}, num_distinct));
+    TS_ASSERT_DELTA(num_distinct, 91 * 7, 40);
+    TS_ASSERT(!estimate_num_distinct(saved, {2}, num_distinct));
+
+    // saving again reuses the sketches
+    std::string index_file2 = get_temp_name() + ".frame_idx";
+    saved.save(index_file2);
+    check_whole_sketch(*sarray_column_sketch(*sframe(index_file2).select_column(0)));
+
+    // every saved segment carries the sketch of its own rows
+    std::string index_file4 = get_temp_name() + ".frame_idx";
+    size_t old_min_segment_size = SFRAME_SAVE_MIN_SEGMENT_SIZE;
+    SFRAME_SAVE_MIN_SEGMENT_SIZE = 1;
+    sf.save(index_file4);
+    SFRAME_SAVE_MIN_SEGMENT_SIZE = old_min_segment_size;
+    auto index4 = sframe(index_file4).select_column(0)->get_index_info();
+    auto segment_sketches = read_column_segment_sketches(index4);
+    TS_ASSERT_EQUALS(segment_sketches.size(), index4.segment_sizes.size());
+    for (size_t i = 0; i < segment_sketches.size(); ++i) {
+      TS_ASSERT_EQUALS(segment_sketches[i]->size(), index4.segment_sizes[i]);
+    }
+    check_whole_sketch(*read_column_sketch(index4));
+
+    std::string index_file3 = get_temp_name() + ".frame_idx";
+    SFRAME_SAVE_COLUMN_SKETCHES = false;
+    saved.save(index_file3);
+    SFRAME_SAVE_COLUMN_SKETCHES = true;
+    TS_ASSERT(sarray_column_sketch(*sframe(index_file3).select_column(0)) == nullptr);
+  }
+};
+
+BOOST_FIXTURE_TEST_SUITE(_column_sketch_test, column_sketch_test)
+BOOST_AUTO_TEST_CASE(test_add_and_merge) {
+  column_sketch_test::test_add_and_merge();
+}
+BOOST_AUTO_TEST_CASE(test_truncated_frequent_items) {
+  column_sketch_test::test_truncated_frequent_items();
+}
+BOOST_AUTO_TEST_CASE(test_serialization) {
+  column_sketch_test::test_serialization();
+}
+BOOST_AUTO_TEST_CASE(test_saved_sketches) {
+  column_sketch_test::test_saved_sketches();
+}
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,126 @@
+#define BOOST_TEST_MODULE
+#include <boost/test/unit_test.hpp>
+#include <util/test_macros.hpp>
+#include <fileio/temp_files.hpp>
+#include <sframe/sarray_file_format_v2.hpp>
+#include <sframe/sarray_v2_decoded_block_cache.hpp>
+#include <sframe/sframe_constants.hpp>
+
+using namespace turi;
+using namespace turi::v2_block_impl;
+
+struct decoded_block_cache_test {
+ public:
+  typedef decoded_block_cache::block_ptr block_ptr;
+
+  block_ptr make_block(size_t n) {
+    return std::make_shared<std::vector<flexible_type>>(n, flex_int(n));
+  }
+
+  void test_admission_and_eviction() {
+    auto& cache = decoded_block_cache::get_instance();
+    size_t old_capacity = SFRAME_DECODED_BLOCK_CACHE_CAPACITY;
+    SFRAME_DECODED_BLOCK_CACHE_CAPACITY = 1000;
+    cache.clear();
+    std::string file = get_temp_name();
+    auto stats = cache.get_stats();
+
+    // a block is only admitted on its second miss
+    bool should_admit = true;
+    TS_ASSERT(cache.find(file, 0, 0, should_admit) == nullptr);
+    TS_ASSERT(!should_admit);
+    TS_ASSERT(cache.find(file, 0, 0, should_admit) == nullptr);
+    TS_ASSERT(should_admit);
+    cache.insert(file, 0, 0, make_block(10), 400);
+    block_ptr block = cache.find(file, 0, 0, should_admit);
+    TS_ASSERT(block != nullptr);
+    TS_ASSERT_EQUALS(block->size(), 10);
+    TS_ASSERT_EQUALS(cache.get_stats().hits, stats.hits + 1);
+    TS_ASSERT_EQUALS(cache.get_stats().misses, stats.misses + 2);
+
+    // block 0 is pinned while held: block 2 replaces block 1
+    cache.insert(file, 0, 1, make_block(1), 400);
+    cache.insert(file, 0, 2, make_block(2), 400);
+    TS_ASSERT(cache.find(file, 0, 0, should_admit) != nullptr);
+    TS_ASSERT_EQUALS(cache.get_stats().num_blocks, 2);
+    TS_ASSERT_LESS_THAN_EQUALS(cache.get_stats().size_in_bytes, 1000);
+
+    // too large
+    cache.insert(file, 1, 0, make_block(1), 2000);
+    TS_ASSERT(cache.find(file, 1, 0, should_admit) == nullptr);
+
+    // unpinned, it can be evicted
+    block.reset();
+    cache.insert(file, 0, 3, make_block(3), 900);
+    TS_ASSERT_EQUALS(cache.get_stats().num_blocks, 1);
+    TS_ASSERT(cache.find(file, 0, 3, should_admit) != nullptr);
+
+    cache.invalidate_file(file);
+    TS_ASSERT_EQUALS(cache.get_stats().num_blocks, 0);
+    TS_ASSERT_EQUALS(cache.get_stats().size_in_bytes, 0);
+    SFRAME_DECODED_BLOCK_CACHE_CAPACITY = old_capacity;
+  }
+
+  void test_shared_across_readers() {
+    auto& cache = decoded_block_cache::get_instance();
+    cache.clear();
+    std::string test_file_name = get_temp_name() + ".sidx";
+    {
+      sarray_group_format_writer_v2<flexible_type> group_writer;
+      group_writer.open(test_file_name, 4, 1);
+      for (size_t i = 0; i < 4; ++i) {
+        for (size_t j = 0; j < 100000; ++j) {
+          group_writer.write_segment(0, i, "s" + std::to_string(i * 100000 + j));
+        }
+      }
+      group_writer.close();
+      group_writer.write_index_file();
+    }
+
+    // scans, then random reads, by independent readers
+    auto hits = cache.get_stats().hits;
+    for (size_t pass = 0; pass < 3; ++pass) {
+      sarray_format_reader_v2<flexible_type> reader;
+      reader.open(test_file_name + ":0");
+      std::vector<flexible_type> vals;
+      for (size_t start = 0; start < 400000; start += 1000) {
+        reader.read_rows(start, start + 1000, vals);
+        TS_ASSERT_EQUALS(vals.size(), 1000);
+        TS_ASSERT_EQUALS(vals[0], "s" + std::to_string(start));
+        TS_ASSERT_EQUALS(vals[999], "s" + std::to_string(start + 999));
+      }
+    }
+    // the third pass reads from the cache
+    TS_ASSERT_LESS_THAN(hits, cache.get_stats().hits);
+
+    for (size_t pass = 0; pass < 2; ++pass) {
+      sarray_format_reader_v2<flexible_type> reader;
+      reader.open(test_file_name + ":0");
+      std::vector<flexible_type> vals;
+      for (size_t start = 350000; start > 0; start -= 50000) {
+        reader.read_rows(start + 10, start + 20, vals);
+        TS_ASSERT_EQUALS(vals.size(), 10);
+        TS_ASSERT_EQUALS(vals[0], "s" + std::to_string(start + 10));
+      }
+    }
+
+    // rewriting the file drops its blocks
+    TS_ASSERT_LESS_THAN(0, cache.get_stats().num_blocks);
+    {
+      sarray_group_format_writer_v2<flexible_type> group_writer;
+      group_writer.open(test_file_name, 4, 1);
+      group_writer.close();
+      group_writer.write_index_file();
+    }
+    TS_ASSERT_EQUALS(cache.get_stats().num_blocks, 0);
+  }
+};
+
+BOOST_FIXTURE_TEST_SUITE(_decoded_block_cache_test, decoded_block_cache_test)
+BOOST_AUTO_TEST_CASE(test_admission_and_eviction) {
+  decoded_block_cache_test::test_admission_and_eviction();
+}
+BOOST_AUTO_TEST_CASE(test_shared_across_readers) {
+  decoded_block_cache_test::test_shared_across_readers();
+}
+BOOST_AUTO_TEST_SUITE_END()
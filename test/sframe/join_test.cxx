@@ -0,0 +1,134 @@
+#define BOOST_TEST_MODULE
+#include <boost/test/unit_test.hpp>
+#include <util/test_macros.hpp>
+#include <algorithm>
+#include <sframe/sframe.hpp>
+#include <sframe/join.hpp>
+#include <sframe/testing_utils.hpp>
+
+using namespace turi;
+
+namespace {
+
+/**
+ * The rows of the frame as strings, sorted, so results from different join
+ * algorithms can be compared.
+ */
+std::vector<std::string> sorted_rows(const sframe& sf) {
+  std::vector<std::string> ret;
+  for (const auto& row : testing_extract_sframe_data(sf)) {
+    std::string s;
+    for (const auto& v : row) {
+      s += (v.get_type() == flex_type_enum::UNDEFINED) ? "None" : (flex_string)v;
+      s += ",";
+    }
+    ret.push_back(s);
+  }
+  std::sort(ret.begin(), ret.end());
+  return ret;
+}
+
+} // anonymous namespace
+
+struct join_test {
+ public:
+  /*
+   * left: keys 0..299 step 1 with every third key repeated; some missing keys.
+   * right: keys 100..599 step 2.
+   */
+  sframe make_left() {
+    std::vector<std::vector<flexible_type>> data;
+    data.push_back({FLEX_UNDEFINED, "l_none"});
+    for (size_t i = 0; i < 300; ++i) {
+      data.push_back({flex_int(i), "l" + std::to_string(i)});
+      if (i % 3 == 0) data.push_back({flex_int(i), "l" + std::to_string(i) + "b"});
+    }
+    return make_testing_sframe({"key", "lval"},
+                               {flex_type_enum::INTEGER, flex_type_enum::STRING},
+                               data);
+  }
+
+  sframe make_right() {
+    std::vector<std::vector<flexible_type>> data;
+    data.push_back({FLEX_UNDEFINED, 0.5});
+    for (size_t i = 100; i < 600; i += 2) {
+      data.push_back({flex_int(i), double(i) / 2});
+    }
+    return make_testing_sframe({"key", "rval"},
+                               {flex_type_enum::INTEGER, flex_type_enum::FLOAT},
+                               data);
+  }
+
+  void test_compare_join_keys() {
+    std::vector<flexible_type> a{1, "b"};
+    std::vector<flexible_type> b{"b", 2};
+    TS_ASSERT_EQUALS(join_impl::compare_join_keys(a, {0, 1}, b, {1, 0}), -1);
+    TS_ASSERT_EQUALS(join_impl::compare_join_keys(b, {1, 0}, a, {0, 1}), 1);
+    TS_ASSERT_EQUALS(join_impl::compare_join_keys(a, {1}, b, {0}), 0);
+    std::vector<flexible_type> c{FLEX_UNDEFINED};
+    std::vector<flexible_type> d{-100};
+    TS_ASSERT_EQUALS(join_impl::compare_join_keys(c, {0}, d, {0}), -1);
+    TS_ASSERT_EQUALS(join_impl::compare_join_keys(c, {0}, c, {0}), 0);
+  }
+
+  void test_is_sorted_on_columns() {
+    TS_ASSERT(join_impl::is_sorted_on_columns(make_left(), {0}));
+    TS_ASSERT(join_impl::is_sorted_on_columns(make_right(), {0}));
+    // lval is not sorted: "l10" < "l2" but comes after it
+    TS_ASSERT(!join_impl::is_sorted_on_columns(make_left(), {1}));
+    TS_ASSERT(!join_impl::is_sorted_on_columns(make_left(), {1, 0}));
+    // sorted on the first key, then the second within equal first keys
+    TS_ASSERT(join_impl::is_sorted_on_columns(make_left(), {0, 1}));
+  }
+
+  void test_sort_merge_join_matches_hash_join() {
+    sframe left = make_left();
+    sframe right = make_right();
+    for (join_type_t type : {INNER_JOIN, LEFT_JOIN, RIGHT_JOIN, FULL_JOIN}) {
+      join_impl::hash_join_executor merge_executor(left, right, {0}, {0}, type, 100);
+      TS_ASSERT_EQUALS(merge_executor.choose_join_strategy(), join_impl::SORT_MERGE_JOIN);
+      sframe merged = merge_executor.sort_merge_join();
+
+      join_impl::hash_join_executor grace_executor(left, right, {0}, {0}, type, 100);
+      sframe hashed = grace_executor.grace_hash_join();
+
+      join_impl::hash_join_executor broadcast_executor(left, right, {0}, {0}, type,
+                                                       SFRAME_JOIN_BUFFER_NUM_CELLS);
+      TS_ASSERT_EQUALS(broadcast_executor.choose_join_strategy(),
+                       join_impl::BROADCAST_HASH_JOIN);
+      sframe broadcast = broadcast_executor.execute();
+
+      TS_ASSERT_EQUALS(merged.column_names(), hashed.column_names());
+      TS_ASSERT_EQUALS(merged.column_types(), hashed.column_types());
+      TS_ASSERT(sorted_rows(merged) == sorted_rows(hashed));
+      TS_ASSERT(sorted_rows(broadcast) == sorted_rows(hashed));
+    }
+  }
+
+  void test_unsorted_input_uses_grace_hash_join() {
+    sframe left = make_left();
+    sframe right = make_right();
+    // reverse the right frame
+    auto right_data = testing_extract_sframe_data(right);
+    std::reverse(right_data.begin(), right_data.end());
+    right = make_testing_sframe(right.column_names(), right.column_types(), right_data);
+
+    join_impl::hash_join_executor executor(left, right, {0}, {0}, INNER_JOIN, 100);
+    TS_ASSERT_EQUALS(executor.choose_join_strategy(), join_impl::GRACE_HASH_JOIN);
+  }
+};
+
+BOOST_FIXTURE_TEST_SUITE(_join_test, join_test)
+BOOST_AUTO_TEST_CASE(test_compare_join_keys) {
+  join_test::test_compare_join_keys();
+}
+BOOST_AUTO_TEST_CASE(test_is_sorted_on_columns) {
+  join_test::test_is_sorted_on_columns();
+}
+BOOST_AUTO_TEST_CASE(test_sort_merge_join_matches_hash_join) {
+  join_test::test_sort_merge_join_matches_hash_join();
+}
+BOOST_AUTO_TEST_CASE(test_unsorted_input_uses_grace_hash_join) {
+  join_test::test_unsorted_input_uses_grace_hash_join();
+}
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,273 @@
+#define BOOST_TEST_MODULE
+#include <boost/test/unit_test.hpp>
+#include <util/test_macros.hpp>
+#include <sframe/sarray.hpp>
+#include <sframe/sframe.hpp>
+#include <sframe/algorithm.hpp>
+#include <sframe/sarray_dict_projection.hpp>
+#include <sframe/sarray_v2_type_encoding.hpp>
+#include <sframe/testing_utils.hpp>
+#include <fileio/temp_files.hpp>
+
+using namespace turi;
+using namespace turi::v2_block_impl;
+
+struct sarray_dict_projection_test {
+ public:
+  /// Equality which also compares the types, recursively.
+  static bool same(const flexible_type& a, const flexible_type& b) {
+    if (a.get_type() != b.get_type()) return false;
+    if (a.get_type() == flex_type_enum::UNDEFINED) return true;
+    if (a.get_type() == flex_type_enum::LIST) {
+      const flex_list& x = a.get<flex_list>();
+      const flex_list& y = b.get<flex_list>();
+      if (x.size() != y.size()) return false;
+      for (size_t i = 0; i < x.size(); ++i) {
+        if (!same(x[i], y[i])) return false;
+      }
+      return true;
+    }
+    if (a.get_type() == flex_type_enum::DICT) {
+      const flex_dict& x = a.get<flex_dict>();
+      const flex_dict& y = b.get<flex_dict>();
+      if (x.size() != y.size()) return false;
+      for (size_t i = 0; i < x.size(); ++i) {
+        if (!same(x[i].first, y[i].first) || !same(x[i].second, y[i].second)) {
+          return false;
+        }
+      }
+      return true;
+    }
+    return a == b;
+  }
+
+  /*
+   * Dictionaries parsed from records: the keys "a", "b" and "c" repeat, with
+   * values of several types; 1 and 1.0 are distinct keys; some rows are
+   * UNDEFINED.
+   */
+  std::vector<flexible_type> make_records(size_t n) {
+    std::vector<flexible_type> ret;
+    for (size_t i = 0; i < n; ++i) {
+      if (i % 13 == 0) {
+        ret.push_back(FLEX_UNDEFINED);
+        continue;
+      }
+      flex_dict d{{"a", flex_int(i)}, {"b", i * 0.5}};
+      if (i % 3 == 0) d.push_back({"c", flex_list{flex_int(i), "x"}});
+      if (i % 5 == 0) d.push_back({flex_int(1), FLEX_UNDEFINED});
+      if (i % 7 == 0) d.push_back({"b", "second b"});
+      if (i % 11 == 0) d.push_back({flex_float(1.0), "one"});
+      ret.push_back(d);
+    }
+    return ret;
+  }
+
+  /// Dictionaries whose keys are (nearly) all distinct.
+  std::vector<flexible_type> make_distinct_keys(size_t n) {
+    std::vector<flexible_type> ret;
+    for (size_t i = 0; i < n; ++i) {
+      ret.push_back(flex_dict{{"k" + std::to_string(i), flex_int(i)},
+                              {"a", flex_dict{{"nested", flex_int(i)}}}});
+    }
+    ret.push_back(flex_dict());
+    ret.push_back(FLEX_UNDEFINED);
+    return ret;
+  }
+
+  std::vector<flexible_type> make_lists(size_t n) {
+    std::vector<flexible_type> ret;
+    for (size_t i = 0; i < n; ++i) {
+      if (i % 9 == 0) ret.push_back(FLEX_UNDEFINED);
+      else if (i % 4 == 0) ret.push_back(flex_list());
+      else ret.push_back(flex_list{flex_int(i), "s" + std::to_string(i % 4),
+                                   flex_dict{{"a", flex_int(i)}}});
+    }
+    return ret;
+  }
+
+  void check_round_trip(const std::vector<flexible_type>& data) {
+    block_info info;
+    oarchive oarc;
+    typed_encode(data, info, oarc);
+    TS_ASSERT(info.flags & BLOCK_ENCODING_EXTENSION);
+
+    std::vector<flexible_type> decoded;
+    TS_ASSERT(typed_decode(info, oarc.buf, oarc.off, decoded));
+    std::vector<flexible_type> streamed;
+    TS_ASSERT(typed_decode_stream_callback(info, oarc.buf, oarc.off,
+                                           [&](const flexible_type& val) {
+                                             streamed.push_back(val);
+                                           }));
+    TS_ASSERT_EQUALS(decoded.size(), data.size());
+    TS_ASSERT_EQUALS(streamed.size(), data.size());
+    for (size_t i = 0; i < data.size(); ++i) {
+      TS_ASSERT(same(decoded[i], data[i]));
+      TS_ASSERT(same(streamed[i], data[i]));
+    }
+    free(oarc.buf);
+  }
+
+  void test_shredded_round_trip() {
+    check_round_trip(make_records(1000));
+    check_round_trip(make_distinct_keys(300));
+    check_round_trip(make_lists(500));
+    check_round_trip({flex_list(), flex_list()});
+    check_round_trip({flex_dict(), FLEX_UNDEFINED});
+  }
+
+  void check_block_projections(const std::vector<flexible_type>& data,
+                               const std::vector<flexible_type>& keys) {
+    block_info info;
+    oarchive oarc;
+    typed_encode(data, info, oarc);
+
+    std::vector<flexible_type> dict_keys;
+    TS_ASSERT(typed_decode_dict_keys(info, oarc.buf, oarc.off, dict_keys));
+    std::vector<std::vector<flexible_type>> values;
+    TS_ASSERT(typed_decode_dict_values(info, oarc.buf, oarc.off, keys, values));
+    for (size_t i = 0; i < data.size(); ++i) {
+      if (data[i].get_type() == flex_type_enum::UNDEFINED) {
+        TS_ASSERT(same(dict_keys[i], FLEX_UNDEFINED));
+        for (size_t k = 0; k < keys.size(); ++k) {
+          TS_ASSERT(same(values[k][i], FLEX_UNDEFINED));
+        }
+        continue;
+      }
+      flex_list expected_keys;
+      for (const auto& entry: data[i].get<flex_dict>()) {
+        expected_keys.push_back(entry.first);
+      }
+      TS_ASSERT(same(dict_keys[i], expected_keys));
+      for (size_t k = 0; k < keys.size(); ++k) {
+        flexible_type expected = FLEX_UNDEFINED;
+        for (const auto& entry: data[i].get<flex_dict>()) {
+          if (entry.first == keys[k]) {
+            expected = entry.second;
+            break;
+          }
+        }
+        TS_ASSERT(same(values[k][i], expected));
+      }
+    }
+    free(oarc.buf);
+  }
+
+  void test_block_projections() {
+    // 1 matches the integer and the float key, whichever comes first
+    check_block_projections(make_records(1000),
+                            {"a", "b", "c", flex_int(1), "missing"});
+    check_block_projections(make_distinct_keys(300), {"a", "k7", "missing"});
+  }
+
+  std::shared_ptr<sarray<flexible_type>>
+  make_sarray(const std::vector<flexible_type>& data) {
+    auto ret = std::make_shared<sarray<flexible_type>>();
+    ret->open_for_write(4);
+    ret->set_type(flex_type_enum::DICT);
+    turi::copy(data.begin(), data.end(), *ret);
+    ret->close();
+    return ret;
+  }
+
+  void test_sarray_projections() {
+    std::vector<flexible_type> data;
+    for (size_t i = 0; i < 5000; ++i) {
+      if (i % 13 == 0) {
+        data.push_back(FLEX_UNDEFINED);
+        continue;
+      }
+      flex_dict d{{"id", flex_int(i)}, {"score", i * 0.25}};
+      if (i % 2) d.push_back({"name", "n" + std::to_string(i % 10)});
+      if (i % 3 == 0) d.push_back({"score", flex_int(0)});
+      if (i % 5 == 0) d.push_back({"na", flex_int(-1)});
+      data.push_back(d);
+    }
+    auto column = make_sarray(data);
+    TS_ASSERT(sarray_dict_projection_supported(*column));
+
+    std::vector<flexible_type> keys;
+    sarray_dict_keys(*column)->get_reader()->read_rows(0, data.size(), keys);
+    TS_ASSERT_EQUALS(keys.size(), data.size());
+    for (size_t i = 0; i < data.size(); ++i) {
+      if (data[i].get_type() == flex_type_enum::UNDEFINED) {
+        TS_ASSERT(same(keys[i], FLEX_UNDEFINED));
+      } else {
+        TS_ASSERT_EQUALS(keys[i].size(), data[i].size());
+      }
+    }
+
+    auto types = sarray_dict_value_types(*column);
+    TS_ASSERT_EQUALS(types.size(), 4);
+    TS_ASSERT(types["id"] == std::set<flex_type_enum>{flex_type_enum::INTEGER});
+    TS_ASSERT(types["score"] == (std::set<flex_type_enum>{flex_type_enum::FLOAT,
+                                                          flex_type_enum::INTEGER}));
+    TS_ASSERT(types["name"] == std::set<flex_type_enum>{flex_type_enum::STRING});
+
+    sframe unpacked = sarray_dict_unpack(*column, {"name", "score", "na"},
+                                         {"x.name", "x.score", "x.na"},
+                                         {flex_type_enum::STRING,
+                                          flex_type_enum::FLOAT,
+                                          flex_type_enum::INTEGER},
+                                         flex_int(-1));
+    TS_ASSERT(unpacked.column_names() ==
+              (std::vector<std::string>{"x.name", "x.score", "x.na"}));
+    auto rows = testing_extract_sframe_data(unpacked);
+    TS_ASSERT_EQUALS(rows.size(), data.size());
+    for (size_t i = 0; i < data.size(); ++i) {
+      if (data[i].get_type() == flex_type_enum::UNDEFINED || i % 2 == 0) {
+        TS_ASSERT(same(rows[i][0], FLEX_UNDEFINED));
+      } else {
+        TS_ASSERT_EQUALS(rows[i][0], "n" + std::to_string(i % 10));
+      }
+      if (data[i].get_type() == flex_type_enum::UNDEFINED) {
+        TS_ASSERT(same(rows[i][1], FLEX_UNDEFINED));
+      } else {
+        // the first "score" entry wins
+        TS_ASSERT(same(rows[i][1], flex_float(i * 0.25)));
+      }
+      // -1 is the NA value
+      TS_ASSERT(same(rows[i][2], FLEX_UNDEFINED));
+    }
+  }
+
+  void test_index_file_version() {
+    // only arrays holding shredded blocks get the new version
+    auto records = make_records(1000);
+    auto column = make_sarray(records);
+    TS_ASSERT_EQUALS(column->get_index_info().version, NESTED_INDEX_FILE_VERSION);
+    auto missing = make_sarray(std::vector<flexible_type>(10, FLEX_UNDEFINED));
+    TS_ASSERT_EQUALS(missing->get_index_info().version, 2);
+
+    // saving copies the blocks, and keeps the version
+    std::string index_file = get_temp_name() + ".sidx";
+    column->save(index_file);
+    sarray<flexible_type> saved(index_file);
+    TS_ASSERT_EQUALS(saved.get_index_info().version, NESTED_INDEX_FILE_VERSION);
+    std::vector<flexible_type> values;
+    saved.get_reader()->read_rows(0, records.size(), values);
+    TS_ASSERT_EQUALS(values.size(), records.size());
+    for (size_t i = 0; i < records.size(); ++i) {
+      TS_ASSERT(same(values[i], records[i]));
+    }
+
+    auto appended = missing->append(*column);
+    TS_ASSERT_EQUALS(appended.get_index_info().version, NESTED_INDEX_FILE_VERSION);
+    TS_ASSERT_EQUALS(appended.size(), records.size() + 10);
+  }
+};
+
+BOOST_FIXTURE_TEST_SUITE(_sarray_dict_projection_test, sarray_dict_projection_test)
+BOOST_AUTO_TEST_CASE(test_shredded_round_trip) {
+  sarray_dict_projection_test::test_shredded_round_trip();
+}
+BOOST_AUTO_TEST_CASE(test_block_projections) {
+  sarray_dict_projection_test::test_block_projections();
+}
+BOOST_AUTO_TEST_CASE(test_sarray_projections) {
+  sarray_dict_projection_test::test_sarray_projections();
+}
+BOOST_AUTO_TEST_CASE(test_index_file_version) {
+  sarray_dict_projection_test::test_index_file_version();
+}
+BOOST_AUTO_TEST_SUITE_END()
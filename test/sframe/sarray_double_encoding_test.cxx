@@ -0,0 +1,152 @@
+#define BOOST_TEST_MODULE
+#include <boost/test/unit_test.hpp>
+#include <util/test_macros.hpp>
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <sframe/sarray_v2_type_encoding.hpp>
+
+using namespace turi;
+using namespace turi::v2_block_impl;
+
+struct sarray_double_encoding_test {
+ public:
+  /// Equality of the types and of the bits of the floating point values.
+  static bool same(const flexible_type& a, const flexible_type& b) {
+    if (a.get_type() != b.get_type()) return false;
+    if (a.get_type() == flex_type_enum::FLOAT) {
+      return a.reinterpret_get<flex_int>() == b.reinterpret_get<flex_int>();
+    }
+    if (a.get_type() == flex_type_enum::VECTOR) {
+      const flex_vec& x = a.get<flex_vec>();
+      const flex_vec& y = b.get<flex_vec>();
+      return x.size() == y.size() &&
+          (x.empty() || std::memcmp(x.data(), y.data(), sizeof(double) * x.size()) == 0);
+    }
+    return a.get_type() == flex_type_enum::UNDEFINED || a == b;
+  }
+
+  /**
+   * Encodes and decodes data, both in one go and as a stream, and returns
+   * the encoded size.
+   */
+  size_t check_round_trip(const std::vector<flexible_type>& data) {
+    block_info info;
+    oarchive oarc;
+    typed_encode(data, info, oarc);
+    TS_ASSERT(info.flags & BLOCK_ENCODING_EXTENSION);
+
+    std::vector<flexible_type> ret;
+    TS_ASSERT(typed_decode(info, oarc.buf, oarc.off, ret));
+    TS_ASSERT_EQUALS(ret.size(), data.size());
+    for (size_t i = 0; i < data.size(); ++i) TS_ASSERT(same(ret[i], data[i]));
+
+    std::vector<flexible_type> streamed;
+    typed_decode_stream_callback(info, oarc.buf, oarc.off,
+                                 [&](const flexible_type& val) {
+                                   streamed.push_back(val);
+                                 });
+    TS_ASSERT_EQUALS(streamed.size(), data.size());
+    for (size_t i = 0; i < data.size(); ++i) TS_ASSERT(same(streamed[i], data[i]));
+    size_t ret_size = oarc.off;
+    free(oarc.buf);
+    return ret_size;
+  }
+
+  /// The encoding chosen for a block of FLOAT values only.
+  char chosen_encoding(const std::vector<flexible_type>& data) {
+    block_info info;
+    oarchive oarc;
+    typed_encode(data, info, oarc);
+    // number of types, the type, then the double encoding
+    char ret = oarc.buf[2];
+    free(oarc.buf);
+    return ret;
+  }
+
+  void test_decimal_encoding() {
+    std::mt19937 gen(1);
+    std::uniform_int_distribution<int> cents(-100000, 100000);
+    std::vector<flexible_type> prices;
+    for (size_t i = 0; i < 1000; ++i) prices.push_back(cents(gen) / 100.0);
+    TS_ASSERT_EQUALS(chosen_encoding(prices), DOUBLE_RESERVED_FLAGS::DECIMAL_ENCODING);
+    // older readers accept 0 to 2: they must reject the new encodings
+    TS_ASSERT_LESS_THAN(2, chosen_encoding(prices));
+    TS_ASSERT_LESS_THAN(check_round_trip(prices), prices.size() * 5);
+
+    check_round_trip({0.1, 1e-15, -123.456, 4503599627370495.5});
+  }
+
+  void test_float32_encoding() {
+    std::mt19937 gen(1);
+    std::normal_distribution<float> normal;
+    std::vector<flexible_type> embeddings;
+    for (size_t i = 0; i < 1000; ++i) embeddings.push_back(double(normal(gen)));
+    TS_ASSERT_EQUALS(chosen_encoding(embeddings), DOUBLE_RESERVED_FLAGS::FLOAT32_ENCODING);
+    TS_ASSERT_LESS_THAN(check_round_trip(embeddings), embeddings.size() * 5);
+
+    std::vector<flexible_type> vectors;
+    for (size_t i = 0; i < 100; ++i) {
+      flex_vec v;
+      for (size_t j = 0; j < 32; ++j) v.push_back(normal(gen));
+      vectors.push_back(v);
+    }
+    vectors.push_back(FLEX_UNDEFINED);
+    vectors.push_back(flex_vec());
+    TS_ASSERT_LESS_THAN(check_round_trip(vectors), 100 * 32 * 5);
+  }
+
+  void test_xor_encoding() {
+    // A slowly changing sensor reading: runs of equal values.
+    std::mt19937 gen(1);
+    std::uniform_real_distribution<double> uniform(0, 1);
+    std::vector<flexible_type> readings;
+    double reading = 0;
+    for (size_t i = 0; i < 1000; ++i) {
+      if (i % 50 == 0) reading = uniform(gen);
+      readings.push_back(reading);
+    }
+    TS_ASSERT_EQUALS(chosen_encoding(readings), DOUBLE_RESERVED_FLAGS::XOR_ENCODING);
+    TS_ASSERT_LESS_THAN(check_round_trip(readings), readings.size());
+
+    // The special values must round trip exactly whichever encoding is used.
+    std::vector<flexible_type> special{-0.0, NAN, INFINITY, -INFINITY, 1e-310,
+                                       1e300, 0.0, FLEX_UNDEFINED};
+    for (size_t i = 0; i < 300; ++i) special.push_back(uniform(gen));
+    check_round_trip(special);
+  }
+
+  void test_integral_and_legacy_encoding() {
+    std::vector<flexible_type> integral;
+    for (size_t i = 0; i < 1000; ++i) integral.push_back(double(i));
+    TS_ASSERT_EQUALS(chosen_encoding(integral), DOUBLE_RESERVED_FLAGS::INTEGER_ENCODING);
+    check_round_trip(integral);
+
+    // Random doubles have nothing to share: no encoding may be larger
+    // than the legacy encoding.
+    std::mt19937_64 gen(1);
+    std::vector<flexible_type> random;
+    for (size_t i = 0; i < 1000; ++i) {
+      uint64_t bits = gen() & ~(uint64_t(0x7ff) << 52);
+      double val;
+      std::memcpy(&val, &bits, sizeof(val));
+      random.push_back(val);
+    }
+    TS_ASSERT_LESS_THAN_EQUALS(check_round_trip(random), random.size() * 8 + 100);
+  }
+};
+
+BOOST_FIXTURE_TEST_SUITE(_sarray_double_encoding_test, sarray_double_encoding_test)
+BOOST_AUTO_TEST_CASE(test_decimal_encoding) {
+  sarray_double_encoding_test::test_decimal_encoding();
+}
+BOOST_AUTO_TEST_CASE(test_float32_encoding) {
+  sarray_double_encoding_test::test_float32_encoding();
+}
+BOOST_AUTO_TEST_CASE(test_xor_encoding) {
+  sarray_double_encoding_test::test_xor_encoding();
+}
+BOOST_AUTO_TEST_CASE(test_integral_and_legacy_encoding) {
+  sarray_double_encoding_test::test_integral_and_legacy_encoding();
+}
+BOOST_AUTO_TEST_SUITE_END()
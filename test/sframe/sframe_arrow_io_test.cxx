@@ -0,0 +1,327 @@
+#define BOOST_TEST_MODULE
+#include <boost/test/unit_test.hpp>
+#include <util/test_macros.hpp>
+#include <cmath>
+#include <sstream>
+#include <sframe/sframe.hpp>
+#include <sframe/sframe_arrow_io.hpp>
+#include <sframe/arrow_ipc_format.hpp>
+#include <sframe/sframe_constants.hpp>
+#include <sframe/testing_utils.hpp>
+#include <fileio/temp_files.hpp>
+#include <fileio/general_fstream.hpp>
+
+using namespace turi;
+
+struct sframe_arrow_io_test {
+ public:
+  void test_all_types_round_trip() {
+    std::vector<std::string> names = {"int", "float", "str", "vec",
+                                      "dt", "list", "dict", "none"};
+    std::vector<flex_type_enum> types = {
+        flex_type_enum::INTEGER, flex_type_enum::FLOAT,
+        flex_type_enum::STRING, flex_type_enum::VECTOR,
+        flex_type_enum::DATETIME, flex_type_enum::LIST,
+        flex_type_enum::DICT, flex_type_enum::UNDEFINED};
+
+    std::vector<std::vector<flexible_type>> data;
+    for (size_t i = 0; i < 1000; ++i) {
+      std::vector<flexible_type> row;
+      row.push_back(flex_int(i) - 500);
+      row.push_back(i % 7 == 0 ? FLEX_UNDEFINED : flexible_type(i * 0.25));
+      row.push_back(std::string(i % 13, 'a' + (i % 26)));
+      row.push_back(flex_vec(i % 5, double(i)));
+      row.push_back(flex_date_time(flex_int(i) * 3600 - 100000, 0,
+                                   (i * 7919) % 1000000));
+      row.push_back(flex_list{flex_int(i), "x"});
+      row.push_back(i % 3 == 0 ? FLEX_UNDEFINED
+                               : flexible_type(flex_dict{{"k", flex_int(i)}}));
+      row.push_back(FLEX_UNDEFINED);
+      data.push_back(row);
+    }
+    sframe sf = make_testing_sframe(names, types, data);
+
+    // force several record batches
+    size_t old_batch_size = SFRAME_ARROW_BATCH_NUM_CELLS;
+    SFRAME_ARROW_BATCH_NUM_CELLS = 8 * 97;
+    std::string filename = get_temp_name() + ".arrow";
+    sframe_save_as_arrow(sf, filename);
+    SFRAME_ARROW_BATCH_NUM_CELLS = old_batch_size;
+
+    sframe loaded = sframe_load_from_arrow(filename);
+    TS_ASSERT_EQUALS(loaded.num_columns(), names.size());
+    TS_ASSERT_EQUALS(loaded.size(), data.size());
+    for (size_t i = 0; i < names.size(); ++i) {
+      TS_ASSERT_EQUALS(loaded.column_name(i), names[i]);
+      TS_ASSERT_EQUALS(loaded.column_type(i), types[i]);
+    }
+
+    auto loaded_data = testing_extract_sframe_data(loaded);
+    TS_ASSERT_EQUALS(loaded_data.size(), data.size());
+    for (size_t i = 0; i < data.size(); ++i) {
+      for (size_t j = 0; j < names.size(); ++j) {
+        if (types[j] == flex_type_enum::DATETIME) {
+          // the timezone is not preserved
+          const auto& expected = data[i][j].get<flex_date_time>();
+          const auto& actual = loaded_data[i][j].get<flex_date_time>();
+          TS_ASSERT_EQUALS(actual.posix_timestamp(), expected.posix_timestamp());
+          TS_ASSERT_EQUALS(actual.microsecond(), expected.microsecond());
+        } else {
+          TS_ASSERT_EQUALS(loaded_data[i][j].get_type(), data[i][j].get_type());
+          TS_ASSERT(loaded_data[i][j] == data[i][j]);
+        }
+      }
+    }
+  }
+
+  void test_empty_sframe() {
+    sframe sf = make_testing_sframe({"a", "b"},
+                                    {flex_type_enum::INTEGER, flex_type_enum::STRING},
+                                    {});
+    std::string filename = get_temp_name() + ".arrow";
+    sframe_save_as_arrow(sf, filename);
+    sframe loaded = sframe_load_from_arrow(filename);
+    TS_ASSERT_EQUALS(loaded.size(), 0);
+    TS_ASSERT_EQUALS(loaded.num_columns(), 2);
+    TS_ASSERT_EQUALS(loaded.column_type(0), flex_type_enum::INTEGER);
+    TS_ASSERT_EQUALS(loaded.column_type(1), flex_type_enum::STRING);
+  }
+
+  void test_unaligned_blocks() {
+    // Columns written with different segment layouts have blocks which do
+    // not line up; record batches cut through blocks of both.
+    size_t num_rows = 5000;
+    std::vector<std::shared_ptr<sarray<flexible_type>>> columns;
+    for (size_t num_segments : {1, 3}) {
+      auto column = std::make_shared<sarray<flexible_type>>();
+      column->open_for_write(num_segments);
+      column->set_type(flex_type_enum::INTEGER);
+      for (size_t s = 0; s < num_segments; ++s) {
+        auto out = column->get_output_iterator(s);
+        for (size_t i = s * num_rows / num_segments;
+             i < (s + 1) * num_rows / num_segments; ++i) {
+          *out = flex_int(i * num_segments);
+          ++out;
+        }
+      }
+      column->close();
+      columns.push_back(column);
+    }
+    sframe sf(columns, {"a", "b"});
+
+    size_t old_batch_size = SFRAME_ARROW_BATCH_NUM_CELLS;
+    SFRAME_ARROW_BATCH_NUM_CELLS = 2 * 333;
+    std::string filename = get_temp_name() + ".arrow";
+    sframe_save_as_arrow(sf, filename);
+    SFRAME_ARROW_BATCH_NUM_CELLS = old_batch_size;
+
+    auto data = testing_extract_sframe_data(sframe_load_from_arrow(filename));
+    TS_ASSERT_EQUALS(data.size(), num_rows);
+    for (size_t i = 0; i < num_rows; ++i) {
+      TS_ASSERT_EQUALS(data[i][0], flex_int(i));
+      TS_ASSERT_EQUALS(data[i][1], flex_int(3 * i));
+    }
+  }
+
+  void test_foreign_schema() {
+    // A file without the turi.dtype metadata, as written by other Arrow
+    // libraries, gets the default type mapping.
+    std::vector<arrow_ipc::field_desc> schema(3);
+    schema[0].name = "ts";
+    schema[0].type = arrow_ipc::arrow_type::TIMESTAMP_MICROS;
+    schema[1].name = "bin";
+    schema[1].type = arrow_ipc::arrow_type::BINARY;
+    schema[2].name = "";
+    schema[2].type = arrow_ipc::arrow_type::LIST_FLOAT64;
+
+    std::vector<arrow_ipc::column_buffers> columns(3);
+    columns[0].append_int64(-1);
+    columns[0].append_null(arrow_ipc::arrow_type::TIMESTAMP_MICROS);
+    columns[1].append_bytes("ab", 2);
+    columns[1].append_bytes("", 0);
+    double values[] = {1.0, 2.0};
+    columns[2].append_double_list(values, 2);
+    columns[2].append_null(arrow_ipc::arrow_type::LIST_FLOAT64);
+
+    std::string filename = get_temp_name() + ".arrow";
+    {
+      general_ofstream fout(filename);
+      arrow_ipc::file_writer writer(fout, schema);
+      writer.write_encoded_batch(arrow_ipc::encode_record_batch(schema, columns));
+      writer.close();
+    }
+
+    sframe loaded = sframe_load_from_arrow(filename);
+    TS_ASSERT_EQUALS(loaded.column_name(2), "X3");
+    TS_ASSERT_EQUALS(loaded.column_type(0), flex_type_enum::DATETIME);
+    TS_ASSERT_EQUALS(loaded.column_type(1), flex_type_enum::STRING);
+    TS_ASSERT_EQUALS(loaded.column_type(2), flex_type_enum::VECTOR);
+
+    auto data = testing_extract_sframe_data(loaded);
+    TS_ASSERT_EQUALS(data.size(), 2);
+    // -1 microseconds is one microsecond before the epoch
+    TS_ASSERT_EQUALS(data[0][0].get<flex_date_time>().posix_timestamp(), -1);
+    TS_ASSERT_EQUALS(data[0][0].get<flex_date_time>().microsecond(), 999999);
+    TS_ASSERT_EQUALS(data[1][0].get_type(), flex_type_enum::UNDEFINED);
+    TS_ASSERT_EQUALS(data[0][1], "ab");
+    TS_ASSERT_EQUALS(data[1][1], "");
+    TS_ASSERT(data[0][2] == flexible_type(flex_vec{1.0, 2.0}));
+    TS_ASSERT_EQUALS(data[1][2].get_type(), flex_type_enum::UNDEFINED);
+  }
+
+  void test_batch_max_bytes() {
+    std::vector<std::vector<flexible_type>> data;
+    for (size_t i = 0; i < 50; ++i) {
+      data.push_back({flex_int(i),
+                      i % 4 == 0 ? FLEX_UNDEFINED
+                                 : flexible_type(std::string(300, 'a' + i % 26))});
+    }
+    sframe sf = make_testing_sframe({"id", "str"},
+                                    {flex_type_enum::INTEGER,
+                                     flex_type_enum::STRING}, data);
+
+    size_t old_max_bytes = SFRAME_ARROW_BATCH_MAX_BYTES;
+    SFRAME_ARROW_BATCH_MAX_BYTES = 1024;
+    std::string filename = get_temp_name() + ".arrow";
+    sframe_save_as_arrow(sf, filename);
+
+    // no more than 3 strings of 300 bytes per batch
+    {
+      general_ifstream fin(filename);
+      arrow_ipc::file_reader reader(fin);
+      TS_ASSERT_LESS_THAN_EQUALS(13, reader.num_record_batches());
+      std::vector<arrow_ipc::column_buffers> columns;
+      size_t num_rows = 0;
+      for (size_t b = 0; b < reader.num_record_batches(); ++b) {
+        num_rows += reader.read_record_batch(fin, b, columns);
+        TS_ASSERT_LESS_THAN_EQUALS(columns[1].data.size(), 1024);
+      }
+      TS_ASSERT_EQUALS(num_rows, data.size());
+    }
+    TS_ASSERT(testing_extract_sframe_data(sframe_load_from_arrow(filename)) == data);
+
+    // a value which cannot fit in any batch
+    sframe too_large = make_testing_sframe({"str"}, {flex_type_enum::STRING},
+                                           {{std::string(2000, 'x')}});
+    TS_ASSERT_THROWS_ANYTHING(sframe_save_as_arrow(too_large, filename));
+    SFRAME_ARROW_BATCH_MAX_BYTES = old_max_bytes;
+  }
+
+  void test_pyarrow_file() {
+    // Written by pyarrow 26 (pyarrow.ipc.new_file, in batches of 2 rows):
+    //   pa.table({
+    //     'i': pa.array([1, None, -3], pa.int32()),
+    //     'f': pa.array([0.5, 1.5, None], pa.float32()),
+    //     'b': pa.array([True, False, None], pa.bool_()),
+    //     's': pa.array(['abc', None, 'h\u00e9llo'], pa.string()),
+    //     'bin': pa.array([b'\x00\x01', b'', None], pa.binary()),
+    //     'ts': pa.array([0, 1500, None], pa.timestamp('ms')),
+    //     'v': pa.array([[1.0, 2.0], None, []], pa.list_(pa.float64())),
+    //     'l': pa.array([[1, None], [3], None], pa.list_(pa.int32()))})
+    sframe loaded = sframe_load_from_arrow("./pyarrow_written.arrow");
+    TS_ASSERT_EQUALS(loaded.num_columns(), 8);
+    std::vector<flex_type_enum> types = {
+        flex_type_enum::INTEGER, flex_type_enum::FLOAT, flex_type_enum::INTEGER,
+        flex_type_enum::STRING, flex_type_enum::STRING, flex_type_enum::DATETIME,
+        flex_type_enum::VECTOR, flex_type_enum::VECTOR};
+    TS_ASSERT(loaded.column_types() == types);
+    TS_ASSERT_EQUALS(loaded.column_name(4), "bin");
+
+    auto data = testing_extract_sframe_data(loaded);
+    TS_ASSERT_EQUALS(data.size(), 3);
+    TS_ASSERT_EQUALS(data[0][0], 1);
+    TS_ASSERT_EQUALS(data[1][0].get_type(), flex_type_enum::UNDEFINED);
+    TS_ASSERT_EQUALS(data[2][0], -3);
+    TS_ASSERT_EQUALS(data[1][1], 1.5);
+    TS_ASSERT_EQUALS(data[2][1].get_type(), flex_type_enum::UNDEFINED);
+    TS_ASSERT_EQUALS(data[0][2], 1);
+    TS_ASSERT_EQUALS(data[1][2], 0);
+    TS_ASSERT_EQUALS(data[2][2].get_type(), flex_type_enum::UNDEFINED);
+    TS_ASSERT_EQUALS(data[0][3], "abc");
+    TS_ASSERT_EQUALS(data[1][3].get_type(), flex_type_enum::UNDEFINED);
+    TS_ASSERT_EQUALS(data[2][3], "h\xc3\xa9llo");
+    TS_ASSERT_EQUALS(data[0][4], std::string("\x00\x01", 2));
+    TS_ASSERT_EQUALS(data[1][4], "");
+    TS_ASSERT_EQUALS(data[1][5].get<flex_date_time>().posix_timestamp(), 1);
+    TS_ASSERT_EQUALS(data[1][5].get<flex_date_time>().microsecond(), 500000);
+    TS_ASSERT_EQUALS(data[2][5].get_type(), flex_type_enum::UNDEFINED);
+    TS_ASSERT(data[0][6] == flexible_type(flex_vec{1.0, 2.0}));
+    TS_ASSERT_EQUALS(data[1][6].get_type(), flex_type_enum::UNDEFINED);
+    TS_ASSERT(data[2][6] == flexible_type(flex_vec{}));
+    // null list elements become NaN
+    const flex_vec& l = data[0][7].get<flex_vec>();
+    TS_ASSERT_EQUALS(l.size(), 2);
+    TS_ASSERT_EQUALS(l[0], 1.0);
+    TS_ASSERT(std::isnan(l[1]));
+    TS_ASSERT(data[1][7] == flexible_type(flex_vec{3.0}));
+    TS_ASSERT_EQUALS(data[2][7].get_type(), flex_type_enum::UNDEFINED);
+  }
+
+  /**
+   * Writes a file with a UTF8 column holding "abc" and "de", and returns
+   * its bytes.
+   */
+  std::string make_string_file() {
+    std::vector<arrow_ipc::field_desc> schema(1);
+    schema[0].name = "s";
+    schema[0].type = arrow_ipc::arrow_type::UTF8;
+    std::vector<arrow_ipc::column_buffers> columns(1);
+    columns[0].append_bytes("abc", 3);
+    columns[0].append_bytes("de", 2);
+    std::stringstream out;
+    arrow_ipc::file_writer writer(out, schema);
+    writer.write_encoded_batch(arrow_ipc::encode_record_batch(schema, columns));
+    writer.close();
+    return out.str();
+  }
+
+  void test_corrupted_offsets() {
+    std::string file = make_string_file();
+    {
+      std::stringstream in(file);
+      arrow_ipc::file_reader reader(in);
+      std::vector<arrow_ipc::column_buffers> columns;
+      TS_ASSERT_EQUALS(reader.read_record_batch(in, 0, columns), 2);
+      TS_ASSERT_EQUALS(std::string(columns[0].bytes_at(1).first,
+                                   columns[0].bytes_at(1).second), "de");
+    }
+
+    // offsets [0, 3, 5] become [0, 100, 5]: the total still fits in the
+    // data buffer, but the offsets go backwards
+    const int32_t offsets[] = {0, 3, 5};
+    size_t pos = file.find(std::string(reinterpret_cast<const char*>(offsets),
+                                       sizeof(offsets)));
+    TS_ASSERT(pos != std::string::npos);
+    int32_t bad_offset = 100;
+    std::memcpy(&file[pos + sizeof(int32_t)], &bad_offset, sizeof(int32_t));
+
+    std::stringstream in(file);
+    arrow_ipc::file_reader reader(in);
+    std::vector<arrow_ipc::column_buffers> columns;
+    TS_ASSERT_THROWS_ANYTHING(reader.read_record_batch(in, 0, columns));
+  }
+};
+
+BOOST_FIXTURE_TEST_SUITE(_sframe_arrow_io_test, sframe_arrow_io_test)
+BOOST_AUTO_TEST_CASE(test_all_types_round_trip) {
+  sframe_arrow_io_test::test_all_types_round_trip();
+}
+BOOST_AUTO_TEST_CASE(test_empty_sframe) {
+  sframe_arrow_io_test::test_empty_sframe();
+}
+BOOST_AUTO_TEST_CASE(test_unaligned_blocks) {
+  sframe_arrow_io_test::test_unaligned_blocks();
+}
+BOOST_AUTO_TEST_CASE(test_foreign_schema) {
+  sframe_arrow_io_test::test_foreign_schema();
+}
+BOOST_AUTO_TEST_CASE(test_batch_max_bytes) {
+  sframe_arrow_io_test::test_batch_max_bytes();
+}
+BOOST_AUTO_TEST_CASE(test_pyarrow_file) {
+  sframe_arrow_io_test::test_pyarrow_file();
+}
+BOOST_AUTO_TEST_CASE(test_corrupted_offsets) {
+  sframe_arrow_io_test::test_corrupted_offsets();
+}
+BOOST_AUTO_TEST_SUITE_END()
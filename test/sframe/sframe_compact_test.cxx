@@ -0,0 +1,149 @@
+#define BOOST_TEST_MODULE
+#include <boost/test/unit_test.hpp>
+#include <util/test_macros.hpp>
+#include <sframe/sframe.hpp>
+#include <sframe/sframe_saving.hpp>
+#include <sframe/sframe_saving_impl.hpp>
+#include <sframe/sarray_v2_block_manager.hpp>
+#include <sframe/sframe_constants.hpp>
+#include <sframe/testing_utils.hpp>
+#include <fileio/temp_files.hpp>
+
+using namespace turi;
+using namespace turi::sframe_saving_impl;
+
+struct sframe_compact_test {
+ public:
+  sframe_compact_test() {
+    old_num_segments = SFRAME_DEFAULT_NUM_SEGMENTS;
+    old_min_segment_size = SFRAME_SAVE_MIN_SEGMENT_SIZE;
+  }
+
+  ~sframe_compact_test() {
+    SFRAME_DEFAULT_NUM_SEGMENTS = old_num_segments;
+    SFRAME_SAVE_MIN_SEGMENT_SIZE = old_min_segment_size;
+  }
+
+  void test_choose_segment_boundaries() {
+    // the columns share the block ends 10, 20, 40 and 50
+    std::vector<std::vector<size_t> > ends{{5, 10, 20, 30, 40, 50},
+                                           {10, 20, 25, 40, 50}};
+    TS_ASSERT(choose_segment_boundaries(ends, 50, 1) ==
+              std::vector<size_t>({0, 50}));
+    TS_ASSERT(choose_segment_boundaries(ends, 50, 2) ==
+              std::vector<size_t>({0, 40, 50}));
+    TS_ASSERT(choose_segment_boundaries(ends, 50, 5) ==
+              std::vector<size_t>({0, 10, 20, 40, 50}));
+    // nothing lines up
+    TS_ASSERT(choose_segment_boundaries({{3, 7}, {4, 7}}, 7, 4) ==
+              std::vector<size_t>({0, 7}));
+    TS_ASSERT(choose_segment_boundaries({}, 0, 4) == std::vector<size_t>({0, 0}));
+  }
+
+  void test_group_small_blocks() {
+    auto make_block = [](size_t size, bool is_typed) {
+      column_block block;
+      block.block_size = size;
+      block.num_elem = 10;
+      block.is_typed = is_typed;
+      return block;
+    };
+    std::vector<column_block> blocks{
+      make_block(10, true), make_block(20, true), make_block(30, true),
+      make_block(90, true), make_block(10, true), make_block(10, false),
+      make_block(10, true), make_block(10, true), make_block(10, true)};
+    auto runs = group_small_blocks(blocks, 0, blocks.size(), 100, 25);
+    std::vector<std::pair<size_t, size_t> > expected{
+      {0, 2}, {2, 3}, {3, 4}, {4, 5}, {5, 6}, {6, 8}, {8, 9}};
+    TS_ASSERT(runs == expected);
+    runs = group_small_blocks(blocks, 0, 3, 100, 1000);
+    TS_ASSERT(runs == (std::vector<std::pair<size_t, size_t> >{{0, 3}}));
+  }
+
+  /**
+   * Appends num_parts small frames of num_rows rows.
+   */
+  sframe make_appended_sframe(size_t num_parts, size_t num_rows,
+                              std::vector<std::vector<flexible_type> >& data) {
+    sframe ret;
+    for (size_t i = 0; i < num_parts; ++i) {
+      std::vector<std::vector<flexible_type> > part;
+      for (size_t j = 0; j < num_rows; ++j) {
+        size_t row = i * num_rows + j;
+        part.push_back({flex_int(row), std::to_string(row), row * 0.5});
+      }
+      data.insert(data.end(), part.begin(), part.end());
+      ret = ret.append(make_testing_sframe({"a", "b", "c"}, part));
+    }
+    return ret;
+  }
+
+  size_t num_blocks(const sframe& sf) {
+    auto& block_manager = v2_block_impl::block_manager::get_instance();
+    size_t ret = 0;
+    for (size_t i = 0; i < sf.num_columns(); ++i) {
+      ret += list_column_blocks(block_manager,
+                                sf.select_column(i)->get_index_info()).size();
+    }
+    return ret;
+  }
+
+  void test_compact() {
+    SFRAME_DEFAULT_NUM_SEGMENTS = 2;
+    std::vector<std::vector<flexible_type> > data;
+    sframe sf = make_appended_sframe(40, 25, data);
+    TS_ASSERT_EQUALS(sf.num_segments(), 80);
+    TS_ASSERT(sframe_is_fragmented(sf));
+
+    sframe compacted = sframe_compact(sf);
+    TS_ASSERT_EQUALS(compacted.num_rows(), data.size());
+    TS_ASSERT_EQUALS(compacted.num_segments(), 1);
+    TS_ASSERT_EQUALS(num_blocks(compacted), 3);
+    TS_ASSERT(!sframe_is_fragmented(compacted));
+    TS_ASSERT(testing_extract_sframe_data(compacted) == data);
+    // not fragmented: returned as is
+    TS_ASSERT(sframe_compact(compacted).get_index_info().column_files ==
+              compacted.get_index_info().column_files);
+  }
+
+  void test_parallel_save() {
+    SFRAME_DEFAULT_NUM_SEGMENTS = 4;
+    std::vector<std::vector<flexible_type> > data;
+    sframe sf = make_appended_sframe(10, 1000, data);
+    sf = sf.append(make_testing_sframe({"a", "b", "c"},
+                                       {{flex_int(-1), "x", 0.25}}));
+    data.push_back({flex_int(-1), "x", 0.25});
+
+    SFRAME_SAVE_MIN_SEGMENT_SIZE = 1;
+    std::string index_file = get_temp_name() + ".frame_idx";
+    sf.save(index_file);
+    sframe saved(index_file);
+    TS_ASSERT_EQUALS(saved.num_segments(), 4);
+    TS_ASSERT_EQUALS(saved.num_rows(), data.size());
+    TS_ASSERT(testing_extract_sframe_data(saved) == data);
+    // the segments of the columns line up
+    for (size_t i = 1; i < saved.num_columns(); ++i) {
+      TS_ASSERT(saved.select_column(i)->get_index_info().segment_sizes ==
+                saved.select_column(0)->get_index_info().segment_sizes);
+    }
+  }
+
+ private:
+  size_t old_num_segments;
+  size_t old_min_segment_size;
+};
+
+BOOST_FIXTURE_TEST_SUITE(_sframe_compact_test, sframe_compact_test)
+BOOST_AUTO_TEST_CASE(test_choose_segment_boundaries) {
+  sframe_compact_test::test_choose_segment_boundaries();
+}
+BOOST_AUTO_TEST_CASE(test_group_small_blocks) {
+  sframe_compact_test::test_group_small_blocks();
+}
+BOOST_AUTO_TEST_CASE(test_compact) {
+  sframe_compact_test::test_compact();
+}
+BOOST_AUTO_TEST_CASE(test_parallel_save) {
+  sframe_compact_test::test_parallel_save();
+}
+BOOST_AUTO_TEST_SUITE_END()
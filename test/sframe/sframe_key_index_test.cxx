@@ -0,0 +1,179 @@
+#define BOOST_TEST_MODULE
+#include <boost/test/unit_test.hpp>
+#include <util/test_macros.hpp>
+#include <sframe/sframe.hpp>
+#include <sframe/sframe_key_index.hpp>
+#include <sframe/sframe_constants.hpp>
+#include <sframe/sframe_config.hpp>
+#include <sframe/testing_utils.hpp>
+#include <sframe_query_engine/planning/planner.hpp>
+#include <sframe_query_engine/planning/optimization_engine.hpp>
+#include <sframe_query_engine/operators/all_operators.hpp>
+#include <fileio/temp_files.hpp>
+#include <fileio/fs_utils.hpp>
+
+using namespace turi;
+
+struct sframe_key_index_test {
+ public:
+  /*
+   * id: runs of 4 rows with the same key, i.e. 0,0,0,0,1,1,1,1,...
+   * name: 97 distinct strings spread over the frame.
+   */
+  sframe make_saved_frame() {
+    std::vector<std::vector<flexible_type>> data;
+    for (size_t i = 0; i < 2000; ++i) {
+      data.push_back({flex_int(i / 4),
+                      "u" + std::to_string((i * 7) % 97),
+                      double(i)});
+    }
+    data[10][1] = FLEX_UNDEFINED;
+    sframe sf = make_testing_sframe({"id", "name", "value"},
+                                    {flex_type_enum::INTEGER,
+                                     flex_type_enum::STRING,
+                                     flex_type_enum::FLOAT},
+                                    data);
+    std::string index_file = get_temp_name() + ".frame_idx";
+    sf.save(index_file);
+    return sframe(index_file);
+  }
+
+  /// The rows of sf whose column column_id is one of keys, by scanning.
+  std::vector<std::vector<flexible_type>> scan(const sframe& sf,
+                                               size_t column_id,
+                                               const std::vector<flexible_type>& keys) {
+    std::vector<std::vector<flexible_type>> ret;
+    for (const auto& row : testing_extract_sframe_data(sf)) {
+      for (const auto& key : keys) {
+        if (row[column_id].get_type() == key.get_type() && row[column_id] == key) {
+          ret.push_back(row);
+          break;
+        }
+      }
+    }
+    return ret;
+  }
+
+  void test_lookup() {
+    // use small blocks, so the runs of a key span several blocks
+    size_t old_runs_per_block = SFRAME_KEY_INDEX_RUNS_PER_BLOCK;
+    SFRAME_KEY_INDEX_RUNS_PER_BLOCK = 3;
+    sframe saved = make_saved_frame();
+    sframe sf = sframe_add_key_index(saved, {"id"});
+    sf = sframe_add_key_index(sf, {"name"});
+    SFRAME_KEY_INDEX_RUNS_PER_BLOCK = old_runs_per_block;
+
+    // the saved frame is left untouched
+    TS_ASSERT(sf.get_index_file() != saved.get_index_file());
+    TS_ASSERT(sframe_get_key_index(sframe(saved.get_index_file()), 0) == nullptr);
+
+    auto id_index = sframe_get_key_index(sf, 0);
+    auto name_index = sframe_get_key_index(sf, 1);
+    TS_ASSERT(id_index != nullptr);
+    TS_ASSERT(name_index != nullptr);
+    TS_ASSERT(sframe_get_key_index(sf, 2) == nullptr);
+    TS_ASSERT_EQUALS(id_index->column_name(), "id");
+    TS_ASSERT_EQUALS(id_index->num_rows(), 2000);
+
+    // 10.0 matches the integer key 10; 2.5, "x" and 100000 match nothing
+    auto result = id_index->lookup(sf, 0, {flex_int(3), flex_float(10.0),
+                                           flex_float(2.5), "x",
+                                           flex_int(100000)});
+    TS_ASSERT(testing_extract_sframe_data(result) ==
+              scan(sf, 0, {flex_int(3), flex_int(10)}));
+    TS_ASSERT_EQUALS(result.size(), 8);
+
+    std::vector<flexible_type> names{"u5", "u40", FLEX_UNDEFINED};
+    result = name_index->lookup(sf, 1, names);
+    TS_ASSERT(testing_extract_sframe_data(result) == scan(sf, 1, names));
+    TS_ASSERT(result.column_names() == sf.column_names());
+
+    result = id_index->lookup(sf, 0, {});
+    TS_ASSERT_EQUALS(result.size(), 0);
+  }
+
+  void test_unsupported_column() {
+    sframe sf = make_testing_sframe({"v"}, {flex_type_enum::VECTOR},
+                                    {{flex_vec{1, 2}}});
+    std::string index_file = get_temp_name() + ".frame_idx";
+    sf.save(index_file);
+    TS_ASSERT_THROWS_ANYTHING(sframe_add_key_index(sframe(index_file), {"v"}));
+    // the frame is not saved
+    TS_ASSERT_THROWS_ANYTHING(sframe_add_key_index(sf.select_columns({"v"}), {"v"}));
+  }
+
+  void test_no_in_place_update() {
+    sframe saved = make_saved_frame();
+    TS_ASSERT_THROWS_ANYTHING(
+        sframe_add_key_index(saved, {"id"}, saved.get_index_file()));
+
+    // both indexes are recorded in the new index file
+    std::string index_file = get_temp_name() + ".frame_idx";
+    sframe sf = sframe_add_key_index(saved, {"id", "name"}, index_file);
+    TS_ASSERT_EQUALS(sf.get_index_file(), index_file);
+    TS_ASSERT(sframe_has_key_index(sf, 0));
+    TS_ASSERT(sframe_has_key_index(sf, 1));
+    TS_ASSERT(!sframe_has_key_index(sf, 2));
+    TS_ASSERT(!sframe_has_key_index(saved, 0));
+    TS_ASSERT(testing_extract_sframe_data(sf) == testing_extract_sframe_data(saved));
+  }
+
+  /// A filter of sf on the keys of its column "id", with a mask selecting
+  /// nothing: only a key index lookup finds the rows.
+  query_eval::pnode_ptr make_key_filter(const sframe& sf, const flex_list& keys,
+                                        query_eval::pnode_ptr& mask) {
+    using namespace query_eval;
+    mask = op_transform::make_planner_node(
+        op_sarray_source::make_planner_node(sf.select_column(0)),
+        [](const sframe_rows::row&)->flexible_type { return 0; },
+        flex_type_enum::INTEGER);
+    mask->operator_parameters["key_lookup_values"] = keys;
+    return op_logical_filter::make_planner_node(
+        op_sframe_source::make_planner_node(sf), mask);
+  }
+
+  void test_planner_uses_key_index() {
+    using namespace query_eval;
+    sframe sf = sframe_add_key_index(make_saved_frame(), {"id"});
+
+    // The optimization only moves the keys to a lookup node; the index is
+    // read when the node is executed.
+    pnode_ptr mask;
+    auto optimized = optimization_engine::optimize_planner_graph(
+        make_key_filter(sf, {flex_int(7)}, mask), materialize_options());
+    TS_ASSERT(optimized->operator_type == planner_node_type::KEY_INDEX_LOOKUP_NODE);
+    TS_ASSERT_EQUALS(mask->operator_parameters.count("key_lookup_values"), 0);
+
+    // small blocks, so that the lookup skips blocks and the keys straddle
+    // the segments the frame is read in
+    size_t old_batch_size = sframe_config::SFRAME_READ_BATCH_SIZE;
+    sframe_config::SFRAME_READ_BATCH_SIZE = 16;
+    flex_list keys{flex_int(7), flex_int(250), flex_int(499)};
+    sframe result = planner().materialize(make_key_filter(sf, keys, mask));
+    TS_ASSERT(testing_extract_sframe_data(result) ==
+              scan(sf, 0, {flex_int(7), flex_int(250), flex_int(499)}));
+    TS_ASSERT_EQUALS(result.size(), 12);
+
+    // without the index file the lookup reads every block
+    auto key_index_file = sf.get_index_file() + ".0.kidx";
+    fileio::delete_path(key_index_file);
+    result = planner().materialize(make_key_filter(sf, keys, mask));
+    TS_ASSERT_EQUALS(result.size(), 12);
+    sframe_config::SFRAME_READ_BATCH_SIZE = old_batch_size;
+  }
+};
+
+BOOST_FIXTURE_TEST_SUITE(_sframe_key_index_test, sframe_key_index_test)
+BOOST_AUTO_TEST_CASE(test_lookup) {
+  sframe_key_index_test::test_lookup();
+}
+BOOST_AUTO_TEST_CASE(test_unsupported_column) {
+  sframe_key_index_test::test_unsupported_column();
+}
+BOOST_AUTO_TEST_CASE(test_no_in_place_update) {
+  sframe_key_index_test::test_no_in_place_update();
+}
+BOOST_AUTO_TEST_CASE(test_planner_uses_key_index) {
+  sframe_key_index_test::test_planner_uses_key_index();
+}
+BOOST_AUTO_TEST_SUITE_END()
@@ -4,6 +4,7 @@
 #include <sframe/shuffle.hpp>
 #include <sframe/algorithm.hpp>
 #include <timer/timer.hpp>
+#include <util/cityhash_tc.hpp>
 
 using namespace turi;
 
@@ -123,6 +124,38 @@ struct shuffle_test {
       }
     }
 
+    /**
+     * Test that hash_partition puts each row in the segment of the hash of
+     * its key columns, keeping all the columns.
+     */
+    void test_hash_partition() {
+      size_t num_rows = 20000;
+      sframe sframe_in = create_input_sframe(num_rows);
+      for (size_t n : {1, 3, 16}) {
+        sframe sframe_out = hash_partition(sframe_in, {1, 0}, n);
+        TS_ASSERT_EQUALS(sframe_out.num_segments(), n);
+        TS_ASSERT_EQUALS(sframe_out.num_rows(), num_rows);
+        TS_ASSERT(sframe_out.column_names() == sframe_in.column_names());
+
+        auto reader = sframe_out.get_reader();
+        std::set<flexible_type> seen;
+        for (size_t segment = 0; segment < n; ++segment) {
+          for (auto iter = reader->begin(segment); iter != reader->end(segment); ++iter) {
+            std::vector<flexible_type> row = *iter;
+            TS_ASSERT_EQUALS(row[0], row[1]);
+            size_t hash = hash64_combine(hash64_combine(0, row[1].hash()), row[0].hash());
+            TS_ASSERT_EQUALS(hash % n, segment);
+            TS_ASSERT(seen.insert(row[0]).second);
+          }
+        }
+        TS_ASSERT_EQUALS(seen.size(), num_rows);
+      }
+      // empty input
+      sframe empty_out = hash_partition(create_input_sframe(0), {0}, 4);
+      TS_ASSERT_EQUALS(empty_out.num_rows(), 0);
+      TS_ASSERT_EQUALS(empty_out.num_segments(), 4);
+    }
+
     /**
      *
      * Helper function to test we can shuffle an sframe
@@ -173,4 +206,7 @@ BOOST_AUTO_TEST_CASE(test_bench) {
 BOOST_AUTO_TEST_CASE(test_edge) {
   shuffle_test::test_edge();
 }
+BOOST_AUTO_TEST_CASE(test_hash_partition) {
+  shuffle_test::test_hash_partition();
+}
 BOOST_AUTO_TEST_SUITE_END()
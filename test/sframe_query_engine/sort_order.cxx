@@ -0,0 +1,160 @@
+#define BOOST_TEST_MODULE
+#include <boost/test/unit_test.hpp>
+#include <util/test_macros.hpp>
+#include <algorithm>
+#include <sframe_query_engine/planning/planner.hpp>
+#include <sframe_query_engine/planning/planner_node.hpp>
+#include <sframe_query_engine/operators/all_operators.hpp>
+#include <sframe_query_engine/operators/operator_properties.hpp>
+#include <sframe_query_engine/algorithm/sort.hpp>
+#include <sframe_query_engine/algorithm/groupby_aggregate.hpp>
+#include <sframe/groupby_aggregate_operators.hpp>
+#include <sframe/sframe.hpp>
+#include <sframe/testing_utils.hpp>
+#include <fileio/temp_files.hpp>
+
+using namespace turi;
+using namespace turi::query_eval;
+
+struct sort_order_test {
+ public:
+  /// key: a permutation of i % 101, val: i
+  sframe make_frame(size_t num_rows) {
+    std::vector<std::vector<flexible_type>> data;
+    for (size_t i = 0; i < num_rows; ++i) {
+      data.push_back({flex_int((i * 7919) % 101), flex_int(i)});
+    }
+    return make_testing_sframe({"key", "val"},
+                               {flex_type_enum::INTEGER, flex_type_enum::INTEGER},
+                               data);
+  }
+
+  void test_sort_order_metadata() {
+    sframe sf = make_frame(100);
+    TS_ASSERT(sf.get_sort_order().empty());
+
+    sframe_sort_order order{{1, false}, {0, true}};
+    sf.set_sort_order(order);
+    TS_ASSERT(sf.get_sort_order() == order);
+    // frames made from the columns do not inherit it
+    TS_ASSERT(sf.select_columns({"val", "key"}).get_sort_order().empty());
+
+    // saved with the frame
+    std::string index_file = get_temp_name() + ".frame_idx";
+    sf.save(index_file);
+    TS_ASSERT(sframe(index_file).get_sort_order() == order);
+
+    sf.set_sort_order({});
+    TS_ASSERT(sf.get_sort_order().empty());
+  }
+
+  void test_append_drops_sort_order() {
+    sframe sf = make_frame(100);
+    sframe_sort_order order{{0, true}};
+    sf.set_sort_order(order);
+
+    // the appended rows break the order
+    sframe appended = sf.append(make_frame(50));
+    TS_ASSERT_EQUALS(appended.num_rows(), 150);
+    TS_ASSERT(appended.get_sort_order().empty());
+    TS_ASSERT(make_frame(50).append(sf).get_sort_order().empty());
+    // the source keeps its order
+    TS_ASSERT(sf.get_sort_order() == order);
+
+    // appending an empty frame, or to one, keeps it
+    sframe empty = make_frame(0);
+    TS_ASSERT(sf.append(empty).get_sort_order() == order);
+    TS_ASSERT(empty.append(sf).get_sort_order() == order);
+
+    // renaming a column keeps it: the order is kept by column index
+    sframe renamed = sf;
+    renamed.set_column_name(0, "renamed_key");
+    TS_ASSERT(renamed.get_sort_order() == order);
+  }
+
+  void test_infer_sort_order() {
+    sframe sf = make_frame(100);
+    sf.set_sort_order({{0, true}, {1, false}});
+    auto source = op_sframe_source::make_planner_node(sf);
+    typedef std::vector<std::pair<size_t, bool>> order_type;
+
+    TS_ASSERT(infer_planner_node_sort_order(source) == order_type({{0, true}, {1, false}}));
+    // project keeps the most significant projected columns
+    TS_ASSERT(infer_planner_node_sort_order(
+        op_project::make_planner_node(source, {1, 0})) ==
+              order_type({{1, true}, {0, false}}));
+    TS_ASSERT(infer_planner_node_sort_order(
+        op_project::make_planner_node(source, {1})).empty());
+    // filters keep the order
+    auto mask = op_project::make_planner_node(source, {1});
+    auto filtered = op_logical_filter::make_planner_node(source, mask);
+    TS_ASSERT(infer_planner_node_sort_order(filtered) == order_type({{0, true}, {1, false}}));
+    // union shifts the columns of the sorted input
+    auto unioned = op_union::make_planner_node(
+        op_project::make_planner_node(source, {1}), source);
+    TS_ASSERT(infer_planner_node_sort_order(unioned) == order_type({{1, true}, {2, false}}));
+    TS_ASSERT(infer_planner_node_sort_order(op_range::make_planner_node(0, 10)) ==
+              order_type({{0, true}}));
+    // transforms do not
+    auto transformed = op_transform::make_planner_node(
+        source,
+        [](const sframe_rows::row& a)->flexible_type { return a[0]; },
+        flex_type_enum::INTEGER);
+    TS_ASSERT(infer_planner_node_sort_order(transformed).empty());
+
+    // a materialized frame records the order
+    sframe materialized = planner().materialize(filtered);
+    TS_ASSERT(materialized.get_sort_order() == sframe_sort_order({{0, true}, {1, false}}));
+  }
+
+  std::vector<std::vector<flexible_type>> sorted_data(const sframe& sf) {
+    auto ret = testing_extract_sframe_data(sf);
+    std::sort(ret.begin(), ret.end());
+    return ret;
+  }
+
+  void test_sorted_groupby() {
+    sframe sf = make_frame(20000);
+    auto sorted = sort(op_sframe_source::make_planner_node(sf),
+                       sf.column_names(), {0}, {false});
+    TS_ASSERT(sorted->get_sort_order() == sframe_sort_order({{0, false}}));
+    // sorting again is a no-op
+    auto sorted_again = sort(op_sframe_source::make_planner_node(*sorted),
+                             sf.column_names(), {0}, {false});
+    TS_ASSERT(sorted_data(*sorted_again) == sorted_data(*sorted));
+
+    auto groupby = [&](const sframe& source) {
+      return groupby_aggregate(
+          op_sframe_source::make_planner_node(source),
+          source.column_names(), {"key"}, {"sum", "count"},
+          {{{"val"}, std::make_shared<groupby_operators::sum>()},
+           {{}, std::make_shared<groupby_operators::count>()}});
+    };
+    auto hashed = groupby(sf);
+    auto streamed = groupby(*sorted);
+    TS_ASSERT_EQUALS(streamed->num_rows(), 101);
+    TS_ASSERT(sorted_data(*streamed) == sorted_data(*hashed));
+
+    // the groups come out in the order of the keys
+    TS_ASSERT(streamed->get_sort_order() == sframe_sort_order({{0, false}}));
+    auto rows = testing_extract_sframe_data(*streamed);
+    for (size_t i = 0; i < rows.size(); ++i) {
+      TS_ASSERT_EQUALS(rows[i][0], flex_int(100 - i));
+    }
+  }
+};
+
+BOOST_FIXTURE_TEST_SUITE(_sort_order_test, sort_order_test)
+BOOST_AUTO_TEST_CASE(test_sort_order_metadata) {
+  sort_order_test::test_sort_order_metadata();
+}
+BOOST_AUTO_TEST_CASE(test_append_drops_sort_order) {
+  sort_order_test::test_append_drops_sort_order();
+}
+BOOST_AUTO_TEST_CASE(test_infer_sort_order) {
+  sort_order_test::test_infer_sort_order();
+}
+BOOST_AUTO_TEST_CASE(test_sorted_groupby) {
+  sort_order_test::test_sorted_groupby();
+}
+BOOST_AUTO_TEST_SUITE_END()
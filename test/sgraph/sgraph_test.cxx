@@ -3,6 +3,9 @@
 #include <util/test_macros.hpp>
 #include <sgraph/sgraph.hpp>
 #include <sframe/algorithm.hpp>
+#include <sframe/sframe_key_index.hpp>
+#include <serialization/dir_archive.hpp>
+#include <fileio/temp_files.hpp>
 #include "sgraph_test_util.hpp"
 
 using namespace turi;
@@ -289,6 +292,131 @@ struct sgraph_test  {
     assert_vector_equals(expected_vfield_types, g.get_vertex_field_types());
     assert_vector_equals(expected_efield_types, g.get_edge_field_types());
   }
+
+  /// The sorted values of the column of sf.
+  std::vector<flexible_type> sorted_column(const sframe& sf, const std::string& column) {
+    std::vector<flexible_type> ret;
+    sf.select_column(column)->get_reader()->read_rows(0, sf.num_rows(), ret);
+    std::sort(ret.begin(), ret.end());
+    return ret;
+  }
+
+  void check_ring_neighborhood(const sgraph& g) {
+    typedef sgraph::edge_direction edge_direction;
+    // the ring has the edges i -> i + 1
+    auto out_hood = g.get_neighborhood({0}, 2, edge_direction::OUT_EDGE);
+    assert_vector_equals(sorted_column(out_hood.first, "__id"), {0, 1, 2});
+    assert_vector_equals(sorted_column(out_hood.second, "__src_id"), {0, 1});
+
+    auto in_hood = g.get_neighborhood({0}, 2, edge_direction::IN_EDGE);
+    assert_vector_equals(sorted_column(in_hood.first, "__id"), {0, 98, 99});
+    assert_vector_equals(sorted_column(in_hood.second, "__dst_id"), {0, 99});
+
+    // each edge once, even though 0 -> 1 is adjacent to two frontiers
+    auto any_hood = g.get_neighborhood({0, 1}, 1);
+    assert_vector_equals(sorted_column(any_hood.first, "__id"), {0, 1, 2, 99});
+    assert_vector_equals(sorted_column(any_hood.second, "__src_id"), {0, 1, 99});
+
+    auto empty_hood = g.get_neighborhood({1000}, 3);
+    TS_ASSERT_EQUALS(empty_hood.first.num_rows(), 0);
+    TS_ASSERT_EQUALS(empty_hood.second.num_rows(), 0);
+
+    TS_ASSERT_EQUALS(g.get_vertices({5, 7, 1000}).num_rows(), 2);
+    TS_ASSERT_EQUALS(g.get_edges({5, 7, FLEX_UNDEFINED}, {6, 9, 3}).num_rows(), 2);
+  }
+
+  void test_neighborhood() {
+    sgraph g = create_ring_graph(100, 4);
+    check_ring_neighborhood(g);
+
+    // the loaded graph answers the same queries through its id indexes
+    std::string path = get_temp_name();
+    dir_archive write_arc;
+    write_arc.open_directory_for_write(path);
+    oarchive oarc(write_arc);
+    oarc << g;
+    write_arc.close();
+
+    sgraph loaded;
+    dir_archive read_arc;
+    read_arc.open_directory_for_read(path);
+    iarchive iarc(read_arc);
+    iarc >> loaded;
+    read_arc.close();
+
+    // the partitions of the edge 0 -> 1
+    size_t src_partition = flexible_type(0).hash() % 4;
+    size_t dst_partition = flexible_type(1).hash() % 4;
+    const sframe& vertex_sframe = loaded.vertex_partition(src_partition);
+    const sframe& edge_sframe = loaded.edge_partition(src_partition, dst_partition);
+    TS_ASSERT(sframe_get_key_index(vertex_sframe,
+                                   vertex_sframe.column_index("__id")) != nullptr);
+    TS_ASSERT(sframe_get_key_index(edge_sframe,
+                                   edge_sframe.column_index("__src_id")) != nullptr);
+    TS_ASSERT(sframe_get_key_index(edge_sframe,
+                                   edge_sframe.column_index("__dst_id")) != nullptr);
+    check_ring_neighborhood(loaded);
+  }
+
+  /// Checks the graph built by test_incremental_add.
+  void check_incremental_graph(const sgraph& g) {
+    std::vector<std::vector<flexible_type>> rows;
+    sframe vertices = g.get_vertices();
+    size_t vid_idx = vertices.column_index("__id");
+    size_t vdata_idx = vertices.column_index("vdata");
+    vertices.get_reader()->read_rows(0, vertices.num_rows(), rows);
+    TS_ASSERT_EQUALS(rows.size(), 110);
+    for (const auto& row : rows) {
+      // vertex v was last added by batch v / 10
+      TS_ASSERT_EQUALS(row[vdata_idx], std::min<flex_int>(row[vid_idx].get<flex_int>() / 10, 9));
+    }
+
+    sframe edges = g.get_edges();
+    size_t src_idx = edges.column_index("__src_id");
+    size_t dst_idx = edges.column_index("__dst_id");
+    edges.get_reader()->read_rows(0, edges.num_rows(), rows);
+    TS_ASSERT_EQUALS(rows.size(), 10);
+    for (const auto& row : rows) {
+      TS_ASSERT_EQUALS(row[dst_idx], row[src_idx] + 11);
+    }
+  }
+
+  void test_incremental_add() {
+    size_t old_segment_rows = SGRAPH_PARTITION_SEGMENT_ROWS;
+    size_t old_max_delta_segments = SGRAPH_PARTITION_MAX_DELTA_SEGMENTS;
+    SGRAPH_PARTITION_SEGMENT_ROWS = 8;
+    SGRAPH_PARTITION_MAX_DELTA_SEGMENTS = 1000;
+
+    // batch b adds the vertices [10b, 10b + 20), updating half of the
+    // vertices of batch b - 1, and the edge 10b -> 10b + 11.
+    sgraph g(4);
+    for (flex_int b = 0; b < 10; ++b) {
+      std::vector<flexible_type> ids, vdata;
+      for (flex_int v = 10 * b; v < 10 * b + 20; ++v) {
+        ids.push_back(v);
+        vdata.push_back(b);
+      }
+      g.add_vertices(create_sframe({{"vid", flex_type_enum::INTEGER, ids},
+                                    {"vdata", flex_type_enum::INTEGER, vdata}}),
+                     "vid");
+      g.add_edges(create_sframe({{"src", flex_type_enum::INTEGER, {10 * b}},
+                                 {"dst", flex_type_enum::INTEGER, {10 * b + 11}}}),
+                  "src", "dst");
+    }
+    TS_ASSERT_EQUALS(g.num_vertices(), 110);
+    check_incremental_graph(g);
+
+    g.compact();
+    for (size_t i = 0; i < 4; ++i) {
+      const sframe& vertices = g.vertex_partition(i);
+      TS_ASSERT_EQUALS(vertices.num_segments(),
+                       std::max<size_t>(1, (vertices.num_rows() + 7) / 8));
+    }
+    check_incremental_graph(g);
+
+    SGRAPH_PARTITION_SEGMENT_ROWS = old_segment_rows;
+    SGRAPH_PARTITION_MAX_DELTA_SEGMENTS = old_max_delta_segments;
+  }
 };
 
 BOOST_FIXTURE_TEST_SUITE(_sgraph_test, sgraph_test)
@@ -313,4 +441,10 @@ BOOST_AUTO_TEST_CASE(test_star_graph) {
 BOOST_AUTO_TEST_CASE(test_graph_field_query) {
   sgraph_test::test_graph_field_query();
 }
+BOOST_AUTO_TEST_CASE(test_neighborhood) {
+  sgraph_test::test_neighborhood();
+}
+BOOST_AUTO_TEST_CASE(test_incremental_add) {
+  sgraph_test::test_incremental_add();
+}
 BOOST_AUTO_TEST_SUITE_END()
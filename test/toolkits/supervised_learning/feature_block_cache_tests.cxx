@@ -0,0 +1,206 @@
+#define BOOST_TEST_MODULE
+#include <boost/test/unit_test.hpp>
+#include <util/test_macros.hpp>
+#include <vector>
+#include <string>
+#include <cmath>
+
+#include <ml_data/ml_data.hpp>
+#include <toolkits/supervised_learning/feature_block_cache.hpp>
+#include <toolkits/supervised_learning/linear_regression.hpp>
+#include <toolkits/supervised_learning/linear_regression_opt_interface.hpp>
+#include <toolkits/supervised_learning/logistic_regression.hpp>
+#include <toolkits/supervised_learning/logistic_regression_opt_interface.hpp>
+#include <toolkits/supervised_learning/linear_svm.hpp>
+#include <toolkits/supervised_learning/linear_svm_opt_interface.hpp>
+#include <sframe/testing_utils.hpp>
+
+using namespace turi;
+using namespace turi::supervised;
+
+/**
+ * Checks that the solver interfaces compute the same statistics from the
+ * cached feature blocks as from the rows of the ml_data.
+ */
+struct feature_block_cache_test {
+ public:
+  feature_block_cache_test()
+      : m_cache_bytes(SUPERVISED_LEARNING_FEATURE_CACHE_BYTES),
+        m_block_rows(SUPERVISED_LEARNING_FEATURE_BLOCK_ROWS) {
+    // Blocks of a few rows, so that many blocks straddle the segment
+    // boundaries of the data.
+    SUPERVISED_LEARNING_FEATURE_BLOCK_ROWS = 7;
+  }
+
+  ~feature_block_cache_test() {
+    SUPERVISED_LEARNING_FEATURE_CACHE_BYTES = m_cache_bytes;
+    SUPERVISED_LEARNING_FEATURE_BLOCK_ROWS = m_block_rows;
+  }
+
+  /**
+   * Random features, every 11th value missing, and targets from target_fn
+   * of the features. The frame is made of several segments of sizes which
+   * are not multiples of the block size.
+   */
+  template <typename TargetFn>
+  void make_data(flex_type_enum target_type, TargetFn target_fn,
+                 sframe& X, sframe& y) {
+    size_t features = 3;
+    std::vector<std::string> feature_names;
+    std::vector<flex_type_enum> feature_types;
+    for (size_t k = 0; k < features; k++) {
+      feature_names.push_back(std::to_string(k));
+      feature_types.push_back(flex_type_enum::FLOAT);
+    }
+
+    size_t row = 0;
+    bool first = true;
+    for (size_t segment_rows : {50, 33, 67}) {
+      std::vector<std::vector<flexible_type>> X_data;
+      std::vector<std::vector<flexible_type>> y_data;
+      for (size_t i = 0; i < segment_rows; ++i, ++row) {
+        DenseVector x(features);
+        x.randn();
+        std::vector<flexible_type> x_tmp;
+        for (size_t k = 0; k < features; k++) {
+          if ((row * features + k) % 11 == 0) {
+            x_tmp.push_back(FLEX_UNDEFINED);
+          } else {
+            x_tmp.push_back(x(k));
+          }
+        }
+        X_data.push_back(x_tmp);
+        y_data.push_back({target_fn(x)});
+      }
+      sframe X_part = make_testing_sframe(feature_names, feature_types, X_data);
+      sframe y_part = make_testing_sframe({"target"}, {target_type}, y_data);
+      if (first) {
+        X = X_part;
+        y = y_part;
+        first = false;
+      } else {
+        X = X.append(X_part);
+        y = y.append(y_part);
+      }
+    }
+    TS_ASSERT_LESS_THAN(2, X.select_column(0)->get_index_info().nsegments);
+  }
+
+  /// Compares the function values and gradients of the two interfaces.
+  template <typename Interface>
+  static void compare_first_order(Interface& per_row, Interface& blocked,
+                                  const DenseVector& point) {
+    size_t variables = point.size();
+    DenseVector row_gradient(variables), block_gradient(variables);
+    double row_value, block_value;
+    per_row.compute_first_order_statistics(point, row_gradient, row_value);
+    blocked.compute_first_order_statistics(point, block_gradient, block_value);
+    TS_ASSERT_DELTA(row_value, block_value, 1e-8 * (1 + std::abs(row_value)));
+    TS_ASSERT(arma::approx_equal(row_gradient, block_gradient, "both", 1e-8, 1e-8));
+  }
+
+  /// Compares the function values, gradients and hessians of the two interfaces.
+  template <typename Interface>
+  static void compare_second_order(Interface& per_row, Interface& blocked,
+                                   const DenseVector& point) {
+    compare_first_order(per_row, blocked, point);
+    size_t variables = point.size();
+    DenseVector row_gradient(variables), block_gradient(variables);
+    DenseMatrix row_hessian(variables, variables);
+    DenseMatrix block_hessian(variables, variables);
+    double row_value, block_value;
+    per_row.compute_second_order_statistics(point, row_hessian,
+                                            row_gradient, row_value);
+    blocked.compute_second_order_statistics(point, block_hessian,
+                                            block_gradient, block_value);
+    TS_ASSERT_DELTA(row_value, block_value, 1e-8 * (1 + std::abs(row_value)));
+    TS_ASSERT(arma::approx_equal(row_gradient, block_gradient, "both", 1e-8, 1e-8));
+    TS_ASSERT(arma::approx_equal(row_hessian, block_hessian, "both", 1e-8, 1e-8));
+  }
+
+  /**
+   * Builds two solver interfaces on the same data, one without a block
+   * cache budget (the per-row path) and one with blocks, and compares them
+   * with compare(per_row, blocked, point) at random points.
+   */
+  template <typename Interface, typename Model, typename CompareFn>
+  void check_parity(std::shared_ptr<Model> model, const sframe& X,
+                    const sframe& y, bool rescale, CompareFn compare) {
+    model->init(X, y, sframe(), sframe(), ml_missing_value_action::IMPUTE);
+    ml_data data = model->construct_ml_data_using_current_metadata(
+        X, y, ml_missing_value_action::IMPUTE);
+    ml_data valid_data;
+
+    // The cache budget is checked on the first pass.
+    SUPERVISED_LEARNING_FEATURE_CACHE_BYTES = 0;
+    Interface per_row(data, valid_data, *model);
+    if (rescale) per_row.init_feature_rescaling();
+    size_t variables = per_row.num_variables();
+    DenseVector gradient(variables);
+    double function_value;
+    per_row.compute_first_order_statistics(arma::zeros(variables), gradient,
+                                           function_value);
+
+    SUPERVISED_LEARNING_FEATURE_CACHE_BYTES = m_cache_bytes;
+    Interface blocked(data, valid_data, *model);
+    if (rescale) blocked.init_feature_rescaling();
+
+    for (size_t i = 0; i < 5; ++i) {
+      DenseVector point(variables);
+      point.randn();
+      compare(per_row, blocked, point);
+    }
+  }
+
+  void test_linear_regression() {
+    sframe X, y;
+    make_data(flex_type_enum::FLOAT, [](const DenseVector& x) {
+      return flexible_type(1.0 + 2.0 * x(0) - x(1) + 0.5 * x(2));
+    }, X, y);
+    for (bool rescale : {false, true}) {
+      check_parity<linear_regression_opt_interface>(
+          std::make_shared<linear_regression>(), X, y, rescale,
+          compare_second_order<linear_regression_opt_interface>);
+    }
+  }
+
+  void test_logistic_regression() {
+    sframe X, y;
+    make_data(flex_type_enum::STRING, [](const DenseVector& x) {
+      return flexible_type(x(0) > 0.5 ? "a" : (x(1) > 0 ? "b" : "c"));
+    }, X, y);
+    for (bool rescale : {false, true}) {
+      check_parity<logistic_regression_opt_interface>(
+          std::make_shared<logistic_regression>(), X, y, rescale,
+          compare_second_order<logistic_regression_opt_interface>);
+    }
+  }
+
+  void test_linear_svm() {
+    sframe X, y;
+    make_data(flex_type_enum::INTEGER, [](const DenseVector& x) {
+      return flexible_type(x(0) - x(2) > 0 ? 1 : 0);
+    }, X, y);
+    for (bool rescale : {false, true}) {
+      check_parity<linear_svm_scaled_logistic_opt_interface>(
+          std::make_shared<linear_svm>(), X, y, rescale,
+          compare_first_order<linear_svm_scaled_logistic_opt_interface>);
+    }
+  }
+
+ private:
+  size_t m_cache_bytes;
+  size_t m_block_rows;
+};
+
+BOOST_FIXTURE_TEST_SUITE(_feature_block_cache_test, feature_block_cache_test)
+BOOST_AUTO_TEST_CASE(test_linear_regression) {
+  feature_block_cache_test::test_linear_regression();
+}
+BOOST_AUTO_TEST_CASE(test_logistic_regression) {
+  feature_block_cache_test::test_logistic_regression();
+}
+BOOST_AUTO_TEST_CASE(test_linear_svm) {
+  feature_block_cache_test::test_linear_svm();
+}
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,278 @@
+#define BOOST_TEST_MODULE
+#include <boost/test/unit_test.hpp>
+#include <util/test_macros.hpp>
+#include <atomic>
+#include <vector>
+#include <string>
+#include <cmath>
+
+#include <ml_data/ml_data.hpp>
+#include <toolkits/supervised_learning/linear_regression.hpp>
+#include <toolkits/supervised_learning/logistic_regression.hpp>
+#include <toolkits/supervised_learning/prepared_predictor.hpp>
+#include <sframe/testing_utils.hpp>
+#include <parallel/lambda_omp.hpp>
+
+using namespace turi;
+using namespace turi::supervised;
+
+/// A linear regression which makes the predictor go through fast_predict.
+class linear_regression_without_single_example : public linear_regression {
+ public:
+  bool supports_single_example_prediction() const override { return false; }
+};
+
+struct prepared_predictor_test {
+ public:
+  /**
+   * Trains model on y = 1 + 2 x0 - x1 + 0.5 x2 for random x, returning the
+   * features of the examples and the predictions of model through ml_data.
+   */
+  void train_linear_regression(std::shared_ptr<linear_regression> model,
+                               size_t examples,
+                               std::vector<std::string>& feature_names,
+                               std::vector<std::vector<flexible_type>>& X_data,
+                               std::vector<flexible_type>& expected) {
+    size_t features = 3;
+    feature_names.clear();
+    X_data.clear();
+    std::vector<flex_type_enum> feature_types;
+    for (size_t i = 0; i < features; i++) {
+      feature_names.push_back(std::to_string(i));
+      feature_types.push_back(flex_type_enum::FLOAT);
+    }
+
+    std::vector<std::vector<flexible_type>> y_data;
+    for (size_t i = 0; i < examples; i++) {
+      DenseVector x(features);
+      x.randn();
+      std::vector<flexible_type> x_tmp;
+      for (size_t k = 0; k < features; k++) x_tmp.push_back(x(k));
+      X_data.push_back(x_tmp);
+      y_data.push_back({1.0 + 2.0 * x(0) - x(1) + 0.5 * x(2)});
+    }
+
+    sframe X = make_testing_sframe(feature_names, feature_types, X_data);
+    sframe y = make_testing_sframe({"target"}, {flex_type_enum::FLOAT}, y_data);
+
+    model->init(X, y);
+    model->init_options({{"solver", "newton"}, {"max_iterations", 10},
+                         {"l1_penalty", 0.0}, {"l2_penalty", 0.0}});
+    model->train();
+
+    ml_data data = model->construct_ml_data_using_current_metadata(X);
+    model->predict(data)->get_reader()->read_rows(0, examples, expected);
+  }
+
+  /// The rows of X_data as {name: value} dictionaries.
+  std::vector<flexible_type> make_dict_rows(
+      const std::vector<std::string>& feature_names,
+      const std::vector<std::vector<flexible_type>>& X_data) {
+    std::vector<flexible_type> ret;
+    for (const auto& x : X_data) {
+      flex_dict d;
+      for (size_t k = 0; k < feature_names.size(); k++) {
+        d.push_back({feature_names[k], x[k]});
+      }
+      ret.push_back(d);
+    }
+    return ret;
+  }
+
+  void test_linear_regression() {
+    size_t examples = 100;
+    size_t features = 3;
+
+    std::vector<std::string> feature_names;
+    std::vector<std::vector<flexible_type>> X_data;
+    std::vector<flexible_type> expected;
+    std::shared_ptr<linear_regression> model(new linear_regression);
+    train_linear_regression(model, examples, feature_names, X_data, expected);
+    TS_ASSERT(model->supports_single_example_prediction());
+
+    prepared_predictor predictor(model, "error");
+    TS_ASSERT(predictor.feature_names() == feature_names);
+    TS_ASSERT(predictor.prediction_type() == flex_type_enum::FLOAT);
+
+    std::vector<flexible_type> dict_rows, list_rows, vec_rows;
+    for (size_t i = 0; i < examples; i++) {
+      flex_dict d;
+      flex_vec v;
+      for (size_t k = 0; k < features; k++) {
+        d.push_back({feature_names[k], X_data[i][k]});
+        v.push_back(X_data[i][k]);
+      }
+      // The target and unknown columns are ignored.
+      d.push_back({"target", 0.0});
+      d.push_back({"unknown", "x"});
+      dict_rows.push_back(d);
+      list_rows.push_back(flex_list(X_data[i]));
+      vec_rows.push_back(v);
+    }
+
+    // Twice, to go through reused buffers.
+    for (size_t pass = 0; pass < 2; ++pass) {
+      std::vector<flexible_type> preds;
+      for (const auto& rows : {dict_rows, list_rows, vec_rows}) {
+        predictor.predict(rows, preds);
+        TS_ASSERT_EQUALS(preds.size(), examples);
+        for (size_t i = 0; i < examples; i++) {
+          TS_ASSERT_DELTA(preds[i].get<flex_float>(),
+                          expected[i].get<flex_float>(), 1e-8);
+        }
+      }
+    }
+
+    // Batches of one row.
+    for (size_t i = 0; i < examples; i += 17) {
+      auto preds = predictor.predict({dict_rows[i]});
+      TS_ASSERT_DELTA(preds[0].get<flex_float>(),
+                      expected[i].get<flex_float>(), 1e-8);
+    }
+    TS_ASSERT(predictor.predict({}).empty());
+
+    // Missing values.
+    flex_dict partial = {{"0", 1.0}, {"1", 2.0}};
+    TS_ASSERT_THROWS_ANYTHING(predictor.predict({partial}));
+    prepared_predictor imputing(model, "impute");
+    TS_ASSERT_EQUALS(imputing.predict({partial}).size(), 1);
+
+    // Bad rows.
+    TS_ASSERT_THROWS_ANYTHING(predictor.predict({flex_list{1.0, 2.0}}));
+    TS_ASSERT_THROWS_ANYTHING(predictor.predict({flexible_type(1.0)}));
+  }
+
+  void test_concurrent_calls() {
+    size_t examples = 1000;
+    std::vector<std::string> feature_names;
+    std::vector<std::vector<flexible_type>> X_data;
+    std::vector<flexible_type> expected;
+    std::shared_ptr<linear_regression> model(new linear_regression);
+    train_linear_regression(model, examples, feature_names, X_data, expected);
+    std::vector<flexible_type> rows = make_dict_rows(feature_names, X_data);
+
+    prepared_predictor predictor(model, "error");
+    // Every thread predicts batches of different sizes many times over, so
+    // that the calls overlap and buffers are handed from call to call.
+    std::atomic<size_t> num_wrong(0);
+    std::atomic<size_t> num_predicted(0);
+    in_parallel([&](size_t thread_idx, size_t num_threads) {
+      std::vector<flexible_type> preds;
+      for (size_t pass = 0; pass < 20; ++pass) {
+        size_t batch_size = 1 + (thread_idx * 7 + pass * 13) % 50;
+        size_t begin = (thread_idx * 101 + pass * 37) % (examples - batch_size);
+        std::vector<flexible_type> batch(rows.begin() + begin,
+                                         rows.begin() + begin + batch_size);
+        predictor.predict(batch, preds);
+        for (size_t i = 0; i < batch_size; ++i) {
+          if (preds.size() != batch_size ||
+              std::abs(preds[i].get<flex_float>() -
+                       expected[begin + i].get<flex_float>()) > 1e-8) {
+            ++num_wrong;
+          }
+        }
+        num_predicted += batch_size;
+      }
+    });
+    TS_ASSERT_EQUALS(num_wrong.load(), 0);
+    TS_ASSERT_LESS_THAN(0, num_predicted.load());
+  }
+
+  void test_logistic_regression_sparse() {
+    // A numeric and a categorical feature with many categories, so that the
+    // model predicts from sparse vectors, and three classes.
+    size_t examples = 300;
+    size_t categories = 20;
+    std::vector<std::string> feature_names = {"x", "c"};
+    std::vector<std::vector<flexible_type>> X_data;
+    std::vector<std::vector<flexible_type>> y_data;
+    for (size_t i = 0; i < examples; i++) {
+      double x = double(i % 31) / 10.0 - 1.5;
+      size_t c = (i * 7) % categories;
+      X_data.push_back({x, "c" + std::to_string(c)});
+      std::string target = x + (c < 10 ? 1.0 : -1.0) > 0.5 ? "a"
+                           : (c % 3 == 0 ? "b" : "c");
+      y_data.push_back({target});
+    }
+    sframe X = make_testing_sframe(feature_names,
+                                   {flex_type_enum::FLOAT, flex_type_enum::STRING},
+                                   X_data);
+    sframe y = make_testing_sframe({"target"}, {flex_type_enum::STRING}, y_data);
+
+    std::shared_ptr<logistic_regression> model(new logistic_regression);
+    model->init(X, y);
+    model->init_options({{"max_iterations", 10}, {"l1_penalty", 0.0},
+                         {"l2_penalty", 1e-2}});
+    model->train();
+    TS_ASSERT(!model->is_dense());
+
+    ml_data data = model->construct_ml_data_using_current_metadata(X);
+    std::vector<flexible_type> rows = make_dict_rows(feature_names, X_data);
+    std::vector<flexible_type> list_rows;
+    for (const auto& x : X_data) list_rows.push_back(flex_list(x));
+
+    for (std::string output_type : {"class", "probability_vector"}) {
+      std::vector<flexible_type> expected;
+      model->predict(data, output_type)->get_reader()->read_rows(0, examples, expected);
+
+      prepared_predictor predictor(model, "error", output_type);
+      TS_ASSERT(predictor.prediction_type() ==
+                (output_type == "class" ? flex_type_enum::STRING
+                                        : flex_type_enum::VECTOR));
+      for (const auto& batch : {rows, list_rows}) {
+        std::vector<flexible_type> preds = predictor.predict(batch);
+        TS_ASSERT_EQUALS(preds.size(), examples);
+        for (size_t i = 0; i < examples; i++) {
+          if (output_type == "class") {
+            TS_ASSERT(preds[i] == expected[i]);
+          } else {
+            const flex_vec& probs = preds[i].get<flex_vec>();
+            const flex_vec& expected_probs = expected[i].get<flex_vec>();
+            TS_ASSERT_EQUALS(probs.size(), 3);
+            TS_ASSERT_EQUALS(probs.size(), expected_probs.size());
+            for (size_t k = 0; k < probs.size(); k++) {
+              TS_ASSERT_DELTA(probs[k], expected_probs[k], 1e-8);
+            }
+          }
+        }
+      }
+    }
+  }
+
+  void test_fast_predict_fallback() {
+    size_t examples = 100;
+    std::vector<std::string> feature_names;
+    std::vector<std::vector<flexible_type>> X_data;
+    std::vector<flexible_type> expected;
+    std::shared_ptr<linear_regression> model(
+        new linear_regression_without_single_example);
+    train_linear_regression(model, examples, feature_names, X_data, expected);
+    TS_ASSERT(!model->supports_single_example_prediction());
+
+    prepared_predictor predictor(model, "error");
+    std::vector<flexible_type> preds =
+        predictor.predict(make_dict_rows(feature_names, X_data));
+    TS_ASSERT_EQUALS(preds.size(), examples);
+    for (size_t i = 0; i < examples; i++) {
+      TS_ASSERT_DELTA(preds[i].get<flex_float>(),
+                      expected[i].get<flex_float>(), 1e-8);
+    }
+    // fast_predict only takes dictionaries
+    TS_ASSERT_THROWS_ANYTHING(predictor.predict({flex_list(X_data[0])}));
+  }
+};
+
+BOOST_FIXTURE_TEST_SUITE(_prepared_predictor_test, prepared_predictor_test)
+BOOST_AUTO_TEST_CASE(test_linear_regression) {
+  prepared_predictor_test::test_linear_regression();
+}
+BOOST_AUTO_TEST_CASE(test_concurrent_calls) {
+  prepared_predictor_test::test_concurrent_calls();
+}
+BOOST_AUTO_TEST_CASE(test_logistic_regression_sparse) {
+  prepared_predictor_test::test_logistic_regression_sparse();
+}
+BOOST_AUTO_TEST_CASE(test_fast_predict_fallback) {
+  prepared_predictor_test::test_fast_predict_fallback();
+}
+BOOST_AUTO_TEST_SUITE_END()
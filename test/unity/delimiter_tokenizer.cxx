@@ -0,0 +1,130 @@
+#define BOOST_TEST_MODULE
+#include <boost/test/unit_test.hpp>
+#include <util/test_macros.hpp>
+#include <string>
+#include <vector>
+#include <map>
+#include <thread>
+
+#include <unity/lib/delimiter_tokenizer.hpp>
+using namespace turi;
+
+struct delimiter_tokenizer_test {
+ public:
+  /// The reference tokenization: split on any character of delims.
+  std::vector<std::string> split(const std::string& s, const std::string& delims) {
+    std::vector<std::string> ret;
+    std::string current;
+    for (char c : s) {
+      if (delims.find(c) != std::string::npos) {
+        if (!current.empty()) ret.push_back(current);
+        current.clear();
+      } else {
+        current += c;
+      }
+    }
+    if (!current.empty()) ret.push_back(current);
+    return ret;
+  }
+
+  std::vector<std::string> tokenize(const delimiter_tokenizer& tokenizer,
+                                    const std::string& s) {
+    std::vector<std::string> ret;
+    tokenizer.for_each_token(s.data(), s.size(), [&](const char* p, size_t len) {
+      ret.push_back(std::string(p, len));
+    });
+    return ret;
+  }
+
+  void test_tokens() {
+    delimiter_tokenizer whitespace(flex_list{"\r", "\v", "\n", "\f", "\t", " "});
+    std::vector<std::string> docs = {
+      "", " ", "a", "  a  b ", "one two\tthree\nfour",
+      // tokens crossing 16 byte boundaries
+      "abcdefghijklmnopqrstuvwxyz0123456789 ABCDEFGHIJKLMNOPQRSTUVWXYZ x",
+      std::string(40, 'z') + " " + std::string(15, 'y') + "\t\t" + std::string(17, 'w')};
+    for (const auto& d : docs) {
+      TS_ASSERT(tokenize(whitespace, d) == split(d, "\r\v\n\f\t "));
+    }
+
+    // more than 16 delimiters use the byte table only
+    std::string many = "!\"#$%&'()*+,-./:;<=>?@";
+    flex_list many_list;
+    for (char c : many) many_list.push_back(std::string(1, c));
+    delimiter_tokenizer punct(many_list);
+    std::string doc = "hello, world! (this) is-a test; of=many <delimiters> ok?";
+    TS_ASSERT(tokenize(punct, doc) == split(doc, many));
+
+    // only the first character of a delimiter is used
+    delimiter_tokenizer first_char(flex_list{"ab", ""});
+    TS_ASSERT(tokenize(first_char, "xaybz") == split("xaybz", "a"));
+
+    // no delimiters: the whole string is a token
+    delimiter_tokenizer none;
+    TS_ASSERT(tokenize(none, "a b") == std::vector<std::string>{"a b"});
+  }
+
+  void test_count_and_intern() {
+    delimiter_tokenizer whitespace(flex_list{" "});
+    token_counter counter(whitespace, true);
+    counter.add("The cat and the Hat");
+    counter.add("THE end");
+    flex_dict counts = counter.to_dict();
+
+    std::map<std::string, flex_int> expected = {
+      {"the", 3}, {"cat", 1}, {"and", 1}, {"hat", 1}, {"end", 1}};
+    TS_ASSERT_EQUALS(counts.size(), expected.size());
+    for (const auto& kv : counts) {
+      TS_ASSERT_EQUALS(kv.second.get<flex_int>(), expected.at(kv.first.get<flex_string>()));
+    }
+    // first seen order
+    TS_ASSERT_EQUALS(counts[0].first, "the");
+
+    flex_list tokens = tokenize_to_list(whitespace, "Cat cat", false);
+    TS_ASSERT_EQUALS(tokens.size(), 2);
+    TS_ASSERT_EQUALS(tokens[0], "Cat");
+    TS_ASSERT_EQUALS(tokens[1], "cat");
+
+    // interned tokens share the same string
+    auto& vocabulary = whitespace.vocabulary();
+    size_t id = vocabulary.intern("cat", 3);
+    TS_ASSERT_EQUALS(vocabulary.intern("cat", 3), id);
+    TS_ASSERT_EQUALS(vocabulary.intern("CAT", 3, true), id);
+    TS_ASSERT(vocabulary.intern("dog", 3) != id);
+  }
+
+  void test_vocabulary_lifetime() {
+    delimiter_tokenizer a(flex_list{" "});
+    delimiter_tokenizer b(flex_list{" "});
+    tokenize_to_list(a, "x y z", false);
+    TS_ASSERT_EQUALS(a.vocabulary().size(), 3);
+    // copies share the vocabulary; other tokenizers have their own
+    delimiter_tokenizer a_copy = a;
+    TS_ASSERT_EQUALS(&a_copy.vocabulary(), &a.vocabulary());
+    TS_ASSERT_EQUALS(b.vocabulary().size(), 0);
+    TS_ASSERT_EQUALS(a.vocabulary().size(), 3);
+
+    // each thread has its own vocabulary
+    size_t other_thread_size = 1;
+    const token_vocabulary* other_thread_vocabulary = nullptr;
+    std::thread t([&]() {
+      other_thread_vocabulary = &a.vocabulary();
+      other_thread_size = a.vocabulary().size();
+    });
+    t.join();
+    TS_ASSERT(other_thread_vocabulary != &a.vocabulary());
+    TS_ASSERT_EQUALS(other_thread_size, 0);
+  }
+};
+
+BOOST_FIXTURE_TEST_SUITE(_delimiter_tokenizer_test, delimiter_tokenizer_test)
+BOOST_AUTO_TEST_CASE(test_tokens) {
+  delimiter_tokenizer_test::test_tokens();
+}
+BOOST_AUTO_TEST_CASE(test_count_and_intern) {
+  delimiter_tokenizer_test::test_count_and_intern();
+}
+BOOST_AUTO_TEST_CASE(test_vocabulary_lifetime) {
+  delimiter_tokenizer_test::test_vocabulary_lifetime();
+}
+BOOST_AUTO_TEST_SUITE_END()
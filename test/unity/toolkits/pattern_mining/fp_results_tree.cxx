@@ -713,6 +713,42 @@ struct fp_results_tree_test  {
 
     }
 
+    // Test merge_results_trees
+    void testMergeResultsTrees(void){
+      std::vector<size_t> id_order = {3, 2, 9, 0, 8};
+      size_t k = 3;
+      size_t len = 1;
+      std::vector<fp_top_k_results_tree> local_trees;
+      local_trees.push_back(fp_top_k_results_tree(id_order, k, len));
+      local_trees.push_back(fp_top_k_results_tree(id_order, k, len));
+
+      // {3, 2} is redundant with {3, 2, 9} of the other tree
+      local_trees[0].add_itemset({3, 2}, 10);
+      local_trees[0].add_itemset({9}, 12);
+      local_trees[1].add_itemset({3, 2, 9}, 10);
+      local_trees[1].add_itemset({3}, 18);
+      local_trees[1].add_itemset({0}, 5);
+
+      fp_top_k_results_tree my_results = fp_top_k_results_tree(id_order, k, len);
+      merge_results_trees(my_results, local_trees, 6);
+
+      // Closed Itemsets should be
+      // {3}:18, {9}:12, {3, 2, 9}:10
+      gl_sframe closed_itemset = my_results.get_closed_itemsets();
+      TS_ASSERT_EQUALS(closed_itemset.size(), 3);
+      TS_ASSERT_EQUALS(my_results.root_node->children_nodes.size(), 2);
+      TS_ASSERT_EQUALS(my_results.root_node->children_nodes[0]->item_id, 3);
+      TS_ASSERT_EQUALS(my_results.root_node->children_nodes[0]->item_count, 18);
+      TS_ASSERT_EQUALS(my_results.get_min_support_bound(), 10);
+
+      // The result does not depend on the order of the trees
+      std::swap(local_trees[0], local_trees[1]);
+      fp_top_k_results_tree other_results = fp_top_k_results_tree(id_order, k, len);
+      merge_results_trees(other_results, local_trees, 6);
+      TS_ASSERT_EQUALS(other_results.get_closed_itemsets().size(), 3);
+      TS_ASSERT_EQUALS(other_results.root_node->children_nodes[0]->item_id, 3);
+    }
+
 
 };
 
@@ -790,4 +826,7 @@ BOOST_AUTO_TEST_CASE(testFPTopKAddItemset3) {
 BOOST_AUTO_TEST_CASE(testGetSupport) {
   fp_results_tree_test::testGetSupport();
 }
+BOOST_AUTO_TEST_CASE(testMergeResultsTrees) {
+  fp_results_tree_test::testMergeResultsTrees();
+}
 BOOST_AUTO_TEST_SUITE_END()
@@ -8,6 +8,7 @@
 
 #include <vector>
 #include <string>
+#include <set>
 #include <random/random.hpp>
 
 #include <sframe/testing_utils.hpp>
@@ -124,6 +125,62 @@ struct evaluation_test {
   }
 
 
+  void test_exact_auc() {
+
+    // Arrange: scores with ties, so the tie handling is exercised.
+    size_t num_observations = 2000;
+    random::seed(0);
+
+    auto predictions = std::vector<flexible_type>(num_observations);
+    auto targets = std::vector<flexible_type>(num_observations);
+    std::set<double> distinct_scores;
+    for (size_t i = 0; i < num_observations; ++i) {
+      size_t label = random::fast_uniform<size_t>(0, 1);
+      double noise = random::fast_uniform<double>(0, 1);
+      double score = std::round(100 * (0.3 * label + 0.7 * noise)) / 100;
+      targets[i] = label;
+      predictions[i] = score;
+      distinct_scores.insert(score);
+    }
+
+    // Mann-Whitney statistic: P(score_pos > score_neg) + 0.5 P(tie).
+    double num_pairs = 0, num_correct = 0;
+    for (size_t i = 0; i < num_observations; ++i) {
+      if (targets[i] != 1) continue;
+      for (size_t j = 0; j < num_observations; ++j) {
+        if (targets[j] != 0) continue;
+        num_pairs += 1;
+        double si = predictions[i], sj = predictions[j];
+        num_correct += (si > sj) ? 1.0 : ((si == sj) ? 0.5 : 0.0);
+      }
+    }
+    double true_auc = num_correct / num_pairs;
+
+    std::shared_ptr<sarray<flexible_type> > predictions_sa = make_testing_sarray(
+          flex_type_enum::FLOAT, predictions);
+    std::shared_ptr<sarray<flexible_type> > targets_sa = make_testing_sarray(
+          flex_type_enum::INTEGER, targets);
+    std::shared_ptr<unity_sarray> unity_targets_sa = std::make_shared<unity_sarray>();
+    unity_targets_sa->construct_from_sarray(targets_sa);
+    std::shared_ptr<unity_sarray> unity_predictions_sa= std::make_shared<unity_sarray>();
+    unity_predictions_sa->construct_from_sarray(predictions_sa);
+
+    // Act
+    std::map<std::string, flexible_type> kwargs {
+               {"average", "default"},
+               {"binary", true}};
+    variant_type auc = evaluation::_supervised_streaming_evaluator(
+             unity_targets_sa, unity_predictions_sa, "exact_auc", kwargs);
+    variant_type roc = evaluation::_supervised_streaming_evaluator(
+             unity_targets_sa, unity_predictions_sa, "exact_roc_curve", kwargs);
+
+    // Assert
+    TS_ASSERT_DELTA(variant_get_value<double>(auc), true_auc, 1e-10);
+    auto sf = *(variant_get_value<std::shared_ptr<unity_sframe>>(roc))
+                   ->get_underlying_sframe();
+    TS_ASSERT_EQUALS(sf.size(), distinct_scores.size() + 1);
+  }
+
   void test_accuracy() {
 
     size_t num_observations = 5000;
@@ -184,6 +241,9 @@ BOOST_AUTO_TEST_CASE(test_rmse_and_max_error) {
 BOOST_AUTO_TEST_CASE(test_roc_curve) {
   evaluation_test::test_roc_curve();
 }
+BOOST_AUTO_TEST_CASE(test_exact_auc) {
+  evaluation_test::test_exact_auc();
+}
 BOOST_AUTO_TEST_CASE(test_accuracy) {
   evaluation_test::test_accuracy();
 }
@@ -11,6 +11,7 @@
 #include <sframe/sframe.hpp>
 #include <sframe/sarray.hpp>
 #include <sframe/sframe_config.hpp>
+#include <sframe/sframe_constants.hpp>
 using namespace turi;
 
 struct unity_sframe_test {
@@ -684,6 +685,30 @@ struct unity_sframe_test {
     TS_ASSERT_THROWS_ANYTHING(sf->sort(std::vector<std::string>({"b"}), std::vector<int>({0})));
   }
 
+  void test_compact() {
+    size_t old_num_segments = SFRAME_DEFAULT_NUM_SEGMENTS;
+    SFRAME_DEFAULT_NUM_SEGMENTS = 2;
+    dataframe_t testdf = _create_test_dataframe();
+    auto part = std::make_shared<unity_sframe>();
+    part->construct_from_dataframe(testdf);
+
+    std::shared_ptr<unity_sframe_base> sf = part;
+    for (size_t i = 0; i < 10; ++i) sf = sf->append(part);
+    sf->materialize();
+    TS_ASSERT(sf->is_fragmented());
+
+    sf->compact();
+    TS_ASSERT(sf->is_materialized());
+    TS_ASSERT(!sf->is_fragmented());
+    TS_ASSERT_EQUALS(sf->size(), 11 * testdf.nrows());
+    auto values = sf->_head(sf->size());
+    for (size_t i = 0; i < values.nrows(); ++i) {
+      TS_ASSERT_EQUALS(values.values["a"][i], testdf.values["a"][i % testdf.nrows()]);
+      TS_ASSERT_EQUALS(values.values["c"][i], testdf.values["c"][i % testdf.nrows()]);
+    }
+    SFRAME_DEFAULT_NUM_SEGMENTS = old_num_segments;
+  }
+
   void test_save_load() {
     dataframe_t testdf = _create_test_dataframe();
     auto sf = std::make_shared<unity_sframe>();
@@ -747,6 +772,9 @@ BOOST_AUTO_TEST_CASE(test_sort) {
 BOOST_AUTO_TEST_CASE(test_sort_exception) {
   unity_sframe_test::test_sort_exception();
 }
+BOOST_AUTO_TEST_CASE(test_compact) {
+  unity_sframe_test::test_compact();
+}
 BOOST_AUTO_TEST_CASE(test_save_load) {
   unity_sframe_test::test_save_load();
 }
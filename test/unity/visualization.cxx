@@ -0,0 +1,92 @@
+#define BOOST_TEST_MODULE
+#include <boost/test/unit_test.hpp>
+#include <util/test_macros.hpp>
+#include <unity/lib/visualization/histogram.hpp>
+#include <unity/lib/visualization/item_frequency.hpp>
+
+using namespace turi;
+using namespace turi::visualization;
+
+struct visualization_test {
+  public:
+    // Adds the values [0, num_values) to num_threads histogram results,
+    // each thread seeing an overlapping range, and merges them as
+    // histogram::merge_results does.
+    histogram_result merged_histogram(size_t num_values, size_t num_threads) {
+      std::vector<histogram_result> results(num_threads);
+      for (size_t i = 0; i < num_threads; ++i) {
+        results[i].init(flex_type_enum::INTEGER, 0, flex_int(num_values));
+        size_t begin = i * num_values / num_threads;
+        size_t end = std::min(num_values, (i + 2) * num_values / num_threads);
+        for (size_t j = begin; j < end; ++j) {
+          results[i].add_element_simple(flex_int(j));
+        }
+      }
+      histogram_result merged;
+      merged.init(flex_type_enum::INTEGER, 0, flex_int(num_values));
+      for (const auto& result : results) {
+        merged.combine_num_unique(result);
+      }
+      return merged;
+    }
+
+    void test_histogram_num_unique_exact() {
+      size_t limit = histogram_result::MAX_EXACT_NUM_UNIQUE;
+      for (size_t num_values : std::vector<size_t>{0, 1, 199, 200, 201, limit}) {
+        for (size_t num_threads : {1, 3, 16}) {
+          TS_ASSERT_EQUALS(merged_histogram(num_values, num_threads).num_unique(),
+                           num_values);
+        }
+      }
+    }
+
+    void test_histogram_num_unique_estimated() {
+      size_t limit = histogram_result::MAX_EXACT_NUM_UNIQUE;
+      for (size_t num_values : std::vector<size_t>{limit + 1, 10 * limit}) {
+        for (size_t num_threads : {1, 3, 16}) {
+          size_t num_unique = merged_histogram(num_values, num_threads).num_unique();
+          TS_ASSERT_LESS_THAN(limit, num_unique);
+          TS_ASSERT_DELTA(double(num_unique), double(num_values), 0.05 * num_values);
+        }
+      }
+    }
+
+    void test_item_frequency_merge() {
+      size_t num_threads = 4;
+      std::vector<item_frequency_result> results(num_threads);
+      for (size_t i = 0; i < num_threads; ++i) {
+        // every thread sees "a", and one thread sees a missing value
+        results[i].add_element_simple("a");
+        results[i].add_element_simple(std::to_string(i));
+        if (i == 0) results[i].add_element_simple(FLEX_UNDEFINED);
+      }
+      item_frequency_result merged;
+      for (const auto& result : results) {
+        merged.combine(result);
+      }
+      flexible_type counts = merged.emit();
+      std::map<std::string, flexible_type> count_map;
+      for (const auto& kvp : counts.get<flex_dict>()) {
+        if (kvp.first.get_type() == flex_type_enum::STRING) {
+          count_map[kvp.first.get<flex_string>()] = kvp.second;
+        }
+      }
+      TS_ASSERT_EQUALS(merged.num_unique(), num_threads + 2);
+      TS_ASSERT_EQUALS(count_map.at("a"), flex_int(num_threads));
+      TS_ASSERT_EQUALS(count_map.at("0"), 1);
+      TS_ASSERT_EQUALS(merged.m_count.emit(), flex_int(2 * num_threads + 1));
+      TS_ASSERT_EQUALS(merged.m_non_null_count.emit(), flex_int(2 * num_threads));
+    }
+};
+
+BOOST_FIXTURE_TEST_SUITE(_visualization_test, visualization_test)
+BOOST_AUTO_TEST_CASE(test_histogram_num_unique_exact) {
+  visualization_test::test_histogram_num_unique_exact();
+}
+BOOST_AUTO_TEST_CASE(test_histogram_num_unique_estimated) {
+  visualization_test::test_histogram_num_unique_estimated();
+}
+BOOST_AUTO_TEST_CASE(test_item_frequency_merge) {
+  visualization_test::test_item_frequency_merge();
+}
+BOOST_AUTO_TEST_SUITE_END()